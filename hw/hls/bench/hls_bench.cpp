@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <hls_stream.h>
+
+#include "camera.hpp"
+#include "main.hpp"
+#include "scene.hpp"
+#include "shade.hpp"
+
+// Frames per second of the natively built HLS kernels: the initial
+// main_v1.cpp against the dataflow main.cpp at 1, 2, 4 and 8 pixels per
+// beat, and the shading kernel shade.cpp on a scene of four spheres. This
+// measures the kernels as a CPU renderer, not the hardware;
+// items_per_second is pixels per second.
+
+// main_v1.cpp
+void myip_v1_0_HLS(hls::stream<pkt> &A, hls::stream<pkt> &B);
+// main.cpp, built with PIXELS_PER_CLOCK 2, 4 and 8 (1 is in main.hpp)
+void myip_v1_0_HLS(hls::stream<pkt> &A, hls::stream<wide_pkt<2>> &B);
+void myip_v1_0_HLS(hls::stream<pkt> &A, hls::stream<wide_pkt<4>> &B);
+void myip_v1_0_HLS(hls::stream<pkt> &A, hls::stream<wide_pkt<8>> &B);
+
+static void resolutions(benchmark::internal::Benchmark *b) {
+  b->Args({64, 32})->Args({640, 480})->Args({1280, 720});
+}
+
+template <typename Out> static void BM_Kernel(benchmark::State &state) {
+  float width = state.range(0);
+  float height = state.range(1);
+  scene s(width, width / height, 1.0f);
+  uint32_t *camera = s.serialised();
+
+  for (auto _ : state) {
+    hls::stream<pkt> A;
+    hls::stream<Out> B;
+    for (int i = 0; i < CAMERA_STRUCT_LEN; i++) {
+      pkt tmp;
+      tmp.data = camera[i];
+      tmp.last = i == CAMERA_STRUCT_LEN - 1;
+      A.write(tmp);
+    }
+    myip_v1_0_HLS(A, B);
+    while (!B.empty()) {
+      Out beat = B.read();
+      benchmark::DoNotOptimize(beat);
+    }
+  }
+
+  int64_t pixels = int64_t(s.image_width) * int64_t(s.image_height);
+  state.SetItemsProcessed(state.iterations() * pixels);
+  state.counters["fps"] = benchmark::Counter(double(state.iterations()),
+                                             benchmark::Counter::kIsRate);
+}
+
+// Spheres of BM_Shade, three beside each other on a large one
+static const float SPHERES[][4] = {{0, -100.5, -1, 100},
+                                   {0, 0, -1, 0.5},
+                                   {-1, 0, -1.2, 0.5},
+                                   {1, 0, -1.2, 0.5}};
+
+static void BM_Shade(benchmark::State &state) {
+  float width = state.range(0);
+  float height = state.range(1);
+  scene s(width, width / height, 1.0f);
+  uint32_t *camera = s.serialised();
+
+  std::vector<uint32_t> config(camera, camera + CAMERA_STRUCT_LEN);
+  config.push_back(sizeof(SPHERES) / sizeof(float));
+  for (const auto &sphere : SPHERES) {
+    for (float x : sphere) {
+      config.push_back(FLOAT_2_FIX(x));
+    }
+  }
+
+  for (auto _ : state) {
+    hls::stream<pkt> A;
+    hls::stream<pkt> B;
+    for (size_t i = 0; i < config.size(); i++) {
+      pkt tmp;
+      tmp.data = config[i];
+      tmp.last = i == config.size() - 1;
+      A.write(tmp);
+    }
+    myip_shade_HLS(A, B);
+    while (!B.empty()) {
+      pkt beat = B.read();
+      benchmark::DoNotOptimize(beat);
+    }
+  }
+
+  int64_t pixels = int64_t(s.image_width) * int64_t(s.image_height);
+  state.SetItemsProcessed(state.iterations() * pixels);
+  state.counters["fps"] = benchmark::Counter(double(state.iterations()),
+                                             benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_Kernel<pkt>)->Name("main_v1")->Apply(resolutions);
+BENCHMARK(BM_Kernel<wide_pkt<1>>)->Name("main/1")->Apply(resolutions);
+BENCHMARK(BM_Kernel<wide_pkt<2>>)->Name("main/2")->Apply(resolutions);
+BENCHMARK(BM_Kernel<wide_pkt<4>>)->Name("main/4")->Apply(resolutions);
+BENCHMARK(BM_Kernel<wide_pkt<8>>)->Name("main/8")->Apply(resolutions);
+
+BENCHMARK(BM_Shade)->Name("shade")->Apply(resolutions);
+
+BENCHMARK_MAIN();
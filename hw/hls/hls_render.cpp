@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include "hls_render.hpp"
+
+#include <hls_stream.h>
+
+#include "main.hpp"
+
+bool hls_render(const uint32_t *config, size_t words,
+                std::vector<uint32_t> &pixels) {
+  hls::stream<pkt> A;
+  hls::stream<out_pkt> B;
+  for (size_t i = 0; i < words; i++) {
+    pkt tmp;
+    tmp.data = config[i];
+    tmp.last = i == words - 1;
+    A.write(tmp);
+  }
+
+  myip_v1_0_HLS(A, B);
+
+  bool ok = true;
+  bool ragged = false;
+  while (!B.empty()) {
+    out_pkt beat = B.read();
+    for (int k = 0; k < PIXELS_PER_CLOCK; k++) {
+      if (beat.keep.range(4 * k + 3, 4 * k) == 0xf) {
+        ok = ok && !ragged;
+        pixels.push_back(uint32_t(beat.data.range(32 * k + 31, 32 * k)));
+      } else {
+        ragged = true;
+      }
+    }
+    ok = ok && (bool(beat.last) == B.empty()) && !(ragged && !beat.last);
+  }
+  return ok && A.empty();
+}
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Host entry point of the natively built HLS kernel (main.cpp), for tests
+// and tools that do not include the HLS headers.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Runs myip_v1_0_HLS on one configuration packet and appends the pixel
+// words of the frame to pixels, in raster order. Returns false if tlast or
+// tkeep are not set as on the hardware, i.e. tlast only on the last beat
+// and tkeep only cleared at its end.
+bool hls_render(const uint32_t *config, size_t words,
+                std::vector<uint32_t> &pixels);
@@ -1,104 +1,45 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (c) 2025 Hugo Melder
 
+// Dataflow implementation: four stages connected by streams, each pipelined
+// at II=1, so that a beat of P pixels leaves the kernel on every clock once
+// the camera has been received. No frame or line buffer is needed.
+//
+//   recv_config -> generate_coords -> generate_rays -> pack_axis
+//        \_______________________________/
+
 #include <cstdint>
 #include <hls_stream.h>
 
-#include "camera.hpp"
 #include "main.hpp"
 #include "math/vec3.hpp"
+#include "state.hpp"
 
-#define BUF_LEN 128
-
-struct state {
-  // Current Position
-  ap_uint<15> w;
-  ap_uint<15> h;
-  ap_uint<15> image_width;
-  ap_uint<15> image_height;
-  vec3<sfp> pixel_00_loc;
-  vec3<sfp> pixel_delta_u;
-  vec3<sfp> pixel_delta_v;
-  vec3<sfp> camera_center;
-  int valid_len;
-  bool done;
+// Coordinates of the P pixels of a beat
+template <int P> struct coords {
+  ap_uint<15> w[P];
+  ap_uint<15> h[P];
 };
 
-void compute(struct state &s, ap_uint<32> *buffer) {
-  int image_w = s.image_width;
-  int image_h = s.image_height;
-
-  int count = 0;
-compute_loop:
-  while (count < BUF_LEN && s.h < image_h) {
-#pragma HLS pipeline
-    ap_uint<32> value;
-    auto pixel_center = s.pixel_00_loc + (sfp(s.w) * s.pixel_delta_u) +
-                        (sfp(s.h) * s.pixel_delta_v);
-    auto ray_direction = pixel_center - s.camera_center;
-
-    FIXED_2_RAW(ray_direction.y(), value);
-    buffer[count++] = value;
-
-    s.done = (s.w == (image_w - 1)) && (s.h == (image_h - 1));
-
-    if (s.w == image_w - 1) {
-      s.w = 0;
-      s.h += 1;
-    } else {
-      s.w += 1;
-    }
-  }
-  s.valid_len = count;
-}
-
-union cam_u {
-  struct camera cam;
-  uint32_t buf[CAMERA_STRUCT_LEN];
+template <int P> struct ray_beat {
+  ap_uint<32 * P> data;
+  ap_uint<4 * P> keep;
+  bool last;
 };
 
-struct state convert(struct camera &cam) {
-  struct state s;
-  s.w = 0;
-  s.h = 0;
-
-  sfp pixel_00_loc_fp[3], pixel_delta_u_fp[3], pixel_delta_v_fp[3],
-      camera_center_fp[3];
-  sfp image_width, image_height;
-
-  ap_int<32> tmp_image_width = cam.image_width;
-  ap_int<32> tmp_image_height = cam.image_height;
-
-  RAW_2_FIXED_V(cam.pixel_00_loc, pixel_00_loc_fp);
-  RAW_2_FIXED_V(cam.pixel_delta_u, pixel_delta_u_fp);
-  RAW_2_FIXED_V(cam.pixel_delta_v, pixel_delta_v_fp);
-  RAW_2_FIXED_V(cam.camera_center, camera_center_fp);
-  RAW_2_FIXED(tmp_image_width, image_width);
-  RAW_2_FIXED(tmp_image_height, image_height);
-
-  s.image_width = image_width;
-  s.image_height = image_height;
-
-  s.pixel_00_loc = vec3<sfp>(pixel_00_loc_fp);
-  s.pixel_delta_u = vec3<sfp>(pixel_delta_u_fp);
-  s.pixel_delta_v = vec3<sfp>(pixel_delta_v_fp);
-  s.camera_center = vec3<sfp>(camera_center_fp);
-
-  return s;
+// Beats of a frame of n pixels, the last one possibly ragged
+template <int P> static ap_uint<30> beat_count(ap_uint<30> n) {
+  return (n + (P - 1)) / P;
 }
 
-void myip_v1_0_HLS(hls::stream<pkt> &A, hls::stream<pkt> &B) {
-#pragma HLS INTERFACE ap_ctrl_none port = return
-#pragma HLS INTERFACE axis port = A
-#pragma HLS INTERFACE axis port = B
-
-  ap_uint<32> buffer[BUF_LEN];
-#pragma HLS ARRAY_PARTITION variable = buffer complete
-
+// Receives the camera and hands it to the stages that need it
+static void recv_config(hls::stream<pkt> &A, hls::stream<state> &coord_cfg,
+                        hls::stream<state> &ray_cfg) {
   union cam_u cam;
 
 recv_loop:
   for (int i = 0; i < CAMERA_STRUCT_LEN; i++) {
+#pragma HLS pipeline II = 1
     pkt tmp;
 
     A.read(tmp);
@@ -106,14 +47,136 @@ recv_loop:
   }
 
   struct state s = convert(cam.cam);
+  coord_cfg.write(s);
+  ray_cfg.write(s);
+}
 
-  pkt tmp;
-  while (!s.done) {
-    compute(s, buffer);
-    for (int i = 0; i < s.valid_len; i++) {
-      tmp.data = buffer[i];
-      tmp.last = s.done;
-      B.write(tmp);
+// Pixel coordinates in raster order, P per beat. A beat may span rows, and
+// every lane steps P pixels ahead, so the frame is packed without gaps.
+template <int P>
+static void generate_coords(hls::stream<state> &cfg,
+                            hls::stream<coords<P>> &out) {
+  struct state s = cfg.read();
+  ap_uint<30> beats = beat_count<P>(pixel_count(s));
+
+  // Step of a lane; the divisions run once per frame
+  ap_uint<15> dw = P % s.image_width;
+  ap_uint<15> dh = P / s.image_width;
+
+  coords<P> c;
+#pragma HLS array_partition variable = c.w complete
+#pragma HLS array_partition variable = c.h complete
+  for (int k = 0; k < P; k++) {
+    c.w[k] = k % s.image_width;
+    c.h[k] = k / s.image_width;
+  }
+
+coord_loop:
+  for (ap_uint<30> i = 0; i < beats; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS loop_tripcount min = 1 max = 921600
+    out.write(c);
+    for (int k = 0; k < P; k++) {
+#pragma HLS unroll
+      ap_uint<16> w = c.w[k] + dw;
+      ap_uint<15> h = c.h[k] + dh;
+      if (w >= s.image_width) {
+        w -= s.image_width;
+        h += 1;
+      }
+      c.w[k] = w;
+      c.h[k] = h;
     }
   }
 }
+
+template <int P>
+static void generate_rays(hls::stream<state> &cfg,
+                          hls::stream<coords<P>> &in,
+                          hls::stream<ap_uint<30>> &count,
+                          hls::stream<ray_beat<P>> &rays) {
+  struct state s = cfg.read();
+  ap_uint<30> n = pixel_count(s);
+  ap_uint<30> beats = beat_count<P>(n);
+  count.write(beats);
+
+  // Pixels not yet sent
+  ap_uint<30> left = n;
+ray_loop:
+  for (ap_uint<30> i = 0; i < beats; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS loop_tripcount min = 1 max = 921600
+    coords<P> c = in.read();
+
+    ray_beat<P> r;
+    for (int k = 0; k < P; k++) {
+#pragma HLS unroll
+      auto pixel_center = s.pixel_00_loc + (sfp(c.w[k]) * s.pixel_delta_u) +
+                          (sfp(c.h[k]) * s.pixel_delta_v);
+      auto ray_direction = pixel_center - s.camera_center;
+
+      u32 value;
+      FIXED_2_RAW(ray_direction.y(), value);
+      bool valid = left > ap_uint<30>(k);
+      r.data.range(32 * k + 31, 32 * k) = valid ? value : u32(0);
+      r.keep.range(4 * k + 3, 4 * k) = valid ? 0xf : 0;
+    }
+    r.last = i == beats - 1;
+    rays.write(r);
+    left -= P;
+  }
+}
+
+template <int P>
+static void pack_axis(hls::stream<ap_uint<30>> &count,
+                      hls::stream<ray_beat<P>> &rays,
+                      hls::stream<wide_pkt<P>> &B) {
+  ap_uint<30> beats = count.read();
+
+pack_loop:
+  for (ap_uint<30> i = 0; i < beats; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS loop_tripcount min = 1 max = 921600
+    ray_beat<P> r = rays.read();
+    wide_pkt<P> tmp;
+    tmp.data = r.data;
+    tmp.keep = r.keep;
+    tmp.last = r.last;
+    B.write(tmp);
+  }
+}
+
+// P pixels per clock. Only PIXELS_PER_CLOCK is synthesised, through the
+// top-level function below. The body is inlined into it, so the streams and
+// the four stages form the dataflow region of the top-level function.
+template <int P>
+void myip_v1_0_HLS(hls::stream<pkt> &A, hls::stream<wide_pkt<P>> &B) {
+#pragma HLS inline
+  static_assert(P == 1 || P == 2 || P == 4 || P == 8,
+                "P must be 1, 2, 4 or 8");
+
+  hls::stream<state> coord_cfg("coord_cfg");
+  hls::stream<state> ray_cfg("ray_cfg");
+  hls::stream<coords<P>> coord("coords");
+  hls::stream<ap_uint<30>> count("count");
+  hls::stream<ray_beat<P>> rays("rays");
+#pragma HLS stream variable = coord_cfg depth = 2
+#pragma HLS stream variable = ray_cfg depth = 2
+#pragma HLS stream variable = coord depth = 4
+#pragma HLS stream variable = count depth = 2
+#pragma HLS stream variable = rays depth = 4
+
+  recv_config(A, coord_cfg, ray_cfg);
+  generate_coords<P>(coord_cfg, coord);
+  generate_rays<P>(ray_cfg, coord, count, rays);
+  pack_axis<P>(count, rays, B);
+}
+
+void myip_v1_0_HLS(hls::stream<pkt> &A, hls::stream<out_pkt> &B) {
+#pragma HLS INTERFACE ap_ctrl_none port = return
+#pragma HLS INTERFACE axis port = A
+#pragma HLS INTERFACE axis port = B
+#pragma HLS dataflow
+
+  myip_v1_0_HLS<PIXELS_PER_CLOCK>(A, B);
+}
@@ -22,4 +22,16 @@ typedef ap_uint<32> u32;
 
 typedef hls::axis_data<u32, AXIS_ENABLE_LAST> pkt;
 
-void myip_v1_0_HLS(hls::stream<pkt> &S_AXIS, hls::stream<pkt> &M_AXIS);
\ No newline at end of file
+// Pixels per output beat of main.cpp (1, 2, 4 or 8), like LANES in the RTL
+#ifndef PIXELS_PER_CLOCK
+#define PIXELS_PER_CLOCK 1
+#endif
+
+// P words per beat, pixel k in bits [32k+31:32k]. tkeep marks the valid
+// pixels of the last beat of a frame.
+template <int P>
+using wide_pkt =
+    hls::axis_data<ap_uint<32 * P>, AXIS_ENABLE_KEEP | AXIS_ENABLE_LAST>;
+typedef wide_pkt<PIXELS_PER_CLOCK> out_pkt;
+
+void myip_v1_0_HLS(hls::stream<pkt> &S_AXIS, hls::stream<out_pkt> &M_AXIS);
\ No newline at end of file
@@ -22,7 +22,7 @@ struct state {
   vec3<sfp> camera_center;
 };
 
-struct state convert(struct camera &cam) {
+static struct state convert(struct camera &cam) {
   struct state s;
 
   sfp pixel_00_loc_fp[3], pixel_delta_u_fp[3], pixel_delta_v_fp[3],
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Square root and division of ap_fixed values on their raw bits. Both are
+// plain integer logic that HLS unrolls into a pipeline, and give the same
+// bits natively and in C simulation.
+
+#pragma once
+
+#include <ap_fixed.h>
+#include <ap_int.h>
+
+// floor(sqrt(x)), one result bit per step
+template <int W> ap_uint<W / 2> isqrt(ap_uint<W> x) {
+  static_assert(W % 2 == 0, "isqrt needs an even width");
+  ap_uint<W> rem = x;
+  ap_uint<W> root = 0;
+
+isqrt_loop:
+  for (int i = W / 2 - 1; i >= 0; i--) {
+#pragma HLS unroll
+    ap_uint<W> bit = ap_uint<W>(1) << (2 * i);
+    ap_uint<W> trial = root + bit;
+    if (rem >= trial) {
+      rem = rem - trial;
+      root = (root >> 1) + bit;
+    } else {
+      root = root >> 1;
+    }
+  }
+  return root;
+}
+
+// sqrt(x) for x >= 0, truncated to the format of x
+template <int W, int I> ap_fixed<W, I> sqrt_fixed(ap_fixed<W, I> x) {
+  constexpr int F = W - I;
+  ap_uint<W> raw;
+  raw.range() = x.range();
+
+  ap_uint<W + F> scaled = ap_uint<W + F>(raw) << F;
+  ap_uint<(W + F) / 2> root = isqrt<W + F>(scaled);
+
+  ap_fixed<W, I> r;
+  r.range() = root.range();
+  return r;
+}
+
+// x / y for y != 0, truncated towards zero to the format of x and y
+template <int W, int I>
+ap_fixed<W, I> div_fixed(ap_fixed<W, I> x, ap_fixed<W, I> y) {
+  constexpr int F = W - I;
+  ap_int<W> xr, yr;
+  xr.range() = x.range();
+  yr.range() = y.range();
+
+  ap_int<W + F> q = (ap_int<W + F>(xr) << F) / yr;
+
+  ap_fixed<W, I> r;
+  r.range() = q.range(W - 1, 0);
+  return r;
+}
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Minimal stand-in for the Vitis HLS ap_axi_sdata.h, see ap_int.h.
+//
+// hls::axis_data with tdata, tkeep, tstrb and tlast. The side channels are
+// always present; EnableSignals only documents which ones the kernel uses.
+
+#pragma once
+
+#include <cstdint>
+
+#include <ap_int.h>
+
+#define AXIS_ENABLE_DATA 0b00000001
+#define AXIS_ENABLE_DEST 0b00000010
+#define AXIS_ENABLE_ID 0b00000100
+#define AXIS_ENABLE_KEEP 0b00001000
+#define AXIS_ENABLE_LAST 0b00010000
+#define AXIS_ENABLE_STRB 0b00100000
+#define AXIS_ENABLE_USER 0b01000000
+
+namespace hls {
+
+template <typename TData, uint8_t EnableSignals> struct axis_data {
+  TData data;
+  ap_uint<(TData::width + 7) / 8> keep;
+  ap_uint<(TData::width + 7) / 8> strb;
+  ap_uint<1> last;
+};
+
+} // namespace hls
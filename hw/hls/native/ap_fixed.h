@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Minimal stand-in for the Vitis HLS ap_fixed.h, see ap_int.h.
+//
+// ap_fixed<W, I> with the default AP_TRN and AP_WRAP modes, W <= 64.
+// Sums and products are exact and widened like the real types
+// (ap_fixed<W1 + W2, I1 + I2> for a product), and converting to a narrower
+// type truncates towards minus infinity and wraps, so the kernels produce
+// the same bits as in Vitis C simulation.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+#include <ap_int.h>
+
+template <int W, int I> class ap_fixed {
+  static_assert(W > 0 && W <= 64, "ap_fixed is limited to 64 bits");
+
+public:
+  static constexpr int width = W;
+  static constexpr int iwidth = I;
+  static constexpr int F = W - I; // Fractional bits
+
+  ap_fixed() : raw(0) {}
+
+  template <typename T>
+    requires std::is_integral_v<T>
+  ap_fixed(T x) : raw(wrap(shift(int64_t(x), F))) {}
+
+  ap_fixed(double x) : raw(wrap(int64_t(std::floor(std::ldexp(x, F))))) {}
+
+  template <int W2, bool S2>
+    requires(W2 <= 64)
+  ap_fixed(const ap_int_base<W2, S2> &x)
+      : raw(wrap(shift(int64_t(x), F))) {}
+
+  template <int W2, int I2>
+  ap_fixed(const ap_fixed<W2, I2> &x)
+      : raw(wrap(shift(x.bits(), F - ap_fixed<W2, I2>::F))) {}
+
+  int64_t bits() const { return raw; }
+  static ap_fixed from_bits(int64_t x) {
+    ap_fixed f;
+    f.raw = wrap(x);
+    return f;
+  }
+
+  // Integer part, truncated towards zero
+  int64_t to_int64() const {
+    int64_t i = shift(raw, -F);
+    return raw < 0 && shift(i, F) != raw ? i + 1 : i;
+  }
+  double to_double() const { return std::ldexp(double(raw), -F); }
+
+  ap_range_ref<ap_fixed> range() { return {*this, W - 1, 0}; }
+  ap_range_ref<const ap_fixed> range() const { return {*this, W - 1, 0}; }
+  ap_range_ref<ap_fixed> range(int hi, int lo) { return {*this, hi, lo}; }
+  ap_range_ref<const ap_fixed> range(int hi, int lo) const {
+    return {*this, hi, lo};
+  }
+
+  uint64_t get_bits(int lo, int len) const {
+    uint64_t x = uint64_t(raw) >> lo;
+    return len == 64 ? x : x & ((uint64_t(1) << len) - 1);
+  }
+  void set_bits(int lo, int len, uint64_t x) {
+    uint64_t mask = len == 64 ? ~uint64_t(0) : (uint64_t(1) << len) - 1;
+    raw = wrap(int64_t((uint64_t(raw) & ~(mask << lo)) | ((x & mask) << lo)));
+  }
+
+  ap_fixed operator-() const { return from_bits(-raw); }
+
+  template <typename T> ap_fixed &operator+=(const T &x) {
+    return *this = *this + x;
+  }
+  template <typename T> ap_fixed &operator-=(const T &x) {
+    return *this = *this - x;
+  }
+  template <typename T> ap_fixed &operator*=(const T &x) {
+    return *this = *this * x;
+  }
+
+  // Arithmetic shift; right shifts round towards minus infinity
+  static int64_t shift(int64_t x, int n) {
+    return n >= 0 ? int64_t(uint64_t(x) << n) : x >> -n;
+  }
+
+  // Sign-extends the low W bits
+  static int64_t wrap(int64_t x) {
+    return W == 64 ? x : int64_t(uint64_t(x) << (64 - W)) >> (64 - W);
+  }
+
+private:
+  int64_t raw;
+};
+
+template <typename T> struct is_ap_fixed : std::false_type {};
+template <int W, int I> struct is_ap_fixed<ap_fixed<W, I>> : std::true_type {};
+
+// Integers take part in arithmetic as fixed-point values with no fraction
+template <typename T> struct ap_fixed_of {
+  using type = ap_fixed<64, 64>;
+};
+template <int W, int I> struct ap_fixed_of<ap_fixed<W, I>> {
+  using type = ap_fixed<W, I>;
+};
+template <int W, bool S> struct ap_fixed_of<ap_int_base<W, S>> {
+  using type = ap_fixed<W + !S, W + !S>;
+};
+
+template <typename A, typename B>
+concept ap_fixed_operands =
+    (is_ap_fixed<A>::value || is_ap_fixed<B>::value) &&
+    (is_ap_fixed<A>::value || std::is_integral_v<A> ||
+     requires { A::width; }) &&
+    (is_ap_fixed<B>::value || std::is_integral_v<B> ||
+     requires { B::width; });
+
+template <typename A, typename B>
+  requires ap_fixed_operands<A, B>
+auto operator+(const A &a, const B &b) {
+  using FA = typename ap_fixed_of<A>::type;
+  using FB = typename ap_fixed_of<B>::type;
+  constexpr int F = FA::F > FB::F ? FA::F : FB::F;
+  constexpr int I =
+      (FA::iwidth > FB::iwidth ? FA::iwidth : FB::iwidth) + 1;
+  constexpr int W = I + F > 64 ? 64 : I + F;
+  using R = ap_fixed<W, W - F>;
+  return R::from_bits(R::shift(FA(a).bits(), F - FA::F) +
+                      R::shift(FB(b).bits(), F - FB::F));
+}
+
+template <typename A, typename B>
+  requires ap_fixed_operands<A, B>
+auto operator-(const A &a, const B &b) {
+  using FA = typename ap_fixed_of<A>::type;
+  using FB = typename ap_fixed_of<B>::type;
+  constexpr int F = FA::F > FB::F ? FA::F : FB::F;
+  constexpr int I =
+      (FA::iwidth > FB::iwidth ? FA::iwidth : FB::iwidth) + 1;
+  constexpr int W = I + F > 64 ? 64 : I + F;
+  using R = ap_fixed<W, W - F>;
+  return R::from_bits(R::shift(FA(a).bits(), F - FA::F) -
+                      R::shift(FB(b).bits(), F - FB::F));
+}
+
+template <typename A, typename B>
+  requires ap_fixed_operands<A, B>
+auto operator*(const A &a, const B &b) {
+  using FA = typename ap_fixed_of<A>::type;
+  using FB = typename ap_fixed_of<B>::type;
+  constexpr int F = FA::F + FB::F;
+  constexpr int W = FA::width + FB::width > 64 ? 64 : FA::width + FB::width;
+  using R = ap_fixed<W, W - F>;
+  return R::from_bits(FA(a).bits() * FB(b).bits());
+}
+
+#define AP_FIXED_COMPARE(op)                                                   \
+  template <typename A, typename B>                                            \
+    requires ap_fixed_operands<A, B>                                           \
+  bool operator op(const A &a, const B &b) {                                   \
+    auto d = a - b;                                                            \
+    return d.bits() op 0;                                                      \
+  }
+
+AP_FIXED_COMPARE(==)
+AP_FIXED_COMPARE(!=)
+AP_FIXED_COMPARE(<)
+AP_FIXED_COMPARE(<=)
+AP_FIXED_COMPARE(>)
+AP_FIXED_COMPARE(>=)
+
+#undef AP_FIXED_COMPARE
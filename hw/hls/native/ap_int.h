@@ -0,0 +1,184 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Minimal stand-in for the Vitis HLS ap_int.h, for native builds of the
+// kernels without Vitis. Configure with -DHLS_INCLUDE_DIR=<dir> to build
+// against the real headers instead.
+//
+// Only what the kernels in hw/hls use is provided. Values are stored
+// two's complement in 64-bit words and wrap to W bits on every assignment,
+// like AP_WRAP. Arithmetic converts to int64_t (uint64_t for ap_uint<64>),
+// so that mixing signed and unsigned values behaves as with the real types;
+// wider values support copies, comparison and range() only. Unlike the real
+// types, the result of an operation is not widened, which gives the same
+// bits as long as it is assigned to a type that holds it.
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+template <int W, int I> class ap_fixed;
+
+// Bits [hi:lo] of a value, at most 64 of them
+template <typename B> class ap_range_ref {
+public:
+  ap_range_ref(B &b, int hi, int lo) : b(b), hi(hi), lo(lo) {}
+
+  operator uint64_t() const { return b.get_bits(lo, hi - lo + 1); }
+
+  ap_range_ref &operator=(uint64_t x) {
+    b.set_bits(lo, hi - lo + 1, x);
+    return *this;
+  }
+  ap_range_ref &operator=(const ap_range_ref &o) {
+    return *this = uint64_t(o);
+  }
+  template <typename B2> ap_range_ref &operator=(const ap_range_ref<B2> &o) {
+    return *this = uint64_t(o);
+  }
+  template <typename T>
+  ap_range_ref &operator=(const T &x)
+    requires requires { x.get_bits(0, 1); }
+  {
+    return *this = x.get_bits(0, hi - lo + 1);
+  }
+
+private:
+  B &b;
+  int hi;
+  int lo;
+};
+
+template <int W, bool S> class ap_int_base {
+  static_assert(W > 0, "ap_int needs at least one bit");
+  static constexpr int N = (W + 63) / 64;
+
+public:
+  static constexpr int width = W;
+
+  ap_int_base() : v{} {}
+
+  template <typename T>
+    requires std::is_integral_v<T>
+  ap_int_base(T x) : v{} {
+    v[0] = uint64_t(x);
+    uint64_t ext = 0;
+    if constexpr (std::is_signed_v<T>) {
+      ext = x < 0 ? ~uint64_t(0) : 0;
+    }
+    for (int i = 1; i < N; i++) {
+      v[i] = ext;
+    }
+    normalise();
+  }
+
+  ap_int_base(double x) : ap_int_base(int64_t(x)) {}
+
+  template <int W2, bool S2> ap_int_base(const ap_int_base<W2, S2> &x) : v{} {
+    uint64_t ext = S2 && x.get_bits(W2 - 1, 1) ? ~uint64_t(0) : 0;
+    for (int i = 0; i < N; i++) {
+      v[i] = i < (W2 + 63) / 64 ? x.word(i) : ext;
+    }
+    // Sign-extend the top word of x
+    int top = (W2 - 1) / 64;
+    if (top < N && W2 % 64 != 0 && ext) {
+      v[top] |= ~uint64_t(0) << (W2 % 64);
+    }
+    normalise();
+  }
+
+  // Integer part, truncated
+  template <int W2, int I2> ap_int_base(const ap_fixed<W2, I2> &x) {
+    *this = ap_int_base(x.to_int64());
+  }
+
+  using integer = std::conditional_t<S || W < 64, int64_t, uint64_t>;
+
+  operator integer() const
+    requires(W <= 64)
+  {
+    if constexpr (S) {
+      return int64_t(v[0] << (64 - W)) >> (64 - W);
+    } else {
+      return integer(v[0]);
+    }
+  }
+
+  template <typename T> ap_int_base &operator+=(const T &x) {
+    return *this = ap_int_base(value() + x);
+  }
+  template <typename T> ap_int_base &operator-=(const T &x) {
+    return *this = ap_int_base(value() - x);
+  }
+  template <typename T> ap_int_base &operator*=(const T &x) {
+    return *this = ap_int_base(value() * x);
+  }
+  ap_int_base &operator++() { return *this += 1; }
+  ap_int_base &operator--() { return *this -= 1; }
+  ap_int_base operator++(int) {
+    ap_int_base old = *this;
+    *this += 1;
+    return old;
+  }
+  ap_int_base operator--(int) {
+    ap_int_base old = *this;
+    *this -= 1;
+    return old;
+  }
+
+  ap_range_ref<ap_int_base> range(int hi, int lo) { return {*this, hi, lo}; }
+  ap_range_ref<const ap_int_base> range(int hi, int lo) const {
+    return {*this, hi, lo};
+  }
+  ap_range_ref<ap_int_base> range() { return {*this, W - 1, 0}; }
+  ap_range_ref<const ap_int_base> range() const { return {*this, W - 1, 0}; }
+
+  // Narrower values compare through the integer conversion
+  bool operator==(const ap_int_base &o) const
+    requires(W > 64)
+  {
+    for (int i = 0; i < N; i++) {
+      if (v[i] != o.v[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  uint64_t word(int i) const { return v[i]; }
+
+  uint64_t get_bits(int lo, int len) const {
+    uint64_t x = v[lo / 64] >> (lo % 64);
+    if (lo % 64 != 0 && lo / 64 + 1 < N) {
+      x |= v[lo / 64 + 1] << (64 - lo % 64);
+    }
+    return len == 64 ? x : x & ((uint64_t(1) << len) - 1);
+  }
+
+  void set_bits(int lo, int len, uint64_t x) {
+    uint64_t mask = len == 64 ? ~uint64_t(0) : (uint64_t(1) << len) - 1;
+    x &= mask;
+    v[lo / 64] = (v[lo / 64] & ~(mask << (lo % 64))) | (x << (lo % 64));
+    if (lo % 64 != 0 && lo % 64 + len > 64) {
+      int shift = 64 - lo % 64;
+      v[lo / 64 + 1] = (v[lo / 64 + 1] & ~(mask >> shift)) | (x >> shift);
+    }
+    normalise();
+  }
+
+private:
+  integer value() const { return static_cast<integer>(*this); }
+
+  // Clears the bits above W
+  void normalise() {
+    if (W % 64 != 0) {
+      v[N - 1] &= (uint64_t(1) << (W % 64)) - 1;
+    }
+  }
+
+  uint64_t v[N];
+};
+
+template <int W> using ap_int = ap_int_base<W, true>;
+template <int W> using ap_uint = ap_int_base<W, false>;
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Minimal stand-in for the Vitis HLS hls_stream.h, see ap_int.h.
+//
+// An unbounded FIFO, as in C simulation: the functions of a dataflow region
+// run one after the other, so every stream has to hold a whole frame.
+// Reading an empty stream is a bug in the kernel and aborts.
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+
+namespace hls {
+
+template <typename T> class stream {
+public:
+  stream() : name("stream") {}
+  explicit stream(const char *name) : name(name) {}
+  stream(const stream &) = delete;
+  stream &operator=(const stream &) = delete;
+
+  T read() {
+    if (q.empty()) {
+      std::fprintf(stderr, "hls::stream '%s' read while empty\n",
+                   name.c_str());
+      std::abort();
+    }
+    T x = q.front();
+    q.pop_front();
+    return x;
+  }
+  void read(T &x) { x = read(); }
+  bool read_nb(T &x) {
+    if (q.empty()) {
+      return false;
+    }
+    x = read();
+    return true;
+  }
+  void operator>>(T &x) { x = read(); }
+
+  void write(const T &x) { q.push_back(x); }
+  bool write_nb(const T &x) {
+    write(x);
+    return true;
+  }
+  void operator<<(const T &x) { write(x); }
+
+  bool empty() const { return q.empty(); }
+  bool full() const { return false; }
+  size_t size() const { return q.size(); }
+
+private:
+  std::deque<T> q;
+  std::string name;
+};
+
+} // namespace hls
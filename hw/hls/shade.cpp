@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Intersection and shading kernel, a dataflow pipeline like main.cpp:
+//
+//   recv_config -> generate_rays -> intersect -> shade
+//        \______________________________/
+//
+// intersect is pipelined at II=1 per (pixel, group of SPHERES_PER_CLOCK
+// spheres) and keeps the nearest hit. shade then takes one pixel per clock:
+// the normal of the nearest sphere, or the sky gradient on a miss, with
+// gamma 2 applied on the way to 8 bits.
+
+#include <cstdint>
+#include <hls_stream.h>
+
+#include "main.hpp"
+#include "math/fixed.hpp"
+#include "math/ray.hpp"
+#include "math/vec3.hpp"
+#include "shade.hpp"
+#include "state.hpp"
+
+static_assert(MAX_SPHERES % SPHERES_PER_CLOCK == 0,
+              "SPHERES_PER_CLOCK must divide MAX_SPHERES");
+
+// Wide enough for the discriminant, which squares dot products
+typedef ap_fixed<48, 32> wfp;
+
+struct sphere {
+  vec3<sfp> center;
+  sfp radius2;
+  sfp inv_radius;
+};
+
+// Nearest hit of a ray. With a = dot(d, d), the hit is at t = num / a; a is
+// the same for every sphere, so hits are ordered by num alone.
+struct hit {
+  ray<sfp> r;
+  sfp a;
+  sfp num;
+  bool valid;
+  vec3<sfp> center;
+  sfp inv_radius;
+};
+
+static struct sphere make_sphere(const sfp words[SPHERE_WORDS]) {
+  struct sphere s;
+  s.center = vec3<sfp>(words[0], words[1], words[2]);
+  s.radius2 = words[3] * words[3];
+  s.inv_radius = div_fixed(sfp(1), words[3]);
+  return s;
+}
+
+// Receives the camera, then the spheres into the sphere memory
+static void recv_config(hls::stream<pkt> &A, hls::stream<state> &ray_cfg,
+                        struct sphere spheres[MAX_SPHERES],
+                        hls::stream<ap_uint<8>> &sphere_count) {
+  union cam_u cam;
+  pkt tmp;
+
+recv_loop:
+  for (int i = 0; i < CAMERA_STRUCT_LEN; i++) {
+#pragma HLS pipeline II = 1
+    A.read(tmp);
+    cam.buf[i] = tmp.data;
+  }
+  ray_cfg.write(convert(cam.cam));
+
+  A.read(tmp);
+  u32 words = tmp.data;
+
+  sfp fields[SPHERE_WORDS];
+#pragma HLS array_partition variable = fields complete
+  ap_uint<8> n = 0;
+  ap_uint<2> field = 0;
+sphere_loop:
+  for (u32 i = 0; i < words; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS loop_tripcount min = 0 max = 64
+    A.read(tmp);
+    RAW_2_FIXED(tmp.data, fields[field]);
+    if (field == SPHERE_WORDS - 1) {
+      if (n < MAX_SPHERES) {
+        spheres[n] = make_sphere(fields);
+        n++;
+      }
+      field = 0;
+    } else {
+      field++;
+    }
+  }
+  sphere_count.write(n);
+}
+
+// One ray per pixel in raster order
+static void generate_rays(hls::stream<state> &cfg,
+                          hls::stream<ap_uint<30>> &count,
+                          hls::stream<ray<sfp>> &rays) {
+  struct state s = cfg.read();
+  ap_uint<30> n = pixel_count(s);
+  count.write(n);
+
+  ap_uint<15> w = 0;
+  ap_uint<15> h = 0;
+ray_loop:
+  for (ap_uint<30> i = 0; i < n; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS loop_tripcount min = 1 max = 921600
+    auto pixel_center = s.pixel_00_loc + (sfp(w) * s.pixel_delta_u) +
+                        (sfp(h) * s.pixel_delta_v);
+    rays.write(ray<sfp>(s.camera_center, pixel_center - s.camera_center));
+
+    if (w == s.image_width - 1) {
+      w = 0;
+      h++;
+    } else {
+      w++;
+    }
+  }
+}
+
+static void intersect(struct sphere spheres[MAX_SPHERES],
+                      hls::stream<ap_uint<8>> &sphere_count,
+                      hls::stream<ap_uint<30>> &count_in,
+                      hls::stream<ray<sfp>> &rays,
+                      hls::stream<ap_uint<30>> &count_out,
+                      hls::stream<hit> &hits) {
+  ap_uint<8> n_spheres = sphere_count.read();
+  ap_uint<30> n = count_in.read();
+  count_out.write(n);
+
+  // Groups of spheres per pixel; a pixel takes one clock without spheres
+  ap_uint<8> groups = (n_spheres + (SPHERES_PER_CLOCK - 1)) / SPHERES_PER_CLOCK;
+  if (groups == 0) {
+    groups = 1;
+  }
+  ap_uint<36> steps = ap_uint<36>(n) * groups;
+
+  // The pixel and group loops are flattened, so that the pipeline does not
+  // drain between pixels
+  ap_uint<8> g = 0;
+  struct hit best;
+intersect_loop:
+  for (ap_uint<36> i = 0; i < steps; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS loop_tripcount min = 1 max = 7372800
+    if (g == 0) {
+      best.r = rays.read();
+      best.a = dot(best.r.direction(), best.r.direction());
+      best.valid = false;
+    }
+    const vec3<sfp> &d = best.r.direction();
+
+    for (int k = 0; k < SPHERES_PER_CLOCK; k++) {
+#pragma HLS unroll
+      ap_uint<8> index = g * SPHERES_PER_CLOCK + k;
+      struct sphere s = spheres[index];
+
+      vec3<sfp> oc = s.center - best.r.origin();
+      sfp h = dot(d, oc);
+      sfp c = dot(oc, oc) - s.radius2;
+      wfp discriminant = h * h - best.a * c;
+      if (index < n_spheres && discriminant >= 0) {
+        sfp num = h - sfp(sqrt_fixed(discriminant));
+        if (num > 0 && (!best.valid || num < best.num)) {
+          best.num = num;
+          best.valid = true;
+          best.center = s.center;
+          best.inv_radius = s.inv_radius;
+        }
+      }
+    }
+
+    if (g == groups - 1) {
+      hits.write(best);
+      g = 0;
+    } else {
+      g++;
+    }
+  }
+}
+
+// Gamma 2 of a colour in [0, 1], scaled to 8 bits
+static ap_uint<8> gamma_8(sfp x) {
+  ap_uint<16> linear;
+  if (x < 0) {
+    linear = 0;
+  } else if (x >= 1) {
+    linear = 0xffff;
+  } else {
+    linear.range() = x.range(15, 0);
+  }
+  return isqrt<16>(linear);
+}
+
+static void shade(hls::stream<ap_uint<30>> &count, hls::stream<hit> &hits,
+                  hls::stream<pkt> &B) {
+  ap_uint<30> n = count.read();
+
+  const vec3<sfp> white(1, 1, 1);
+  const vec3<sfp> blue(sfp(0.5), sfp(0.7), sfp(1.0));
+
+shade_loop:
+  for (ap_uint<30> i = 0; i < n; i++) {
+#pragma HLS pipeline II = 1
+#pragma HLS loop_tripcount min = 1 max = 921600
+    struct hit nearest = hits.read();
+    const vec3<sfp> &d = nearest.r.direction();
+
+    vec3<sfp> color;
+    if (nearest.valid) {
+      sfp t = div_fixed(nearest.num, nearest.a);
+      vec3<sfp> p = nearest.r.origin() + t * d;
+      vec3<sfp> normal = (p - nearest.center) * nearest.inv_radius;
+      color = sfp(0.5) * (normal + white);
+    } else {
+      sfp unit_y = div_fixed(d.y(), sqrt_fixed(nearest.a));
+      sfp s = sfp(0.5) * (unit_y + 1);
+      color = sfp(1 - s) * white + s * blue;
+    }
+
+    pkt tmp;
+    tmp.data.range(23, 16) = gamma_8(color.x());
+    tmp.data.range(15, 8) = gamma_8(color.y());
+    tmp.data.range(7, 0) = gamma_8(color.z());
+    tmp.data.range(31, 24) = 0;
+    tmp.last = i == n - 1;
+    B.write(tmp);
+  }
+}
+
+void myip_shade_HLS(hls::stream<pkt> &A, hls::stream<pkt> &B) {
+#pragma HLS INTERFACE ap_ctrl_none port = return
+#pragma HLS INTERFACE axis port = A
+#pragma HLS INTERFACE axis port = B
+#pragma HLS dataflow
+
+  struct sphere spheres[MAX_SPHERES];
+#pragma HLS array_partition variable = spheres cyclic factor =                \
+    SPHERES_PER_CLOCK
+
+  hls::stream<state> ray_cfg("ray_cfg");
+  hls::stream<ap_uint<8>> sphere_count("sphere_count");
+  hls::stream<ap_uint<30>> ray_count("ray_count");
+  hls::stream<ap_uint<30>> hit_count("hit_count");
+  hls::stream<ray<sfp>> rays("rays");
+  hls::stream<hit> hits("hits");
+#pragma HLS stream variable = ray_cfg depth = 2
+#pragma HLS stream variable = sphere_count depth = 2
+#pragma HLS stream variable = ray_count depth = 2
+#pragma HLS stream variable = hit_count depth = 2
+#pragma HLS stream variable = rays depth = 4
+#pragma HLS stream variable = hits depth = 4
+
+  recv_config(A, ray_cfg, spheres, sphere_count);
+  generate_rays(ray_cfg, ray_count, rays);
+  intersect(spheres, sphere_count, ray_count, rays, hit_count, hits);
+  shade(hit_count, hits, B);
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Second top-level: intersects the camera rays with a list of spheres and
+// streams shaded pixels, one 0x00RRGGBB word per pixel, like the
+// framebuffer format of the coprocessor.
+//
+// The configuration packet is the camera, then a header with the number of
+// sphere words, then four 16.16 words per sphere: centre x, y, z and
+// radius. tlast is set on the last word. Spheres beyond MAX_SPHERES are
+// dropped. Dot products are computed in sfp, so centres must lie within 128
+// of the camera and radii below 128.
+
+#pragma once
+
+#include "main.hpp"
+
+// Spheres held by the kernel
+#ifndef MAX_SPHERES
+#define MAX_SPHERES 16
+#endif
+
+// Spheres tested per clock, which must divide MAX_SPHERES. A pixel takes
+// ceil(spheres / SPHERES_PER_CLOCK) clocks.
+#ifndef SPHERES_PER_CLOCK
+#define SPHERES_PER_CLOCK 2
+#endif
+
+#define SPHERE_WORDS 4
+
+void myip_shade_HLS(hls::stream<pkt> &S_AXIS, hls::stream<pkt> &M_AXIS);
@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <stdio.h>
+#include <vector>
+
+#include <hls_stream.h>
+
+#include "main.hpp"
+#include "shade.hpp"
+
+#include "camera.hpp"
+#include "scene.hpp"
+
+#define EXPECT_TRUE(cond)                                                      \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      std::cerr << "EXPECT_TRUE failed: " << #cond << "\n";                    \
+      std::exit(EXIT_FAILURE);                                                 \
+    }                                                                          \
+  } while (0)
+
+struct ball {
+  vec3<float> center;
+  float radius;
+};
+
+static uint32_t gamma_8(float x) {
+  x = std::clamp(x, 0.0f, 65535.0f / 65536.0f);
+  return uint32_t(std::sqrt(x) * 256.0f);
+}
+
+// The kernel in float: nearest sphere in front of the camera, shaded by its
+// normal, or the sky
+static uint32_t reference(const scene &s, const std::vector<ball> &balls,
+                          int x, int y) {
+  vec3<float> o = s.camera_center;
+  vec3<float> d = s.pixel_00_loc + (float(x) * s.pixel_delta_u) +
+                  (float(y) * s.pixel_delta_v) - o;
+  float a = dot(d, d);
+
+  const ball *nearest = nullptr;
+  float best = 0;
+  for (size_t i = 0; i < balls.size() && i < MAX_SPHERES; i++) {
+    vec3<float> oc = balls[i].center - o;
+    float h = dot(d, oc);
+    float c = dot(oc, oc) - balls[i].radius * balls[i].radius;
+    float discriminant = h * h - a * c;
+    if (discriminant < 0) {
+      continue;
+    }
+    float num = h - std::sqrt(discriminant);
+    if (num > 0 && (!nearest || num < best)) {
+      nearest = &balls[i];
+      best = num;
+    }
+  }
+
+  vec3<float> color;
+  if (nearest) {
+    vec3<float> p = o + (best / a) * d;
+    vec3<float> normal = (p - nearest->center) / nearest->radius;
+    color = 0.5f * (normal + vec3<float>(1, 1, 1));
+  } else {
+    float t = 0.5f * (d.y() / std::sqrt(a) + 1.0f);
+    color = (1.0f - t) * vec3<float>(1, 1, 1) + t * vec3<float>(0.5, 0.7, 1.0);
+  }
+  return gamma_8(color.x()) << 16 | gamma_8(color.y()) << 8 |
+         gamma_8(color.z());
+}
+
+// Renders one frame and compares it with the float reference. Channels may
+// differ by a few steps from the truncation of the 16.16 arithmetic, and
+// pixels on the silhouettes of the spheres may flip between hit and miss.
+static void run_frame(int image_width, float aspect_ratio,
+                      const std::vector<ball> &balls) {
+  hls::stream<pkt> S_AXIS;
+  hls::stream<pkt> M_AXIS;
+
+  scene s(image_width, aspect_ratio, 1.0);
+  int image_height = s.image_height;
+  int dim = image_width * image_height;
+
+  std::vector<uint32_t> config;
+  uint32_t *cam_buffer = s.serialised();
+  config.insert(config.end(), cam_buffer, cam_buffer + CAMERA_STRUCT_LEN);
+  config.push_back(SPHERE_WORDS * balls.size());
+  for (const ball &b : balls) {
+    config.push_back(FLOAT_2_FIX(b.center.x()));
+    config.push_back(FLOAT_2_FIX(b.center.y()));
+    config.push_back(FLOAT_2_FIX(b.center.z()));
+    config.push_back(FLOAT_2_FIX(b.radius));
+  }
+
+  for (size_t i = 0; i < config.size(); i++) {
+    pkt tmp;
+    tmp.data = config[i];
+    tmp.last = i == config.size() - 1;
+    S_AXIS.write(tmp);
+  }
+
+  std::cout << "Invoke shading kernel (" << image_width << "x" << image_height
+            << ", " << balls.size() << " spheres, " << SPHERES_PER_CLOCK
+            << " per clock)" << std::endl;
+  myip_shade_HLS(S_AXIS, M_AXIS);
+
+  int off = 0;
+  for (int i = 0; i < dim; i++) {
+    EXPECT_TRUE(!M_AXIS.empty());
+    pkt tmp = M_AXIS.read();
+    EXPECT_TRUE(bool(tmp.last) == (i == dim - 1));
+
+    uint32_t actual = uint32_t(tmp.data);
+    uint32_t expected = reference(s, balls, i % image_width, i / image_width);
+    EXPECT_TRUE(actual >> 24 == 0);
+    for (int c = 0; c < 24; c += 8) {
+      int delta = int((actual >> c) & 0xff) - int((expected >> c) & 0xff);
+      if (std::abs(delta) > 3) {
+        off += 1;
+        break;
+      }
+    }
+  }
+  EXPECT_TRUE(M_AXIS.empty());
+
+  std::cout << " " << off << " of " << dim << " pixels off" << std::endl;
+  EXPECT_TRUE(off <= dim / 100);
+}
+
+int main() {
+  // The usual sphere on the ground, with two more beside it and one behind
+  std::vector<ball> balls = {
+      {vec3<float>(0, -100.5, -1), 100},
+      {vec3<float>(0, 0, -1), 0.5},
+      {vec3<float>(-1, 0, -1.2), 0.5},
+      {vec3<float>(1, 0, -1.2), 0.5},
+      {vec3<float>(0.3, 0.6, -2.5), 0.4},
+  };
+
+  run_frame(5, 1.0, balls);
+  run_frame(64, 16.0 / 9.0, {});
+  run_frame(64, 16.0 / 9.0, {balls[1]});
+  run_frame(160, 16.0 / 9.0, balls);
+
+  // More spheres than the kernel holds: the rest are dropped
+  std::vector<ball> many;
+  for (int i = 0; i < MAX_SPHERES + 3; i++) {
+    many.push_back({vec3<float>(-2 + 0.25f * i, 0.3f * (i % 3) - 0.3f, -2),
+                    0.2});
+  }
+  run_frame(96, 2.0, many);
+
+  std::cout << "Test passed" << std::endl;
+  return 0;
+}
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// The camera as the kernels use it, converted once per frame from the
+// 16.16 words of the configuration packet
+
+#pragma once
+
+#include <cstdint>
+
+#include "camera.hpp"
+#include "main.hpp"
+#include "math/vec3.hpp"
+
+union cam_u {
+  struct camera cam;
+  uint32_t buf[CAMERA_STRUCT_LEN];
+};
+
+struct state {
+  ap_uint<15> image_width;
+  ap_uint<15> image_height;
+  vec3<sfp> pixel_00_loc;
+  vec3<sfp> pixel_delta_u;
+  vec3<sfp> pixel_delta_v;
+  vec3<sfp> camera_center;
+};
+
+inline struct state convert(struct camera &cam) {
+  struct state s;
+
+  sfp pixel_00_loc_fp[3], pixel_delta_u_fp[3], pixel_delta_v_fp[3],
+      camera_center_fp[3];
+  sfp image_width, image_height;
+
+  ap_int<32> tmp_image_width = cam.image_width;
+  ap_int<32> tmp_image_height = cam.image_height;
+
+  RAW_2_FIXED_V(cam.pixel_00_loc, pixel_00_loc_fp);
+  RAW_2_FIXED_V(cam.pixel_delta_u, pixel_delta_u_fp);
+  RAW_2_FIXED_V(cam.pixel_delta_v, pixel_delta_v_fp);
+  RAW_2_FIXED_V(cam.camera_center, camera_center_fp);
+  RAW_2_FIXED(tmp_image_width, image_width);
+  RAW_2_FIXED(tmp_image_height, image_height);
+
+  s.image_width = image_width;
+  s.image_height = image_height;
+
+  s.pixel_00_loc = vec3<sfp>(pixel_00_loc_fp);
+  s.pixel_delta_u = vec3<sfp>(pixel_delta_u_fp);
+  s.pixel_delta_v = vec3<sfp>(pixel_delta_v_fp);
+  s.camera_center = vec3<sfp>(camera_center_fp);
+
+  return s;
+}
+
+inline ap_uint<30> pixel_count(const struct state &s) {
+  return ap_uint<30>(s.image_width) * ap_uint<30>(s.image_height);
+}
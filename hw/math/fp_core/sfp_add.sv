@@ -6,7 +6,8 @@
 
 // Addition of sfp signals followed by resizing (equivalant to sfp_add_full + sfp_resize_ind)
 module sfp_add #(
-    parameter CLIP = 1  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter CLIP = 1,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
 ) (
            sfp_if.in  in1,
            sfp_if.in  in2,      // input sfp signal
@@ -26,7 +27,8 @@ module sfp_add #(
       .out(sum)
   );
   sfp_resize #(
-      .clip(CLIP)
+      .clip(CLIP),
+      .ROUND(ROUND)
   ) u_resize (
       .in(sum),
       .out(out),
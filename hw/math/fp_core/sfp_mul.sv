@@ -1,22 +1,90 @@
+// Multiplication of sfp signals followed by resizing
+//
+// DSP = 1 narrows the operands to the native DSP48E2 multiplier before the
+// product is formed: x to DSP_X_IW.(27 - DSP_X_IW) and y to
+// DSP_Y_IW.(18 - DSP_Y_IW). The product then fits a single 27x18 slice
+// instead of the ceil(x.WL / 26) * ceil(y.WL / 17) slices of the full
+// product (4 for 16.16 x 16.16).
+//
+// Narrowing truncates (see ROUND) fractional LSBs and saturates integer MSBs.
+// Without saturation the product is off by less than
+//   |y| * 2^-(27 - DSP_X_IW) + |x| * 2^-(18 - DSP_Y_IW)
+//   + 2^-(45 - DSP_X_IW - DSP_Y_IW)
+// before the final resize, or half of the first two terms with ROUND != 0.
+// It is exact whenever neither operand has bits outside its narrow format,
+// e.g. pixel deltas in 11.16 times integer pixel coordinates in 16.2.
 module sfp_mul #(
-    parameter int CLIP = 0  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int CLIP = 0,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0,  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
+    parameter int DSP = 0,  // 0 = full product, 1 = DSP48E2 27x18 product
+    parameter int DSP_X_IW = 11,  // Integer bits of x kept for the A port
+    parameter int DSP_Y_IW = 16  // Integer bits of y kept for the B port
 ) (
            sfp_if.in  x,
            sfp_if.in  y,
            sfp_if.out out,
     output            clipping  // clipping indicator (active-high)
 );
-  // Output must have the correct iw/qw for a full width operation
-  sfp_if #(
-      .IW(x.IW + y.IW),
-      .QW(x.QW + y.QW)
-  ) prod_fp ();
-  assign prod_fp.val = x.val * y.val;
-  sfp_resize #(
-      .clip(CLIP)
-  ) u_resize (
-      .in(prod_fp),
-      .out(out),
-      .clipping(clipping)
-  );
+  localparam int DSP_A_WIDTH = 27;
+  localparam int DSP_B_WIDTH = 18;
+
+  if (DSP) begin : gen_dsp
+    sfp_if #(
+        .IW(DSP_X_IW),
+        .QW(DSP_A_WIDTH - DSP_X_IW)
+    ) x_narrow ();
+    sfp_if #(
+        .IW(DSP_Y_IW),
+        .QW(DSP_B_WIDTH - DSP_Y_IW)
+    ) y_narrow ();
+    logic x_clipping, y_clipping, out_clipping;
+
+    sfp_resize #(
+        .clip(1),
+        .ROUND(ROUND)
+    ) u_narrow_x (
+        .in(x),
+        .out(x_narrow),
+        .clipping(x_clipping)
+    );
+    sfp_resize #(
+        .clip(1),
+        .ROUND(ROUND)
+    ) u_narrow_y (
+        .in(y),
+        .out(y_narrow),
+        .clipping(y_clipping)
+    );
+
+    sfp_if #(
+        .IW(DSP_X_IW + DSP_Y_IW),
+        .QW(DSP_A_WIDTH + DSP_B_WIDTH - DSP_X_IW - DSP_Y_IW)
+    ) prod_fp ();
+    assign prod_fp.val = x_narrow.val * y_narrow.val;
+    sfp_resize #(
+        .clip(CLIP),
+        .ROUND(ROUND)
+    ) u_resize (
+        .in(prod_fp),
+        .out(out),
+        .clipping(out_clipping)
+    );
+
+    assign clipping = x_clipping || y_clipping || out_clipping;
+  end else begin : gen_full
+    // Output must have the correct iw/qw for a full width operation
+    sfp_if #(
+        .IW(x.IW + y.IW),
+        .QW(x.QW + y.QW)
+    ) prod_fp ();
+    assign prod_fp.val = x.val * y.val;
+    sfp_resize #(
+        .clip(CLIP),
+        .ROUND(ROUND)
+    ) u_resize (
+        .in(prod_fp),
+        .out(out),
+        .clipping(clipping)
+    );
+  end
 endmodule
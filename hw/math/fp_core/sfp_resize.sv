@@ -3,33 +3,55 @@
 // Copyright (c) 2025 Hugo Melder
 
 // Change the # of int/frac bits of a sfp signal (with a clipping indicator)
-// - Decreasing # frac bits: truncates LSBs (floor toward -inf)
+// - Decreasing # frac bits: truncates LSBs (floor toward -inf), or rounds to
+//   nearest depending on 'ROUND'. Rounding adds one integer bit before the
+//   integer bits are resized, so a carry out of the MSB clips or wraps.
 // - Increasing # frac bits: pads zero LSBs
 // - Decreasing # int  bits: clips or drops MSBs depending on 'clip' parameter
 // - Increasing # int  bits: pads zero MSBs (ufp) or sign-extends (sfp)
 module sfp_resize #(
-    clip = 1  // (if reducing iw) 0 = wrap, 1 = clip
+    clip  = 1,  // (if reducing iw) 0 = wrap, 1 = clip
+    ROUND = 0   // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
 ) (
            sfp_if.in  in,       // input sfp signal
            sfp_if.out out,      // output sfp signal
     output            clipping  // clipping indicator (active-high)
 );
 
-  localparam iniw = in.IW;
+  localparam int drop = int'(in.QW) - int'(out.QW);
+  localparam rounding = (ROUND != 0) && (drop > 0);
+
+  localparam iniw = rounding ? in.IW + 1 : in.IW;
   localparam inqw = in.QW;
-  localparam inw = in.WL;
+  localparam inw = iniw + inqw;
   localparam outiw = out.IW;
   localparam outqw = out.QW;
   localparam outw = out.WL;
 
+  // Rounding adds half an output LSB (less one input LSB if the LSB that is
+  // kept is even, so that ties stay even) and lets the truncation below
+  // floor the sum
+  logic signed [inw-1:0] in_val;
+  if (rounding) begin : gen_round
+    logic [inw-1:0] half;
+    if (ROUND == 2) begin : gen_half_even
+      assign half = (inw'(1) << (drop - 1)) - inw'(1) + inw'(in.val[drop]);
+    end else begin : gen_half_up
+      assign half = inw'(1) << (drop - 1);
+    end
+    assign in_val = inw'($signed(in.val)) + half;
+  end else begin : gen_truncate
+    assign in_val = in.val;
+  end
+
   localparam tmp1w = iniw + outqw;
   localparam tmp2w = outiw + inqw;
 
   if (tmp1w > 1) begin : gen_case1
     logic signed [tmp1w-1:0] tmp1;
     // first handle the franctional bits by truncating LSBs or padding zeros
-    if (inqw >= outqw) assign tmp1 = $signed(in.val[inw-1-:tmp1w]);
-    else assign tmp1 = $signed({in.val, (outqw - inqw)'('b0)});
+    if (inqw >= outqw) assign tmp1 = $signed(in_val[inw-1-:tmp1w]);
+    else assign tmp1 = $signed({in_val, (outqw - inqw)'('b0)});
     // then handle the integer bits by clipping / discarding MSBs (may causing wrapping!), or sign extending MSBs
     if (iniw > outiw) begin
       if (clip) begin
@@ -58,16 +80,16 @@ module sfp_resize #(
             .inw (inw),
             .outw(tmp2w)
         ) u_clip (
-            .in(in.val),
+            .in(in_val),
             .out(tmp2),
             .clipping(clipping)
         );
       end else begin
-        assign tmp2 = $signed(in.val[tmp2w-1:0]);
+        assign tmp2 = $signed(in_val[tmp2w-1:0]);
         assign clipping = 1'b0;
       end
     end else begin
-      assign tmp2 = tmp2w'(in.val);
+      assign tmp2 = tmp2w'(in_val);
       assign clipping = 1'b0;
     end
     // then handle the franctional bits by truncating LSBs or padding zeros
@@ -6,7 +6,8 @@
 
 // Subtraction of sfp signals followed by resizing (equivalant to sfp_sub_full + sfp_resize_ind)
 module sfp_sub #(
-    parameter CLIP = 1  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter CLIP = 1,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
 ) (
            sfp_if.in  in1,
     in2,  // input sfp signal
@@ -26,7 +27,8 @@ module sfp_sub #(
       .out(sub)
   );
   sfp_resize #(
-      .clip(CLIP)
+      .clip(CLIP),
+      .ROUND(ROUND)
   ) u_resize (
       .in(sub),
       .out(out),
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+
+#include <cstdint>
+#include <memory>
+
+#include "Vresize_round_wrapper.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+class ResizeRoundTest : public testing::Test {};
+
+// Drop two fractional bits of v, wrap to six bits
+static uint8_t reference(int v, int round) {
+  int half = 0;
+  if (round == 1) {
+    half = 2;
+  } else if (round == 2) {
+    half = 1 + ((v >> 2) & 1);
+  }
+  return uint8_t((v + half) >> 2) & 0x3f;
+}
+
+TEST_F(ResizeRoundTest, Ties) {
+  std::unique_ptr<Vresize_round_wrapper> dut =
+      std::make_unique<Vresize_round_wrapper>();
+
+  dut->in = 0x06; // 0.375
+  dut->eval();
+  EXPECT_EQ(dut->out_trunc, 0x01);     // 0.25
+  EXPECT_EQ(dut->out_half_up, 0x02);   // 0.5
+  EXPECT_EQ(dut->out_half_even, 0x02); // 0.5
+
+  dut->in = 0x02; // 0.125
+  dut->eval();
+  EXPECT_EQ(dut->out_trunc, 0x00);
+  EXPECT_EQ(dut->out_half_up, 0x01);   // 0.25
+  EXPECT_EQ(dut->out_half_even, 0x00); // 0.0
+
+  dut->in = 0xfa; // -0.375
+  dut->eval();
+  EXPECT_EQ(dut->out_trunc, 0x3e);     // -0.5
+  EXPECT_EQ(dut->out_half_up, 0x3f);   // -0.25
+  EXPECT_EQ(dut->out_half_even, 0x3e); // -0.5
+}
+
+TEST_F(ResizeRoundTest, CarryOutOfTheMsb) {
+  std::unique_ptr<Vresize_round_wrapper> dut =
+      std::make_unique<Vresize_round_wrapper>();
+
+  dut->in = 0x7f; // 7.9375
+  dut->eval();
+  EXPECT_EQ(dut->out_trunc, 0x1f);     // 7.75
+  EXPECT_EQ(dut->out_half_up, 0x20);   // Wraps to -8.0
+  EXPECT_EQ(dut->clipping_half_up, 1); // Clipped to 7.75
+}
+
+TEST_F(ResizeRoundTest, Exhaustive) {
+  std::unique_ptr<Vresize_round_wrapper> dut =
+      std::make_unique<Vresize_round_wrapper>();
+
+  for (int v = 0; v < 256; v++) {
+    int s = int8_t(v);
+    dut->in = v;
+    dut->eval();
+    ASSERT_EQ(dut->out_trunc, reference(s, 0)) << v;
+    ASSERT_EQ(dut->out_half_up, reference(s, 1)) << v;
+    ASSERT_EQ(dut->out_half_even, reference(s, 2)) << v;
+    ASSERT_EQ(dut->out_unsigned_half_even, reference(v, 2)) << v;
+  }
+}
+
+} // namespace
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// 4.4 to 4.2 with every rounding mode, wrapping on a carry out of the MSB
+module resize_round_wrapper (
+    input  logic [7:0] in,
+    output logic [5:0] out_trunc,
+    output logic [5:0] out_half_up,
+    output logic [5:0] out_half_even,
+    output logic [5:0] out_unsigned_half_even,
+    output logic       clipping_half_up          // Clipped variant of out_half_up
+);
+
+  sfp_if #(
+      .IW(4),
+      .QW(4)
+  ) in_if ();
+  sfp_if #(
+      .IW(4),
+      .QW(2)
+  ) out_if[4] ();
+  ufp_if #(
+      .IW(4),
+      .QW(4)
+  ) in_unsigned_if ();
+  ufp_if #(
+      .IW(4),
+      .QW(2)
+  ) out_unsigned_if ();
+
+  assign in_if.val = in;
+  assign in_unsigned_if.val = in;
+
+  genvar i;
+  generate
+    for (i = 0; i < 3; i++) begin : gen_round
+      sfp_resize #(
+          .clip (0),
+          .ROUND(i)
+      ) u_resize (
+          .in(in_if),
+          .out(out_if[i]),
+          .clipping()
+      );
+    end
+  endgenerate
+
+  sfp_resize #(
+      .clip (1),
+      .ROUND(1)
+  ) u_resize_clipped (
+      .in(in_if),
+      .out(out_if[3]),
+      .clipping(clipping_half_up)
+  );
+
+  ufp_resize #(
+      .clip (0),
+      .ROUND(2)
+  ) u_resize_unsigned (
+      .in(in_unsigned_if),
+      .out(out_unsigned_if),
+      .clipping()
+  );
+
+  assign out_trunc = out_if[0].val;
+  assign out_half_up = out_if[1].val;
+  assign out_half_even = out_if[2].val;
+  assign out_unsigned_half_even = out_unsigned_if.val;
+
+endmodule
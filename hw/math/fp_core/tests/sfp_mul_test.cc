@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+
+#include "Vsfp_mul_wrapper.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+class SfpMulTest : public testing::Test {};
+
+static double to_double(uint32_t v) { return double(int32_t(v)) / 65536.0; }
+
+TEST_F(SfpMulTest, Basic) {
+  std::unique_ptr<Vsfp_mul_wrapper> dut = std::make_unique<Vsfp_mul_wrapper>();
+
+  dut->x = 0xffff8000; // -0.5
+  dut->y = 0x00030000; // 3.0
+  dut->eval();
+
+  EXPECT_EQ(dut->out_full, 0xfffe8000); // -1.5
+  EXPECT_EQ(dut->out_dsp, 0xfffe8000);
+  EXPECT_EQ(dut->clipping_dsp, 0);
+}
+
+// Pixel deltas times integer pixel coordinates, as in rt_rgu_5_stage
+TEST_F(SfpMulTest, DspExactInNarrowFormat) {
+  std::unique_ptr<Vsfp_mul_wrapper> dut = std::make_unique<Vsfp_mul_wrapper>();
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int32_t> delta(-(1 << 26), (1 << 26) - 1);
+  std::uniform_int_distribution<int32_t> coordinate(0, (1 << 15) - 1);
+
+  for (int i = 0; i < 10000; i++) {
+    dut->x = uint32_t(delta(rng));
+    dut->y = uint32_t(coordinate(rng)) << 16;
+    dut->eval();
+    ASSERT_EQ(dut->out_dsp, dut->out_full)
+        << std::hex << dut->x << " " << dut->y;
+    ASSERT_EQ(dut->clipping_dsp, 0);
+  }
+}
+
+// y loses 14 fractional bits, x none (see the error bound in sfp_mul)
+TEST_F(SfpMulTest, DspErrorBound) {
+  std::unique_ptr<Vsfp_mul_wrapper> dut = std::make_unique<Vsfp_mul_wrapper>();
+  std::mt19937 rng(6);
+  std::uniform_int_distribution<int32_t> value(-(1 << 22), (1 << 22) - 1);
+
+  for (int i = 0; i < 10000; i++) {
+    dut->x = uint32_t(value(rng));
+    dut->y = uint32_t(value(rng));
+    dut->eval();
+
+    double x = to_double(dut->x);
+    double bound = std::fabs(x) * std::ldexp(1.0, -2) + std::ldexp(1.0, -15);
+    ASSERT_LE(std::fabs(to_double(dut->out_dsp) - to_double(dut->out_full)),
+              bound);
+  }
+}
+
+// Operands outside the narrow format saturate
+TEST_F(SfpMulTest, DspClipping) {
+  std::unique_ptr<Vsfp_mul_wrapper> dut = std::make_unique<Vsfp_mul_wrapper>();
+
+  dut->x = 0x07d00000; // 2000.0 does not fit 11.16
+  dut->y = 0x00010000; // 1.0
+  dut->eval();
+
+  EXPECT_EQ(dut->clipping_dsp, 1);
+  EXPECT_EQ(dut->out_dsp, 0x03ffffff); // 1023.99998
+}
+
+} // namespace
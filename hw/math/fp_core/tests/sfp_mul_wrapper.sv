@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// 16.16 products with the full multiplier and with the DSP48E2 27x18 mode
+// (x in 11.16, y in 16.2)
+module sfp_mul_wrapper (
+    input logic [31:0] x,
+    input logic [31:0] y,
+    output logic [31:0] out_full,
+    output logic [31:0] out_dsp,
+    output clipping_dsp
+);
+
+  localparam w = 16;
+
+  sfp_if #(
+      .IW(w),
+      .QW(w)
+  ) x_if ();
+  sfp_if #(
+      .IW(w),
+      .QW(w)
+  ) y_if ();
+  sfp_if #(
+      .IW(w),
+      .QW(w)
+  ) out_full_if ();
+  sfp_if #(
+      .IW(w),
+      .QW(w)
+  ) out_dsp_if ();
+
+  assign x_if.val = x;
+  assign y_if.val = y;
+
+  sfp_mul #(
+      .CLIP(0)
+  ) mul_full (
+      .x(x_if),
+      .y(y_if),
+      .out(out_full_if),
+      .clipping()
+  );
+
+  sfp_mul #(
+      .CLIP(0),
+      .DSP(1),
+      .DSP_X_IW(11),
+      .DSP_Y_IW(16)
+  ) mul_dsp (
+      .x(x_if),
+      .y(y_if),
+      .out(out_dsp_if),
+      .clipping(clipping_dsp)
+  );
+
+  assign out_full = out_full_if.val;
+  assign out_dsp  = out_dsp_if.val;
+
+endmodule
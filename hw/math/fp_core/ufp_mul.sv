@@ -1,5 +1,6 @@
 module ufp_mul #(
-    parameter int CLIP = 0  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int CLIP = 0,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
 ) (
            ufp_if.in  x,
            ufp_if.in  y,
@@ -13,7 +14,8 @@ module ufp_mul #(
   ) prod_fp ();
   assign prod_fp.val = x.val * y.val;
   ufp_resize #(
-      .clip(CLIP)
+      .clip(CLIP),
+      .ROUND(ROUND)
   ) u_resize (
       .in(prod_fp),
       .out(out),
@@ -6,7 +6,8 @@
 //             u.e[0] * v.e[1] - u.e[1] * v.e[0]);
 
 module sfp_vec3_cross #(
-    parameter CLIP = 1  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter CLIP = 1,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
 ) (
     sfp_if.in  a  [3],
     sfp_if.in  b  [3],
@@ -59,7 +60,8 @@ module sfp_vec3_cross #(
   generate
     for (i = 0; i < 3; i++) begin : gen_sub
       sfp_sub #(
-          .CLIP(CLIP)
+          .CLIP(CLIP),
+          .ROUND(ROUND)
       ) sub_i (
           .in1(left_prod_fp[i]),
           .in2(right_prod_fp[i]),
@@ -1,8 +1,14 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (c) 2025 Hugo Melder
 
+// DSP = 1 narrows the operands as in sfp_mul, so that every element product
+// maps onto one DSP48E2 and the sum onto the cascaded post-adders.
 module sfp_vec3_dot #(
-    parameter CLIP = 1  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter CLIP = 1,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0,  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
+    parameter int DSP = 0,  // 1 = one DSP48E2 per element, see sfp_mul
+    parameter int DSP_X_IW = 11,  // Integer bits of a kept for the A port
+    parameter int DSP_Y_IW = 16  // Integer bits of b kept for the B port
 ) (
     sfp_if.in a[3],
     sfp_if.in b[3],
@@ -10,19 +16,63 @@ module sfp_vec3_dot #(
     output clipping
 );
 
+  localparam int DSP_A_WIDTH = 27;
+  localparam int DSP_B_WIDTH = 18;
+
+  // Operand formats of the multipliers
+  localparam int MUL_A_IW = DSP ? DSP_X_IW : a.IW;
+  localparam int MUL_A_QW = DSP ? DSP_A_WIDTH - DSP_X_IW : a.QW;
+  localparam int MUL_B_IW = DSP ? DSP_Y_IW : b.IW;
+  localparam int MUL_B_QW = DSP ? DSP_B_WIDTH - DSP_Y_IW : b.QW;
+
+  sfp_if #(
+      .IW(MUL_A_IW),
+      .QW(MUL_A_QW)
+  ) a_mul[3] ();
+  sfp_if #(
+      .IW(MUL_B_IW),
+      .QW(MUL_B_QW)
+  ) b_mul[3] ();
+  logic [2:0] a_clipping, b_clipping;
+  logic acc_clipping;
+
   // Product must have the correct iw/qw for a full width operation
   sfp_if #(
-      .IW(a.IW + b.IW),
-      .QW(a.QW + b.QW)
+      .IW(MUL_A_IW + MUL_B_IW),
+      .QW(MUL_A_QW + MUL_B_QW)
   ) prod_fp[3] ();
 
   // Multiply element-wise
   genvar i;
   generate
     for (i = 0; i < 3; i++) begin : gen_mul
+      if (DSP) begin : gen_narrow
+        sfp_resize #(
+            .clip(1),
+            .ROUND(ROUND)
+        ) u_narrow_a (
+            .in(a[i]),
+            .out(a_mul[i]),
+            .clipping(a_clipping[i])
+        );
+        sfp_resize #(
+            .clip(1),
+            .ROUND(ROUND)
+        ) u_narrow_b (
+            .in(b[i]),
+            .out(b_mul[i]),
+            .clipping(b_clipping[i])
+        );
+      end else begin : gen_pass
+        assign a_mul[i].val = a[i].val;
+        assign b_mul[i].val = b[i].val;
+        assign a_clipping[i] = 1'b0;
+        assign b_clipping[i] = 1'b0;
+      end
+
       sfp_mul_full mul_i (
-          .in1(a[i]),
-          .in2(b[i]),
+          .in1(a_mul[i]),
+          .in2(b_mul[i]),
           .out(prod_fp[i])
       );
     end
@@ -30,19 +80,22 @@ module sfp_vec3_dot #(
 
   // Accumulate elements of prod_fp
   sfp_if #(
-      .IW(a.IW + b.IW),
-      .QW(a.QW + b.QW)
+      .IW(MUL_A_IW + MUL_B_IW),
+      .QW(MUL_A_QW + MUL_B_QW)
   ) acc_fp ();
 
   assign acc_fp.val = prod_fp[0].val + prod_fp[1].val + prod_fp[2].val;
 
   // Resize
   sfp_resize #(
-      .clip(CLIP)
+      .clip(CLIP),
+      .ROUND(ROUND)
   ) u_resize (
       .in(acc_fp),
       .out(out),
-      .clipping(clipping)
+      .clipping(acc_clipping)
   );
 
+  assign clipping = acc_clipping || (|a_clipping) || (|b_clipping);
+
 endmodule
@@ -3,7 +3,8 @@
 
 module sfp_vec_add_s #(
     parameter int N = 3,
-    parameter CLIP = 1  // 0 = wrap, 1 = clip
+    parameter CLIP = 1,  // 0 = wrap, 1 = clip
+    parameter int ROUND = 0  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
 ) (
     sfp_if.in  a  [N],
     sfp_if.in  s,
@@ -15,7 +16,8 @@ module sfp_vec_add_s #(
   generate
     for (i = 0; i < N; i++) begin : gen_add
       sfp_add #(
-          .CLIP(CLIP)
+          .CLIP(CLIP),
+          .ROUND(ROUND)
       ) add_i (
           .in1(a[i]),
           .in2(s),
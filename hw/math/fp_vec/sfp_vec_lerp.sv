@@ -2,73 +2,132 @@
 // Copyright (c) 2025 Hugo Melder
 
 // Implements (1.0 - norm) * a + norm * b
+//
+// PREADD = 1 computes the same as a + norm * (b - a) instead, which needs one
+// multiplier per element. With DSP = 1 the subtraction maps onto the
+// DSP48E2 pre-adder (D - A), norm onto the B port and the addition of a onto
+// the post-adder. b - a gets one more integer bit, norm is usually in 2.16.
+// DSP has no effect on the two-multiplier form.
 module sfp_vec_lerp #(
     parameter int N = 3,
-    parameter CLIP = 1  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter CLIP = 1,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0,  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
+    parameter int PREADD = 0,  // 1 = a + norm * (b - a)
+    parameter int DSP = 0,  // 1 = one DSP48E2 per element, see sfp_mul
+    parameter int DSP_X_IW = 11,  // Integer bits of b - a for the A/D ports
+    parameter int DSP_Y_IW = 2  // Integer bits of norm for the B port
 ) (
     sfp_if.in a[N],
     sfp_if.in b[N],
     sfp_if.in norm[N],
     sfp_if.out out[N]
 );
-  sfp_if #(
-      .IW(out.IW),
-      .QW(out.QW)
-  )
-      left_side[N] (), right_side[N] ();
+  if (PREADD) begin : gen_preadd
+    sfp_if #(
+        .IW(a.IW + 1),
+        .QW(a.QW)
+    ) diff[N] ();
+    sfp_if #(
+        .IW(out.IW),
+        .QW(out.QW)
+    ) prod[N] ();
 
-  // Compute -norm + 1.0
-  sfp_if #(
-      .IW(norm.IW),
-      .QW(norm.QW)
-  )
-      norm_neg[N] (), constant_one (), one_minus_norm[N] ();
+    sfp_vec_sub #(
+        .N(N),
+        .CLIP(CLIP),
+        .ROUND(ROUND)
+    ) pre_add (
+        .a  (b),
+        .b  (a),
+        .out(diff)
+    );
 
-  assign constant_one.val = 1'h1 << constant_one.QW;
+    sfp_vec_mul #(
+        .N(N),
+        .CLIP(CLIP),
+        .ROUND(ROUND),
+        .DSP(DSP),
+        .DSP_X_IW(DSP_X_IW),
+        .DSP_Y_IW(DSP_Y_IW)
+    ) mul (
+        .a  (diff),
+        .b  (norm),
+        .out(prod)
+    );
 
-  sfp_vec_neg #(
-      .N(N)
-  ) neg (
-      .in (norm),
-      .out(norm_neg)
-  );
+    sfp_vec_add #(
+        .N(N),
+        .CLIP(CLIP),
+        .ROUND(ROUND)
+    ) post_add (
+        .a  (a),
+        .b  (prod),
+        .out(out)
+    );
+  end else begin : gen_two_mul
+    sfp_if #(
+        .IW(out.IW),
+        .QW(out.QW)
+    )
+        left_side[N] (), right_side[N] ();
 
-  sfp_vec_add_s #(
-      .N(N),
-      .CLIP(CLIP)
-  ) add_left (
-      .a  (norm_neg),
-      .s  (constant_one),
-      .out(one_minus_norm)
-  );
+    // Compute -norm + 1.0
+    sfp_if #(
+        .IW(norm.IW),
+        .QW(norm.QW)
+    )
+        norm_neg[N] (), constant_one (), one_minus_norm[N] ();
 
-  // Compute one_minus_norm * a
+    assign constant_one.val = 1'h1 << constant_one.QW;
 
-  sfp_vec_mul #(
-      .N(N),
-      .CLIP(CLIP)
-  ) left_mul (
-      .a  (one_minus_norm),
-      .b  (a),
-      .out(left_side)
-  );
+    sfp_vec_neg #(
+        .N(N)
+    ) neg (
+        .in (norm),
+        .out(norm_neg)
+    );
 
-  sfp_vec_mul #(
-      .N(N),
-      .CLIP(CLIP)
-  ) right_mul (
-      .a  (norm),
-      .b  (b),
-      .out(right_side)
-  );
+    sfp_vec_add_s #(
+        .N(N),
+        .CLIP(CLIP),
+        .ROUND(ROUND)
+    ) add_left (
+        .a  (norm_neg),
+        .s  (constant_one),
+        .out(one_minus_norm)
+    );
 
-  sfp_vec_add #(
-      .N(N),
-      .CLIP(CLIP)
-  ) acc (
-      .a  (left_side),
-      .b  (right_side),
-      .out(out)
-  );
+    // Compute one_minus_norm * a
+
+    sfp_vec_mul #(
+        .N(N),
+        .CLIP(CLIP),
+        .ROUND(ROUND)
+    ) left_mul (
+        .a  (one_minus_norm),
+        .b  (a),
+        .out(left_side)
+    );
+
+    sfp_vec_mul #(
+        .N(N),
+        .CLIP(CLIP),
+        .ROUND(ROUND)
+    ) right_mul (
+        .a  (norm),
+        .b  (b),
+        .out(right_side)
+    );
+
+    sfp_vec_add #(
+        .N(N),
+        .CLIP(CLIP),
+        .ROUND(ROUND)
+    ) acc (
+        .a  (left_side),
+        .b  (right_side),
+        .out(out)
+    );
+  end
 
 endmodule
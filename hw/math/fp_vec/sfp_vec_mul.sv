@@ -3,7 +3,11 @@
 
 module sfp_vec_mul #(
     parameter int N = 3,
-    parameter CLIP = 1  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter CLIP = 1,  // (if reducing iw) 0 = wrap, 1 = clip
+    parameter int ROUND = 0,  // (if reducing qw) 0 = trunc, 1 = half up, 2 = half even
+    parameter int DSP = 0,  // 1 = one DSP48E2 per element, see sfp_mul
+    parameter int DSP_X_IW = 11,
+    parameter int DSP_Y_IW = 16
 ) (
     sfp_if.in  a  [N],
     sfp_if.in  b  [N],
@@ -15,7 +19,11 @@ module sfp_vec_mul #(
   generate
     for (i = 0; i < N; i++) begin : gen_add
       sfp_mul #(
-          .CLIP(CLIP)
+          .CLIP(CLIP),
+          .ROUND(ROUND),
+          .DSP(DSP),
+          .DSP_X_IW(DSP_X_IW),
+          .DSP_Y_IW(DSP_Y_IW)
       ) add_i (
           .x(a[i]),
           .y(b[i]),
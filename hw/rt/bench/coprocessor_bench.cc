@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Cycle-accurate throughput benchmark of the coprocessor.
+//
+// Renders frames at production resolutions back-to-back on one Verilated
+// instance, with tracing compiled out. For every frame it reports:
+// - upload: cycles to send the camera configuration
+// - fill: cycles from the end of the upload to the first pixel
+// - cycles/pixel: cycles from the first to the last pixel, per pixel
+// - drain: cycles from the last pixel until the next configuration is
+//   accepted
+// - simulation speed in kHz
+//
+// The benchmark fails if cycles/pixel exceeds --max-cycles-per-pixel.
+//
+// Usage: Vcoprocessor_bench [--frames 720p,1080p,4k]
+//                           [--max-cycles-per-pixel <limit>]
+
+#include <verilated.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Vcoprocessor.h"
+#include "scene.h"
+
+static const int CLOCK_HALF_PERIOD = 5;
+
+struct resolution {
+  const char *name;
+  int width;
+  int height;
+};
+
+static const resolution resolutions[] = {
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"4k", 3840, 2160},
+};
+
+struct frame_stats {
+  uint64_t upload_cycles = 0;
+  uint64_t fill_cycles = 0;
+  uint64_t stream_cycles = 0;
+  uint64_t drain_cycles = 0;
+  uint64_t pixels = 0;
+  double seconds = 0;
+};
+
+class coprocessor_bench {
+public:
+  coprocessor_bench() : context(new VerilatedContext), dut(context.get()) {
+    dut.s_axis_tvalid = 0;
+    dut.s_axis_tlast = 0;
+    dut.m_axis_tready = 1;
+
+    dut.resetn = 0;
+    tick(2);
+    dut.resetn = 1;
+    tick();
+  }
+
+  void tick() {
+    dut.aclk ^= 1;
+    dut.eval();
+    context->timeInc(CLOCK_HALF_PERIOD);
+
+    dut.aclk ^= 1;
+    dut.eval();
+    context->timeInc(CLOCK_HALF_PERIOD);
+
+    cycles += 1;
+  }
+  void tick(int n) {
+    for (int i = 0; i < n; i++) {
+      tick();
+    }
+  }
+
+  // Offer the first configuration word and wait until the coprocessor is
+  // ready for it. Returns the number of cycles waited.
+  uint64_t wait_ready() {
+    uint64_t start = cycles;
+    dut.s_axis_tvalid = 1;
+    while (!dut.s_axis_tready) {
+      tick();
+    }
+    return cycles - start;
+  }
+
+  // Same handshake as coprocessor_test.cc. Expects wait_ready() first.
+  uint64_t upload(Scene &scene) {
+    uint64_t start = cycles;
+    uint32_t *serialised_scene = scene.serialised();
+    int send_counter = 0;
+
+    while (send_counter < SCENE_PAYLOAD_SIZE) {
+      if (dut.s_axis_tready) {
+        dut.s_axis_tdata = serialised_scene[send_counter];
+        dut.s_axis_tlast = send_counter == SCENE_PAYLOAD_SIZE - 1;
+        send_counter += 1;
+      }
+      tick();
+    }
+    dut.s_axis_tvalid = 0;
+    dut.s_axis_tlast = 0;
+    return cycles - start;
+  }
+
+  // Receive the whole frame with m_axis_tready held high. Returns false if
+  // the frame did not end with tlast after the expected number of pixels.
+  bool receive(uint64_t expected_pixels, frame_stats &stats) {
+    uint64_t start = cycles;
+    uint64_t first = 0;
+    uint64_t limit = cycles + 4 * expected_pixels + 10000;
+
+    while (cycles < limit) {
+      if (dut.m_axis_tvalid) {
+        if (stats.pixels == 0) {
+          first = cycles;
+        }
+        stats.pixels += 1;
+
+        if (dut.m_axis_tlast) {
+          stats.fill_cycles = first - start;
+          stats.stream_cycles = cycles - first + 1;
+          tick();
+          return stats.pixels == expected_pixels;
+        }
+      }
+      tick();
+    }
+    return false;
+  }
+
+  unsigned threads() const { return context->threads(); }
+
+  uint64_t cycles = 0;
+
+private:
+  std::unique_ptr<VerilatedContext> context;
+  Vcoprocessor dut;
+};
+
+// https://stackoverflow.com/a/868894
+static char *getCmdOption(char **begin, char **end,
+                          const std::string &option) {
+  char **itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end) {
+    return *itr;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  Verilated::commandArgs(argc, argv);
+
+  std::string frames = "720p,1080p,4k";
+  double max_cycles_per_pixel = 0;
+
+  char *arg = getCmdOption(argv, argv + argc, "--frames");
+  if (arg) {
+    frames = arg;
+  }
+  arg = getCmdOption(argv, argv + argc, "--max-cycles-per-pixel");
+  if (arg) {
+    max_cycles_per_pixel = std::atof(arg);
+  }
+
+  std::vector<resolution> selected;
+  for (const resolution &r : resolutions) {
+    if (("," + frames + ",").find("," + std::string(r.name) + ",") !=
+        std::string::npos) {
+      selected.push_back(r);
+    }
+  }
+  if (selected.empty()) {
+    std::fprintf(stderr, "No known resolution in '%s'\n", frames.c_str());
+    return 1;
+  }
+
+  coprocessor_bench bench;
+  std::vector<frame_stats> stats(selected.size());
+  bool failed = false;
+
+  bench.wait_ready();
+  for (size_t i = 0; i < selected.size(); i++) {
+    const resolution &r = selected[i];
+    Scene scene(float(r.width), float(r.width) / float(r.height), 1.0f);
+    uint64_t expected = uint64_t(r.width) * uint64_t(scene.image_height);
+
+    auto t0 = std::chrono::steady_clock::now();
+    stats[i].upload_cycles = bench.upload(scene);
+    if (!bench.receive(expected, stats[i])) {
+      std::fprintf(stderr, "%s: expected %llu pixels, received %llu\n",
+                   r.name, (unsigned long long)expected,
+                   (unsigned long long)stats[i].pixels);
+      return 1;
+    }
+
+    // Drain: time until the next configuration would be accepted
+    stats[i].drain_cycles = bench.wait_ready();
+    stats[i].seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - t0)
+                           .count();
+  }
+
+  std::printf("Verilator threads: %u\n", bench.threads());
+  std::printf("%-6s %10s %8s %6s %12s %6s %10s\n", "frame", "pixels",
+              "upload", "fill", "cycles/pixel", "drain", "sim_kHz");
+  for (size_t i = 0; i < selected.size(); i++) {
+    const frame_stats &s = stats[i];
+    uint64_t total = s.upload_cycles + s.fill_cycles + s.stream_cycles +
+                     s.drain_cycles;
+    double cycles_per_pixel = double(s.stream_cycles) / double(s.pixels);
+    double khz = double(total) / s.seconds / 1000.0;
+
+    std::printf("%-6s %10llu %8llu %6llu %12.4f %6llu %10.1f\n",
+                selected[i].name, (unsigned long long)s.pixels,
+                (unsigned long long)s.upload_cycles,
+                (unsigned long long)s.fill_cycles, cycles_per_pixel,
+                (unsigned long long)s.drain_cycles, khz);
+
+    if (max_cycles_per_pixel > 0 && cycles_per_pixel > max_cycles_per_pixel) {
+      std::fprintf(stderr,
+                   "%s: %.4f cycles/pixel exceeds the limit of %.4f\n",
+                   selected[i].name, cycles_per_pixel, max_cycles_per_pixel);
+      failed = true;
+    }
+  }
+
+  return failed ? 1 : 0;
+}
@@ -15,15 +15,59 @@ module coprocessor (
     input wire s_axis_tvalid,
 
     // AXIS Master
-    output reg m_axis_tvalid,
-    output reg [31 : 0] m_axis_tdata,
-    output reg m_axis_tlast,
-    input wire m_axis_tready
+    output wire m_axis_tvalid,
+    output wire [31 : 0] m_axis_tdata,
+    output wire m_axis_tlast,
+    input wire m_axis_tready,
+
+    // Framebuffer: with fb_enable, pixels are written to DDR instead of the
+    // AXIS master. fb_done is the frame-done interrupt.
+    input wire fb_enable,
+    input wire [31 : 0] fb_base,
+    input wire [31 : 0] fb_stride,
+    output wire fb_done,
+    output wire fb_error,
+
+    // AXI4 Read Master (BVH nodes and primitives in DDR)
+    output wire m_axi_arvalid,
+    input wire m_axi_arready,
+    output wire [31 : 0] m_axi_araddr,
+    output wire [7 : 0] m_axi_arlen,
+    output wire [2 : 0] m_axi_arsize,
+    output wire [1 : 0] m_axi_arburst,
+    output wire [3 : 0] m_axi_arcache,
+    output wire [2 : 0] m_axi_arprot,
+    output wire [1 : 0] m_axi_arid,
+    input wire m_axi_rvalid,
+    output wire m_axi_rready,
+    input wire [31 : 0] m_axi_rdata,
+    input wire [1 : 0] m_axi_rresp,
+    input wire m_axi_rlast,
+    input wire [1 : 0] m_axi_rid,
+
+    // AXI4 Write Master (framebuffer)
+    output wire m_axi_awvalid,
+    input wire m_axi_awready,
+    output wire [31 : 0] m_axi_awaddr,
+    output wire [7 : 0] m_axi_awlen,
+    output wire [2 : 0] m_axi_awsize,
+    output wire [1 : 0] m_axi_awburst,
+    output wire [3 : 0] m_axi_awcache,
+    output wire [2 : 0] m_axi_awprot,
+    output wire m_axi_wvalid,
+    input wire m_axi_wready,
+    output wire [31 : 0] m_axi_wdata,
+    output wire [3 : 0] m_axi_wstrb,
+    output wire m_axi_wlast,
+    input wire m_axi_bvalid,
+    output wire m_axi_bready,
+    input wire [1 : 0] m_axi_bresp
 );
 
   // State encoding
   localparam IDLE = 3'b000;
   localparam RECV_SCENE = 3'b010;
+  localparam RECV_OBJECTS = 3'b011;
   localparam SEND_FRAGMENT = 3'b100;
 
   // State declaration
@@ -113,37 +157,72 @@ module coprocessor (
   reg [WORD_LEN-1:0] pixel_00_loc_y;
   reg [WORD_LEN-1:0] pixel_00_loc_z;
 
+  // Scene Memory
+  // Without tlast on the last camera word, the packet continues with the
+  // objects of the scene: a length header, then that many words. They are
+  // stored in the back buffer of rt_scene_mem at one word per clock and
+  // become visible to the intersection units with the next frame.
+  localparam SceneWords = 4096;  // Per buffer
+
+  reg scene_header;
+  wire scene_valid = state == RECV_OBJECTS && s_axis_tvalid && s_axis_tready;
+  wire scene_done;
+  wire [WORD_LEN-1:0] scene_length;
+  wire scene_overflow;
+
   // Render (rt_core)
   reg render_start;
-  reg render_stall;
 
   wire render_valid;
   wire render_last;
   wire [FP_WL - 1:0] render_pixel;
 
-  reg deferred_last;
+  // Output register, drives either the AXIS master or the framebuffer
+  // writer. frag_x and frag_y are the coordinates of the held pixel.
+  reg frag_valid;
+  reg [WORD_LEN-1:0] frag_data;
+  reg frag_last;
+  reg [COORDINATE_BITS-1:0] frag_x;
+  reg [COORDINATE_BITS-1:0] frag_y;
+  wire frag_ready;
+
+  reg fb_active;  // fb_enable, sampled when the frame starts
+  wire fb_ready;
+  wire fb_written;
+
+  assign m_axis_tvalid = frag_valid && !fb_active;
+  assign m_axis_tdata = frag_data;
+  assign m_axis_tlast = frag_last;
+  assign frag_ready = fb_active ? fb_ready : m_axis_tready;
+
+  // The pipeline advances together with the output register, i.e. whenever
+  // the output register is empty or its beat is accepted in this cycle.
+  // Stalling from a registered tready would let the pipeline overwrite the
+  // beat that is being held.
+  wire render_stall = frag_valid && !frag_ready;
 
 
   always @(posedge aclk) begin
     if (!resetn) begin
       state <= IDLE;
+      fb_active <= 0;
     end else begin
       case (state)
         IDLE: begin
           // Reset AXIS
           s_axis_tready <= 0;
-          m_axis_tvalid <= 0;
-          m_axis_tlast  <= 0;
+          frag_valid <= 0;
+          frag_last <= 0;
 
           // Reset Stream Control Registers
           recv_counter  <= 0;
 
           // Reset rt_core registers
           render_start  <= 0;
-          render_stall  <= 0;
 
           if (s_axis_tvalid) begin
             s_axis_tready <= 1;
+            fb_active <= fb_enable;
 
             state <= RECV_SCENE;
           end
@@ -192,40 +271,65 @@ module coprocessor (
             endcase
 
             if (recv_counter == CameraPayloadSize - 1) begin
-              s_axis_tready <= 0;
-              render_start <= 1;
+              if (s_axis_tlast) begin
+                s_axis_tready <= 0;
+                render_start  <= 1;
 
-              state <= SEND_FRAGMENT;
+                state <= SEND_FRAGMENT;
+              end else begin
+                scene_header <= 1;
+
+                state <= RECV_OBJECTS;
+              end
             end else begin
               recv_counter <= recv_counter + 1;
             end
           end
         end
 
+        // Stream the objects of the scene into the scene memory
+        RECV_OBJECTS: begin
+          if (s_axis_tvalid) begin
+            scene_header <= 0;
+
+            if (scene_done) begin
+              s_axis_tready <= 0;
+              render_start  <= 1;
+
+              state <= SEND_FRAGMENT;
+            end
+          end
+        end
+
         // Send out fragment via AXIS master
         SEND_FRAGMENT: begin
           render_start <= 0;
 
           // AXIS Master Bus Control
 
-          // Do not update data when pipeline is stalled
+          // Hold the current beat until it has been accepted
           if (!render_stall) begin
-            m_axis_tvalid <= render_valid;
-            m_axis_tdata  <= render_pixel;
-            m_axis_tlast  <= render_last;
+            frag_valid <= render_valid;
+            frag_data  <= render_pixel;
+            frag_last  <= render_last;
           end
 
-          if (m_axis_tready) begin
-            render_stall <= 0;
-
-            // Renderer signaled that this is the last fragment
-            if (render_last || deferred_last) begin
-              state <= IDLE;
-            end else begin  // Wait for new fragments
-              state <= SEND_FRAGMENT;
+          // Raster order
+          if (render_start) begin
+            frag_x <= 0;
+            frag_y <= 0;
+          end else if (frag_valid && frag_ready) begin
+            if (frag_x == image_width[FP_WL-2 : FP_QW] - 1) begin
+              frag_x <= 0;
+              frag_y <= frag_y + 1;
+            end else begin
+              frag_x <= frag_x + 1;
             end
-          end else begin
-            render_stall <= 1;
+          end
+
+          // The last fragment has been accepted, or written to DDR
+          if (fb_active ? fb_written : frag_valid && frag_ready && frag_last) begin
+            state <= IDLE;
           end
         end
 
@@ -238,6 +342,108 @@ module coprocessor (
   end
 
 
+  // The new scene takes effect with the frame
+  rt_scene_mem #(
+      .WORD_LEN(WORD_LEN),
+      .DEPTH(SceneWords)
+  ) scene (
+      .clk(aclk),
+      .resetn(resetn),
+      .in_valid(scene_valid),
+      .in_header(scene_header),
+      .in_data(s_axis_tdata),
+      .in_last(s_axis_tlast),
+      .done(scene_done),
+      .swap(render_start),
+      .rd_en(1'b0),  // Read by the intersection units
+      .rd_addr({$clog2(SceneWords) {1'b0}}),
+      .rd_data(),
+      .length(scene_length),
+      .overflow(scene_overflow)
+  );
+
+  // Node Cache
+  // Traversal fetches BVH nodes and primitives that do not fit into the
+  // scene memory from DDR through rt_node_cache. A new scene invalidates
+  // the cache.
+
+  rt_node_cache #(
+      .WORD_LEN(WORD_LEN),
+      .ADDR_LEN(32),
+      .MSHRS(4),
+      .AXI_ID_LEN(2)
+  ) node_cache (
+      .clk(aclk),
+      .resetn(resetn),
+      .flush(render_start),
+      .req_valid(1'b0),  // Requested by the traversal units
+      .req_ready(),
+      .req_addr(32'b0),
+      .req_id(8'b0),
+      .resp_valid(),
+      .resp_ready(1'b1),
+      .resp_id(),
+      .resp_hit(),
+      .resp_data(),
+      .m_axi_arvalid(m_axi_arvalid),
+      .m_axi_arready(m_axi_arready),
+      .m_axi_araddr(m_axi_araddr),
+      .m_axi_arlen(m_axi_arlen),
+      .m_axi_arsize(m_axi_arsize),
+      .m_axi_arburst(m_axi_arburst),
+      .m_axi_arcache(m_axi_arcache),
+      .m_axi_arprot(m_axi_arprot),
+      .m_axi_arid(m_axi_arid),
+      .m_axi_rvalid(m_axi_rvalid),
+      .m_axi_rready(m_axi_rready),
+      .m_axi_rdata(m_axi_rdata),
+      .m_axi_rresp(m_axi_rresp),
+      .m_axi_rlast(m_axi_rlast),
+      .m_axi_rid(m_axi_rid),
+      .stat_hits(),
+      .stat_misses(),
+      .stat_latency_sum(),
+      .stat_latency_max(),
+      .stat_stalls()
+  );
+
+  // Framebuffer Writer
+  rt_fb_writer #(
+      .ADDR_LEN(32),
+      .COORD_LEN(COORDINATE_BITS)
+  ) framebuffer (
+      .clk(aclk),
+      .resetn(resetn),
+      .base(fb_base),
+      .stride(fb_stride),
+      .start(render_start),
+      .in_valid(frag_valid && fb_active),
+      .in_ready(fb_ready),
+      .in_x(frag_x),
+      .in_y(frag_y),
+      .in_data(frag_data),
+      .in_last(frag_last),
+      .done(fb_written),
+      .frame_done(fb_done),
+      .error(fb_error),
+      .m_axi_awvalid(m_axi_awvalid),
+      .m_axi_awready(m_axi_awready),
+      .m_axi_awaddr(m_axi_awaddr),
+      .m_axi_awlen(m_axi_awlen),
+      .m_axi_awsize(m_axi_awsize),
+      .m_axi_awburst(m_axi_awburst),
+      .m_axi_awcache(m_axi_awcache),
+      .m_axi_awprot(m_axi_awprot),
+      .m_axi_wvalid(m_axi_wvalid),
+      .m_axi_wready(m_axi_wready),
+      .m_axi_wdata(m_axi_wdata),
+      .m_axi_wstrb(m_axi_wstrb),
+      .m_axi_wlast(m_axi_wlast),
+      .m_axi_bvalid(m_axi_bvalid),
+      .m_axi_bready(m_axi_bready),
+      .m_axi_bresp(m_axi_bresp)
+  );
+
   rt_core_wrapper render (
       .clk(aclk),
       .resetn(resetn),
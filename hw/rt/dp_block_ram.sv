@@ -1,37 +1,48 @@
-// Simple Dual-Port Block RAM with One Clock
-// File: simple_dual_one_clock.v
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
 
-// From Vivado Design Suite User Guide: Synthesis (UG901)
+// True Dual-Port Block RAM with One Clock, read-first
+//
+// From Vivado Design Suite User Guide: Synthesis (UG901). Each port reads
+// and writes DEPTH words of WORD_LEN bits with a registered output. Tie web
+// to 0 for a simple dual-port RAM (write on A, read on B), which Vivado maps
+// onto a single RAMB36E2 per 1K x 36 bits.
 
 module dp_block_ram #(
     parameter WORD_LEN = 32,
-    parameter DEPTH = 256,
+    parameter DEPTH = 256
 ) (
-    clk,
-    ena,
-    enb,
-    wea,
-    addra,
-    addrb,
-    dia,
-    dob
+    input clk,
+
+    // Port A
+    input                             ena,
+    input                             wea,
+    input      [$clog2(DEPTH) - 1:0] addra,
+    input      [     WORD_LEN - 1:0] dia,
+    output reg [     WORD_LEN - 1:0] doa,
+
+    // Port B
+    input                             enb,
+    input                             web,
+    input      [$clog2(DEPTH) - 1:0] addrb,
+    input      [     WORD_LEN - 1:0] dib,
+    output reg [     WORD_LEN - 1:0] dob
 );
 
-  input clk, ena, enb, wea;
-  input [$clog2(DEPTH) - 1:0] addra, addrb;
-  input [$clog2(WORD_LEN) - 1:0] dia;
-  output [$clog2(WORD_LEN) - 1:0] dob;
-  reg [$clog2(WORD_LEN) - 1:0] ram[$clog2(DEPTH) - 1:0];
-  reg [$clog2(WORD_LEN) - 1:0] doa, dob;
+  reg [WORD_LEN - 1:0] ram[DEPTH];
 
   always @(posedge clk) begin
     if (ena) begin
+      doa <= ram[addra];
       if (wea) ram[addra] <= dia;
     end
   end
 
   always @(posedge clk) begin
-    if (enb) dob <= ram[addrb];
+    if (enb) begin
+      dob <= ram[addrb];
+      if (web) ram[addrb] <= dib;
+    end
   end
 
 endmodule
@@ -1,6 +1,19 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
 
 `include "macros.svh"
 
+// One Goldschmidt iteration for 1 / sqrt(S) and sqrt(S) from an estimate y0:
+//
+//   x0 = S * y0
+//   b1 = x0 * y0
+//   Y1 = (3 - b1) / 2
+//   y1 = y0 * Y1 ~ 1 / sqrt(S)
+//   x1 = x0 * Y1 ~ sqrt(S)
+//
+// b1 is formed from x0 rather than from y0^2, which keeps the bits of y0^2
+// that fall below the LSB for large S. Fully pipelined: a new start is
+// accepted every cycle, rsqrt and sqrt follow 5 cycles later with valid.
 module goldschmidt (
     input  logic clk,
     input  logic resetn,
@@ -13,152 +26,120 @@ module goldschmidt (
     sfp_if.out sqrt
 );
 
-  sfp_if #(IW, QW) const_3 ();
-
-  parameter IW = in.IW;  // * 2;
-  parameter QW = in.QW;  // * 2;
+  localparam int IW = in.IW;
+  localparam int QW = in.QW;
 
-  assign const_3.val = 3 << IW;
+  sfp_if #(IW, QW) const_3 ();
+  assign const_3.val = 3 << QW;
 
   // --- Pipeline Registers ---
-  // Stage -1: (Sorry this was bolted on later)
-  sfp_if #(IW, QW) b_0_reg (), y_0_reg ();
+  // Stage 0
+  sfp_if #(IW, QW) b_0_reg ();
+  sfp_if #(IW, QW) y_0_reg ();
 
-  // Stage 0:
-  sfp_if #(IW, QW) x_0_reg (), YY_0_reg ();
-
-  // Stage 1 
-  sfp_if #(IW, QW) x_0_reg_stage1 (), y_0_reg_stage1 (), b_1_reg ();
+  // Stage 1
+  sfp_if #(IW, QW) x_0_reg ();
+  sfp_if #(IW, QW) y_0_reg_stage1 ();
 
   // Stage 2
-  sfp_if #(IW, QW) x_0_reg_stage2 (), y_0_reg_stage2 (), b_1_reg_stage2 (), Y_1_reg ();
+  sfp_if #(IW, QW) x_0_reg_stage2 ();
+  sfp_if #(IW, QW) y_0_reg_stage2 ();
+  sfp_if #(IW, QW) b_1_reg ();
 
   // Stage 3
-  sfp_if #(IW, QW) YY_1_reg (), b_1_reg_stage3 ();
+  sfp_if #(IW, QW) x_0_reg_stage3 ();
+  sfp_if #(IW, QW) y_0_reg_stage3 ();
+  sfp_if #(IW, QW) Y_1_reg ();
+
+  // Stage 4
   sfp_if #(rsqrt.IW, rsqrt.QW) y_1_reg ();
   sfp_if #(sqrt.IW, sqrt.QW) x_1_reg ();
 
-
   // --- Pipeline Control ---
   localparam PIPE_DEPTH = 5;
   logic [PIPE_DEPTH-1:0] pipe_valid;  // Shift register for valid signal
 
-
   // --- Combinational Logic for Pipeline Stages ---
-  sfp_if #(IW, QW) tmp_x_0_stage0 (), tmp_YY_0_stage0 ();
-
-  // Stage 0 Logic (Inputs: b_0_reg, y_0_reg)
-  // x_0 = S * y_0 <=> in * est
-  sfp_mul mul_x_0_stage0 (
+  // Stage 1: x_0 = S * y_0 <=> in * est
+  sfp_if #(IW, QW) tmp_x_0_stage1 ();
+  sfp_mul mul_x_0_stage1 (
       .x(b_0_reg),
       .y(y_0_reg),
-      .out(tmp_x_0_stage0),
+      .out(tmp_x_0_stage1),
       .clipping()
   );
 
-  // YY_0 = Y_0 * Y_0
-  sfp_mul mul_YY_0_stage0 (
-      .x(y_0_reg),
-      .y(y_0_reg),
-      .out(tmp_YY_0_stage0),
+  // Stage 2: b_1 = x_0 * y_0
+  sfp_if #(IW, QW) tmp_b_1_stage2 ();
+  sfp_mul mul_b_1_stage2 (
+      .x(x_0_reg),
+      .y(y_0_reg_stage1),
+      .out(tmp_b_1_stage2),
       .clipping()
   );
 
-  // Stage 1 (Inputs: b_0_reg, YY_0_reg)
-  sfp_if #(IW, QW) tmp_b_1_stage1 ();
-
-  // b_1 = b_0 * YY_0
-  sfp_mul mul_b_1_stage1 (
-      .x(b_0_reg),
-      .y(YY_0_reg),
-      .out(tmp_b_1_stage1),
-      .clipping()
-  );
-
-  // Stage 2 (Inputs: b_1_reg)
-  sfp_if #(IW, QW) tmp_Y_1_stage2 ();
-
-  // Y_1 = 1/2 * (3-b_1) <=> Y_1 = (3-b_1) >>> 1 (Shift done below in register assignment)
-  sfp_sub sub_Y_1_stage2 (
+  // Stage 3: Y_1 = 1/2 * (3-b_1) <=> Y_1 = (3-b_1) >>> 1 (Shift done below in
+  // register assignment)
+  sfp_if #(IW, QW) tmp_Y_1_stage3 ();
+  sfp_sub sub_Y_1_stage3 (
       .in1(const_3),
       .in2(b_1_reg),
-      .out(tmp_Y_1_stage2),
+      .out(tmp_Y_1_stage3),
       .clipping()
   );
 
-  // Stage 3 (Inputs: x_0_reg_stage2, y_0_reg_stage2, Y_1_reg, b_1_reg_stage2)
-  sfp_if #(rsqrt.IW, rsqrt.QW) tmp_y_1_stage3 ();
-  sfp_if #(sqrt.IW, sqrt.QW) tmp_x_1_stage3 ();
-  //  sfp_if #(IW, QW) tmp_YY_1_stage3 ();
+  // Stage 4
+  sfp_if #(rsqrt.IW, rsqrt.QW) tmp_y_1_stage4 ();
+  sfp_if #(sqrt.IW, sqrt.QW) tmp_x_1_stage4 ();
 
   // x_1 = x_0 * Y_1
-  sfp_mul mul_x_1_stage3 (
-      .x(x_0_reg_stage2),
+  sfp_mul mul_x_1_stage4 (
+      .x(x_0_reg_stage3),
       .y(Y_1_reg),
-      .out(tmp_x_1_stage3),
+      .out(tmp_x_1_stage4),
       .clipping()
   );
   // y_1 = y_0 * Y_1
-  sfp_mul mul_y_1_stage3 (
-      .x(y_0_reg_stage2),
+  sfp_mul mul_y_1_stage4 (
+      .x(y_0_reg_stage3),
       .y(Y_1_reg),
-      .out(tmp_y_1_stage3),
+      .out(tmp_y_1_stage4),
       .clipping()
   );
 
   // --- Sequential Logic (Registers and Control) ---
   always_ff @(posedge clk) begin
     if (!resetn) begin
-      // Reset pipeline registers and control
       pipe_valid <= '0;
     end else begin
-      // Pipeline Staging and Input Latching
       pipe_valid <= {pipe_valid[PIPE_DEPTH-2:0], start};  // Shift valid bit
     end
 
-    // Stage -1
-    if (start) begin
-      b_0_reg.val <= in.val;
-      y_0_reg.val <= est.val;
-    end
+    // Every stage keeps its own copy of the operands, so that a start in the
+    // next cycle does not overwrite them
+    b_0_reg.val <= in.val;
+    y_0_reg.val <= est.val;
 
-    // Stage 0
-    if (pipe_valid[0]) begin
-      x_0_reg.val  <= tmp_x_0_stage0.val;
-      YY_0_reg.val <= tmp_YY_0_stage0.val;
-    end
+    x_0_reg.val <= tmp_x_0_stage1.val;
+    y_0_reg_stage1.val <= y_0_reg.val;
 
-    // Stage 1
-    if (pipe_valid[1]) begin
-      x_0_reg_stage1.val <= x_0_reg.val;
-      y_0_reg_stage1.val <= y_0_reg.val;
-      b_1_reg.val = tmp_b_1_stage1.val;
-    end
+    x_0_reg_stage2.val <= x_0_reg.val;
+    y_0_reg_stage2.val <= y_0_reg_stage1.val;
+    b_1_reg.val <= tmp_b_1_stage2.val;
 
-    // Stage 2
-    if (pipe_valid[2]) begin
-      x_0_reg_stage2.val <= x_0_reg_stage1.val;
-      y_0_reg_stage2.val <= y_0_reg_stage1.val;
-      b_1_reg_stage2.val <= b_1_reg.val;
-      Y_1_reg.val <= (tmp_Y_1_stage2.val >>> 1);
-    end
-
-    // Stage 3
-    if (pipe_valid[3]) begin
-      x_1_reg.val <= tmp_x_1_stage3.val;
-      y_1_reg.val <= tmp_y_1_stage3.val;
-    end
+    x_0_reg_stage3.val <= x_0_reg_stage2.val;
+    y_0_reg_stage3.val <= y_0_reg_stage2.val;
+    Y_1_reg.val <= (tmp_Y_1_stage3.val >>> 1);
 
+    x_1_reg.val <= tmp_x_1_stage4.val;
+    y_1_reg.val <= tmp_y_1_stage4.val;
   end
 
-
   // --- Output Assignments ---
-  // Assign registered values to outputs
   assign rsqrt.val = y_1_reg.val;
   assign sqrt.val = x_1_reg.val;
 
   // valid signal is high when the last stage of the pipeline is valid
   assign valid = pipe_valid[PIPE_DEPTH-1];
 
-
 endmodule
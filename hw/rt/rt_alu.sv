@@ -1,31 +1,46 @@
 // SPDX-License-Identifier: Apache-2.0
 // Copyright (c) 2025 Hugo Melder
 
-`define ASSIGN_VEC_FP(A, B) \
-    A[0] <= B[0].val; \
-    A[1] <= B[1].val; \
-    A[2] <= B[2].val;
-
+`include "shader_isa.vh"
+
+// Pipelined vec3 ALU of rt_shader_core. Accepts an operation every cycle and
+// returns its result SHADER_ALU_LATENCY cycles later, together with in_tag.
+//
+// Stage 1: add, sub, mul, dot, max, min, mov, splat and b - a of lerp, the
+//          rsqrt estimate
+// Stage 2: c * (b - a)
+// Stage 3: a + c * (b - a), i.e. sfp_vec_lerp with PREADD = 1
+// Stage 2-6: goldschmidt
+//
+// All units wrap (CLIP = 0) and truncate. SHADER_OP_CONST returns a; the core
+// passes the constant in place of the register.
 module rt_alu_vec #(
     parameter WORD_LEN = 32,
     parameter IW = 16,
-    patameter QW = 16,
-    parameter OP_LEN = 4
+    parameter QW = 16,
+    parameter OP_LEN = 4,
+    parameter TAG_LEN = 8
 ) (
+    input logic clk,
+    input logic resetn,
+
+    input logic in_valid,
+    input logic [TAG_LEN-1:0] in_tag,
     input logic [OP_LEN - 1:0] op,
+    input logic [3:0] k,
 
     input logic signed [WORD_LEN - 1:0] a[3],
     input logic signed [WORD_LEN - 1:0] b[3],
+    input logic signed [WORD_LEN - 1:0] c[3],
 
+    output logic out_valid,
+    output logic [TAG_LEN-1:0] out_tag,
     output logic signed [WORD_LEN - 1:0] out[3]
 );
 
-  localparam OP_ADD = 4'b0000;  // Vector addition
-  localparam OP_SUB = 4'b0001;  // Vector subtraction
-  localparam OP_MUL = 4'b0010;  // Vector multiplication
-
   // Wrap into signed fixed-point interface
-  sfp_if #(IW, QW) a_fp[3] (), b_fp[3] ();
+  sfp_if #(IW, QW) a_fp[3] ();
+  sfp_if #(IW, QW) b_fp[3] ();
   genvar i;
   generate
     for (i = 0; i < 3; i++) begin : gen_fp_assign
@@ -34,9 +49,11 @@ module rt_alu_vec #(
     end
   endgenerate
 
-  // Arithmetic Modules
-
+  // --- Stage 1 ---
   sfp_if #(IW, QW) tmp_add_out[3] (), tmp_sub_out[3] (), tmp_mul_out[3] ();
+  sfp_if #(IW, QW) tmp_dot_out ();
+  sfp_if #(IW + 1, QW) tmp_diff_out[3] ();
+  sfp_if #(IW, QW) tmp_est_out ();
 
   sfp_vec_add #(
       .CLIP(0)
@@ -62,28 +79,172 @@ module rt_alu_vec #(
       .out(tmp_mul_out)
   );
 
+  sfp_vec3_dot #(
+      .CLIP(0)
+  ) dot_vec (
+      .a(a_fp),
+      .b(b_fp),
+      .out(tmp_dot_out),
+      .clipping()
+  );
+
+  // b - a with one more integer bit: exact
+  sfp_vec_sub #(
+      .CLIP(0)
+  ) lerp_diff (
+      .a  (b_fp),
+      .b  (a_fp),
+      .out(tmp_diff_out)
+  );
+
+  rt_rsqrt_est rsqrt_est (
+      .in (a_fp[0]),
+      .est(tmp_est_out)
+  );
 
-  // --- Output Selection Logic ---
-  // Select the result based on the 'op' input code
+  logic signed [WORD_LEN-1:0] result[3];
   always_comb begin
-    case (op)
-      OP_ADD: begin
-        `ASSIGN_VEC_FP(out, tmp_add_out)
-      end
-      OP_SUB: begin
-        `ASSIGN_VEC_FP(out, tmp_sub_out)
-      end
-      OP_MUL: begin
-        `ASSIGN_VEC_FP(out, tmp_mul_out)
-      end
+    for (int n = 0; n < 3; n++) begin
+      case (op)
+        SHADER_OP_ADD: result[n] = tmp_add_out[n].val;
+        SHADER_OP_SUB: result[n] = tmp_sub_out[n].val;
+        SHADER_OP_MUL: result[n] = tmp_mul_out[n].val;
+        SHADER_OP_DOT: result[n] = tmp_dot_out.val;
+        SHADER_OP_MAX: result[n] = a[n] > b[n] ? a[n] : b[n];
+        SHADER_OP_MIN: result[n] = a[n] < b[n] ? a[n] : b[n];
+        SHADER_OP_SPLAT: result[n] = k < 3 ? a[k[1:0]] : a[0];
+        default: result[n] = a[n];  // mov, const
+      endcase
+    end
+  end
 
-      default: begin  // Handles undefined opcodes
-        `ASSIGN_VEC_FP(out, a_fp)
-      end
-    endcase
+  // Stage 1 registers
+  logic valid_s1;
+  logic [TAG_LEN-1:0] tag_s1;
+  logic [OP_LEN-1:0] op_s1;
+  logic positive_s1;
+  logic signed [WORD_LEN-1:0] result_s1[3];
+  sfp_if #(IW, QW) a_s1[3] ();
+  sfp_if #(IW, QW) c_s1[3] ();
+  sfp_if #(IW + 1, QW) diff_s1[3] ();
+  sfp_if #(IW, QW) s_s1 (), est_s1 ();
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      valid_s1 <= 0;
+    end else begin
+      valid_s1 <= in_valid;
+    end
+    tag_s1 <= in_tag;
+    op_s1 <= op;
+    positive_s1 <= a[0] > 0;
+    result_s1 <= result;
+    for (int n = 0; n < 3; n++) begin
+      a_s1[n].val <= a[n];
+      c_s1[n].val <= c[n];
+      diff_s1[n].val <= tmp_diff_out[n].val;
+    end
+    s_s1.val <= a[0];
+    est_s1.val <= tmp_est_out.val;
   end
 
+  // --- Stage 2 ---
+  sfp_if #(IW, QW) tmp_prod_out[3] ();
+  sfp_vec_mul #(
+      .CLIP(0)
+  ) lerp_mul (
+      .a  (diff_s1),
+      .b  (c_s1),
+      .out(tmp_prod_out)
+  );
+
+  // Start every cycle, the result is only used for SHADER_OP_RSQ
+  sfp_if #(IW, QW) rsqrt_out (), sqrt_out ();
+  goldschmidt u_rsqrt (
+      .clk(clk),
+      .resetn(resetn),
+      .start(1'b1),
+      .valid(),
+      .in(s_s1),
+      .est(est_s1),
+      .rsqrt(rsqrt_out),
+      .sqrt(sqrt_out)
+  );
+
+  logic valid_s2;
+  logic [TAG_LEN-1:0] tag_s2;
+  logic [OP_LEN-1:0] op_s2;
+  logic positive_s2;
+  logic signed [WORD_LEN-1:0] result_s2[3];
+  sfp_if #(IW, QW) a_s2[3] ();
+  sfp_if #(IW, QW) prod_s2[3] ();
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      valid_s2 <= 0;
+    end else begin
+      valid_s2 <= valid_s1;
+    end
+    tag_s2 <= tag_s1;
+    op_s2 <= op_s1;
+    positive_s2 <= positive_s1;
+    result_s2 <= result_s1;
+    for (int n = 0; n < 3; n++) begin
+      a_s2[n].val <= a_s1[n].val;
+      prod_s2[n].val <= tmp_prod_out[n].val;
+    end
+  end
+
+  // --- Stage 3 ---
+  sfp_if #(IW, QW) tmp_lerp_out[3] ();
+  sfp_vec_add #(
+      .CLIP(0)
+  ) lerp_add (
+      .a  (a_s2),
+      .b  (prod_s2),
+      .out(tmp_lerp_out)
+  );
 
+  // Stages 3 to 6 delay the result to the goldschmidt output
+  localparam int DELAY = SHADER_ALU_LATENCY - 2;
 
+  logic [DELAY-1:0] valid_d;
+  logic [TAG_LEN-1:0] tag_d[DELAY];
+  logic [OP_LEN-1:0] op_d[DELAY];
+  logic [DELAY-1:0] positive_d;
+  logic signed [WORD_LEN-1:0] result_d[DELAY][3];
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      valid_d <= '0;
+    end else begin
+      valid_d <= {valid_d[DELAY-2:0], valid_s2};
+    end
+    tag_d[0] <= tag_s2;
+    op_d[0] <= op_s2;
+    positive_d[0] <= positive_s2;
+    for (int n = 0; n < 3; n++) begin
+      result_d[0][n] <= op_s2 == SHADER_OP_LERP ? tmp_lerp_out[n].val : result_s2[n];
+    end
+    for (int s = 1; s < DELAY; s++) begin
+      tag_d[s] <= tag_d[s-1];
+      op_d[s] <= op_d[s-1];
+      positive_d[s] <= positive_d[s-1];
+      result_d[s] <= result_d[s-1];
+    end
+  end
+
+  // --- Output ---
+  assign out_valid = valid_d[DELAY-1];
+  assign out_tag   = tag_d[DELAY-1];
+  always_comb begin
+    for (int n = 0; n < 3; n++) begin
+      if (op_d[DELAY-1] == SHADER_OP_RSQ) begin
+        out[n] = positive_d[DELAY-1] ? rsqrt_out.val : '0;
+      end else begin
+        out[n] = result_d[DELAY-1][n];
+      end
+    end
+  end
 
 endmodule
@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Framebuffer writer: an AXI4 write master that stores a pixel stream in
+// DDR.
+//
+// Every pixel carries its coordinates and is written to
+// base + y * stride + 4 * x, so pixels may arrive in raster or tile order.
+// Pixels at consecutive addresses are coalesced into INCR bursts of up to
+// MAX_BURST beats. A burst is closed when it is full, when the next pixel is
+// not adjacent (which costs one cycle), before a 4 KiB boundary and with
+// in_last. Closed bursts wait in a queue, so the next burst is collected
+// while the previous ones are written, and up to MAX_OUTSTANDING bursts
+// wait for their write response.
+//
+// done is high for one cycle when the write response of the last burst of
+// the frame has arrived; frame_done then stays high until the next start.
+// error is set by a write response other than OKAY and cleared by start.
+// base and stride must be stable from start to done.
+module rt_fb_writer #(
+    parameter int ADDR_LEN = 32,
+    parameter int COORD_LEN = 15,
+    parameter int MAX_BURST = 16,  // A power of two, at most 256
+    parameter int MAX_OUTSTANDING = 8
+) (
+    input logic clk,
+    input logic resetn,
+
+    input logic [ADDR_LEN-1:0] base,
+    input logic [ADDR_LEN-1:0] stride,  // Bytes from one row to the next
+    input logic start,  // A new frame begins
+
+    // Pixels
+    input  logic                 in_valid,
+    output logic                 in_ready,
+    input  logic [COORD_LEN-1:0] in_x,
+    input  logic [COORD_LEN-1:0] in_y,
+    input  logic [         31:0] in_data,
+    input  logic                 in_last,
+
+    output logic done,
+    output logic frame_done,
+    output logic error,
+
+    // AXI4 write master
+    output logic                m_axi_awvalid,
+    input  logic                m_axi_awready,
+    output logic [ADDR_LEN-1:0] m_axi_awaddr,
+    output logic [         7:0] m_axi_awlen,
+    output logic [         2:0] m_axi_awsize,
+    output logic [         1:0] m_axi_awburst,
+    output logic [         3:0] m_axi_awcache,
+    output logic [         2:0] m_axi_awprot,
+    output logic                m_axi_wvalid,
+    input  logic                m_axi_wready,
+    output logic [        31:0] m_axi_wdata,
+    output logic [         3:0] m_axi_wstrb,
+    output logic                m_axi_wlast,
+    input  logic                m_axi_bvalid,
+    output logic                m_axi_bready,
+    input  logic [         1:0] m_axi_bresp
+);
+
+  localparam int LEN_BITS = $clog2(MAX_BURST + 1);
+  localparam int DATA_DEPTH = 2 * MAX_BURST;  // Collecting and closed bursts
+  localparam int DATA_BITS = $clog2(DATA_DEPTH);
+  localparam int DESC_DEPTH = 4;
+  localparam int DESC_BITS = $clog2(DESC_DEPTH);
+  localparam int PENDING_BITS = $clog2(MAX_OUTSTANDING + 1);
+
+  // --- Address ---
+  logic p_valid, p_ready, p_last;
+  logic [ADDR_LEN-1:0] p_addr;
+  logic [31:0] p_data;
+
+  assign in_ready = !p_valid || p_ready;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      p_valid <= 0;
+    end else if (in_ready) begin
+      p_valid <= in_valid;
+    end
+    if (in_ready) begin
+      p_addr <= base + ADDR_LEN'(in_y) * stride + ADDR_LEN'({in_x, 2'b00});
+      p_data <= in_data;
+      p_last <= in_last;
+    end
+  end
+
+  // --- Data queue ---
+  logic [31:0] data_q[DATA_DEPTH];
+  logic [DATA_BITS-1:0] data_head, data_tail;
+  logic [DATA_BITS:0] data_count;
+  logic data_push, data_pop;
+
+  // --- Burst queue: closed bursts waiting for AW ---
+  logic [ADDR_LEN-1:0] desc_addr[DESC_DEPTH];
+  logic [LEN_BITS-1:0] desc_len[DESC_DEPTH];
+  logic [DESC_BITS-1:0] desc_head, desc_tail;
+  logic [DESC_BITS:0] desc_count;
+  logic desc_push, desc_pop;
+
+  // --- Collect ---
+  logic open;  // A burst is being collected
+  logic [ADDR_LEN-1:0] open_addr, next_addr;
+  logic [LEN_BITS-1:0] open_len;
+  logic last_seen;  // The last pixel of the frame has been collected
+
+  logic adjacent, room, break_burst;
+  logic [LEN_BITS-1:0] new_len;
+  logic [ADDR_LEN-1:0] new_next;
+  logic close;
+
+  assign adjacent = open && p_addr == next_addr;
+  assign room = data_count != (DATA_BITS + 1)'(DATA_DEPTH) &&
+      desc_count != (DESC_BITS + 1)'(DESC_DEPTH);
+
+  // A pixel that does not continue the open burst closes it first
+  assign break_burst = p_valid && open && !adjacent && room;
+  assign p_ready = room && !(open && !adjacent);
+
+  assign new_len = adjacent ? open_len + 1 : LEN_BITS'(1);
+  assign new_next = p_addr + 4;
+  assign close = p_last || new_len == LEN_BITS'(MAX_BURST) || new_next[11:0] == 0;
+
+  assign data_push = p_valid && p_ready;
+  assign desc_push = break_burst || (data_push && close);
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      open <= 0;
+    end else if (break_burst) begin
+      open <= 0;
+    end else if (data_push) begin
+      open <= !close;
+      open_len <= new_len;
+      next_addr <= new_next;
+      if (!adjacent) open_addr <= p_addr;
+    end
+
+    if (!resetn || start) begin
+      last_seen <= 0;
+    end else if (data_push && p_last) begin
+      last_seen <= 1;
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      data_head  <= '0;
+      data_tail  <= '0;
+      data_count <= '0;
+      desc_head  <= '0;
+      desc_tail  <= '0;
+      desc_count <= '0;
+    end else begin
+      if (data_push) begin
+        data_q[data_tail] <= p_data;
+        data_tail <= data_tail + 1;
+      end
+      if (data_pop) data_head <= data_head + 1;
+      data_count <= data_count + (DATA_BITS + 1)'(data_push) - (DATA_BITS + 1)'(data_pop);
+
+      if (desc_push) begin
+        if (break_burst) begin
+          desc_addr[desc_tail] <= open_addr;
+          desc_len[desc_tail]  <= open_len;
+        end else begin
+          desc_addr[desc_tail] <= adjacent ? open_addr : p_addr;
+          desc_len[desc_tail]  <= new_len;
+        end
+        desc_tail <= desc_tail + 1;
+      end
+      if (desc_pop) desc_head <= desc_head + 1;
+      desc_count <= desc_count + (DESC_BITS + 1)'(desc_push) - (DESC_BITS + 1)'(desc_pop);
+    end
+  end
+
+  // --- AW ---
+  // Bursts whose address has been issued and whose data has not been sent
+  logic [LEN_BITS-1:0] wlen_q[DESC_DEPTH];
+  logic [DESC_BITS-1:0] wlen_head, wlen_tail;
+  logic [DESC_BITS:0] wlen_count;
+  logic [PENDING_BITS-1:0] pending;  // Bursts waiting for B
+  logic wlen_pop, b_done;
+
+  assign desc_pop = desc_count != 0 && (!m_axi_awvalid || m_axi_awready) &&
+      wlen_count != (DESC_BITS + 1)'(DESC_DEPTH) &&
+      pending != PENDING_BITS'(MAX_OUTSTANDING);
+
+  assign m_axi_awsize  = 3'b010;  // 4 bytes
+  assign m_axi_awburst = 2'b01;  // INCR
+  assign m_axi_awcache = 4'b0011;  // Normal, non-cacheable, bufferable
+  assign m_axi_awprot  = 3'b000;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      m_axi_awvalid <= 0;
+    end else if (!m_axi_awvalid || m_axi_awready) begin
+      m_axi_awvalid <= desc_pop;
+      m_axi_awaddr  <= desc_addr[desc_head];
+      m_axi_awlen   <= 8'(desc_len[desc_head] - 1);
+    end
+  end
+
+  // --- W ---
+  logic [LEN_BITS-1:0] beat;
+
+  assign m_axi_wvalid = wlen_count != 0 && data_count != 0;
+  assign m_axi_wdata = data_q[data_head];
+  assign m_axi_wstrb = 4'hf;
+  assign m_axi_wlast = beat == wlen_q[wlen_head] - 1;
+  assign data_pop = m_axi_wvalid && m_axi_wready;
+  assign wlen_pop = data_pop && m_axi_wlast;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      wlen_head <= '0;
+      wlen_tail <= '0;
+      wlen_count <= '0;
+      beat <= '0;
+    end else begin
+      if (desc_pop) begin
+        wlen_q[wlen_tail] <= desc_len[desc_head];
+        wlen_tail <= wlen_tail + 1;
+      end
+      if (wlen_pop) begin
+        wlen_head <= wlen_head + 1;
+        beat <= '0;
+      end else if (data_pop) begin
+        beat <= beat + 1;
+      end
+      wlen_count <= wlen_count + (DESC_BITS + 1)'(desc_pop) - (DESC_BITS + 1)'(wlen_pop);
+    end
+  end
+
+  // --- B ---
+  assign m_axi_bready = 1;
+  assign b_done = m_axi_bvalid && m_axi_bready;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      pending <= '0;
+    end else begin
+      pending <= pending + PENDING_BITS'(desc_pop) - PENDING_BITS'(b_done);
+    end
+  end
+
+  // --- Frame ---
+  logic idle;
+  assign idle = last_seen && !p_valid && !open && desc_count == 0 &&
+      !m_axi_awvalid && wlen_count == 0 && pending == 0;
+
+  always_ff @(posedge clk) begin
+    if (!resetn || start) begin
+      done <= 0;
+      frame_done <= 0;
+      error <= 0;
+    end else begin
+      done <= idle && !frame_done && !done;
+      if (done) frame_done <= 1;
+      if (b_done && m_axi_bresp != 2'b00) error <= 1;
+    end
+  end
+
+endmodule
@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Read-only set-associative cache for BVH nodes and primitives in DDR.
+//
+// A request names the line containing req_addr (a byte address) and gets the
+// whole line back, tagged with req_id. A line is LINE_WORDS words, 32 bytes
+// by default, which is one BVH node. Hits are answered two cycles after the
+// request. A miss allocates one of MSHRS miss registers and fetches the line
+// with an INCR burst on the AXI4 read master, using the miss register as
+// ARID, so up to MSHRS bursts are outstanding and may complete in any order.
+// Responses therefore leave out of request order; match them by resp_id.
+//
+// A request to a line that is already being fetched waits for the fill and
+// then hits, so no line is fetched twice. Lines are replaced round-robin per
+// set. flush invalidates every line and must only be raised while no miss is
+// outstanding, e.g. after a new scene has been written to DDR. rresp is
+// ignored.
+//
+// The stat_* counters run from reset:
+// - stat_hits, stat_misses: requests answered from the cache and from DDR
+// - stat_latency_sum, stat_latency_max: cycles from a miss to its fill
+// - stat_stalls: cycles with req_valid && !req_ready
+module rt_node_cache #(
+    parameter int WORD_LEN = 32,
+    parameter int ADDR_LEN = 32,
+    parameter int LINE_WORDS = 8,  // Words per line and burst, a power of two
+    parameter int SETS = 64,  // A power of two, at least 2
+    parameter int WAYS = 2,  // A power of two, at least 2
+    parameter int MSHRS = 4,  // Outstanding bursts, at least 2
+    parameter int AXI_ID_LEN = 2,  // At least $clog2(MSHRS)
+    parameter int REQ_ID_LEN = 8,
+    parameter int COUNTER_LEN = 32
+) (
+    input logic clk,
+    input logic resetn,
+    input logic flush,
+
+    // Line requests
+    input  logic                  req_valid,
+    output logic                  req_ready,
+    input  logic [  ADDR_LEN-1:0] req_addr,
+    input  logic [REQ_ID_LEN-1:0] req_id,
+
+    output logic                  resp_valid,
+    input  logic                  resp_ready,
+    output logic [REQ_ID_LEN-1:0] resp_id,
+    output logic                  resp_hit,
+    output logic [  WORD_LEN-1:0] resp_data [LINE_WORDS],
+
+    // AXI4 read master
+    output logic                  m_axi_arvalid,
+    input  logic                  m_axi_arready,
+    output logic [  ADDR_LEN-1:0] m_axi_araddr,
+    output logic [           7:0] m_axi_arlen,
+    output logic [           2:0] m_axi_arsize,
+    output logic [           1:0] m_axi_arburst,
+    output logic [           3:0] m_axi_arcache,
+    output logic [           2:0] m_axi_arprot,
+    output logic [AXI_ID_LEN-1:0] m_axi_arid,
+    input  logic                  m_axi_rvalid,
+    output logic                  m_axi_rready,
+    input  logic [  WORD_LEN-1:0] m_axi_rdata,
+    input  logic [           1:0] m_axi_rresp,
+    input  logic                  m_axi_rlast,
+    input  logic [AXI_ID_LEN-1:0] m_axi_rid,
+
+    // Statistics
+    output logic [COUNTER_LEN-1:0] stat_hits,
+    output logic [COUNTER_LEN-1:0] stat_misses,
+    output logic [COUNTER_LEN-1:0] stat_latency_sum,
+    output logic [COUNTER_LEN-1:0] stat_latency_max,
+    output logic [COUNTER_LEN-1:0] stat_stalls
+);
+
+  initial begin
+    if (MSHRS > 2 ** AXI_ID_LEN) begin
+      $error("AXI_ID_LEN must cover MSHRS");
+    end
+  end
+
+  localparam int OFFSET_BITS = $clog2(LINE_WORDS * WORD_LEN / 8);
+  localparam int SET_BITS = $clog2(SETS);
+  localparam int LINE_ADDR_BITS = ADDR_LEN - OFFSET_BITS;
+  localparam int TAG_BITS = LINE_ADDR_BITS - SET_BITS;
+  localparam int WAY_BITS = $clog2(WAYS);
+  localparam int MSHR_BITS = $clog2(MSHRS);
+  localparam int BEAT_BITS = $clog2(LINE_WORDS);
+  localparam int LINE_BITS = LINE_WORDS * WORD_LEN;
+
+  // --- Lookup ---
+  logic s1_valid;
+  logic [ADDR_LEN-1:0] s1_addr;
+  logic [REQ_ID_LEN-1:0] s1_id;
+  logic s1_hit_go, s1_miss_go;
+
+  logic [SET_BITS-1:0] req_set, s1_set, rd_set;
+  logic [LINE_ADDR_BITS-1:0] s1_line;
+  logic [TAG_BITS-1:0] s1_tag;
+  assign req_set = req_addr[OFFSET_BITS+:SET_BITS];
+  assign s1_set  = s1_addr[OFFSET_BITS+:SET_BITS];
+  assign s1_line = s1_addr[ADDR_LEN-1-:LINE_ADDR_BITS];
+  assign s1_tag  = s1_addr[ADDR_LEN-1-:TAG_BITS];
+
+  logic [TAG_BITS-1:0] tags[WAYS][SETS];
+  logic [SETS-1:0] tag_valid[WAYS];
+  logic [WAY_BITS-1:0] victim[SETS];
+  logic [LINE_BITS-1:0] way_line[WAYS];  // Registered read of rd_set
+
+  logic hit;
+  logic [WAY_BITS-1:0] hit_way;
+  always_comb begin
+    hit = 0;
+    hit_way = '0;
+    for (int w = 0; w < WAYS; w++) begin
+      if (tag_valid[w][s1_set] && tags[w][s1_set] == s1_tag) begin
+        hit = 1;
+        hit_way = WAY_BITS'(w);
+      end
+    end
+  end
+
+  // --- Miss registers ---
+  logic [MSHRS-1:0] mshr_valid, mshr_issued, mshr_done;
+  logic [LINE_ADDR_BITS-1:0] mshr_line[MSHRS];
+  logic [REQ_ID_LEN-1:0] mshr_id[MSHRS];
+  logic [BEAT_BITS-1:0] mshr_beat[MSHRS];
+  logic [COUNTER_LEN-1:0] mshr_start[MSHRS];
+  logic [WORD_LEN-1:0] mshr_buf[MSHRS][LINE_WORDS];
+  logic [COUNTER_LEN-1:0] stat_cycles;  // Time of the misses
+
+  logic in_flight;  // The line of s1 is being fetched
+  logic have_free, ar_pending, fill_pending;
+  logic [MSHR_BITS-1:0] free_mshr, ar_mshr, fill_mshr;
+  always_comb begin
+    in_flight = 0;
+    have_free = 0;
+    ar_pending = 0;
+    fill_pending = 0;
+    free_mshr = '0;
+    ar_mshr = '0;
+    fill_mshr = '0;
+    for (int m = MSHRS - 1; m >= 0; m--) begin
+      if (mshr_valid[m] && mshr_line[m] == s1_line) in_flight = 1;
+      if (!mshr_valid[m]) begin
+        have_free = 1;
+        free_mshr = MSHR_BITS'(m);
+      end
+      if (mshr_valid[m] && !mshr_issued[m]) begin
+        ar_pending = 1;
+        ar_mshr = MSHR_BITS'(m);
+      end
+      if (mshr_done[m]) begin
+        fill_pending = 1;
+        fill_mshr = MSHR_BITS'(m);
+      end
+    end
+  end
+
+  // --- Fill ---
+  // A completed burst is written into the cache and answered in the same
+  // cycle. It has priority over a hit for the response register.
+  logic slot_free, fill_go;
+  logic [SET_BITS-1:0] fill_set;
+  logic [TAG_BITS-1:0] fill_tag;
+  logic [WAY_BITS-1:0] fill_way;
+  logic [LINE_BITS-1:0] fill_line;
+
+  assign slot_free = !resp_valid || resp_ready;
+  assign fill_go   = fill_pending && slot_free;
+  assign fill_set  = mshr_line[fill_mshr][SET_BITS-1:0];
+  assign fill_tag  = mshr_line[fill_mshr][LINE_ADDR_BITS-1-:TAG_BITS];
+  assign fill_way  = victim[fill_set];
+  always_comb begin
+    for (int k = 0; k < LINE_WORDS; k++) begin
+      fill_line[k*WORD_LEN+:WORD_LEN] = mshr_buf[fill_mshr][k];
+    end
+  end
+
+  // way_line was read before a fill at the last edge to the same set
+  logic refill_q;
+  logic [SET_BITS-1:0] refill_set_q;
+  logic hazard;
+  assign hazard = refill_q && refill_set_q == s1_set;
+
+  assign s1_hit_go = s1_valid && hit && !hazard && slot_free && !fill_go;
+  assign s1_miss_go = s1_valid && !hit && !in_flight && have_free;
+  assign req_ready = !s1_valid || s1_hit_go || s1_miss_go;
+
+  // A waiting request reads its set again every cycle
+  assign rd_set = req_ready ? req_set : s1_set;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      s1_valid <= 0;
+    end else if (req_ready) begin
+      s1_valid <= req_valid;
+    end
+    if (req_ready) begin
+      s1_addr <= req_addr;
+      s1_id   <= req_id;
+    end
+
+    refill_q <= fill_go;
+    refill_set_q <= fill_set;
+  end
+
+  // --- Storage ---
+  always_ff @(posedge clk) begin
+    if (!resetn || flush) begin
+      for (int w = 0; w < WAYS; w++) begin
+        tag_valid[w] <= '0;
+      end
+    end else if (fill_go) begin
+      tag_valid[fill_way][fill_set] <= 1;
+    end
+
+    if (!resetn) begin
+      for (int s = 0; s < SETS; s++) begin
+        victim[s] <= '0;
+      end
+    end else if (fill_go) begin
+      victim[fill_set] <= fill_way + 1;
+    end
+
+    if (fill_go) begin
+      tags[fill_way][fill_set] <= fill_tag;
+    end
+  end
+
+  // One BRAM per way
+  genvar w;
+  generate
+    for (w = 0; w < WAYS; w++) begin : gen_way
+      logic [LINE_BITS-1:0] ram[SETS];
+      logic [LINE_BITS-1:0] q;
+
+      always_ff @(posedge clk) begin
+        if (fill_go && fill_way == WAY_BITS'(w)) begin
+          ram[fill_set] <= fill_line;
+        end
+        q <= ram[rd_set];
+      end
+
+      assign way_line[w] = q;
+    end
+  endgenerate
+
+  // --- Response ---
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      resp_valid <= 0;
+    end else if (fill_go) begin
+      resp_valid <= 1;
+      resp_id <= mshr_id[fill_mshr];
+      resp_hit <= 0;
+      resp_data <= mshr_buf[fill_mshr];
+    end else if (s1_hit_go) begin
+      resp_valid <= 1;
+      resp_id <= s1_id;
+      resp_hit <= 1;
+      for (int k = 0; k < LINE_WORDS; k++) begin
+        resp_data[k] <= way_line[hit_way][k*WORD_LEN+:WORD_LEN];
+      end
+    end else if (resp_ready) begin
+      resp_valid <= 0;
+    end
+  end
+
+  // --- AXI4 read master ---
+  // AR is registered so that it stays stable until accepted. Every beat is
+  // accepted: the line buffer of its miss register is always free.
+  assign m_axi_arlen = 8'(LINE_WORDS - 1);
+  assign m_axi_arsize = 3'($clog2(WORD_LEN / 8));
+  assign m_axi_arburst = 2'b01;  // INCR
+  assign m_axi_arcache = 4'b0011;  // Normal, non-cacheable, bufferable
+  assign m_axi_arprot = 3'b000;
+  assign m_axi_rready = 1;
+
+  logic ar_load;
+  logic [MSHR_BITS-1:0] r_mshr;
+  assign ar_load = ar_pending && (!m_axi_arvalid || m_axi_arready);
+  assign r_mshr  = MSHR_BITS'(m_axi_rid);
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      m_axi_arvalid <= 0;
+    end else if (!m_axi_arvalid || m_axi_arready) begin
+      m_axi_arvalid <= ar_pending;
+      m_axi_araddr <= {mshr_line[ar_mshr], OFFSET_BITS'(0)};
+      m_axi_arid <= AXI_ID_LEN'(ar_mshr);
+    end
+  end
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      mshr_valid  <= '0;
+      mshr_issued <= '0;
+      mshr_done   <= '0;
+    end else begin
+      if (s1_miss_go) begin
+        mshr_valid[free_mshr] <= 1;
+        mshr_issued[free_mshr] <= 0;
+        mshr_done[free_mshr] <= 0;
+        mshr_line[free_mshr] <= s1_line;
+        mshr_id[free_mshr] <= s1_id;
+        mshr_beat[free_mshr] <= '0;
+        mshr_start[free_mshr] <= stat_cycles;
+      end
+
+      if (ar_load) begin
+        mshr_issued[ar_mshr] <= 1;
+      end
+
+      if (m_axi_rvalid && m_axi_rready) begin
+        mshr_buf[r_mshr][mshr_beat[r_mshr]] <= m_axi_rdata;
+        mshr_beat[r_mshr] <= mshr_beat[r_mshr] + 1;
+        if (m_axi_rlast) mshr_done[r_mshr] <= 1;
+      end
+
+      if (fill_go) begin
+        mshr_valid[fill_mshr] <= 0;
+        mshr_done[fill_mshr]  <= 0;
+      end
+    end
+  end
+
+  // --- Statistics ---
+  logic [COUNTER_LEN-1:0] latency;
+  assign latency = stat_cycles - mshr_start[fill_mshr];
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      stat_cycles <= '0;
+      stat_hits <= '0;
+      stat_misses <= '0;
+      stat_latency_sum <= '0;
+      stat_latency_max <= '0;
+      stat_stalls <= '0;
+    end else begin
+      stat_cycles <= stat_cycles + 1;
+      if (s1_hit_go) stat_hits <= stat_hits + 1;
+      if (s1_miss_go) stat_misses <= stat_misses + 1;
+      if (fill_go) begin
+        stat_latency_sum <= stat_latency_sum + latency;
+        if (latency > stat_latency_max) stat_latency_max <= latency;
+      end
+      if (req_valid && !req_ready) stat_stalls <= stat_stalls + 1;
+    end
+  end
+
+endmodule
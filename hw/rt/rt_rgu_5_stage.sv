@@ -71,11 +71,18 @@ module rt_rgu_5_stage (
   // --- Combinational Logic for Pipeline Stages ---
 
   // Stage 1 Logic (Inputs: x_reg, y_reg)
+  // Pixel deltas in (27 - FP_QW).FP_QW and integer coordinates in
+  // FP_IW.(18 - FP_IW) keep all of their bits, so each product fits one
+  // DSP48E2 without changing the result (see sfp_mul).
+  localparam int RGU_DSP = (FP_QW <= 26) && (FP_IW <= 18);
   sfp_if #(FP_IW, FP_QW) tmp_x_delta_u_stage1[3] ();
   sfp_if #(FP_IW, FP_QW) tmp_y_delta_v_stage1[3] ();
 
   sfp_vec_mul_s #(
-      .CLIP(0)
+      .CLIP(0),
+      .DSP(RGU_DSP),
+      .DSP_X_IW(27 - FP_QW),
+      .DSP_Y_IW(FP_IW)
   ) mul_x_delta (
       .a(pixel_delta_u_fp),
       .s(x_reg),  // Use registered input
@@ -83,7 +90,10 @@ module rt_rgu_5_stage (
   );
 
   sfp_vec_mul_s #(
-      .CLIP(0)
+      .CLIP(0),
+      .DSP(RGU_DSP),
+      .DSP_X_IW(27 - FP_QW),
+      .DSP_Y_IW(FP_IW)
   ) mul_y_delta (
       .a(pixel_delta_v_fp),
       .s(y_reg),  // Use registered input
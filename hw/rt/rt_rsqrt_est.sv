@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Initial estimate of 1 / sqrt(in) for goldschmidt, in > 0.
+//
+// For in = 2^m * (1 + f) the estimate is 2^(-m/2) / sqrt(1 + f), read from a
+// table indexed by the parity of m and the INDEX_BITS bits of f below the
+// leading one. Each entry holds the value at the centre of its interval, so
+// the estimate is within 1.6 % for INDEX_BITS = 4 and one goldschmidt
+// iteration brings it to 0.04 %. Combinational; see shader_rsqrt_estimate()
+// in sw/model/shader_interpreter.hpp.
+module rt_rsqrt_est #(
+    parameter int INDEX_BITS = 4
+) (
+    sfp_if.in  in,
+    sfp_if.out est
+);
+  localparam int WL = in.IW + in.QW;
+  localparam int QW = in.QW;
+  localparam int ENTRIES = 1 << INDEX_BITS;
+
+  function automatic logic [WL-1:0] table_value(int parity, int index);
+    real scale = parity ? 2.0 : 1.0;
+    real mantissa = 1.0 + (real'(index) + 0.5) / real'(ENTRIES);
+    // real to integer conversion rounds to the nearest value
+    return WL'(longint'((2.0 ** QW) / $sqrt(scale * mantissa)));
+  endfunction
+
+  logic [WL-1:0] lut[2][ENTRIES];
+  genvar p, i;
+  generate
+    for (p = 0; p < 2; p++) begin : gen_parity
+      for (i = 0; i < ENTRIES; i++) begin : gen_index
+        assign lut[p][i] = table_value(p, i);
+      end
+    end
+  endgenerate
+
+  // Position of the leading one
+  logic [$clog2(WL)-1:0] msb;
+  always_comb begin
+    msb = '0;
+    for (int b = 0; b < WL; b++) begin
+      if (in.val[b]) msb = b[$clog2(WL)-1:0];
+    end
+  end
+
+  int m, k;
+  logic [INDEX_BITS-1:0] index;
+  logic [WL+INDEX_BITS-1:0] shifted;
+  logic signed [2*WL-1:0] value;
+
+  always_comb begin
+    m = int'(msb) - QW;
+    k = m >>> 1;  // floor(m / 2), m = 2k + parity
+    shifted = {in.val, INDEX_BITS'(0)} >> msb;
+    index = shifted[INDEX_BITS-1:0];
+    value = (2 * WL)'(lut[m&1][index]);
+    if (k >= 0) value = value >>> k;
+    else value = value << -k;
+  end
+
+  assign est.val = value[WL-1:0];
+
+endmodule
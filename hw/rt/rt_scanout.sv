@@ -0,0 +1,292 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Double-buffered scan-out engine.
+//
+// Reads the front framebuffer over an AXI4 read master and sends it at video
+// timing as an AXI4-Stream video: m_axis_tvalid follows the active video
+// area, tuser marks the first pixel of a frame and tlast the last pixel of
+// a line. The sink must accept a pixel every clock (aclk is the pixel
+// clock), as the AXI4-Stream to Video Out IP or a DVI/HDMI encoder does.
+// hsync, vsync and de are aligned with the stream for a direct encoder.
+//
+// Framebuffers are H_ACTIVE x V_ACTIVE words in XRGB8888 with stride bytes
+// between rows; tdata is the RGB888 part of the word. A line FIFO of
+// FIFO_DEPTH words is refilled with INCR bursts of up to MAX_BURST beats,
+// several of them outstanding. A pixel that has not arrived in time is sent
+// black and counted in stat_underflows; its word is dropped when it arrives,
+// so the pixels after it stay in place. The read master returns at most one
+// word per clock, so a backlog of late words is only worked off in the
+// blanking.
+//
+// The renderer draws into the back buffer (base1 while front is 0) and
+// raises swap for one cycle when it is complete. The buffers are exchanged
+// at the start of the next vertical blank, so a frame is never shown half
+// old and half new; swap_pending is high until then, and the back buffer
+// must not be written while it is. The front buffer is then fetched during
+// the blank.
+//
+// Timings with a pixel clock of aclk:
+// - 640x480@60, 25.175 MHz: H 640 16 96 48, V 480 10 2 33, negative syncs
+// - 1280x720@60, 74.25 MHz: H 1280 110 40 220, V 720 5 5 20, positive syncs
+module rt_scanout #(
+    parameter int H_ACTIVE = 640,
+    parameter int H_FP = 16,
+    parameter int H_SYNC = 96,
+    parameter int H_BP = 48,
+    parameter int V_ACTIVE = 480,
+    parameter int V_FP = 10,
+    parameter int V_SYNC = 2,
+    parameter int V_BP = 33,
+    parameter bit SYNC_POSITIVE = 0,
+    parameter int ADDR_LEN = 32,
+    parameter int FIFO_DEPTH = 2048,  // A power of two, at least 2 * MAX_BURST
+    parameter int MAX_BURST = 16,  // At most 256
+    parameter int COUNTER_LEN = 32
+) (
+    input logic aclk,
+    input logic resetn,
+
+    input  logic [ADDR_LEN-1:0] base0,
+    input  logic [ADDR_LEN-1:0] base1,
+    input  logic [ADDR_LEN-1:0] stride,
+    input  logic                swap,
+    output logic                swap_pending,
+    output logic                front,         // Buffer on screen
+    output logic                vblank,
+
+    // Video
+    output logic        m_axis_tvalid,
+    input  logic        m_axis_tready,
+    output logic [23:0] m_axis_tdata,
+    output logic        m_axis_tuser,
+    output logic        m_axis_tlast,
+    output logic        hsync,
+    output logic        vsync,
+    output logic        de,
+
+    // AXI4 read master
+    output logic                m_axi_arvalid,
+    input  logic                m_axi_arready,
+    output logic [ADDR_LEN-1:0] m_axi_araddr,
+    output logic [         7:0] m_axi_arlen,
+    output logic [         2:0] m_axi_arsize,
+    output logic [         1:0] m_axi_arburst,
+    output logic [         3:0] m_axi_arcache,
+    output logic [         2:0] m_axi_arprot,
+    output logic                m_axi_arid,
+    input  logic                m_axi_rvalid,
+    output logic                m_axi_rready,
+    input  logic [        31:0] m_axi_rdata,
+    input  logic                m_axi_rlast,
+    input  logic                m_axi_rid,
+    input  logic [         1:0] m_axi_rresp,
+
+    // Statistics
+    output logic [COUNTER_LEN-1:0] stat_frames,
+    output logic [COUNTER_LEN-1:0] stat_underflows,
+    output logic [COUNTER_LEN-1:0] stat_stalls  // Pixels the sink refused
+);
+
+  localparam int H_TOTAL = H_ACTIVE + H_FP + H_SYNC + H_BP;
+  localparam int V_TOTAL = V_ACTIVE + V_FP + V_SYNC + V_BP;
+  localparam int H_BITS = $clog2(H_TOTAL);
+  localparam int V_BITS = $clog2(V_TOTAL);
+  localparam int FIFO_BITS = $clog2(FIFO_DEPTH);
+  localparam int LEN_BITS = $clog2(MAX_BURST + 1);
+
+  // --- Timing ---
+  // Counting starts in the vertical blank so that the first frame is
+  // fetched before it is shown
+  logic [H_BITS-1:0] h;
+  logic [V_BITS-1:0] v;
+  logic active, blank_start;
+
+  assign active = h < H_BITS'(H_ACTIVE) && v < V_BITS'(V_ACTIVE);
+  assign blank_start = h == 0 && v == V_BITS'(V_ACTIVE);
+
+  always_ff @(posedge aclk) begin
+    if (!resetn) begin
+      h <= '0;
+      v <= V_BITS'(V_ACTIVE);
+    end else if (h == H_BITS'(H_TOTAL - 1)) begin
+      h <= '0;
+      v <= v == V_BITS'(V_TOTAL - 1) ? '0 : v + 1;
+    end else begin
+      h <= h + 1;
+    end
+  end
+
+  // --- Buffer swap ---
+  always_ff @(posedge aclk) begin
+    if (!resetn) begin
+      front <= 0;
+      swap_pending <= 0;
+    end else if (blank_start && swap_pending) begin
+      front <= !front;
+      swap_pending <= swap;
+    end else if (swap) begin
+      swap_pending <= 1;
+    end
+  end
+
+  // --- Line FIFO ---
+  // A block RAM with a registered read. The oldest word is prefetched into
+  // q, which the next active pixel shows. missed counts the pixels that were
+  // sent black while q was empty. Their words are skipped at the head of the
+  // RAM as soon as they are there, all in one cycle, and the word after them
+  // is loaded into q in the same cycle.
+  localparam int PIXEL_BITS = $clog2(H_ACTIVE * V_ACTIVE + 1);
+
+  logic [31:0] fifo[FIFO_DEPTH];
+  logic [31:0] q;
+  logic q_valid;
+  logic [FIFO_BITS-1:0] head, tail;
+  logic [FIFO_BITS:0] count;  // Words in the RAM, without q
+  logic [FIFO_BITS:0] reserved;  // Beats requested and not yet received
+  logic [PIXEL_BITS-1:0] missed;
+  logic [PIXEL_BITS:0] behind;  // Missed pixels, with the one of this cycle
+  logic [FIFO_BITS:0] skip;  // Words dropped in this cycle
+  logic push, pop, underflow, load, flush;
+
+  assign push = m_axi_rvalid && m_axi_rready;
+  assign pop = active && q_valid;
+  assign underflow = active && !q_valid;
+  assign behind = (PIXEL_BITS + 1)'(missed) + (PIXEL_BITS + 1)'(underflow);
+  assign skip = 32'(count) > 32'(behind) ? (FIFO_BITS + 1)'(behind) : count;
+  assign load = count > skip && (!q_valid || pop);
+
+  always_ff @(posedge aclk) begin
+    if (push) fifo[tail] <= m_axi_rdata;
+    if (load) q <= fifo[head+FIFO_BITS'(skip)];
+  end
+
+  always_ff @(posedge aclk) begin
+    if (!resetn || flush) begin
+      head <= '0;
+      tail <= '0;
+      count <= '0;
+      q_valid <= 0;
+      missed <= '0;
+    end else begin
+      if (push) tail <= tail + 1;
+      head <= head + FIFO_BITS'(skip) + FIFO_BITS'(load);
+      count <= count + (FIFO_BITS + 1)'(push) - skip - (FIFO_BITS + 1)'(load);
+      q_valid <= load || (q_valid && !pop);
+      missed <= PIXEL_BITS'(behind - (PIXEL_BITS + 1)'(skip));
+    end
+  end
+
+  // --- Fetch ---
+  // A new frame is fetched from the start of every vertical blank, once the
+  // bursts of the last frame have arrived
+  logic fetching, restart;
+  logic [V_BITS-1:0] fetch_y;
+  logic [H_BITS-1:0] fetch_x;
+  logic [ADDR_LEN-1:0] line_addr, fetch_addr;
+  logic [LEN_BITS-1:0] len;
+  logic [H_BITS:0] to_line_end;
+  logic [10:0] to_page_end;
+  logic issue;
+
+  assign fetch_addr = line_addr + ADDR_LEN'({fetch_x, 2'b00});
+  assign to_line_end = (H_BITS + 1)'(H_ACTIVE) - (H_BITS + 1)'(fetch_x);
+  assign to_page_end = 11'((13'h1000 - {1'b0, fetch_addr[11:0]}) >> 2);
+
+  always_comb begin
+    len = LEN_BITS'(MAX_BURST);
+    if (to_line_end < (H_BITS + 1)'(len)) len = LEN_BITS'(to_line_end);
+    if (to_page_end < 11'(len)) len = LEN_BITS'(to_page_end);
+  end
+
+  assign flush = restart && reserved == 0 && !m_axi_arvalid;
+  assign issue = fetching && (!m_axi_arvalid || m_axi_arready) &&
+      (FIFO_BITS + 1)'(FIFO_DEPTH) - count - reserved >= (FIFO_BITS + 1)'(MAX_BURST);
+
+  always_ff @(posedge aclk) begin
+    if (!resetn) begin
+      fetching <= 0;
+      restart  <= 0;
+    end else begin
+      if (blank_start) begin
+        fetching <= 0;
+        restart  <= 1;
+      end else if (flush) begin
+        restart <= 0;
+        fetching <= 1;
+        fetch_x <= '0;
+        fetch_y <= '0;
+        line_addr <= front ? base1 : base0;
+      end else if (issue) begin
+        if ((H_BITS + 1)'(len) == to_line_end) begin
+          fetch_x <= '0;
+          fetch_y <= fetch_y + 1;
+          line_addr <= line_addr + stride;
+          if (fetch_y == V_BITS'(V_ACTIVE - 1)) fetching <= 0;
+        end else begin
+          fetch_x <= fetch_x + H_BITS'(len);
+        end
+      end
+    end
+  end
+
+  assign m_axi_arsize = 3'b010;  // 4 bytes
+  assign m_axi_arburst = 2'b01;  // INCR
+  assign m_axi_arcache = 4'b0011;  // Normal, non-cacheable, bufferable
+  assign m_axi_arprot = 3'b000;
+  assign m_axi_arid = 0;  // In order
+  assign m_axi_rready = 1;
+
+  always_ff @(posedge aclk) begin
+    if (!resetn) begin
+      m_axi_arvalid <= 0;
+      reserved <= '0;
+    end else begin
+      if (!m_axi_arvalid || m_axi_arready) begin
+        m_axi_arvalid <= issue;
+        m_axi_araddr  <= fetch_addr;
+        m_axi_arlen   <= 8'(len - 1);
+      end
+      reserved <= reserved + (issue ? (FIFO_BITS + 1)'(len) : '0) - (FIFO_BITS + 1)'(push);
+    end
+  end
+
+  // --- Output ---
+  logic [H_BITS-1:0] sync_h;
+  logic [V_BITS-1:0] sync_v;
+  assign sync_h = h - H_BITS'(H_ACTIVE + H_FP);
+  assign sync_v = v - V_BITS'(V_ACTIVE + V_FP);
+
+  always_ff @(posedge aclk) begin
+    if (!resetn) begin
+      m_axis_tvalid <= 0;
+      de <= 0;
+      hsync <= !SYNC_POSITIVE;
+      vsync <= !SYNC_POSITIVE;
+      vblank <= 1;
+    end else begin
+      m_axis_tvalid <= active;
+      de <= active;
+      hsync <= (sync_h < H_BITS'(H_SYNC)) == SYNC_POSITIVE;
+      vsync <= (sync_v < V_BITS'(V_SYNC)) == SYNC_POSITIVE;
+      vblank <= v >= V_BITS'(V_ACTIVE);
+    end
+    m_axis_tdata <= q_valid ? q[23:0] : '0;
+    m_axis_tuser <= h == 0 && v == 0;
+    m_axis_tlast <= h == H_BITS'(H_ACTIVE - 1);
+  end
+
+  // --- Statistics ---
+  always_ff @(posedge aclk) begin
+    if (!resetn) begin
+      stat_frames <= '0;
+      stat_underflows <= '0;
+      stat_stalls <= '0;
+    end else begin
+      if (active && h == 0 && v == 0) stat_frames <= stat_frames + 1;
+      if (underflow) stat_underflows <= stat_underflows + 1;
+      if (m_axis_tvalid && !m_axis_tready) stat_stalls <= stat_stalls + 1;
+    end
+  end
+
+endmodule
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Double-buffered scene memory.
+//
+// Holds the object data of the scene (spheres, triangles, BVH nodes) in two
+// DEPTH-word buffers of a dp_block_ram. The loader writes a blob into the
+// back buffer at one word per clock while the intersection units read the
+// front buffer, and swap exchanges them at a frame boundary.
+//
+// A blob is a length header with the number of words that follow, then the
+// words. in_last ends a blob early; the words received up to and including
+// it are kept. Words past DEPTH are dropped and set overflow. done is high
+// with the handshake of the last word (or of the header of an empty blob).
+//
+// swap makes the last complete blob the front buffer. Without a new blob it
+// has no effect, so the scene stays loaded across frames.
+//
+// Reads have a latency of one cycle.
+module rt_scene_mem #(
+    parameter int WORD_LEN = 32,
+    parameter int DEPTH = 4096  // Words per buffer, a power of two
+) (
+    input logic clk,
+    input logic resetn,
+
+    // Loader
+    input  logic                in_valid,
+    input  logic                in_header,  // in_data is the length header
+    input  logic [WORD_LEN-1:0] in_data,
+    input  logic                in_last,
+    output logic                done,
+
+    input logic swap,
+
+    // Front buffer
+    input  logic                     rd_en,
+    input  logic [$clog2(DEPTH)-1:0] rd_addr,
+    output logic [     WORD_LEN-1:0] rd_data,
+    output logic [     WORD_LEN-1:0] length,    // Words in the front buffer
+    output logic                     overflow   // The last blob was cut at DEPTH
+);
+
+  localparam int ADDR_LEN = $clog2(DEPTH);
+
+  logic front;  // Buffer read by rd_addr
+  logic back_valid;  // The back buffer holds a complete blob
+  logic [WORD_LEN-1:0] back_length;
+  logic back_overflow;
+
+  logic [WORD_LEN-1:0] expected;  // From the header
+  logic [WORD_LEN-1:0] received;
+
+  logic write;
+  assign write = in_valid && !in_header && received < DEPTH;
+  assign done = in_valid &&
+      (in_last || (in_header ? in_data == 0 : received == expected - 1));
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      front <= 0;
+      back_valid <= 0;
+      length <= 0;
+      overflow <= 0;
+      received <= 0;
+    end else begin
+      if (in_valid) begin
+        if (in_header) begin
+          expected <= in_data;
+          received <= 0;
+          back_valid <= 0;
+          back_overflow <= 0;
+        end else begin
+          received <= received + 1;
+          if (!write) back_overflow <= 1;
+        end
+
+        if (done) begin
+          back_valid <= 1;
+          back_length <= in_header ? 0 : received + 1;
+        end
+      end
+
+      if (swap && back_valid) begin
+        front <= !front;
+        back_valid <= 0;
+        length <= back_length > DEPTH ? DEPTH : back_length;
+        overflow <= back_overflow;
+      end
+    end
+  end
+
+  dp_block_ram #(
+      .WORD_LEN(WORD_LEN),
+      .DEPTH(2 * DEPTH)
+  ) ram (
+      .clk(clk),
+      .ena(write),
+      .wea(1'b1),
+      .addra({!front, received[ADDR_LEN-1:0]}),
+      .dia(in_data),
+      .doa(),
+      .enb(rd_en),
+      .web(1'b0),
+      .addrb({front, rd_addr}),
+      .dib('0),
+      .dob(rd_data)
+  );
+
+endmodule
@@ -0,0 +1,346 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+`include "parameters.vh"
+`include "shader_isa.vh"
+
+// Programmable SIMD shader core.
+//
+// LANES fragments enter per beat with the ray direction and origin, run the
+// program in the instruction memory and leave with r0 as their colour.
+// Fragments are shaded in batches of THREADS beats: the core issues one
+// instruction per clock to every lane, cycling through the THREADS
+// fragments of the batch before moving to the next instruction. The result
+// of an instruction is written back before the same fragment issues again,
+// so the rt_alu_vec pipeline never stalls and needs no forwarding.
+//
+// A batch of THREADS beats takes 2 * THREADS cycles to load, THREADS cycles
+// per instruction to run, SHADER_ALU_LATENCY + 1 cycles to drain and THREADS
+// cycles to store. in_last closes a batch early and is passed on with its
+// last fragment. Registers other than r0 and r1 start undefined.
+//
+// The program is loaded through s_cfg while the core is idle: a header
+// {constants[31:16], instructions[15:0]}, one word per instruction, then the
+// x, y and z words of every constant. See sw/model/shader_isa.hpp.
+module rt_shader_core #(
+    parameter int LANES = 1,
+    parameter int THREADS = 8  // Fragments in flight per lane
+) (
+    input logic clk,
+    input logic resetn,
+
+    // Program
+    input  logic        s_cfg_tvalid,
+    output logic        s_cfg_tready,
+    input  logic [31:0] s_cfg_tdata,
+    input  logic        s_cfg_tlast,
+    output logic        program_loaded,
+
+    // Fragments: direction and origin of LANES rays
+    input  logic                    in_valid,
+    output logic                    in_ready,
+    input  logic                    in_last,
+    input  logic signed [FP_WL-1:0] in_direction[LANES*3],
+    input  logic signed [FP_WL-1:0] in_origin   [LANES*3],
+
+    // Colours
+    output logic                    out_valid,
+    input  logic                    out_ready,
+    output logic                    out_last,
+    output logic signed [FP_WL-1:0] out_color[LANES*3]
+);
+
+  initial begin
+    if (THREADS < SHADER_ALU_LATENCY + 2) begin
+      $error("THREADS must cover the operand register, rt_alu_vec and the write back");
+    end
+  end
+
+  localparam int THREAD_BITS = $clog2(THREADS);
+  localparam int REG_BITS = $clog2(SHADER_REGS);
+  localparam int PC_BITS = $clog2(SHADER_IMEM_DEPTH);
+  localparam int TAG_LEN = THREAD_BITS + REG_BITS;
+
+  typedef enum logic [2:0] {
+    IDLE,
+    LOAD,
+    RUN,
+    DRAIN,
+    STORE
+  } state_t;
+
+  typedef enum logic [1:0] {
+    CFG_HEADER,
+    CFG_CODE,
+    CFG_CONST
+  } cfg_state_t;
+
+  state_t state;
+  cfg_state_t cfg_state;
+
+  logic [THREAD_BITS-1:0] t;
+  logic [THREAD_BITS:0] count;  // Fragments in the batch
+  logic [PC_BITS-1:0] pc;
+  logic phase;  // LOAD: 0 = direction, 1 = origin
+  logic last_batch;
+  logic [$clog2(SHADER_ALU_LATENCY+1)-1:0] drain;
+
+  // --- Program ---
+  logic [15:0] n_inst, n_const;
+  logic [15:0] cfg_count;
+  logic [1:0] cfg_component;
+
+  logic [31:0] imem[SHADER_IMEM_DEPTH];
+  logic [31:0] inst;
+  logic [PC_BITS-1:0] imem_addr;
+
+  logic signed [FP_WL-1:0] constants[SHADER_CONSTS][3];
+
+  // A new program is loaded between batches, before any waiting fragments
+  logic start_batch;
+  assign s_cfg_tready = state == IDLE;
+  assign start_batch = state == IDLE && in_valid && program_loaded &&
+      cfg_state == CFG_HEADER && !s_cfg_tvalid;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      cfg_state <= CFG_HEADER;
+      program_loaded <= 0;
+    end else if (s_cfg_tvalid && s_cfg_tready) begin
+      case (cfg_state)
+        CFG_HEADER: begin
+          n_inst <= s_cfg_tdata[15:0];
+          n_const <= s_cfg_tdata[31:16];
+          cfg_count <= 0;
+          cfg_component <= 0;
+          program_loaded <= 0;
+          if (s_cfg_tdata[15:0] != 0) cfg_state <= CFG_CODE;
+          else if (s_cfg_tdata[31:16] != 0) cfg_state <= CFG_CONST;
+        end
+        CFG_CODE: begin
+          if (cfg_count == n_inst - 1) begin
+            cfg_count <= 0;
+            if (n_const != 0) begin
+              cfg_state <= CFG_CONST;
+            end else begin
+              cfg_state <= CFG_HEADER;
+              program_loaded <= 1;
+            end
+          end else begin
+            cfg_count <= cfg_count + 1;
+          end
+        end
+        CFG_CONST: begin
+          if (cfg_component == 2) begin
+            cfg_component <= 0;
+            if (cfg_count == n_const - 1) begin
+              cfg_state <= CFG_HEADER;
+              program_loaded <= n_inst != 0;
+            end else begin
+              cfg_count <= cfg_count + 1;
+            end
+          end else begin
+            cfg_component <= cfg_component + 1;
+          end
+        end
+        default: cfg_state <= CFG_HEADER;
+      endcase
+    end
+  end
+
+  // Instruction and constant memories (BRAM and LUTRAM)
+  always_ff @(posedge clk) begin
+    if (s_cfg_tvalid && s_cfg_tready && cfg_state == CFG_CODE) begin
+      imem[cfg_count[PC_BITS-1:0]] <= s_cfg_tdata;
+    end
+    if (s_cfg_tvalid && s_cfg_tready && cfg_state == CFG_CONST) begin
+      constants[cfg_count[$clog2(SHADER_CONSTS)-1:0]][cfg_component] <= s_cfg_tdata;
+    end
+    inst <= imem[imem_addr];
+  end
+
+  // The read is registered: fetch the next instruction while the last
+  // fragment issues the current one
+  always_comb begin
+    if (state == RUN) begin
+      imem_addr = t == THREAD_BITS'(THREADS - 1) ? pc + 1 : pc;
+    end else begin
+      imem_addr = '0;
+    end
+  end
+
+  // --- Control ---
+  logic [15:0] last_pc;
+  assign last_pc = n_inst - 1;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      state <= IDLE;
+      phase <= 0;
+    end else begin
+      case (state)
+        IDLE: begin
+          if (start_batch) begin
+            state <= LOAD;
+            t <= 0;
+            phase <= 0;
+          end
+        end
+        LOAD: begin
+          if (in_valid) begin
+            phase <= !phase;
+            if (phase) begin
+              count <= t + 1;
+              if (t == THREAD_BITS'(THREADS - 1) || in_last) begin
+                state <= RUN;
+                t <= 0;
+                pc <= 0;
+                last_batch <= in_last;
+              end else begin
+                t <= t + 1;
+              end
+            end
+          end
+        end
+        RUN: begin
+          if (t == THREAD_BITS'(THREADS - 1)) begin
+            t <= 0;
+            if (16'(pc) == last_pc) begin
+              state <= DRAIN;
+              drain <= $bits(drain)'(SHADER_ALU_LATENCY);
+            end else begin
+              pc <= pc + 1;
+            end
+          end else begin
+            t <= t + 1;
+          end
+        end
+        DRAIN: begin
+          if (drain == 0) begin
+            state <= STORE;
+            t <= 0;
+          end else begin
+            drain <= drain - 1;
+          end
+        end
+        STORE: begin
+          if (out_ready) begin
+            if ((THREAD_BITS + 1)'(t) == count - 1) begin
+              state <= IDLE;
+            end else begin
+              t <= t + 1;
+            end
+          end
+        end
+        default: state <= IDLE;
+      endcase
+    end
+  end
+
+  assign in_ready  = state == LOAD && phase;
+  assign out_valid = state == STORE;
+  assign out_last  = last_batch && (THREAD_BITS + 1)'(t) == count - 1;
+
+  // --- Lanes ---
+  logic [SHADER_OP_LEN-1:0] inst_op;
+  logic [REG_BITS-1:0] inst_d, inst_a, inst_b, inst_c;
+  logic [3:0] inst_k;
+  logic inst_writes;
+
+  assign inst_op = `SHADER_INST_OP(inst);
+  assign inst_d = REG_BITS'(`SHADER_INST_D(inst));
+  assign inst_a = REG_BITS'(`SHADER_INST_A(inst));
+  assign inst_b = REG_BITS'(`SHADER_INST_B(inst));
+  assign inst_c = REG_BITS'(`SHADER_INST_C(inst));
+  assign inst_k = `SHADER_INST_K(inst);
+  assign inst_writes = state == RUN && inst_op != SHADER_OP_NOP && inst_op <= SHADER_OP_SPLAT;
+
+  logic signed [FP_WL-1:0] constant[3];
+  always_comb begin
+    for (int n = 0; n < 3; n++) begin
+      constant[n] = 16'(inst_k) < n_const ? constants[inst_k][n] : '0;
+    end
+  end
+
+  // Operand registers, shared by the lanes except for the values
+  logic op_valid;
+  logic [TAG_LEN-1:0] op_tag;
+  logic [SHADER_OP_LEN-1:0] op_op;
+  logic [3:0] op_k;
+
+  always_ff @(posedge clk) begin
+    if (!resetn) begin
+      op_valid <= 0;
+    end else begin
+      op_valid <= inst_writes;
+    end
+    op_tag <= {t, inst_d};
+    op_op  <= inst_op;
+    op_k   <= inst_k;
+  end
+
+  genvar l;
+  generate
+    for (l = 0; l < LANES; l++) begin : gen_lane
+      // r0-r7 of every fragment: three asynchronous reads, one write
+      logic [3*FP_WL-1:0] regs[THREADS*SHADER_REGS];
+      logic [TAG_LEN-1:0] read_a;
+      logic signed [FP_WL-1:0] reg_a[3], reg_b[3], reg_c[3];
+      logic signed [FP_WL-1:0] op_a[3], op_b[3], op_c[3];
+
+      logic alu_valid;
+      logic [TAG_LEN-1:0] alu_tag;
+      logic signed [FP_WL-1:0] alu_out[3];
+
+      assign read_a = state == STORE ? {t, REG_BITS'(0)} : {t, inst_a};
+      for (genvar n = 0; n < 3; n++) begin : gen_read
+        assign reg_a[n] = regs[read_a][n*FP_WL+:FP_WL];
+        assign reg_b[n] = regs[{t, inst_b}][n*FP_WL+:FP_WL];
+        assign reg_c[n] = regs[{t, inst_c}][n*FP_WL+:FP_WL];
+        assign out_color[l*3+n] = reg_a[n];
+      end
+
+      always_ff @(posedge clk) begin
+        if (state == LOAD && in_valid) begin
+          if (phase) begin
+            regs[{t, REG_BITS'(1)}] <= {in_origin[l*3+2], in_origin[l*3+1], in_origin[l*3]};
+          end else begin
+            regs[{t, REG_BITS'(0)}] <= {
+              in_direction[l*3+2], in_direction[l*3+1], in_direction[l*3]
+            };
+          end
+        end else if (alu_valid) begin
+          regs[alu_tag] <= {alu_out[2], alu_out[1], alu_out[0]};
+        end
+
+        for (int n = 0; n < 3; n++) begin
+          op_a[n] <= inst_op == SHADER_OP_CONST ? constant[n] : reg_a[n];
+          op_b[n] <= reg_b[n];
+          op_c[n] <= reg_c[n];
+        end
+      end
+
+      rt_alu_vec #(
+          .WORD_LEN(FP_WL),
+          .IW(FP_IW),
+          .QW(FP_QW),
+          .OP_LEN(SHADER_OP_LEN),
+          .TAG_LEN(TAG_LEN)
+      ) alu (
+          .clk(clk),
+          .resetn(resetn),
+          .in_valid(op_valid),
+          .in_tag(op_tag),
+          .op(op_op),
+          .k(op_k),
+          .a(op_a),
+          .b(op_b),
+          .c(op_c),
+          .out_valid(alu_valid),
+          .out_tag(alu_tag),
+          .out(alu_out)
+      );
+    end
+  endgenerate
+
+endmodule
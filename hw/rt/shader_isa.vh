@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Instruction set of rt_shader_core, see sw/model/shader_isa.hpp for the
+// encoding and the assembler.
+
+`ifndef SHADER_ISA
+`define SHADER_ISA
+
+parameter SHADER_OP_LEN = 4;
+parameter SHADER_REGS = 8;
+parameter SHADER_CONSTS = 16;
+parameter SHADER_IMEM_DEPTH = 256;
+
+// Cycles from the operands at rt_alu_vec to its result
+parameter SHADER_ALU_LATENCY = 6;
+
+parameter SHADER_OP_NOP = 4'd0;
+parameter SHADER_OP_ADD = 4'd1;
+parameter SHADER_OP_SUB = 4'd2;
+parameter SHADER_OP_MUL = 4'd3;
+parameter SHADER_OP_DOT = 4'd4;
+parameter SHADER_OP_LERP = 4'd5;
+parameter SHADER_OP_RSQ = 4'd6;
+parameter SHADER_OP_MAX = 4'd7;
+parameter SHADER_OP_MIN = 4'd8;
+parameter SHADER_OP_MOV = 4'd9;
+parameter SHADER_OP_CONST = 4'd10;
+parameter SHADER_OP_SPLAT = 4'd11;
+
+// Instruction fields
+`define SHADER_INST_OP(w) w[31:28]
+`define SHADER_INST_D(w) w[27:24]
+`define SHADER_INST_A(w) w[23:20]
+`define SHADER_INST_B(w) w[19:16]
+`define SHADER_INST_C(w) w[15:12]
+`define SHADER_INST_K(w) w[3:0]
+
+`endif
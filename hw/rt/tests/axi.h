@@ -0,0 +1,306 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <verilated.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "axis.h"
+
+// Transaction-level DDR behind the AXI4 read master (m_axi_ar*, m_axi_r*)
+// of a Verilated model.
+//
+// A burst is returned latency cycles after its AR handshake, plus a random
+// jitter of up to jitter cycles, so bursts with different IDs may complete
+// out of order; bursts with the same ID complete in order. Beats of one
+// burst are not interleaved with other bursts.
+// bandwidth is the mean number of R beats per cycle (at most 1), and at most
+// max_outstanding bursts are accepted before arready is dropped. No R beat
+// starts in the pause cycles from cycle pause_at, as when another master
+// holds the memory.
+//
+// The memory holds axi_ddr_word(addr) at every word address, so a test can
+// check any line without a backing store of the size of the scene.
+//
+// Advanced once per clock cycle with axis_cycle() like the AXIS drivers.
+
+struct axi_ddr_config {
+  uint32_t latency = 40;
+  uint32_t jitter = 0;
+  double bandwidth = 1.0;
+  uint32_t max_outstanding = 16;
+  uint32_t seed = 1;
+  uint64_t pause_at = 0;
+  uint32_t pause = 0;
+};
+
+struct axi_ddr_stats {
+  uint64_t cycles = 0;
+  uint64_t bursts = 0;           // AR handshakes
+  uint64_t beats = 0;            // R handshakes
+  uint64_t max_outstanding = 0;  // Bursts accepted but not completed
+  uint64_t violations = 0;       // AR changed while stalled, or a bad burst
+};
+
+static inline uint32_t axi_ddr_word(uint32_t addr) {
+  uint32_t x = (addr >> 2) * 2654435761u;
+  return x ^ (x >> 15) ^ addr;
+}
+
+template <typename DUT> class axi_ddr {
+public:
+  axi_ddr(DUT &dut, axi_ddr_config config = {})
+      : dut(dut), config(config), rng(config.seed) {
+    dut.m_axi_arready = 0;
+    dut.m_axi_rvalid = 0;
+    dut.m_axi_rlast = 0;
+    dut.m_axi_rresp = 0;
+  }
+
+  void drive() {
+    if (r_accepted) {
+      // The model has seen the beat at the last clock edge
+      burst &b = active();
+      b.beat += 1;
+      if (b.beat == b.len) {
+        pending.erase(pending.begin() + current);
+        current = -1;
+      }
+      dut.m_axi_rvalid = 0;
+      dut.m_axi_rlast = 0;
+      r_accepted = false;
+    }
+
+    dut.m_axi_arready = pending.size() < config.max_outstanding;
+
+    credit = std::min(credit + config.bandwidth, 1.0);
+    bool paused = s.cycles >= config.pause_at &&
+                  s.cycles - config.pause_at < config.pause;
+    if (!dut.m_axi_rvalid && credit >= 1.0 && !paused) {
+      if (current < 0) {
+        current = next_ready();
+      }
+      if (current >= 0) {
+        burst &b = active();
+        uint32_t addr = b.addr + b.beat * 4;
+        dut.m_axi_rvalid = 1;
+        dut.m_axi_rdata = axi_ddr_word(addr);
+        dut.m_axi_rlast = b.beat == b.len - 1;
+        dut.m_axi_rid = b.id;
+        credit -= 1.0;
+      }
+    }
+  }
+
+  // Call after the model has settled and before the clock edge
+  void sample() {
+    bool ar = dut.m_axi_arvalid && dut.m_axi_arready;
+    if (ar_stalled && (!dut.m_axi_arvalid || dut.m_axi_araddr != held_addr ||
+                       dut.m_axi_arid != held_id)) {
+      s.violations += 1;
+    }
+    if (ar) {
+      // INCR bursts of 32-bit words only
+      if (dut.m_axi_arburst != 1 || dut.m_axi_arsize != 2) {
+        s.violations += 1;
+      }
+      uint64_t ready = s.cycles + config.latency;
+      if (config.jitter) {
+        ready += rng() % (config.jitter + 1);
+      }
+      pending.push_back({uint32_t(dut.m_axi_araddr), uint32_t(dut.m_axi_arid),
+                         uint32_t(dut.m_axi_arlen) + 1, 0, ready});
+      s.bursts += 1;
+      s.max_outstanding =
+          std::max<uint64_t>(s.max_outstanding, pending.size());
+    }
+    ar_stalled = dut.m_axi_arvalid && !dut.m_axi_arready;
+    held_addr = dut.m_axi_araddr;
+    held_id = dut.m_axi_arid;
+
+    if (dut.m_axi_rvalid && dut.m_axi_rready) {
+      r_accepted = true;
+      s.beats += 1;
+    }
+    s.cycles += 1;
+  }
+
+  bool idle() const { return pending.empty(); }
+  const axi_ddr_stats &stats() const { return s; }
+
+private:
+  struct burst {
+    uint32_t addr;
+    uint32_t id;
+    uint32_t len;
+    uint32_t beat;
+    uint64_t ready; // Cycle of the first beat
+  };
+
+  burst &active() { return pending[size_t(current)]; }
+
+  // Oldest burst whose data is available. Bursts with the same ID are
+  // returned in order.
+  int next_ready() const {
+    for (size_t i = 0; i < pending.size(); i++) {
+      bool first = true;
+      for (size_t j = 0; j < i; j++) {
+        first = first && pending[j].id != pending[i].id;
+      }
+      if (first && pending[i].ready <= s.cycles) {
+        return int(i);
+      }
+    }
+    return -1;
+  }
+
+  DUT &dut;
+  axi_ddr_config config;
+  std::mt19937 rng;
+
+  std::deque<burst> pending;
+  int current = -1;  // Burst being returned
+  bool r_accepted = false;
+  double credit = 0.0;
+
+  bool ar_stalled = false;
+  uint32_t held_addr = 0;
+  uint32_t held_id = 0;
+
+  axi_ddr_stats s;
+};
+
+// Transaction-level memory behind the AXI4 write master (m_axi_aw*,
+// m_axi_w*, m_axi_b*) of a Verilated model.
+//
+// awready and wready follow their axis_pattern; write data is accepted only
+// for bursts whose address has been accepted. The write response of a burst
+// is returned b_latency cycles after its last beat. Written words are kept
+// sparsely, by byte address.
+struct axi_mem_stats {
+  uint64_t bursts = 0;     // AW handshakes
+  uint64_t beats = 0;      // W handshakes
+  uint64_t responses = 0;  // B handshakes
+  uint64_t violations = 0; // Unstable AW or W, bad wlast, 4 KiB crossings
+
+  double mean_burst() const {
+    return bursts ? double(beats) / double(bursts) : 0.0;
+  }
+};
+
+template <typename DUT> class axi_mem {
+public:
+  axi_mem(DUT &dut, axis_pattern aw_ready = axis_pattern::always(),
+          axis_pattern w_ready = axis_pattern::always(),
+          uint32_t b_latency = 10)
+      : dut(dut), aw_ready(std::move(aw_ready)), w_ready(std::move(w_ready)),
+        b_latency(b_latency) {
+    dut.m_axi_awready = 0;
+    dut.m_axi_wready = 0;
+    dut.m_axi_bvalid = 0;
+    dut.m_axi_bresp = 0;
+  }
+
+  void drive() {
+    if (b_accepted) {
+      responses.pop_front();
+      dut.m_axi_bvalid = 0;
+      b_accepted = false;
+    }
+    dut.m_axi_awready = aw_ready.next();
+    dut.m_axi_wready = !bursts.empty() && w_ready.next();
+    if (!dut.m_axi_bvalid && !responses.empty() &&
+        responses.front() <= s_cycles) {
+      dut.m_axi_bvalid = 1;
+    }
+  }
+
+  // Call after the model has settled and before the clock edge
+  void sample() {
+    if (aw_stalled && (!dut.m_axi_awvalid || dut.m_axi_awaddr != held_addr ||
+                       dut.m_axi_awlen != held_len)) {
+      s.violations += 1;
+    }
+    if (w_stalled && (!dut.m_axi_wvalid || dut.m_axi_wdata != held_data ||
+                      bool(dut.m_axi_wlast) != held_last)) {
+      s.violations += 1;
+    }
+
+    if (dut.m_axi_awvalid && dut.m_axi_awready) {
+      uint32_t addr = dut.m_axi_awaddr;
+      uint32_t len = uint32_t(dut.m_axi_awlen) + 1;
+      if (dut.m_axi_awburst != 1 || dut.m_axi_awsize != 2 ||
+          (addr & 0xfff) + 4 * len > 0x1000) {
+        s.violations += 1;
+      }
+      bursts.push_back({addr, len, 0});
+      s.bursts += 1;
+    }
+
+    if (dut.m_axi_wvalid && dut.m_axi_wready) {
+      burst &b = bursts.front();
+      if (bool(dut.m_axi_wlast) != (b.beat == b.len - 1) ||
+          dut.m_axi_wstrb != 0xf) {
+        s.violations += 1;
+      }
+      memory[b.addr + 4 * b.beat] = dut.m_axi_wdata;
+      b.beat += 1;
+      s.beats += 1;
+      if (b.beat == b.len) {
+        bursts.pop_front();
+        responses.push_back(s_cycles + b_latency);
+      }
+    }
+
+    if (dut.m_axi_bvalid && dut.m_axi_bready) {
+      b_accepted = true;
+      s.responses += 1;
+    }
+
+    aw_stalled = dut.m_axi_awvalid && !dut.m_axi_awready;
+    held_addr = dut.m_axi_awaddr;
+    held_len = dut.m_axi_awlen;
+    w_stalled = dut.m_axi_wvalid && !dut.m_axi_wready;
+    held_data = dut.m_axi_wdata;
+    held_last = dut.m_axi_wlast;
+    s_cycles += 1;
+  }
+
+  bool idle() const { return bursts.empty() && responses.empty(); }
+  const axi_mem_stats &stats() const { return s; }
+
+  std::unordered_map<uint32_t, uint32_t> memory;
+
+private:
+  struct burst {
+    uint32_t addr;
+    uint32_t len;
+    uint32_t beat;
+  };
+
+  DUT &dut;
+  axis_pattern aw_ready;
+  axis_pattern w_ready;
+  uint32_t b_latency;
+
+  std::deque<burst> bursts;       // Address accepted, data outstanding
+  std::deque<uint64_t> responses; // Cycle from which B may be sent
+  bool b_accepted = false;
+
+  bool aw_stalled = false;
+  uint32_t held_addr = 0;
+  uint32_t held_len = 0;
+  bool w_stalled = false;
+  uint32_t held_data = 0;
+  bool held_last = false;
+
+  uint64_t s_cycles = 0;
+  axi_mem_stats s;
+};
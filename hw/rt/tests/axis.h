@@ -0,0 +1,312 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <verilated.h>
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Transaction-level AXI4-Stream drivers for Verilated models.
+//
+// axis_master drives a slave port of the model (tvalid, tdata, tlast) from a
+// queue of beats, axis_slave drives tready of a master port and collects the
+// beats, and axis_monitor passively records handshakes, per-beat latency,
+// stalls and protocol violations on either port. When tvalid and tready are
+// asserted is decided by an axis_pattern.
+//
+// All components are advanced once per clock cycle with axis_cycle().
+
+struct axis_beat {
+  uint32_t data;
+  bool last;
+
+  bool operator==(const axis_beat &o) const {
+    return data == o.data && last == o.last;
+  }
+};
+
+// Per-cycle on/off sequence for tvalid or tready
+class axis_pattern {
+public:
+  // Asserted every cycle
+  static axis_pattern always() { return axis_pattern(ALWAYS); }
+
+  // Asserted with probability p in every cycle
+  static axis_pattern random(double p, uint32_t seed = 1) {
+    axis_pattern pattern(RANDOM);
+    pattern.probability = p;
+    pattern.rng.seed(seed);
+    return pattern;
+  }
+
+  // on cycles asserted, then off cycles deasserted
+  static axis_pattern bursty(int on, int off) {
+    axis_pattern pattern(BURSTY);
+    pattern.on = on;
+    pattern.off = off;
+    return pattern;
+  }
+
+  // One character per cycle: '1' asserted, '0' deasserted. Whitespace is
+  // ignored and lines starting with '#' are comments. The sequence repeats.
+  static axis_pattern replay(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+      throw std::runtime_error("Cannot open pattern file " + path);
+    }
+    std::vector<bool> bits;
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty() && line[0] == '#') {
+        continue;
+      }
+      for (char c : line) {
+        if (c == '0' || c == '1') {
+          bits.push_back(c == '1');
+        }
+      }
+    }
+    return replay(bits);
+  }
+  static axis_pattern replay(std::vector<bool> bits) {
+    if (bits.empty()) {
+      throw std::runtime_error("Empty replay pattern");
+    }
+    axis_pattern pattern(REPLAY);
+    pattern.bits = std::move(bits);
+    return pattern;
+  }
+
+  // Value for the next cycle
+  bool next() {
+    switch (kind) {
+    case RANDOM:
+      return std::bernoulli_distribution(probability)(rng);
+    case BURSTY: {
+      bool value = position < uint64_t(on);
+      position = (position + 1) % uint64_t(on + off);
+      return value;
+    }
+    case REPLAY: {
+      bool value = bits[position];
+      position = (position + 1) % bits.size();
+      return value;
+    }
+    default:
+      return true;
+    }
+  }
+
+private:
+  enum kind_t { ALWAYS, RANDOM, BURSTY, REPLAY };
+
+  explicit axis_pattern(kind_t kind) : kind(kind) {}
+
+  kind_t kind;
+  double probability = 1.0;
+  std::mt19937 rng;
+  int on = 1;
+  int off = 0;
+  std::vector<bool> bits;
+  uint64_t position = 0;
+};
+
+struct axis_stats {
+  uint64_t cycles = 0;       // Cycles observed
+  uint64_t beats = 0;        // Handshakes
+  uint64_t packets = 0;      // Handshakes with tlast
+  uint64_t stalls = 0;       // tvalid && !tready: backpressure
+  uint64_t bubbles = 0;      // !tvalid && tready: starvation
+  uint64_t violations = 0;   // tvalid dropped or beat changed while stalled
+  uint64_t first_beat = 0;   // Cycle of the first handshake
+  uint64_t last_beat = 0;    // Cycle of the last handshake
+
+  // Cycles from tvalid to the handshake of every beat
+  std::vector<uint32_t> latency;
+
+  // Beats per cycle between the first and the last handshake
+  double throughput() const {
+    return beats ? double(beats) / double(last_beat - first_beat + 1) : 0.0;
+  }
+  uint32_t max_latency() const {
+    uint32_t m = 0;
+    for (uint32_t l : latency) {
+      m = l > m ? l : m;
+    }
+    return m;
+  }
+  double mean_latency() const {
+    uint64_t sum = 0;
+    for (uint32_t l : latency) {
+      sum += l;
+    }
+    return latency.empty() ? 0.0 : double(sum) / latency.size();
+  }
+};
+
+// Passive observer of one AXIS port
+class axis_monitor {
+public:
+  axis_monitor(const CData &tvalid, const IData &tdata, const CData &tlast,
+               const CData &tready)
+      : tvalid(tvalid), tdata(tdata), tlast(tlast), tready(tready) {}
+
+  void drive() {}
+
+  // Call after the model has settled and before the clock edge. Returns true
+  // if a beat is transferred at this edge.
+  bool sample() {
+    bool handshake = tvalid && tready;
+
+    // A stalled beat must be held until it is accepted
+    if (stalled &&
+        (!tvalid || tdata != held.data || bool(tlast) != held.last)) {
+      s.violations += 1;
+    }
+    if (tvalid && !offered) {
+      offered = true;
+      offer_cycle = s.cycles;
+    }
+
+    if (handshake) {
+      if (s.beats == 0) {
+        s.first_beat = s.cycles;
+      }
+      s.last_beat = s.cycles;
+      s.beats += 1;
+      s.packets += tlast ? 1 : 0;
+      s.latency.push_back(uint32_t(s.cycles - offer_cycle));
+      offered = false;
+    } else if (tvalid) {
+      s.stalls += 1;
+    } else if (tready) {
+      s.bubbles += 1;
+    }
+
+    stalled = tvalid && !tready;
+    held = {tdata, bool(tlast)};
+    s.cycles += 1;
+    return handshake;
+  }
+
+  const axis_stats &stats() const { return s; }
+
+private:
+  const CData &tvalid;
+  const IData &tdata;
+  const CData &tlast;
+  const CData &tready;
+
+  axis_stats s;
+  bool offered = false;
+  uint64_t offer_cycle = 0;
+  bool stalled = false;
+  axis_beat held = {0, false};
+};
+
+// Drives a slave port of the model
+class axis_master {
+public:
+  axis_master(CData &tvalid, IData &tdata, CData &tlast, const CData &tready,
+              axis_pattern valid = axis_pattern::always())
+      : tvalid(tvalid), tdata(tdata), tlast(tlast), tready(tready),
+        valid(std::move(valid)), monitor(tvalid, tdata, tlast, tready) {
+    tvalid = 0;
+    tlast = 0;
+  }
+
+  void send(uint32_t data, bool last) { queue.push_back({data, last}); }
+
+  // Queue a packet, tlast is set on the final word
+  void send(const uint32_t *words, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      send(words[i], i == count - 1);
+    }
+  }
+
+  // Set tvalid for this cycle. A beat that has been offered stays valid
+  // until it is accepted.
+  void drive() {
+    if (accepted) {
+      // The model has seen the handshake at the last clock edge
+      queue.pop_front();
+      tvalid = 0;
+      tlast = 0;
+      accepted = false;
+    }
+    if (!tvalid && !queue.empty() && valid.next()) {
+      tvalid = 1;
+      tdata = queue.front().data;
+      tlast = queue.front().last;
+    }
+  }
+
+  // The inputs of the model must not change before the clock edge
+  void sample() { accepted = monitor.sample(); }
+
+  bool idle() const { return pending() == 0; }
+  size_t pending() const { return queue.size() - (accepted ? 1 : 0); }
+  const axis_stats &stats() const { return monitor.stats(); }
+
+private:
+  CData &tvalid;
+  IData &tdata;
+  CData &tlast;
+  const CData &tready;
+
+  axis_pattern valid;
+  axis_monitor monitor;
+  std::deque<axis_beat> queue;
+  bool accepted = false;
+};
+
+// Drives tready of a master port of the model and collects its beats
+class axis_slave {
+public:
+  axis_slave(const CData &tvalid, const IData &tdata, const CData &tlast,
+             CData &tready, axis_pattern ready = axis_pattern::always())
+      : tvalid(tvalid), tdata(tdata), tlast(tlast), tready(tready),
+        ready(std::move(ready)), monitor(tvalid, tdata, tlast, tready) {
+    tready = 0;
+  }
+
+  void drive() { tready = ready.next(); }
+
+  void sample() {
+    if (monitor.sample()) {
+      received.push_back({tdata, bool(tlast)});
+    }
+  }
+
+  // Packets completed so far
+  uint64_t packets() const { return monitor.stats().packets; }
+  const axis_stats &stats() const { return monitor.stats(); }
+
+  std::vector<axis_beat> received;
+
+private:
+  const CData &tvalid;
+  const IData &tdata;
+  const CData &tlast;
+  CData &tready;
+
+  axis_pattern ready;
+  axis_monitor monitor;
+};
+
+// One clock cycle: drive all components, let the model settle, record the
+// handshakes at the coming edge and clock the model
+template <typename SIM, typename... C>
+void axis_cycle(SIM &sim, C &...components) {
+  (components.drive(), ...);
+  sim.eval();
+  (components.sample(), ...);
+  sim.tick();
+}
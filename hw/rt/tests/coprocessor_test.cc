@@ -2,48 +2,26 @@
 // Copyright (c) 2024 Hugo Melder
 
 #include <cstdint>
+#include <cstdio>
 #include <random>
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 
 #include "Vcoprocessor.h"
+#include "axi.h"
+#include "axis.h"
+#include "coprocessor_model.hpp"
+#include "hls_render.hpp"
 #include "scene.h"
+#include "sim_trace.h"
 #include "test_helpers.h"
 #include "vec3.h"
 
-static const int CLOCK_PERIOD = 10;
-static const int CLOCK_HALF_PERIOD = 5;
-
-// Keep tlast from the previous clock cycle
-static int m_axis_tlast_prev = 0;
-
-static void tick(std::shared_ptr<Vcoprocessor> dut,
-                 std::shared_ptr<VerilatedVcdC> m_trace) {
-  // Save tlast
-  m_axis_tlast_prev = dut->m_axis_tlast;
-
-  // Cycle the clock
-  dut->aclk ^= 1;
-  dut->eval();
-  m_trace->dump(dut->contextp()->time());
-  dut->contextp()->timeInc(CLOCK_HALF_PERIOD);
-
-  dut->aclk ^= 1;
-  dut->eval();
-  m_trace->dump(dut->contextp()->time());
-  dut->contextp()->timeInc(CLOCK_HALF_PERIOD);
-}
-static void tick(std::shared_ptr<Vcoprocessor> dut,
-                 std::shared_ptr<VerilatedVcdC> m_trace, int cycles) {
-  for (int i = 0; i < cycles; i++) {
-    tick(dut, m_trace);
-  }
-}
-
 #pragma mark - Unit Test
 
 namespace {
@@ -54,16 +32,11 @@ TEST_F(CoprocessorTest, Basic) {
   auto context = std::make_unique<VerilatedContext>();
   std::shared_ptr<Vcoprocessor> dut =
       std::make_shared<Vcoprocessor>(context.get());
-  std::shared_ptr<VerilatedVcdC> trace = std::make_shared<VerilatedVcdC>();
 
   int send_counter = 0;
   int recv_counter = 0;
 
-  Verilated::traceEverOn(true);
-
-  // Register trace object
-  dut->trace(trace.get(), 10);
-  trace->open("coprocessor_waveform.vcd");
+  sim_trace<Vcoprocessor> sim(*dut, dut->aclk, "coprocessor_waveform");
 
   // Initial AXIS Configuration
   dut->s_axis_tvalid = 0;
@@ -71,10 +44,10 @@ TEST_F(CoprocessorTest, Basic) {
   dut->m_axis_tready = 0;
 
   // Reset Coprocessor
-  dut->resetn = 0;     // Assert reset (active low)
-  tick(dut, trace, 2); // Hold reset for 2 clock cycles
-  dut->resetn = 1;     // Deassert reset
-  tick(dut, trace);
+  dut->resetn = 0; // Assert reset (active low)
+  sim.tick(2);     // Hold reset for 2 clock cycles
+  dut->resetn = 1; // Deassert reset
+  sim.tick();
 
   // Get Scene
   Scene scene(10.0f, 16.0f / 9.0f, 1.0f);
@@ -92,7 +65,7 @@ TEST_F(CoprocessorTest, Basic) {
 
       send_counter += 1;
     }
-    tick(dut, trace);
+    sim.tick();
   }
   dut->s_axis_tvalid = 0;
   dut->s_axis_tlast = 0;
@@ -107,6 +80,9 @@ TEST_F(CoprocessorTest, Basic) {
   int image_width = int(scene.image_width);
   int image_height = int(scene.image_height);
   const int max_receive_cycles = 10000;
+
+  // Keep the waveform of the first word past the end of the frame
+  sim.trigger_when([&] { return recv_counter > image_width * image_height; });
   bool is_last = dut->m_axis_tlast;
   while (!is_last && (recv_cycles < max_receive_cycles)) {
     if (dut->m_axis_tvalid) {
@@ -132,12 +108,12 @@ TEST_F(CoprocessorTest, Basic) {
       // Delay
       if (x == image_width - 1) {
         dut->m_axis_tready = 0;
-        tick(dut, trace, 2);
+        sim.tick(2);
         dut->m_axis_tready = 1;
       }
     }
 
-    tick(dut, trace);
+    sim.tick();
     recv_cycles += 1;
   }
   dut->m_axis_tready = 0;
@@ -148,4 +124,261 @@ TEST_F(CoprocessorTest, Basic) {
   std::cout << "recv_cycles: " << recv_cycles << std::endl;
 }
 
-} // namespace
\ No newline at end of file
+#pragma mark - Backpressure
+
+// Render one frame with the given tvalid pattern on the configuration
+// upload and tready pattern on the pixel stream. With objects, the camera is
+// followed by a length header and the objects in the same packet. Returns
+// the statistics of the upload.
+static axis_stats
+render_frame(const char *name, axis_pattern valid, axis_pattern ready,
+             const std::vector<uint32_t> *objects = nullptr) {
+  auto context = std::make_unique<VerilatedContext>();
+  auto dut = std::make_unique<Vcoprocessor>(context.get());
+  sim_trace<Vcoprocessor> sim(*dut, dut->aclk, name);
+
+  // The performance model sees the same tvalid/tready sequences
+  axis_pattern model_valid = valid;
+  axis_pattern model_ready = ready;
+
+  axis_master upload(dut->s_axis_tvalid, dut->s_axis_tdata, dut->s_axis_tlast,
+                     dut->s_axis_tready, std::move(valid));
+  axis_slave pixels(dut->m_axis_tvalid, dut->m_axis_tdata, dut->m_axis_tlast,
+                    dut->m_axis_tready, std::move(ready));
+
+  dut->resetn = 0;
+  sim.tick(2);
+  dut->resetn = 1;
+  sim.tick();
+
+  Scene scene(16.0f, 16.0f / 9.0f, 1.0f);
+  int image_width = int(scene.image_width);
+  int image_height = int(scene.image_height);
+  size_t expected = size_t(image_width) * size_t(image_height);
+
+  uint32_t *camera = scene.serialised();
+  if (objects) {
+    for (int i = 0; i < SCENE_PAYLOAD_SIZE; i++) {
+      upload.send(camera[i], false);
+    }
+    upload.send(uint32_t(objects->size()), objects->empty());
+    for (size_t i = 0; i < objects->size(); i++) {
+      upload.send((*objects)[i], i == objects->size() - 1);
+    }
+  } else {
+    upload.send(camera, SCENE_PAYLOAD_SIZE);
+  }
+
+  // Run until the frame is complete, plus a few cycles to catch extra beats
+  const uint64_t max_cycles = 100 * expected + 1000;
+  while (pixels.packets() == 0 && sim.cycles() < max_cycles) {
+    axis_cycle(sim, upload, pixels);
+  }
+  for (int i = 0; i < 16; i++) {
+    axis_cycle(sim, upload, pixels);
+  }
+
+  EXPECT_TRUE(upload.idle());
+  EXPECT_EQ(upload.stats().violations, 0u);
+  EXPECT_EQ(pixels.stats().violations, 0u);
+  EXPECT_EQ(pixels.received.size(), expected);
+  if (pixels.received.size() != expected) {
+    return upload.stats();
+  }
+  EXPECT_EQ(pixels.packets(), 1u);
+
+  for (size_t i = 0; i < expected; i++) {
+    int x = int(i) % image_width;
+    int y = int(i) / image_width;
+    vec3 pixel_center = scene.pixel_00_loc + (x * scene.pixel_delta_u) +
+                        (y * scene.pixel_delta_v);
+    vec3 ray_direction = pixel_center - scene.camera_center;
+
+    EXPECT_NEAR(FIX_2_FLOAT(pixels.received[i].data), ray_direction[1],
+                0.00005)
+        << "pixel (" << x << ", " << y << ")";
+    EXPECT_EQ(pixels.received[i].last, i == expected - 1)
+        << "pixel (" << x << ", " << y << ")";
+  }
+
+  uint64_t words = SCENE_PAYLOAD_SIZE + (objects ? 1 + objects->size() : 0);
+  EXPECT_EQ(upload.stats().beats, words);
+
+  // coprocessor_model must stay cycle-exact with the RTL
+  coprocessor_config config;
+  config.scene_upload = objects != nullptr;
+  config.scene_words = objects ? uint32_t(objects->size()) : 0;
+  frame_timing model = coprocessor_model(config).run(
+      image_width, image_height, [&] { return model_valid.next(); },
+      [&] { return model_ready.next(); });
+  EXPECT_EQ(model.first_upload, upload.stats().first_beat);
+  EXPECT_EQ(model.last_upload, upload.stats().last_beat);
+  EXPECT_EQ(model.last_beat, pixels.stats().last_beat);
+  EXPECT_EQ(model.stalls, pixels.stats().stalls);
+
+  const axis_stats &s = pixels.stats();
+  std::printf("%s: %.3f pixels/cycle, %llu stalls, %llu bubbles, latency "
+              "mean %.2f max %u, upload %.3f words/cycle\n",
+              name, s.throughput(), (unsigned long long)s.stalls,
+              (unsigned long long)s.bubbles, s.mean_latency(), s.max_latency(),
+              upload.stats().throughput());
+  return upload.stats();
+}
+
+TEST_F(CoprocessorTest, BackpressureNone) {
+  render_frame("coprocessor_none", axis_pattern::always(),
+               axis_pattern::always());
+}
+
+TEST_F(CoprocessorTest, BackpressureRandom) {
+  render_frame("coprocessor_random", axis_pattern::always(),
+               axis_pattern::random(0.5, 42));
+}
+
+TEST_F(CoprocessorTest, BackpressureBursty) {
+  render_frame("coprocessor_bursty", axis_pattern::always(),
+               axis_pattern::bursty(16, 4));
+}
+
+TEST_F(CoprocessorTest, UploadStarved) {
+  render_frame("coprocessor_starved", axis_pattern::random(0.3, 7),
+               axis_pattern::always());
+}
+
+// The objects are accepted at one word per clock, in the same packet as the
+// camera
+TEST_F(CoprocessorTest, SceneUpload) {
+  std::vector<uint32_t> objects(300);
+  for (size_t i = 0; i < objects.size(); i++) {
+    objects[i] = uint32_t(i * 2654435761u);
+  }
+  axis_stats upload = render_frame("coprocessor_scene", axis_pattern::always(),
+                                   axis_pattern::always(), &objects);
+  EXPECT_EQ(upload.last_beat - upload.first_beat + 1, upload.beats);
+  EXPECT_EQ(upload.packets, 1u);
+
+  std::vector<uint32_t> empty;
+  render_frame("coprocessor_scene_empty", axis_pattern::always(),
+               axis_pattern::always(), &empty);
+  render_frame("coprocessor_scene_starved", axis_pattern::random(0.5, 3),
+               axis_pattern::random(0.5, 4), &objects);
+}
+
+// With fb_enable the frame is written to DDR instead of the AXIS master
+TEST_F(CoprocessorTest, Framebuffer) {
+  auto context = std::make_unique<VerilatedContext>();
+  auto dut = std::make_unique<Vcoprocessor>(context.get());
+  sim_trace<Vcoprocessor> sim(*dut, dut->aclk, "coprocessor_framebuffer");
+
+  axis_master upload(dut->s_axis_tvalid, dut->s_axis_tdata, dut->s_axis_tlast,
+                     dut->s_axis_tready);
+  axis_slave pixels(dut->m_axis_tvalid, dut->m_axis_tdata, dut->m_axis_tlast,
+                    dut->m_axis_tready);
+  axi_mem<Vcoprocessor> mem(*dut, axis_pattern::random(0.8, 1),
+                            axis_pattern::random(0.8, 2), 20);
+
+  Scene scene(16.0f, 16.0f / 9.0f, 1.0f);
+  int image_width = int(scene.image_width);
+  int image_height = int(scene.image_height);
+  const uint32_t base = 0x100000;
+  const uint32_t stride = 4 * uint32_t(image_width) + 64;
+
+  dut->fb_enable = 1;
+  dut->fb_base = base;
+  dut->fb_stride = stride;
+  dut->resetn = 0;
+  sim.tick(2);
+  dut->resetn = 1;
+  sim.tick();
+
+  for (int frame = 0; frame < 2; frame++) {
+    upload.send(scene.serialised(), SCENE_PAYLOAD_SIZE);
+    // fb_done stays set from the last frame until rendering starts
+    const uint64_t max_cycles = sim.cycles() + 100000;
+    while ((!upload.idle() || dut->fb_done) && sim.cycles() < max_cycles) {
+      axis_cycle(sim, upload, pixels, mem);
+    }
+    while (!dut->fb_done && sim.cycles() < max_cycles) {
+      axis_cycle(sim, upload, pixels, mem);
+    }
+    ASSERT_TRUE(dut->fb_done) << "frame " << frame;
+  }
+
+  EXPECT_FALSE(dut->fb_error);
+  EXPECT_EQ(pixels.received.size(), 0u);
+  EXPECT_EQ(mem.stats().violations, 0u);
+  EXPECT_EQ(mem.memory.size(), size_t(image_width) * size_t(image_height));
+
+  for (int y = 0; y < image_height; y++) {
+    for (int x = 0; x < image_width; x++) {
+      auto it = mem.memory.find(base + uint32_t(y) * stride + 4 * uint32_t(x));
+      ASSERT_NE(it, mem.memory.end()) << "pixel (" << x << ", " << y << ")";
+      vec3 pixel_center = scene.pixel_00_loc + (x * scene.pixel_delta_u) +
+                          (y * scene.pixel_delta_v);
+      vec3 ray_direction = pixel_center - scene.camera_center;
+      EXPECT_NEAR(FIX_2_FLOAT(it->second), ray_direction[1], 0.00005)
+          << "pixel (" << x << ", " << y << ")";
+    }
+  }
+  std::printf("framebuffer: %llu bursts, %.2f beats per burst\n",
+              (unsigned long long)mem.stats().bursts, mem.stats().mean_burst());
+}
+
+// tready recorded from an MM2S/S2MM DMA pair, see data/dma_backpressure.txt
+TEST_F(CoprocessorTest, BackpressureReplay) {
+  render_frame("coprocessor_replay", axis_pattern::always(),
+               axis_pattern::replay(std::string(TEST_DATA_DIR) +
+                                    "/dma_backpressure.txt"));
+}
+
+#pragma mark - HLS
+
+// The HLS kernel (hw/hls/main.cpp) renders the same bits as the RTL
+TEST_F(CoprocessorTest, HlsBitExact) {
+  for (float width : {16.0f, 61.0f}) {
+    auto context = std::make_unique<VerilatedContext>();
+    auto dut = std::make_unique<Vcoprocessor>(context.get());
+    sim_trace<Vcoprocessor> sim(*dut, dut->aclk, "coprocessor_hls");
+
+    axis_master upload(dut->s_axis_tvalid, dut->s_axis_tdata,
+                       dut->s_axis_tlast, dut->s_axis_tready);
+    axis_slave pixels(dut->m_axis_tvalid, dut->m_axis_tdata,
+                      dut->m_axis_tlast, dut->m_axis_tready);
+
+    dut->resetn = 0;
+    sim.tick(2);
+    dut->resetn = 1;
+    sim.tick();
+
+    Scene scene(width, 16.0f / 9.0f, 1.0f);
+    int image_width = int(scene.image_width);
+    size_t expected = size_t(image_width) * size_t(scene.image_height);
+    upload.send(scene.serialised(), SCENE_PAYLOAD_SIZE);
+
+    const uint64_t max_cycles = 100 * expected + 1000;
+    while (pixels.packets() == 0 && sim.cycles() < max_cycles) {
+      axis_cycle(sim, upload, pixels);
+    }
+    for (int i = 0; i < 16; i++) {
+      axis_cycle(sim, upload, pixels);
+    }
+
+    std::vector<uint32_t> hls;
+    EXPECT_TRUE(hls_render(scene.serialised(), SCENE_PAYLOAD_SIZE, hls));
+
+    // The frame length: one packet of expected words from both, with tlast
+    // on the last pixel only (hls_render checks tlast of the kernel). Then
+    // every pixel word.
+    EXPECT_EQ(pixels.packets(), 1u);
+    ASSERT_EQ(hls.size(), expected) << "width " << width;
+    ASSERT_EQ(pixels.received.size(), expected) << "width " << width;
+    for (size_t i = 0; i < expected; i++) {
+      EXPECT_EQ(pixels.received[i].last, i == expected - 1)
+          << "pixel (" << i % image_width << ", " << i / image_width << ")";
+      EXPECT_EQ(pixels.received[i].data, hls[i])
+          << "pixel (" << i % image_width << ", " << i / image_width << ")";
+    }
+  }
+}
+
+} // namespace
@@ -2,35 +2,18 @@
 // Copyright (c) 2025 Hugo Melder
 
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 
 #include <gtest/gtest.h>
 
 #include <memory>
 
 #include "scene.h"
+#include "sim_trace.h"
 #include "test_helpers.h"
 #include "vec3.h"
 
 #include "Vrt_core.h"
 
-static const int CLOCK_PERIOD = 10;
-static const int CLOCK_HALF_PERIOD = 5;
-
-static void tick(std::shared_ptr<Vrt_core> dut,
-                 std::shared_ptr<VerilatedVcdC> m_trace) {
-  // Cycle the clock
-  dut->clk ^= 1;
-  dut->eval();
-  m_trace->dump(dut->contextp()->time());
-  Verilated::timeInc(CLOCK_HALF_PERIOD);
-
-  dut->clk ^= 1;
-  dut->eval();
-  m_trace->dump(dut->contextp()->time());
-  dut->contextp()->timeInc(CLOCK_HALF_PERIOD);
-}
-
 namespace {
 
 class RtCoreTest : public testing::Test {};
@@ -38,21 +21,16 @@ class RtCoreTest : public testing::Test {};
 TEST_F(RtCoreTest, NoStall) {
   auto context = std::make_unique<VerilatedContext>();
   std::shared_ptr<Vrt_core> dut = std::make_shared<Vrt_core>(context.get());
-  std::shared_ptr<VerilatedVcdC> trace = std::make_shared<VerilatedVcdC>();
-
-  Verilated::traceEverOn(true);
-  // Register trace object
-  dut->trace(trace.get(), 10);
-  trace->open("RtCoreTest_NoStall.vcd");
+  sim_trace<Vrt_core> sim(*dut, dut->clk, "RtCoreTest_NoStall");
 
   // Get Scene
   Scene scene(10.0f, 16.0f / 9.0f, 1.0f);
   struct Scene::camera cam = scene.raw_camera();
 
   dut->resetn = 0; // Assert reset (active low)
-  tick(dut, trace);
+  sim.tick();
   dut->resetn = 1; // Deassert reset
-  tick(dut, trace);
+  sim.tick();
 
   dut->image_width = cam.image_width >> FP_QW;
   dut->image_height = cam.image_height >> FP_QW;
@@ -66,7 +44,7 @@ TEST_F(RtCoreTest, NoStall) {
   dut->start = 0;
   dut->stall = 0;
 
-  tick(dut, trace);
+  sim.tick();
 
   // rt_controller state : IDLE
   EXPECT_EQ(dut->valid, 0);
@@ -75,7 +53,7 @@ TEST_F(RtCoreTest, NoStall) {
   dut->start = 1;
   // rt_controller state : READY
   for (int i = 0; i < 5; i++) {
-    tick(dut, trace);
+    sim.tick();
     EXPECT_EQ(dut->valid, 0);
     EXPECT_EQ(dut->last, 0);
   }
@@ -84,7 +62,7 @@ TEST_F(RtCoreTest, NoStall) {
   int image_height = dut->image_height;
   for (int h = 0; h < dut->image_height; h++) {
     for (int w = 0; w < dut->image_width; w++) {
-      tick(dut, trace);
+      sim.tick();
       EXPECT_EQ(dut->valid, 1);
 
       if (w == (image_width - 1) && (h == (image_height - 1))) {
@@ -99,21 +77,16 @@ TEST_F(RtCoreTest, NoStall) {
 TEST_F(RtCoreTest, Stall) {
   auto context = std::make_unique<VerilatedContext>();
   std::shared_ptr<Vrt_core> dut = std::make_shared<Vrt_core>(context.get());
-  std::shared_ptr<VerilatedVcdC> trace = std::make_shared<VerilatedVcdC>();
-
-  Verilated::traceEverOn(true);
-  // Register trace object
-  dut->trace(trace.get(), 10);
-  trace->open("RtCoreTest_Stall.vcd");
+  sim_trace<Vrt_core> sim(*dut, dut->clk, "RtCoreTest_Stall");
 
   // Get Scene
   Scene scene(64.0f, 16.0f / 9.0f, 1.0f);
   struct Scene::camera cam = scene.raw_camera();
 
   dut->resetn = 0; // Assert reset (active low)
-  tick(dut, trace);
+  sim.tick();
   dut->resetn = 1; // Deassert reset
-  tick(dut, trace);
+  sim.tick();
 
   dut->image_width = cam.image_width >> FP_QW;
   dut->image_height = cam.image_height >> FP_QW;
@@ -127,7 +100,7 @@ TEST_F(RtCoreTest, Stall) {
   dut->start = 0;
   dut->stall = 0;
 
-  tick(dut, trace);
+  sim.tick();
 
   // rt_controller state : IDLE
   EXPECT_EQ(dut->valid, 0);
@@ -136,7 +109,7 @@ TEST_F(RtCoreTest, Stall) {
   dut->start = 1;
   // rt_controller state : READY
   for (int i = 0; i < 5; i++) {
-    tick(dut, trace);
+    sim.tick();
     dut->start = 0;
     EXPECT_EQ(dut->valid, 0);
     EXPECT_EQ(dut->last, 0);
@@ -146,7 +119,7 @@ TEST_F(RtCoreTest, Stall) {
   int image_height = dut->image_height;
   for (int h = 0; h < dut->image_height;) {
     for (int w = 0; w < dut->image_width;) {
-      tick(dut, trace);
+      sim.tick();
       EXPECT_EQ(dut->valid, 1);
       // Validation
       vec3 pixel_center = scene.pixel_center(w, h);
@@ -156,8 +129,8 @@ TEST_F(RtCoreTest, Stall) {
 
       if (w == (image_width - 1) && (h == (image_height - 1))) {
         dut->stall = 1;
-        tick(dut, trace);
-        tick(dut, trace);
+        sim.tick();
+        sim.tick();
         dut->stall = 0;
         EXPECT_EQ(dut->last, 1);
       } else {
@@ -166,8 +139,8 @@ TEST_F(RtCoreTest, Stall) {
 
       if (w == image_width / 2) {
         dut->stall = 1;
-        tick(dut, trace);
-        tick(dut, trace);
+        sim.tick();
+        sim.tick();
         dut->stall = 0;
       }
 
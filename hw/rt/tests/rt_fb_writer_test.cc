@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <verilated.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Vrt_fb_writer.h"
+#include "axi.h"
+#include "axis.h"
+#include "sim_trace.h"
+
+#pragma mark - Helpers
+
+namespace {
+
+// Default parameters
+static const uint32_t MAX_BURST = 16;
+
+struct pixel {
+  uint32_t x;
+  uint32_t y;
+};
+
+static uint32_t pixel_value(uint32_t x, uint32_t y) {
+  return (y << 16) | x | 0x80008000u;
+}
+
+static std::vector<pixel> raster(uint32_t width, uint32_t height) {
+  std::vector<pixel> pixels;
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      pixels.push_back({x, y});
+    }
+  }
+  return pixels;
+}
+
+// tile x tile blocks, in raster order within a block
+static std::vector<pixel> tiled(uint32_t width, uint32_t height,
+                                uint32_t tile) {
+  std::vector<pixel> pixels;
+  for (uint32_t ty = 0; ty < height; ty += tile) {
+    for (uint32_t tx = 0; tx < width; tx += tile) {
+      for (uint32_t y = ty; y < ty + tile && y < height; y++) {
+        for (uint32_t x = tx; x < tx + tile && x < width; x++) {
+          pixels.push_back({x, y});
+        }
+      }
+    }
+  }
+  return pixels;
+}
+
+class fb_writer {
+public:
+  fb_writer(const std::string &name, axis_pattern aw_ready,
+            axis_pattern w_ready, uint32_t b_latency)
+      : context(std::make_unique<VerilatedContext>()),
+        dut(std::make_unique<Vrt_fb_writer>(context.get())),
+        sim(*dut, dut->clk, name),
+        mem(*dut, std::move(aw_ready), std::move(w_ready), b_latency) {
+    dut->start = 0;
+    dut->in_valid = 0;
+    dut->in_last = 0;
+    dut->resetn = 0;
+    sim.tick(2);
+    dut->resetn = 1;
+    sim.tick();
+  }
+
+  // Write one frame and return the cycles from start to done
+  uint64_t frame(const std::vector<pixel> &pixels, uint32_t base,
+                 uint32_t stride, axis_pattern valid) {
+    dut->base = base;
+    dut->stride = stride;
+    dut->start = 1;
+    sim.tick();
+    dut->start = 0;
+
+    size_t sent = 0;
+    int done = 0;
+    uint64_t cycles = 0;
+    for (; cycles < 1000000 && !dut->frame_done; cycles++) {
+      if (!dut->in_valid && sent < pixels.size() && valid.next()) {
+        dut->in_valid = 1;
+        dut->in_x = pixels[sent].x;
+        dut->in_y = pixels[sent].y;
+        dut->in_data = pixel_value(pixels[sent].x, pixels[sent].y);
+        dut->in_last = sent == pixels.size() - 1;
+      }
+      mem.drive();
+      sim.eval();
+      mem.sample();
+
+      bool accepted = dut->in_valid && dut->in_ready;
+      done += dut->done;
+      sim.tick();
+
+      if (accepted) {
+        dut->in_valid = 0;
+        dut->in_last = 0;
+        sent += 1;
+      }
+    }
+    EXPECT_EQ(sent, pixels.size());
+    EXPECT_EQ(done, 1);
+    EXPECT_TRUE(mem.idle());
+    return cycles;
+  }
+
+  void expect_frame(uint32_t width, uint32_t height, uint32_t base,
+                    uint32_t stride) {
+    for (uint32_t y = 0; y < height; y++) {
+      for (uint32_t x = 0; x < width; x++) {
+        auto it = mem.memory.find(base + y * stride + 4 * x);
+        ASSERT_NE(it, mem.memory.end()) << "pixel (" << x << ", " << y << ")";
+        EXPECT_EQ(it->second, pixel_value(x, y))
+            << "pixel (" << x << ", " << y << ")";
+      }
+    }
+    // Nothing outside the frame, e.g. in the padding of a row
+    EXPECT_EQ(mem.memory.size(), size_t(width) * height);
+    EXPECT_EQ(mem.stats().violations, 0u);
+    EXPECT_FALSE(dut->error);
+  }
+
+  std::unique_ptr<VerilatedContext> context;
+  std::unique_ptr<Vrt_fb_writer> dut;
+  sim_trace<Vrt_fb_writer> sim;
+  axi_mem<Vrt_fb_writer> mem;
+};
+
+#pragma mark - Unit Test
+
+class FbWriterTest : public testing::Test {};
+
+TEST_F(FbWriterTest, Raster) {
+  const uint32_t width = 64, height = 8;
+  const uint32_t base = 0x10000, stride = 320;
+  fb_writer fb("rt_fb_writer_raster", axis_pattern::always(),
+               axis_pattern::always(), 10);
+  uint64_t cycles = fb.frame(raster(width, height), base, stride,
+                             axis_pattern::always());
+  fb.expect_frame(width, height, base, stride);
+
+  // Full bursts, and one pixel per clock apart from a cycle per row
+  EXPECT_EQ(fb.mem.stats().bursts, width * height / MAX_BURST);
+  EXPECT_LT(cycles, width * height + height + 64);
+  EXPECT_TRUE(fb.dut->frame_done);
+}
+
+// Tile rows are coalesced into bursts of one tile width
+TEST_F(FbWriterTest, Tiled) {
+  const uint32_t width = 64, height = 32, tile = 8;
+  const uint32_t base = 0x200000, stride = 4 * width;
+  fb_writer fb("rt_fb_writer_tiled", axis_pattern::always(),
+               axis_pattern::always(), 20);
+  fb.frame(tiled(width, height, tile), base, stride, axis_pattern::always());
+  fb.expect_frame(width, height, base, stride);
+  EXPECT_EQ(fb.mem.stats().bursts, width * height / tile);
+}
+
+// Rows that cross 4 KiB boundaries, with backpressure everywhere
+TEST_F(FbWriterTest, Backpressure) {
+  const uint32_t width = 100, height = 12;
+  const uint32_t base = 0x0ff0, stride = 4 * width + 12;
+  fb_writer fb("rt_fb_writer_backpressure", axis_pattern::random(0.4, 1),
+               axis_pattern::random(0.6, 2), 50);
+  fb.frame(raster(width, height), base, stride,
+           axis_pattern::random(0.7, 3));
+  fb.expect_frame(width, height, base, stride);
+  std::printf("backpressure: %llu bursts, %.2f beats per burst\n",
+              (unsigned long long)fb.mem.stats().bursts,
+              fb.mem.stats().mean_burst());
+
+  // The next frame clears frame_done and overwrites the buffer
+  fb.frame(tiled(width, height, 4), base, stride, axis_pattern::always());
+  fb.expect_frame(width, height, base, stride);
+}
+
+} // namespace
@@ -0,0 +1,249 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <verilated.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Vrt_node_cache.h"
+#include "axi.h"
+#include "axis.h"
+#include "sim_trace.h"
+
+#pragma mark - Helpers
+
+namespace {
+
+// -GSETS=16 in CMakeLists.txt, the other parameters are the defaults
+static const uint32_t LINE_BYTES = 32;
+static const uint32_t LINE_WORDS = 8;
+static const uint32_t CACHE_LINES = 16 * 2;
+static const uint32_t MSHRS = 4;
+
+struct response {
+  uint32_t id;
+  bool hit;
+};
+
+class node_cache {
+public:
+  node_cache(const std::string &name, axi_ddr_config config)
+      : context(std::make_unique<VerilatedContext>()),
+        dut(std::make_unique<Vrt_node_cache>(context.get())),
+        sim(*dut, dut->clk, name), ddr(*dut, config) {
+    dut->flush = 0;
+    dut->req_valid = 0;
+    dut->resp_ready = 0;
+    dut->resetn = 0;
+    sim.tick(2);
+    dut->resetn = 1;
+    sim.tick();
+  }
+
+  // One clock cycle. Offers the front of requests, removes it when it is
+  // accepted and returns the response transferred in this cycle, if any.
+  bool cycle(std::deque<std::pair<uint32_t, uint32_t>> &requests,
+             bool ready, response &out) {
+    dut->req_valid = !requests.empty();
+    if (!requests.empty()) {
+      dut->req_addr = requests.front().first;
+      dut->req_id = requests.front().second;
+    }
+    dut->resp_ready = ready;
+    ddr.drive();
+    sim.eval();
+    ddr.sample();
+
+    bool accepted = dut->req_valid && dut->req_ready;
+    bool responded = dut->resp_valid && dut->resp_ready;
+    if (responded) {
+      out = {uint32_t(dut->resp_id), bool(dut->resp_hit)};
+      line.resize(LINE_WORDS);
+      for (uint32_t k = 0; k < LINE_WORDS; k++) {
+        line[k] = dut->resp_data[k];
+      }
+    }
+    sim.tick();
+
+    if (accepted) {
+      requests.pop_front();
+    }
+    return responded;
+  }
+
+  // Data of the last response
+  std::vector<uint32_t> line;
+
+  std::unique_ptr<VerilatedContext> context;
+  std::unique_ptr<Vrt_node_cache> dut;
+  sim_trace<Vrt_node_cache> sim;
+  axi_ddr<Vrt_node_cache> ddr;
+};
+
+static void expect_line(const std::vector<uint32_t> &line, uint32_t addr) {
+  uint32_t base = addr & ~(LINE_BYTES - 1);
+  ASSERT_EQ(line.size(), LINE_WORDS);
+  for (uint32_t k = 0; k < LINE_WORDS; k++) {
+    EXPECT_EQ(line[k], axi_ddr_word(base + 4 * k))
+        << "address " << addr << " word " << k;
+  }
+}
+
+#pragma mark - Unit Test
+
+class NodeCacheTest : public testing::Test {};
+
+TEST_F(NodeCacheTest, HitAfterMiss) {
+  axi_ddr_config config;
+  config.latency = 30;
+  node_cache cache("rt_node_cache_hit", config);
+
+  std::deque<std::pair<uint32_t, uint32_t>> requests = {{0x1040, 1}};
+  response r;
+  int cycles = 0;
+  while (!cache.cycle(requests, true, r) && cycles++ < 1000) {
+  }
+  EXPECT_EQ(r.id, 1u);
+  EXPECT_FALSE(r.hit);
+  expect_line(cache.line, 0x1040);
+
+  // Another word of the same line
+  requests.push_back({0x105c, 2});
+  cycles = 0;
+  while (!cache.cycle(requests, true, r) && cycles++ < 1000) {
+  }
+  EXPECT_EQ(r.id, 2u);
+  EXPECT_TRUE(r.hit);
+  EXPECT_EQ(cycles, 2); // Answered two cycles after the request
+  expect_line(cache.line, 0x1040);
+
+  EXPECT_EQ(cache.dut->stat_hits, 1u);
+  EXPECT_EQ(cache.dut->stat_misses, 1u);
+  EXPECT_GE(cache.dut->stat_latency_max, config.latency);
+  EXPECT_EQ(cache.ddr.stats().bursts, 1u);
+  EXPECT_EQ(cache.ddr.stats().violations, 0u);
+
+  // flush drops the line
+  cache.dut->flush = 1;
+  cache.sim.tick();
+  cache.dut->flush = 0;
+  requests.push_back({0x1040, 3});
+  cycles = 0;
+  while (!cache.cycle(requests, true, r) && cycles++ < 1000) {
+  }
+  EXPECT_FALSE(r.hit);
+  EXPECT_EQ(cache.ddr.stats().bursts, 2u);
+}
+
+// Evictions, out-of-order bursts and backpressure on the responses
+TEST_F(NodeCacheTest, RandomTraffic) {
+  axi_ddr_config config;
+  config.latency = 20;
+  config.jitter = 40;
+  config.bandwidth = 0.5;
+  node_cache cache("rt_node_cache_random", config);
+
+  const uint32_t count = 3000;
+  std::mt19937 rng(5);
+  std::vector<uint32_t> addrs(count);
+  std::deque<std::pair<uint32_t, uint32_t>> requests;
+  for (uint32_t i = 0; i < count; i++) {
+    addrs[i] = (rng() % (4 * CACHE_LINES * LINE_BYTES)) & ~3u;
+    requests.push_back({addrs[i], i % 256});
+  }
+
+  // Requests in flight per ID, oldest first
+  std::vector<std::deque<uint32_t>> in_flight(256);
+  size_t issued = 0;
+  uint32_t received = 0;
+  axis_pattern ready = axis_pattern::random(0.6, 9);
+  for (int cycle = 0; cycle < 1000000 && received < count; cycle++) {
+    size_t before = requests.size();
+    response r;
+    bool responded = cache.cycle(requests, ready.next(), r);
+    if (requests.size() != before) {
+      in_flight[issued % 256].push_back(addrs[issued]);
+      issued += 1;
+    }
+    if (responded) {
+      ASSERT_FALSE(in_flight[r.id].empty()) << "unexpected id " << r.id;
+      expect_line(cache.line, in_flight[r.id].front());
+      in_flight[r.id].pop_front();
+      received += 1;
+    }
+  }
+
+  EXPECT_EQ(received, count);
+  EXPECT_EQ(cache.dut->stat_hits + cache.dut->stat_misses, count);
+  EXPECT_EQ(cache.ddr.stats().bursts, cache.dut->stat_misses);
+  EXPECT_EQ(cache.ddr.stats().beats, LINE_WORDS * cache.dut->stat_misses);
+  EXPECT_EQ(cache.ddr.stats().violations, 0u);
+  EXPECT_GT(cache.ddr.stats().max_outstanding, 1u);
+  EXPECT_LE(cache.ddr.stats().max_outstanding, MSHRS);
+}
+
+// Rays walk from the root to a random leaf of a BVH over 256K triangles,
+// 512K nodes of 32 bytes. The top of the tree stays in the cache, and the
+// misses below overlap in the miss registers.
+TEST_F(NodeCacheTest, BvhWalk) {
+  axi_ddr_config config;
+  config.latency = 60;
+  config.jitter = 20;
+  node_cache cache("rt_node_cache_walk", config);
+
+  const uint32_t leaves = 1u << 18;
+  const int rays = 16;
+  const int walks = 256;
+  std::mt19937 rng(11);
+
+  std::vector<uint32_t> node(rays, 1);
+  std::deque<std::pair<uint32_t, uint32_t>> requests;
+  for (int ray = 0; ray < rays; ray++) {
+    requests.push_back({node[ray] * LINE_BYTES, uint32_t(ray)});
+  }
+
+  int completed = 0;
+  uint64_t visited = 0;
+  uint64_t cycles = 0;
+  for (; cycles < 10000000 && completed < walks; cycles++) {
+    response r;
+    if (!cache.cycle(requests, true, r)) {
+      continue;
+    }
+    expect_line(cache.line, node[r.id] * LINE_BYTES);
+    visited += 1;
+    node[r.id] = 2 * node[r.id] + rng() % 2;
+    if (node[r.id] >= 2 * leaves) {
+      node[r.id] = 1;
+      completed += 1;
+    }
+    requests.push_back({node[r.id] * LINE_BYTES, r.id});
+  }
+  ASSERT_EQ(completed, walks);
+
+  uint64_t misses = cache.dut->stat_misses;
+  std::printf("bvh walk: %.3f nodes/cycle, %.1f %% hits, mean miss latency "
+              "%.1f, max %u, %llu bursts outstanding\n",
+              double(visited) / double(cycles),
+              100.0 * double(cache.dut->stat_hits) /
+                  double(cache.dut->stat_hits + misses),
+              double(cache.dut->stat_latency_sum) / double(misses),
+              cache.dut->stat_latency_max,
+              (unsigned long long)cache.ddr.stats().max_outstanding);
+
+  // A blocking cache would spend at least the latency and the burst on
+  // every miss
+  EXPECT_GT(cache.dut->stat_hits, 0u);
+  EXPECT_LT(cycles, misses * (config.latency + LINE_WORDS));
+  EXPECT_EQ(cache.ddr.stats().violations, 0u);
+}
+
+} // namespace
@@ -2,53 +2,30 @@
 // Copyright (c) 2025 Hugo Melder
 
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 
 #include <gtest/gtest.h>
 
 #include <memory>
 
 #include "scene.h"
+#include "sim_trace.h"
 #include "test_helpers.h"
 #include "vec3.h"
 
 #include "Vrt_rgu_wrapper.h"
 
-static const int CLOCK_PERIOD = 10;
-static const int CLOCK_HALF_PERIOD = 5;
-
-static void tick(std::shared_ptr<Vrt_rgu_wrapper> dut,
-                 std::shared_ptr<VerilatedVcdC> m_trace) {
-  // Cycle the clock
-  dut->clk ^= 1;
-  dut->eval();
-  m_trace->dump(Verilated::time());
-  Verilated::timeInc(CLOCK_HALF_PERIOD);
-
-  dut->clk ^= 1;
-  dut->eval();
-  m_trace->dump(Verilated::time());
-  Verilated::timeInc(CLOCK_HALF_PERIOD);
-}
-
 namespace {
 
 class RtRGUTest : public testing::Test {};
 
 TEST_F(RtRGUTest, SinglePipelineIteration) {
   std::shared_ptr<Vrt_rgu_wrapper> dut = std::make_shared<Vrt_rgu_wrapper>();
-  std::shared_ptr<VerilatedVcdC> trace = std::make_shared<VerilatedVcdC>();
-
-  Verilated::traceEverOn(true);
-
-  // Register trace object
-  dut->trace(trace.get(), 10);
-  trace->open("rgu_waveform.vcd");
+  sim_trace<Vrt_rgu_wrapper> sim(*dut, dut->clk, "rgu_waveform");
 
   dut->resetn = 0; // Assert reset (active low)
-  tick(dut, trace);
+  sim.tick();
   dut->resetn = 1; // Deassert reset
-  tick(dut, trace);
+  sim.tick();
 
   // Get Scene
   Scene scene(10.0f, 16.0f / 9.0f, 1.0f);
@@ -68,13 +45,13 @@ TEST_F(RtRGUTest, SinglePipelineIteration) {
   for (int i = 0; i < 4; i++) {
     dut->x = i;
     EXPECT_EQ(dut->valid, 0);
-    tick(dut, trace);
+    sim.tick();
   }
   dut->start = 0;
 
   // Validation
   for (int i = 0; i < 4; i++) {
-    tick(dut, trace);
+    sim.tick();
     EXPECT_EQ(dut->valid, 1);
     // Validation
     vec3 pixel_center = scene.pixel_center(x + i, y);
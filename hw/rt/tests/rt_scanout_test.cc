@@ -0,0 +1,311 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <verilated.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Vrt_scanout.h"
+#include "axi.h"
+#include "axis.h"
+#include "sim_trace.h"
+
+#pragma mark - Helpers
+
+namespace {
+
+// The small video mode in CMakeLists.txt
+static const uint32_t H_ACTIVE = 32;
+static const uint32_t H_SYNC = 4;
+static const uint32_t H_TOTAL = 32 + 4 + 4 + 8;
+static const uint32_t V_ACTIVE = 12;
+static const uint32_t V_TOTAL = 12 + 2 + 2 + 4;
+
+static const uint32_t BASE0 = 0x10000;
+static const uint32_t BASE1 = 0x80f00; // Rows cross 4 KiB boundaries
+static const uint32_t STRIDE = 4 * H_ACTIVE + 64;
+
+static uint32_t expected(uint32_t base, uint32_t x, uint32_t y) {
+  return axi_ddr_word(base + y * STRIDE + 4 * x) & 0xffffff;
+}
+
+// Cycles from the R handshake of a word to its pixel on the stream: the RAM
+// write, the load into q and the output register
+static const uint64_t FIFO_LATENCY = 3;
+
+// A frame as seen by the pixel-capture sink
+struct frame {
+  uint64_t sof; // Cycle of the first pixel
+  std::vector<uint32_t> pixels;
+  std::vector<uint64_t> cycles; // Of every pixel
+  uint32_t lines = 0;
+};
+
+class scanout {
+public:
+  scanout(const std::string &name, axi_ddr_config config)
+      : context(std::make_unique<VerilatedContext>()),
+        dut(std::make_unique<Vrt_scanout>(context.get())),
+        sim(*dut, dut->aclk, name), ddr(*dut, config) {
+    dut->base0 = BASE0;
+    dut->base1 = BASE1;
+    dut->stride = STRIDE;
+    dut->swap = 0;
+    dut->m_axis_tready = 1;
+    dut->resetn = 0;
+    sim.tick(2);
+    dut->resetn = 1;
+  }
+
+  // One clock cycle of the sink
+  void cycle() {
+    dut->m_axis_tready = ready.next();
+    ddr.drive();
+    sim.eval();
+    ddr.sample();
+    if (dut->m_axi_rvalid && dut->m_axi_rready) {
+      beats.push_back(cycles);
+    }
+
+    // The sync signals and de are aligned with the stream
+    if (bool(dut->de) != bool(dut->m_axis_tvalid)) {
+      errors += 1;
+    }
+    if (!dut->hsync && hsync) {
+      hsync_start = cycles;
+    }
+    if (dut->hsync && !hsync && cycles - hsync_start != H_SYNC) {
+      errors += 1;
+    }
+    hsync = dut->hsync;
+
+    if (dut->m_axis_tvalid && dut->m_axis_tready) {
+      if (dut->m_axis_tuser) {
+        if (!frames.empty() && (line_pixels != 0 ||
+                                frames.back().lines != V_ACTIVE)) {
+          errors += 1;
+        }
+        frames.push_back({cycles, {}, {}, 0});
+      } else if (frames.empty()) {
+        errors += 1;
+      }
+      if (!frames.empty()) {
+        frames.back().pixels.push_back(dut->m_axis_tdata);
+        frames.back().cycles.push_back(cycles);
+        line_pixels += 1;
+        if (dut->m_axis_tlast) {
+          if (line_pixels != H_ACTIVE) {
+            errors += 1;
+          }
+          frames.back().lines += 1;
+          line_pixels = 0;
+        }
+      }
+    }
+    sim.tick();
+    cycles += 1;
+  }
+
+  // Runs until lines lines of frame index have been received
+  void run_to(size_t index, uint32_t lines = V_ACTIVE) {
+    for (int i = 0; i < 1000000; i++) {
+      if (frames.size() > index && frames[index].lines >= lines) {
+        return;
+      }
+      cycle();
+    }
+    FAIL() << "frame " << index << " not received";
+  }
+
+  void request_swap() {
+    dut->swap = 1;
+    cycle();
+    dut->swap = 0;
+  }
+
+  // Buffer shown by a frame, or -1 if it matches neither
+  int buffer(const frame &f) const {
+    for (int b = 0; b < 2; b++) {
+      uint32_t base = b ? BASE1 : BASE0;
+      bool match = f.pixels.size() == H_ACTIVE * V_ACTIVE;
+      for (uint32_t i = 0; match && i < f.pixels.size(); i++) {
+        match = f.pixels[i] == expected(base, i % H_ACTIVE, i / H_ACTIVE);
+      }
+      if (match) {
+        return b;
+      }
+    }
+    return -1;
+  }
+
+  // A pixel of buffer 0 is black if and only if its word arrived too late
+  // for it. Needs every frame to be fetched in full, so that beat n belongs
+  // to pixel n. Returns the number of black pixels.
+  uint32_t expect_late_pixels_black() const {
+    uint32_t black = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+      const frame &f = frames[i];
+      for (uint32_t p = 0; p < f.pixels.size(); p++) {
+        size_t n = i * H_ACTIVE * V_ACTIVE + p;
+        bool late = n >= beats.size() || beats[n] + FIFO_LATENCY > f.cycles[p];
+        uint32_t x = p % H_ACTIVE, y = p / H_ACTIVE;
+        EXPECT_EQ(f.pixels[p], late ? 0u : expected(BASE0, x, y))
+            << "frame " << i << ", pixel (" << x << ", " << y << ")";
+        black += late;
+      }
+    }
+    return black;
+  }
+
+  void expect_timing() const {
+    EXPECT_EQ(errors, 0u);
+    for (size_t i = 1; i < frames.size(); i++) {
+      EXPECT_EQ(frames[i].sof - frames[i - 1].sof, H_TOTAL * V_TOTAL)
+          << "frame " << i;
+    }
+  }
+
+  std::unique_ptr<VerilatedContext> context;
+  std::unique_ptr<Vrt_scanout> dut;
+  sim_trace<Vrt_scanout> sim;
+  axi_ddr<Vrt_scanout> ddr;
+  axis_pattern ready = axis_pattern::always();
+
+  std::vector<frame> frames;
+  std::vector<uint64_t> beats; // Cycle of every R handshake
+  uint32_t line_pixels = 0;
+  uint64_t cycles = 0;
+  uint64_t errors = 0; // Misplaced tuser, tlast, de or hsync
+  bool hsync = true;
+  uint64_t hsync_start = 0;
+};
+
+#pragma mark - Unit Test
+
+class ScanoutTest : public testing::Test {};
+
+TEST_F(ScanoutTest, Frames) {
+  axi_ddr_config config;
+  config.latency = 40;
+  config.jitter = 10;
+  scanout s("rt_scanout_frames", config);
+  s.run_to(3);
+
+  for (size_t i = 0; i < s.frames.size(); i++) {
+    EXPECT_EQ(s.buffer(s.frames[i]), 0) << "frame " << i;
+  }
+  s.expect_timing();
+  EXPECT_EQ(s.dut->stat_frames, s.frames.size());
+  EXPECT_EQ(s.dut->stat_underflows, 0u);
+  EXPECT_EQ(s.dut->stat_stalls, 0u);
+  EXPECT_EQ(s.ddr.stats().violations, 0u);
+  EXPECT_FALSE(s.dut->front);
+}
+
+// A swap requested during a frame takes effect at the next frame, never
+// within one
+TEST_F(ScanoutTest, Swap) {
+  axi_ddr_config config;
+  config.latency = 60;
+  scanout s("rt_scanout_swap", config);
+
+  s.run_to(0, V_ACTIVE / 2);
+  s.request_swap();
+  EXPECT_TRUE(s.dut->swap_pending);
+  s.run_to(0);
+  EXPECT_TRUE(s.dut->swap_pending);
+  EXPECT_FALSE(s.dut->front);
+  s.run_to(1);
+  EXPECT_FALSE(s.dut->swap_pending);
+  EXPECT_TRUE(s.dut->front);
+
+  // And back, half way through frame 2
+  s.run_to(2, V_ACTIVE / 2);
+  s.request_swap();
+  s.run_to(4);
+
+  std::vector<int> shown;
+  for (const frame &f : s.frames) {
+    shown.push_back(s.buffer(f));
+  }
+  EXPECT_EQ(shown, std::vector<int>({0, 1, 1, 0, 0}));
+  s.expect_timing();
+  EXPECT_EQ(s.dut->stat_underflows, 0u);
+  EXPECT_EQ(s.ddr.stats().violations, 0u);
+}
+
+// Too little bandwidth: pixels are lost, but the timing holds and the next
+// frame starts clean
+TEST_F(ScanoutTest, Underflow) {
+  axi_ddr_config config;
+  config.bandwidth = 0.3;
+  scanout s("rt_scanout_underflow", config);
+  s.run_to(2);
+
+  std::printf("underflow: %u of %u pixels\n", s.dut->stat_underflows,
+              H_ACTIVE * V_ACTIVE * uint32_t(s.frames.size()));
+  EXPECT_GT(s.dut->stat_underflows, 0u);
+
+  // Every pixel is either black or its own word: the late words of the lost
+  // pixels are dropped, so the pixels after them are not shifted
+  uint32_t lost = 0, shown = 0;
+  for (size_t i = 0; i < s.frames.size(); i++) {
+    const frame &f = s.frames[i];
+    ASSERT_EQ(f.pixels.size(), H_ACTIVE * V_ACTIVE) << "frame " << i;
+    for (uint32_t p = 0; p < f.pixels.size(); p++) {
+      uint32_t x = p % H_ACTIVE, y = p / H_ACTIVE;
+      uint32_t want = expected(BASE0, x, y);
+      if (f.pixels[p] == want) {
+        shown += want != 0;
+      } else {
+        EXPECT_EQ(f.pixels[p], 0u)
+            << "frame " << i << ", pixel (" << x << ", " << y << ")";
+        lost += 1;
+      }
+    }
+  }
+  EXPECT_EQ(lost, s.dut->stat_underflows);
+  EXPECT_GT(shown, 0u);
+  s.expect_timing();
+  EXPECT_EQ(s.ddr.stats().violations, 0u);
+}
+
+// The memory pauses in line 4 of frame 1, longer than the FIFO lasts.
+// Exactly the pixels whose words arrive late go out black, and once the
+// backlog has been worked off in the horizontal blanking the pixels show
+// their own words again
+TEST_F(ScanoutTest, LateBurst) {
+  axi_ddr_config config;
+  config.pause_at = (V_TOTAL - V_ACTIVE + V_TOTAL + 4) * H_TOTAL + 14;
+  config.pause = 60;
+  scanout s("rt_scanout_late_burst", config);
+  s.run_to(2);
+
+  uint32_t black = s.expect_late_pixels_black();
+  EXPECT_GT(black, 0u);
+  EXPECT_EQ(black, s.dut->stat_underflows);
+
+  // One run of black pixels, which ends before the frame does
+  EXPECT_EQ(s.buffer(s.frames[0]), 0);
+  EXPECT_EQ(s.buffer(s.frames[2]), 0);
+  const std::vector<uint32_t> &pixels = s.frames[1].pixels;
+  uint32_t first = 0;
+  while (first < pixels.size() && pixels[first] != 0) {
+    first++;
+  }
+  uint32_t last = first + black - 1;
+  for (uint32_t p = first; p <= last && p < pixels.size(); p++) {
+    EXPECT_EQ(pixels[p], 0u) << "pixel " << p;
+  }
+  EXPECT_LT(last, H_ACTIVE * (V_ACTIVE - 1));
+  s.expect_timing();
+  EXPECT_EQ(s.ddr.stats().violations, 0u);
+}
+
+} // namespace
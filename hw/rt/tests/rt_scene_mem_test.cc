@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <verilated.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Vrt_scene_mem.h"
+#include "sim_trace.h"
+
+#pragma mark - Helpers
+
+namespace {
+
+// -GDEPTH=16 in CMakeLists.txt
+static const uint32_t DEPTH = 16;
+
+class scene_mem {
+public:
+  scene_mem(const std::string &name)
+      : context(std::make_unique<VerilatedContext>()),
+        dut(std::make_unique<Vrt_scene_mem>(context.get())),
+        sim(*dut, dut->clk, name) {
+    dut->in_valid = 0;
+    dut->in_header = 0;
+    dut->in_last = 0;
+    dut->swap = 0;
+    dut->rd_en = 0;
+    dut->resetn = 0;
+    sim.tick(2);
+    dut->resetn = 1;
+    sim.tick();
+  }
+
+  // Send a header announcing length words and then words, one per clock.
+  // in_last is set on the final word if last is true. Returns the number of
+  // cycles in which done was high.
+  int load(uint32_t length, const std::vector<uint32_t> &words, bool last) {
+    int done = 0;
+    dut->in_valid = 1;
+    dut->in_header = 1;
+    dut->in_data = length;
+    dut->in_last = last && words.empty();
+    sim.eval();
+    done += dut->done;
+    sim.tick();
+
+    dut->in_header = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+      dut->in_data = words[i];
+      dut->in_last = last && i == words.size() - 1;
+      sim.eval();
+      done += dut->done;
+      sim.tick();
+    }
+    dut->in_valid = 0;
+    dut->in_last = 0;
+    return done;
+  }
+
+  void swap() {
+    dut->swap = 1;
+    sim.tick();
+    dut->swap = 0;
+  }
+
+  uint32_t read(uint32_t addr) {
+    dut->rd_en = 1;
+    dut->rd_addr = addr;
+    sim.tick();
+    dut->rd_en = 0;
+    sim.eval();
+    return dut->rd_data;
+  }
+
+  std::vector<uint32_t> front() {
+    std::vector<uint32_t> words;
+    for (uint32_t i = 0; i < dut->length; i++) {
+      words.push_back(read(i));
+    }
+    return words;
+  }
+
+  std::unique_ptr<VerilatedContext> context;
+  std::unique_ptr<Vrt_scene_mem> dut;
+  sim_trace<Vrt_scene_mem> sim;
+};
+
+static std::vector<uint32_t> blob(size_t count, uint32_t seed) {
+  std::vector<uint32_t> words(count);
+  for (size_t i = 0; i < count; i++) {
+    words[i] = (seed << 16) | uint32_t(i);
+  }
+  return words;
+}
+
+#pragma mark - Unit Test
+
+class SceneMemTest : public testing::Test {};
+
+TEST_F(SceneMemTest, LoadAndSwap) {
+  scene_mem mem("rt_scene_mem_swap");
+  EXPECT_EQ(mem.dut->length, 0u);
+
+  std::vector<uint32_t> first = blob(10, 1);
+  EXPECT_EQ(mem.load(10, first, false), 1);
+
+  // Not visible before the swap
+  EXPECT_EQ(mem.dut->length, 0u);
+  mem.swap();
+  EXPECT_EQ(mem.dut->length, 10u);
+  EXPECT_FALSE(mem.dut->overflow);
+  EXPECT_EQ(mem.front(), first);
+
+  // The front buffer is untouched while the next blob is loaded
+  std::vector<uint32_t> second = blob(DEPTH, 2);
+  EXPECT_EQ(mem.load(DEPTH, second, false), 1);
+  EXPECT_EQ(mem.front(), first);
+  mem.swap();
+  EXPECT_EQ(mem.front(), second);
+
+  // Without a new blob the scene stays loaded
+  mem.swap();
+  EXPECT_EQ(mem.front(), second);
+}
+
+TEST_F(SceneMemTest, EarlyLast) {
+  scene_mem mem("rt_scene_mem_last");
+  std::vector<uint32_t> words = blob(5, 3);
+  EXPECT_EQ(mem.load(12, words, true), 1);
+  mem.swap();
+  EXPECT_EQ(mem.dut->length, 5u);
+  EXPECT_EQ(mem.front(), words);
+}
+
+TEST_F(SceneMemTest, Empty) {
+  scene_mem mem("rt_scene_mem_empty");
+  EXPECT_EQ(mem.load(4, blob(4, 4), false), 1);
+  mem.swap();
+  EXPECT_EQ(mem.dut->length, 4u);
+
+  EXPECT_EQ(mem.load(0, {}, false), 1);
+  mem.swap();
+  EXPECT_EQ(mem.dut->length, 0u);
+}
+
+TEST_F(SceneMemTest, Overflow) {
+  scene_mem mem("rt_scene_mem_overflow");
+  std::vector<uint32_t> words = blob(DEPTH + 3, 5);
+  EXPECT_EQ(mem.load(DEPTH + 3, words, false), 1);
+  mem.swap();
+  EXPECT_EQ(mem.dut->length, DEPTH);
+  EXPECT_TRUE(mem.dut->overflow);
+  words.resize(DEPTH);
+  EXPECT_EQ(mem.front(), words);
+
+  // Cleared by the next blob that fits
+  EXPECT_EQ(mem.load(2, blob(2, 6), false), 1);
+  mem.swap();
+  EXPECT_FALSE(mem.dut->overflow);
+  EXPECT_EQ(mem.front(), blob(2, 6));
+}
+
+} // namespace
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <verilated.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Vrt_shader_core.h"
+#include "axis.h"
+#include "shader_interpreter.hpp"
+#include "shader_isa.hpp"
+#include "sim_trace.h"
+
+#pragma mark - Helpers
+
+namespace {
+
+// -GLANES=2 in CMakeLists.txt
+static const int LANES = 2;
+
+struct fragment {
+  shader_vec direction;
+  shader_vec origin;
+};
+
+class shader_core {
+public:
+  shader_core(const std::string &name)
+      : context(std::make_unique<VerilatedContext>()),
+        dut(std::make_unique<Vrt_shader_core>(context.get())),
+        sim(*dut, dut->clk, name),
+        cfg(dut->s_cfg_tvalid, dut->s_cfg_tdata, dut->s_cfg_tlast,
+            dut->s_cfg_tready) {
+    dut->in_valid = 0;
+    dut->in_last = 0;
+    dut->out_ready = 0;
+    dut->resetn = 0;
+    sim.tick(2);
+    dut->resetn = 1;
+    sim.tick();
+  }
+
+  bool load(const shader_program &program) {
+    std::vector<uint32_t> words = program.stream();
+    cfg.send(words.data(), words.size());
+    for (int cycle = 0; cycle < 10000 && !cfg.idle(); cycle++) {
+      axis_cycle(sim, cfg);
+    }
+    axis_cycle(sim, cfg);
+    return cfg.idle() && dut->program_loaded;
+  }
+
+  // Shade the fragments as one packet, LANES per beat, and return r0 of
+  // every fragment in order
+  std::vector<shader_vec> shade(const std::vector<fragment> &fragments,
+                                axis_pattern valid, axis_pattern ready) {
+    size_t beats = (fragments.size() + LANES - 1) / LANES;
+    size_t sent = 0;
+    std::vector<shader_vec> colors;
+
+    for (int cycle = 0; cycle < 100000 && colors.size() < beats * LANES;
+         cycle++) {
+      if (!dut->in_valid && sent < beats && valid.next()) {
+        dut->in_valid = 1;
+        dut->in_last = sent == beats - 1;
+        for (int l = 0; l < LANES; l++) {
+          size_t i = std::min(sent * LANES + l, fragments.size() - 1);
+          for (int n = 0; n < 3; n++) {
+            dut->in_direction[l * 3 + n] =
+                uint32_t(fragments[i].direction[n]);
+            dut->in_origin[l * 3 + n] = uint32_t(fragments[i].origin[n]);
+          }
+        }
+      }
+      dut->out_ready = ready.next();
+      sim.eval();
+
+      bool accepted = dut->in_valid && dut->in_ready;
+      if (dut->out_valid && dut->out_ready) {
+        size_t beat = colors.size() / LANES;
+        EXPECT_EQ(bool(dut->out_last), beat == beats - 1) << beat;
+        for (int l = 0; l < LANES; l++) {
+          shader_vec color;
+          for (int n = 0; n < 3; n++) {
+            color[n] = int32_t(dut->out_color[l * 3 + n]);
+          }
+          colors.push_back(color);
+        }
+      }
+      sim.tick();
+
+      if (accepted) {
+        dut->in_valid = 0;
+        dut->in_last = 0;
+        sent += 1;
+      }
+    }
+    EXPECT_EQ(sent, beats);
+    colors.resize(fragments.size());
+    return colors;
+  }
+
+  std::unique_ptr<VerilatedContext> context;
+  std::unique_ptr<Vrt_shader_core> dut;
+  sim_trace<Vrt_shader_core> sim;
+  axis_master cfg;
+};
+
+static shader_program assemble(const std::string &source) {
+  shader_program program;
+  std::string error;
+  EXPECT_TRUE(shader_assemble(source, program, error)) << error;
+  return program;
+}
+
+static std::vector<fragment> random_fragments(size_t count, double range,
+                                              uint32_t seed) {
+  sfp_format f = {FP_IW, FP_QW};
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> value(-range, range);
+  std::vector<fragment> fragments(count);
+  for (fragment &frag : fragments) {
+    for (int n = 0; n < 3; n++) {
+      frag.direction[n] = sfp_from_float(value(rng), f);
+      frag.origin[n] = sfp_from_float(value(rng), f);
+    }
+  }
+  return fragments;
+}
+
+static void expect_matches_interpreter(const shader_program &program,
+                                       const std::vector<fragment> &fragments,
+                                       const std::vector<shader_vec> &colors) {
+  shader_interpreter reference(program);
+  ASSERT_EQ(colors.size(), fragments.size());
+  for (size_t i = 0; i < fragments.size(); i++) {
+    shader_vec expected =
+        reference.run(fragments[i].direction, fragments[i].origin);
+    EXPECT_EQ(colors[i], expected) << "fragment " << i;
+  }
+}
+
+#pragma mark - Unit Test
+
+class ShaderCoreTest : public testing::Test {};
+
+TEST_F(ShaderCoreTest, Sky) {
+  std::ifstream in(SHADER_DIR "/sky.s");
+  ASSERT_TRUE(in);
+  std::stringstream source;
+  source << in.rdbuf();
+  shader_program program = assemble(source.str());
+
+  shader_core core("rt_shader_core_sky");
+  ASSERT_TRUE(core.load(program));
+
+  // Not a multiple of LANES * THREADS: the last batch is partial
+  std::vector<fragment> fragments = random_fragments(45, 2.0, 1);
+  std::vector<shader_vec> colors = core.shade(
+      fragments, axis_pattern::always(), axis_pattern::always());
+  expect_matches_interpreter(program, fragments, colors);
+}
+
+// Every operation, with backpressure on both sides
+TEST_F(ShaderCoreTest, RandomPrograms) {
+  std::mt19937 rng(7);
+  shader_core core("rt_shader_core_random");
+
+  for (int p = 0; p < 8; p++) {
+    std::string source;
+    std::uniform_real_distribution<double> value(-4, 4);
+    for (int k = 0; k < 4; k++) {
+      source += ".const k" + std::to_string(k);
+      for (int n = 0; n < 3; n++) {
+        source += " " + std::to_string(value(rng));
+      }
+      source += "\n";
+    }
+
+    // Only read registers that have been written, the others are undefined
+    // in hardware
+    std::vector<int> defined = {0, 1};
+    auto pick = [&] {
+      return "r" + std::to_string(defined[rng() % defined.size()]);
+    };
+    for (int i = 0; i < 24; i++) {
+      const shader_mnemonic &m =
+          SHADER_MNEMONICS[1 + rng() % (std::size(SHADER_MNEMONICS) - 1)];
+      int d = int(rng() % SHADER_REGS);
+      std::string line = std::string(m.name) + " r" + std::to_string(d);
+      for (const char *o = m.operands + 1; *o; o++) {
+        if (*o == 'k') {
+          line += ", k" + std::to_string(rng() % 4);
+        } else if (*o == 's') {
+          line += ", " + pick() + "." + "xyz"[rng() % 3];
+        } else {
+          line += ", " + pick();
+        }
+      }
+      source += line + "\n";
+      if (std::find(defined.begin(), defined.end(), d) == defined.end()) {
+        defined.push_back(d);
+      }
+    }
+    shader_program program = assemble(source);
+
+    ASSERT_TRUE(core.load(program)) << "program " << p;
+    std::vector<fragment> fragments = random_fragments(37, 8.0, p);
+    std::vector<shader_vec> colors =
+        core.shade(fragments, axis_pattern::random(0.7, p),
+                   axis_pattern::random(0.5, p + 100));
+    expect_matches_interpreter(program, fragments, colors);
+    if (HasFailure()) {
+      std::cerr << source;
+      break;
+    }
+  }
+}
+
+} // namespace
@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Shared clock and waveform helper for the Verilated tests.
+//
+// Tracing is off by default, so the tests run at full Verilator speed. It
+// is selected per test or through the environment:
+// - TRACE_OFF:  no tracing
+// - TRACE_FULL: the whole simulation is written to <name>.vcd
+// - TRACE_RING: the last ring_cycles to 2 * ring_cycles cycles are kept in
+//               memory and written to <name>.vcd only when the test fails or
+//               a trigger condition fires
+//
+// The environment variables SIM_TRACE (off, full or ring) and
+// SIM_TRACE_CYCLES override the mode and ring length of every test, e.g. to
+// get a full trace of a test that passes.
+
+enum trace_mode {
+  TRACE_OFF,
+  TRACE_FULL,
+  TRACE_RING,
+};
+
+static const int SIM_CLOCK_HALF_PERIOD = 5;
+
+// VCD output that stays in memory. Every open() starts a new segment; only
+// the two most recent segments are kept.
+class vcd_ring_file : public VerilatedVcdFile {
+public:
+  bool open(const std::string &) override {
+    segments.emplace_back();
+    if (segments.size() > 2) {
+      segments.pop_front();
+    }
+    return true;
+  }
+  void close() override {}
+  ssize_t write(const char *bufp, ssize_t len) override {
+    segments.back().append(bufp, size_t(len));
+    return len;
+  }
+
+  bool save(const std::string &path) const {
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+      return false;
+    }
+    std::fwrite(header.data(), 1, header.size(), f);
+    for (const std::string &s : segments) {
+      std::fwrite(s.data(), 1, s.size(), f);
+    }
+    return std::fclose(f) == 0;
+  }
+
+  std::string header;
+  std::deque<std::string> segments;
+};
+
+template <typename DUT> class sim_trace {
+public:
+  sim_trace(DUT &dut, CData &clk, const std::string &name,
+            trace_mode mode = TRACE_OFF, uint64_t ring_cycles = 1024)
+      : dut(dut), clk(clk), name(name), mode(mode), ring_cycles(ring_cycles) {
+    const char *env = std::getenv("SIM_TRACE");
+    if (env && std::strcmp(env, "off") == 0) {
+      this->mode = TRACE_OFF;
+    } else if (env && std::strcmp(env, "full") == 0) {
+      this->mode = TRACE_FULL;
+    } else if (env && std::strcmp(env, "ring") == 0) {
+      this->mode = TRACE_RING;
+    }
+    env = std::getenv("SIM_TRACE_CYCLES");
+    if (env && std::atoll(env) > 0) {
+      this->ring_cycles = uint64_t(std::atoll(env));
+    }
+
+    if (this->mode == TRACE_OFF) {
+      return;
+    }
+
+    Verilated::traceEverOn(true);
+    if (this->mode == TRACE_RING) {
+      ring = std::make_unique<vcd_ring_file>();
+      trace = std::make_unique<VerilatedVcdC>(ring.get());
+    } else {
+      trace = std::make_unique<VerilatedVcdC>();
+    }
+    dut.trace(trace.get(), 10);
+    trace->open((name + ".vcd").c_str());
+
+    if (ring) {
+      // Everything written so far is the declaration header
+      trace->flush();
+      ring->header = std::move(ring->segments.back());
+      ring->segments.back().clear();
+    }
+  }
+
+  ~sim_trace() {
+    if (ring && testing::Test::HasFailure()) {
+      save(name + ".vcd", "test failure");
+    }
+    if (trace) {
+      trace->close();
+    }
+  }
+
+  sim_trace(const sim_trace &) = delete;
+  sim_trace &operator=(const sim_trace &) = delete;
+
+  void tick() {
+    if (trigger && !triggered && trigger()) {
+      triggered = true;
+      save(name + "_trigger.vcd", "trigger");
+    }
+
+    clk ^= 1;
+    dut.eval();
+    dump();
+    dut.contextp()->timeInc(SIM_CLOCK_HALF_PERIOD);
+
+    clk ^= 1;
+    dut.eval();
+    dump();
+    dut.contextp()->timeInc(SIM_CLOCK_HALF_PERIOD);
+
+    cycle += 1;
+    if (ring && cycle % ring_cycles == 0) {
+      // Start a new segment; its first dump contains every signal
+      trace->openNext(false);
+      trace->flush();
+      ring->segments.back().clear();
+    }
+  }
+  void tick(int cycles) {
+    for (int i = 0; i < cycles; i++) {
+      tick();
+    }
+  }
+
+  // Propagate inputs changed between clock edges
+  void eval() { dut.eval(); }
+
+  // Save the ring buffer the first time cond returns true. cond is evaluated
+  // before every clock cycle.
+  void trigger_when(std::function<bool()> cond) {
+    trigger = std::move(cond);
+    triggered = false;
+  }
+
+  // Write the cycles kept in memory. Full traces are on disk already.
+  bool save(const std::string &path, const char *reason) {
+    if (!ring) {
+      return false;
+    }
+    trace->flush();
+    std::printf("[sim_trace] %s at cycle %llu, waveform in %s\n", reason,
+                (unsigned long long)cycle, path.c_str());
+    return ring->save(path);
+  }
+
+  trace_mode current_mode() const { return mode; }
+  uint64_t cycles() const { return cycle; }
+
+private:
+  void dump() {
+    if (trace) {
+      trace->dump(dut.contextp()->time());
+    }
+  }
+
+  DUT &dut;
+  CData &clk;
+  std::string name;
+  trace_mode mode;
+  uint64_t ring_cycles;
+  uint64_t cycle = 0;
+
+  std::unique_ptr<vcd_ring_file> ring;
+  std::unique_ptr<VerilatedVcdC> trace;
+
+  std::function<bool()> trigger;
+  bool triggered = false;
+};
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "vec3.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+inline vec3 vmin(const vec3 &u, const vec3 &v) {
+  return vec3(std::min(u.e[0], v.e[0]), std::min(u.e[1], v.e[1]),
+              std::min(u.e[2], v.e[2]));
+}
+
+inline vec3 vmax(const vec3 &u, const vec3 &v) {
+  return vec3(std::max(u.e[0], v.e[0]), std::max(u.e[1], v.e[1]),
+              std::max(u.e[2], v.e[2]));
+}
+
+// Axis-aligned bounding box
+class aabb {
+public:
+  vec3 min, max;
+
+  // Default box is empty
+  aabb()
+      : min(+INFINITY, +INFINITY, +INFINITY),
+        max(-INFINITY, -INFINITY, -INFINITY) {}
+
+  aabb(const vec3 &min, const vec3 &max) : min(min), max(max) {}
+
+  bool empty() const {
+    return min.e[0] > max.e[0] || min.e[1] > max.e[1] || min.e[2] > max.e[2];
+  }
+
+  void grow(const vec3 &p) {
+    min = vmin(min, p);
+    max = vmax(max, p);
+  }
+
+  void grow(const aabb &b) {
+    min = vmin(min, b.min);
+    max = vmax(max, b.max);
+  }
+
+  vec3 extent() const { return max - min; }
+
+  vec3 centroid() const { return 0.5f * (min + max); }
+
+  float surface_area() const {
+    if (empty()) {
+      return 0;
+    }
+    vec3 d = extent();
+    return 2 * (d.e[0] * d.e[1] + d.e[1] * d.e[2] + d.e[2] * d.e[0]);
+  }
+
+  bool contains(const aabb &b) const {
+    for (int a = 0; a < 3; a++) {
+      if (b.min.e[a] < min.e[a] || b.max.e[a] > max.e[a]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Slab test against a ray given by its origin and 1 / direction. On a hit,
+  // t_entry is where the ray enters the box, clamped to t_min.
+  bool hit(const vec3 &origin, const vec3 &inv_dir, float t_min, float t_max,
+           float &t_entry) const {
+    for (int a = 0; a < 3; a++) {
+      float t0 = (min.e[a] - origin.e[a]) * inv_dir.e[a];
+      float t1 = (max.e[a] - origin.e[a]) * inv_dir.e[a];
+      if (inv_dir.e[a] < 0) {
+        std::swap(t0, t1);
+      }
+      // Written so that a NaN from 0 * inf keeps the old bound
+      t_min = t0 > t_min ? t0 : t_min;
+      t_max = t1 < t_max ? t1 : t_max;
+      if (t_max < t_min) {
+        return false;
+      }
+    }
+    t_entry = t_min;
+    return true;
+  }
+};
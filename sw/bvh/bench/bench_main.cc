@@ -0,0 +1,6 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
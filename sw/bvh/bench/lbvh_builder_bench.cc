@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "bvh.hpp"
+#include "lbvh_builder.hpp"
+#include "mesh.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+
+// LBVH build of 100K and 1M triangles on 1 to N threads, doubling.
+// items_per_second is triangles per second; BM_SahBuild is the comparison.
+// BM_RadixSort is the sort step alone, on 30-bit keys.
+
+static void threads(benchmark::internal::Benchmark *b) {
+  for (int n : {100000, 1000000}) {
+    for (unsigned t = 1;; t *= 2) {
+      unsigned clamped = std::min(t, default_threads());
+      b->Args({n, int(clamped)});
+      if (clamped == default_threads()) {
+        break;
+      }
+    }
+  }
+}
+
+static void BM_LbvhBuild(benchmark::State &state) {
+  std::vector<triangle> triangles = random_mesh(state.range(0));
+  lbvh_options options;
+  options.threads = unsigned(state.range(1));
+  lbvh_builder builder(options);
+
+  bvh b;
+  for (auto _ : state) {
+    b = builder.build(triangles);
+    benchmark::DoNotOptimize(b.nodes.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * triangles.size());
+  state.counters["sah"] = b.sah_cost();
+  state.counters["nodes"] = double(b.nodes.size());
+}
+
+static void BM_RadixSort(benchmark::State &state) {
+  std::vector<uint32_t> keys(state.range(0)), values(state.range(0));
+  uint32_t x = 1;
+  for (uint32_t &k : keys) {
+    x = x * 1664525 + 1013904223;
+    k = x >> 2;
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint32_t> k = keys, v = values;
+    state.ResumeTiming();
+    radix_sort(k, v, 30, unsigned(state.range(1)));
+    benchmark::DoNotOptimize(k.data());
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+BENCHMARK(BM_LbvhBuild)
+    ->ArgNames({"triangles", "threads"})
+    ->Apply(threads)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_RadixSort)
+    ->ArgNames({"keys", "threads"})
+    ->Apply(threads)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
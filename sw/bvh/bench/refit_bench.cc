@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "bvh.hpp"
+#include "lbvh_builder.hpp"
+#include "mesh.hpp"
+#include "refit.hpp"
+#include "sah_builder.hpp"
+
+// Time per frame of an animated scene of 100K and 1M triangles: refitting
+// with and without rotations, against rebuilding with either builder. The
+// animation itself is not timed. Refitting never rebuilds here; the "sah"
+// counter is the SAH cost after the frames run, against a fresh build, and
+// "uploaded" the node words per frame that upload() writes.
+
+static void BM_Refit(benchmark::State &state) {
+  std::vector<triangle> mesh = random_mesh(state.range(0));
+  refit_options options;
+  options.rotate = state.range(1);
+  options.rebuild_threshold = INFINITY;
+  dynamic_bvh d(mesh, options);
+  std::vector<uint32_t> image;
+  d.upload(image);
+
+  size_t uploaded = 0;
+  int frame = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<triangle> triangles = animate_mesh(mesh, float(++frame));
+    state.ResumeTiming();
+    d.update(triangles);
+    uploaded += d.upload(image);
+  }
+
+  state.SetItemsProcessed(state.iterations() * mesh.size());
+  state.counters["sah"] = d.degradation();
+  state.counters["uploaded"] = double(uploaded) / state.iterations();
+}
+
+template <typename Builder> static void BM_Rebuild(benchmark::State &state) {
+  std::vector<triangle> mesh = random_mesh(state.range(0));
+  Builder builder;
+
+  int frame = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<triangle> triangles = animate_mesh(mesh, float(++frame));
+    state.ResumeTiming();
+    bvh b = builder.build(triangles);
+    benchmark::DoNotOptimize(b.serialise_nodes().data());
+  }
+  state.SetItemsProcessed(state.iterations() * mesh.size());
+}
+
+BENCHMARK(BM_Refit)
+    ->ArgNames({"triangles", "rotate"})
+    ->ArgsProduct({{100000, 1000000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Rebuild, sah_builder)
+    ->ArgNames({"triangles"})
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Rebuild, lbvh_builder)
+    ->ArgNames({"triangles"})
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bvh.hpp"
+#include "mesh.hpp"
+#include "parallel.hpp"
+#include "sah_builder.hpp"
+
+// Binned SAH build of 10K to 1M triangles on 1 thread and on every core.
+// Besides the build time, reports the SAH cost of the tree, its nodes and
+// its memory (nodes and indices) per triangle.
+
+static void BM_SahBuild(benchmark::State &state) {
+  std::vector<triangle> triangles = random_mesh(state.range(0));
+  sah_options options;
+  options.threads = unsigned(state.range(1));
+  sah_builder builder(options);
+
+  bvh b;
+  for (auto _ : state) {
+    b = builder.build(triangles);
+    benchmark::DoNotOptimize(b.nodes.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * triangles.size());
+  state.counters["sah"] = b.sah_cost();
+  state.counters["nodes"] = double(b.nodes.size());
+  state.counters["bytes_per_tri"] = double(b.memory()) / triangles.size();
+}
+
+static void sizes(benchmark::internal::Benchmark *b) {
+  for (int threads : {1, int(default_threads())}) {
+    for (int n : {10000, 100000, 1000000}) {
+      b->Args({n, threads});
+    }
+    if (default_threads() == 1) {
+      break;
+    }
+  }
+}
+
+BENCHMARK(BM_SahBuild)
+    ->ArgNames({"triangles", "threads"})
+    ->Apply(sizes)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "bvh.hpp"
+#include "mesh.hpp"
+#include "sah_builder.hpp"
+#include "wide_bvh.hpp"
+
+// Closest-hit traversal of the binary BVH against the compressed BVH4 and
+// BVH8 of the same scene. items_per_second is rays per second. The counters
+// give the node memory (nodes and triangles per KB, counting nodes and
+// indices) and the work per ray: nodes fetched, box tests and triangle
+// tests.
+
+static std::vector<ray> rays_into(const std::vector<triangle> &triangles) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> coord(-80, 80);
+  std::vector<ray> rays;
+  for (int i = 0; i < 4096; i++) {
+    const triangle &t = triangles[rng() % triangles.size()];
+    point3 origin(coord(rng), coord(rng), coord(rng));
+    rays.emplace_back(origin, t.centroid() - origin);
+  }
+  return rays;
+}
+
+// width 2 is the binary BVH
+static void BM_Traverse(benchmark::State &state) {
+  std::vector<triangle> triangles = random_mesh(state.range(0));
+  int width = state.range(1);
+  bvh b = sah_builder().build(triangles);
+  wide_bvh w;
+  if (width > 2 && !w.encode(b, width)) {
+    state.SkipWithError("leaves too large");
+    return;
+  }
+  std::vector<ray> rays = rays_into(triangles);
+
+  traversal_stats stats;
+  size_t traced = 0;
+  for (auto _ : state) {
+    for (const ray &r : rays) {
+      bvh_hit hit;
+      bool found = width > 2 ? w.hit(triangles, r, interval(0.001f, INFINITY),
+                                     hit, &stats)
+                             : b.hit(triangles, r, interval(0.001f, INFINITY),
+                                     hit, &stats);
+      benchmark::DoNotOptimize(found);
+    }
+    traced += rays.size();
+  }
+
+  size_t nodes = width > 2 ? w.nodes() : b.nodes.size();
+  size_t memory = width > 2 ? w.memory() : b.memory();
+  state.SetItemsProcessed(traced);
+  state.counters["nodes_per_kb"] = 1024.0 * nodes / memory;
+  state.counters["tris_per_kb"] = 1024.0 * triangles.size() / memory;
+  state.counters["nodes_per_ray"] = double(stats.nodes) / traced;
+  state.counters["boxes_per_ray"] = double(stats.boxes) / traced;
+  state.counters["tris_per_ray"] = double(stats.triangles) / traced;
+}
+
+BENCHMARK(BM_Traverse)
+    ->ArgNames({"triangles", "width"})
+    ->ArgsProduct({{100000, 1000000}, {2, 4, 8}})
+    ->Unit(benchmark::kMicrosecond);
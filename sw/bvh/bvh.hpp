@@ -0,0 +1,235 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "aabb.hpp"
+#include "interval.hpp"
+#include "ray.hpp"
+#include "scene.hpp"
+#include "triangle.hpp"
+#include "vec3.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary BVH over triangles, flattened in depth-first order.
+//
+// The left child of an interior node is the next node in the array, so a
+// node only stores the index of its right child. Leaves store a range of
+// bvh::indices, the triangles they hold. A node is 32 bytes, one line of
+// rt_node_cache:
+//
+//   word 0-2  bounds min x, y, z
+//   word 3-5  bounds max x, y, z
+//   word 6    interior: index of the right child; leaf: first index
+//   word 7    bits 15:0 triangle count (0 for interior nodes),
+//             bits 17:16 split axis of an interior node
+//
+// serialise_nodes() writes the bounds in 16.16 fixed point, like
+// FLOAT_2_FIX in scene.hpp, but rounded outwards so that the fixed-point
+// box still contains its triangles. serialise_triangles() writes 9 words
+// per triangle in the order of bvh::indices, so that the index range of a
+// leaf addresses the serialised triangles directly.
+
+struct bvh_node {
+  float min[3];
+  float max[3];
+  uint32_t offset; // Interior: right child; leaf: first index
+  uint16_t count;  // Triangles of a leaf, 0 for interior nodes
+  uint16_t axis;   // Split axis of an interior node
+
+  bool leaf() const { return count != 0; }
+
+  aabb bounds() const {
+    return aabb(vec3(min[0], min[1], min[2]), vec3(max[0], max[1], max[2]));
+  }
+
+  void set_bounds(const aabb &b) {
+    for (int a = 0; a < 3; a++) {
+      min[a] = b.min.e[a];
+      max[a] = b.max.e[a];
+    }
+  }
+};
+
+static_assert(sizeof(bvh_node) == 32, "A BVH node is one node cache line");
+
+#define BVH_NODE_WORDS 8
+#define BVH_TRIANGLE_WORDS 9
+
+// Deepest tree the traversal handles; the builders stay below it
+#define BVH_MAX_DEPTH 128
+
+// Weights of the surface area heuristic
+struct sah_costs {
+  float traversal = 1.0f;
+  float intersection = 1.0f;
+};
+
+// 16.16 fixed point rounded towards minus and plus infinity
+inline uint32_t fix_floor(float x) {
+  return uint32_t(int32_t(std::floor(double(x) * FP_2_POW_QW)));
+}
+inline uint32_t fix_ceil(float x) {
+  return uint32_t(int32_t(std::ceil(double(x) * FP_2_POW_QW)));
+}
+
+inline void serialise_node(const bvh_node &n, uint32_t out[BVH_NODE_WORDS]) {
+  for (int a = 0; a < 3; a++) {
+    out[a] = fix_floor(n.min[a]);
+    out[3 + a] = fix_ceil(n.max[a]);
+  }
+  out[6] = n.offset;
+  out[7] = uint32_t(n.count) | uint32_t(n.axis) << 16;
+}
+
+// Nearest hit of a ray
+struct bvh_hit {
+  float t;
+  uint32_t triangle; // Index into the triangles the BVH was built over
+};
+
+// Work of a traversal, summed over rays
+struct traversal_stats {
+  size_t nodes = 0;     // Nodes fetched
+  size_t boxes = 0;     // Ray-box tests
+  size_t triangles = 0; // Ray-triangle tests
+};
+
+// 9 words per triangle in the order of indices
+inline std::vector<uint32_t>
+serialise_triangles(const std::vector<triangle> &triangles,
+                    const std::vector<uint32_t> &indices) {
+  std::vector<uint32_t> words;
+  words.reserve(indices.size() * BVH_TRIANGLE_WORDS);
+  for (uint32_t i : indices) {
+    const triangle &t = triangles[i];
+    for (const point3 *v : {&t.v0, &t.v1, &t.v2}) {
+      for (int a = 0; a < 3; a++) {
+        words.push_back(uint32_t(FLOAT_2_FIX(v->e[a])));
+      }
+    }
+  }
+  return words;
+}
+
+class bvh {
+public:
+  std::vector<bvh_node> nodes;   // Depth-first, the root first
+  std::vector<uint32_t> indices; // Triangles of the leaves
+
+  // Expected cost of a random ray, relative to the root
+  float sah_cost(sah_costs costs = {}) const {
+    if (nodes.empty()) {
+      return 0;
+    }
+    float root = nodes[0].bounds().surface_area();
+    if (root <= 0) {
+      return 0;
+    }
+    double cost = 0;
+    for (const bvh_node &n : nodes) {
+      float area = n.bounds().surface_area() / root;
+      cost += n.leaf() ? costs.intersection * n.count * area
+                       : costs.traversal * area;
+    }
+    return float(cost);
+  }
+
+  // Bytes of nodes and indices
+  size_t memory() const {
+    return nodes.size() * sizeof(bvh_node) + indices.size() * sizeof(uint32_t);
+  }
+
+  size_t leaves() const {
+    return std::count_if(nodes.begin(), nodes.end(),
+                         [](const bvh_node &n) { return n.leaf(); });
+  }
+
+  int depth() const {
+    int deepest = 0;
+    std::vector<std::pair<uint32_t, int>> stack;
+    if (!nodes.empty()) {
+      stack.push_back({0, 1});
+    }
+    while (!stack.empty()) {
+      auto [i, d] = stack.back();
+      stack.pop_back();
+      deepest = std::max(deepest, d);
+      if (!nodes[i].leaf()) {
+        stack.push_back({i + 1, d + 1});
+        stack.push_back({nodes[i].offset, d + 1});
+      }
+    }
+    return deepest;
+  }
+
+  // Nearest hit within ray_t. Visits the near child first, by the sign of
+  // the ray direction on the split axis.
+  bool hit(const std::vector<triangle> &triangles, const ray &r,
+           interval ray_t, bvh_hit &result,
+           traversal_stats *stats = nullptr) const {
+    if (nodes.empty()) {
+      return false;
+    }
+    const vec3 &d = r.direction();
+    vec3 inv_dir(1 / d.e[0], 1 / d.e[1], 1 / d.e[2]);
+
+    bool found = false;
+    uint32_t stack[BVH_MAX_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+      const bvh_node &n = nodes[stack[--top]];
+      if (stats) {
+        stats->nodes += 1;
+        stats->boxes += 1;
+      }
+      float t_entry;
+      if (!n.bounds().hit(r.origin(), inv_dir, ray_t.min, ray_t.max,
+                          t_entry)) {
+        continue;
+      }
+      if (n.leaf()) {
+        if (stats) {
+          stats->triangles += n.count;
+        }
+        for (uint32_t i = n.offset; i < n.offset + n.count; i++) {
+          float t;
+          if (triangles[indices[i]].hit(r, ray_t, t)) {
+            ray_t.max = t;
+            result = {t, indices[i]};
+            found = true;
+          }
+        }
+        continue;
+      }
+      uint32_t left = uint32_t(&n - nodes.data()) + 1;
+      if (d.e[n.axis] < 0) {
+        stack[top++] = left;
+        stack[top++] = n.offset;
+      } else {
+        stack[top++] = n.offset;
+        stack[top++] = left;
+      }
+    }
+    return found;
+  }
+
+  std::vector<uint32_t> serialise_nodes() const {
+    std::vector<uint32_t> words(nodes.size() * BVH_NODE_WORDS);
+    for (size_t i = 0; i < nodes.size(); i++) {
+      serialise_node(nodes[i], &words[i * BVH_NODE_WORDS]);
+    }
+    return words;
+  }
+
+  std::vector<uint32_t>
+  serialise_triangles(const std::vector<triangle> &triangles) const {
+    return ::serialise_triangles(triangles, indices);
+  }
+};
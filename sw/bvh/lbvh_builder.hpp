@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "parallel.hpp"
+#include "radix_sort.hpp"
+#include "triangle.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Linear BVH build for per-frame rebuilds (Karras, "Maximizing Parallelism
+// in the Construction of BVHs, Octrees, and k-d Trees", HPG 2012).
+//
+//   1. 30-bit Morton codes of the triangle centroids, in parallel
+//   2. Parallel LSD radix sort of the codes (radix_sort.hpp)
+//   3. The n - 1 internal nodes of the radix tree over the sorted codes,
+//      each found on its own from the common prefixes of its neighbours
+//   4. Bounds from the leaves up, in parallel: the second child to finish
+//      a node computes its bounds
+//   5. Subtrees of at most max_leaf_size triangles become leaves, and the
+//      tree is written in the depth-first bvh format, subtrees in parallel
+//
+// Every step is linear in the triangles, and the result does not depend
+// on the thread count. The trees cost more to traverse than sah_builder's.
+
+struct lbvh_options {
+  int max_leaf_size = 4; // Subtrees this small become leaves
+  unsigned threads = 0;  // 0 for one per core
+  size_t grain = 1 << 14; // Smallest chunk of work for a thread
+};
+
+// Spreads the low 10 bits of x to every third bit
+inline uint32_t morton_expand(uint32_t x) {
+  x &= 0x3ff;
+  x = (x | x << 16) & 0x030000ff;
+  x = (x | x << 8) & 0x0300f00f;
+  x = (x | x << 4) & 0x030c30c3;
+  x = (x | x << 2) & 0x09249249;
+  return x;
+}
+
+// Morton code of a point in [0, 1]^3, x in the most significant bit
+inline uint32_t morton_code(const vec3 &p) {
+  uint32_t m[3];
+  for (int a = 0; a < 3; a++) {
+    m[a] = uint32_t(std::clamp(p.e[a] * 1024.0f, 0.0f, 1023.0f));
+  }
+  return morton_expand(m[0]) << 2 | morton_expand(m[1]) << 1 |
+         morton_expand(m[2]);
+}
+
+class lbvh_builder {
+public:
+  explicit lbvh_builder(lbvh_options options = {})
+      : options(options), threads(options.threads ? options.threads
+                                                  : default_threads()) {}
+
+  bvh build(const std::vector<triangle> &triangles) {
+    size_t n = triangles.size();
+    bvh result;
+    if (n == 0) {
+      return result;
+    }
+    unsigned chunks = parallel_chunks(n, threads, options.grain);
+
+    // Triangle bounds, and the bounds of the centroids
+    bounds.resize(n);
+    std::vector<aabb> partial(chunks);
+    parallel_for(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        bounds[i] = triangles[i].bounds();
+        partial[c].grow(bounds[i].centroid());
+      }
+    });
+    aabb cb;
+    for (const aabb &b : partial) {
+      cb.grow(b);
+    }
+    vec3 extent = cb.extent();
+    vec3 scale(extent.e[0] > 0 ? 1 / extent.e[0] : 0,
+               extent.e[1] > 0 ? 1 / extent.e[1] : 0,
+               extent.e[2] > 0 ? 1 / extent.e[2] : 0);
+
+    codes.resize(n);
+    result.indices.resize(n);
+    parallel_for(n, chunks, [&](unsigned, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        codes[i] = morton_code((bounds[i].centroid() - cb.min) * scale);
+        result.indices[i] = uint32_t(i);
+      }
+    });
+    radix_sort(codes, result.indices, 30, threads, options.grain);
+    leaves = result.indices.data();
+
+    // Radix tree: internal node i and leaf i, with their parents
+    size_t internal = n - 1;
+    tree = std::vector<radix_node>(internal);
+    leaf_parent.resize(n);
+    parallel_for(internal, parallel_chunks(internal, threads, options.grain),
+                 [&](unsigned, size_t begin, size_t end) {
+                   for (size_t i = begin; i < end; i++) {
+                     split(int64_t(i));
+                   }
+                 });
+
+    fit(chunks);
+    flatten(result);
+
+    tree.clear();
+    codes.clear();
+    bounds.clear();
+    return result;
+  }
+
+private:
+  // Children at or above LEAF are leaves
+  static constexpr uint32_t LEAF = 0x80000000;
+
+  struct radix_node {
+    aabb bounds;
+    uint32_t child[2];
+    uint32_t parent;
+    uint32_t first, last; // Leaves covered
+    uint32_t size;        // Nodes once flattened
+    std::atomic<uint32_t> arrived{0};
+  };
+
+  // Length of the common prefix of the codes of leaves i and j, with the
+  // leaf index as tie breaker, or -1 outside the leaves
+  int delta(int64_t i, int64_t j) const {
+    if (j < 0 || j >= int64_t(codes.size())) {
+      return -1;
+    }
+    uint32_t a = codes[i], b = codes[j];
+    if (a == b) {
+      return 32 + __builtin_clz(uint32_t(i ^ j));
+    }
+    return __builtin_clz(a ^ b);
+  }
+
+  // Finds the leaf range and the split of internal node i
+  void split(int64_t i) {
+    int d = delta(i, i + 1) > delta(i, i - 1) ? 1 : -1;
+
+    // Upper bound of the range, then the other end by binary search
+    int min_delta = delta(i, i - d);
+    int64_t lmax = 2;
+    while (delta(i, i + lmax * d) > min_delta) {
+      lmax *= 2;
+    }
+    int64_t l = 0;
+    for (int64_t t = lmax / 2; t >= 1; t /= 2) {
+      if (delta(i, i + (l + t) * d) > min_delta) {
+        l += t;
+      }
+    }
+    int64_t j = i + l * d;
+
+    // Split position: the last leaf sharing more than the node prefix
+    int node_delta = delta(i, j);
+    int64_t s = 0;
+    for (int64_t div = 2;; div *= 2) {
+      int64_t t = (l + div - 1) / div;
+      if (delta(i, i + (s + t) * d) > node_delta) {
+        s += t;
+      }
+      if (t <= 1) {
+        break;
+      }
+    }
+    int64_t gamma = i + s * d + std::min(d, 0);
+
+    radix_node &node = tree[i];
+    node.first = uint32_t(std::min(i, j));
+    node.last = uint32_t(std::max(i, j));
+    node.child[0] =
+        uint32_t(gamma) | (int64_t(node.first) == gamma ? LEAF : 0);
+    node.child[1] =
+        uint32_t(gamma + 1) | (int64_t(node.last) == gamma + 1 ? LEAF : 0);
+    for (int c = 0; c < 2; c++) {
+      if (node.child[c] & LEAF) {
+        leaf_parent[node.child[c] & ~LEAF] = uint32_t(i);
+      } else {
+        tree[node.child[c]].parent = uint32_t(i);
+      }
+    }
+  }
+
+  const aabb &child_bounds(uint32_t child) const {
+    return child & LEAF ? bounds[leaves[child & ~LEAF]] : tree[child].bounds;
+  }
+
+  uint32_t child_size(uint32_t child) const {
+    return child & LEAF ? 1 : tree[child].size;
+  }
+
+  // Bounds and flattened sizes, walking up from every leaf. The first
+  // child to arrive at a node stops there, the second one fits it.
+  void fit(unsigned chunks) {
+    size_t n = codes.size();
+    if (n == 1) {
+      return;
+    }
+    parallel_for(n, chunks, [&](unsigned, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        uint32_t node = leaf_parent[i];
+        while (true) {
+          radix_node &r = tree[node];
+          if (r.arrived.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            break;
+          }
+          r.bounds = child_bounds(r.child[0]);
+          r.bounds.grow(child_bounds(r.child[1]));
+          r.size = r.last - r.first + 1 <= uint32_t(options.max_leaf_size)
+                       ? 1
+                       : 1 + child_size(r.child[0]) + child_size(r.child[1]);
+          if (node == 0) {
+            break;
+          }
+          node = r.parent;
+        }
+      }
+    });
+  }
+
+  // Writes one node at index of result. Returns false for a leaf.
+  bool write_node(bvh &result, uint32_t child, uint32_t index) const {
+    bvh_node &out = result.nodes[index];
+    out = {};
+    out.set_bounds(child_bounds(child));
+    if (child & LEAF) {
+      out.offset = child & ~LEAF;
+      out.count = 1;
+      return false;
+    }
+    const radix_node &r = tree[child];
+    if (r.size == 1) {
+      out.offset = r.first;
+      out.count = uint16_t(r.last - r.first + 1);
+      return false;
+    }
+    // The highest bit in which the codes of the node differ splits it; the
+    // bits are x, y, z from the top
+    uint32_t differ = codes[r.first] ^ codes[r.last];
+    out.axis = differ ? uint16_t(2 - (31 - __builtin_clz(differ)) % 3) : 0;
+    out.offset = index + 1 + child_size(r.child[0]);
+    return true;
+  }
+
+  void flatten_subtree(bvh &result, uint32_t child, uint32_t index) const {
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{child, index}};
+    while (!stack.empty()) {
+      auto [c, i] = stack.back();
+      stack.pop_back();
+      if (write_node(result, c, i)) {
+        stack.push_back({tree[c].child[1], result.nodes[i].offset});
+        stack.push_back({tree[c].child[0], i + 1});
+      }
+    }
+  }
+
+  // Writes the top of the tree until there are a few subtrees per thread,
+  // then the subtrees in parallel
+  void flatten(bvh &result) const {
+    uint32_t root = codes.size() == 1 ? LEAF : 0;
+    result.nodes.resize(child_size(root));
+
+    std::vector<std::pair<uint32_t, uint32_t>> subtrees = {{root, 0}};
+    size_t target = threads > 1 ? 8 * size_t(threads) : 1;
+    for (size_t k = 0; k < subtrees.size() && subtrees.size() < target;) {
+      auto [c, i] = subtrees[k];
+      if (!write_node(result, c, i)) {
+        k++;
+        continue;
+      }
+      subtrees[k] = {tree[c].child[0], i + 1};
+      subtrees.push_back({tree[c].child[1], result.nodes[i].offset});
+    }
+
+    unsigned chunks = unsigned(std::min<size_t>(threads, subtrees.size()));
+    parallel_for(subtrees.size(), chunks,
+                 [&](unsigned, size_t begin, size_t end) {
+                   for (size_t k = begin; k < end; k++) {
+                     flatten_subtree(result, subtrees[k].first,
+                                     subtrees[k].second);
+                   }
+                 });
+  }
+
+  lbvh_options options;
+  unsigned threads;
+
+  std::vector<aabb> bounds;    // Per triangle
+  std::vector<uint32_t> codes; // Sorted
+  const uint32_t *leaves = nullptr; // Triangle of each leaf
+  std::vector<radix_node> tree;
+  std::vector<uint32_t> leaf_parent;
+};
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "triangle.hpp"
+#include "vec3.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Triangle soup for tests and benchmarks: n small triangles on the surfaces
+// of spheres of random size and position in [-50, 50]^3, about 1000 per
+// sphere, so that the density varies as in a real scene
+inline std::vector<triangle> random_mesh(size_t n, uint32_t seed = 1) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  auto direction = [&] {
+    float z = 2 * unit(rng) - 1;
+    float phi = 2 * float(M_PI) * unit(rng);
+    float r = std::sqrt(1 - z * z);
+    return vec3(r * std::cos(phi), r * std::sin(phi), z);
+  };
+
+  std::vector<triangle> triangles;
+  triangles.reserve(n);
+  while (triangles.size() < n) {
+    point3 center(100 * unit(rng) - 50, 100 * unit(rng) - 50,
+                  100 * unit(rng) - 50);
+    float radius = 0.5f + 9.5f * unit(rng) * unit(rng);
+    size_t count = std::min<size_t>(1000, n - triangles.size());
+
+    // Edges of about the spacing of the triangles on the sphere
+    float size = 4 * radius / std::sqrt(float(count));
+    for (size_t i = 0; i < count; i++) {
+      point3 p = center + radius * direction();
+      triangles.push_back(
+          {p, p + size * direction(), p + size * direction()});
+    }
+  }
+  return triangles;
+}
+
+// random_mesh() at time t: every 100 triangles swing back and forth along
+// their own direction, by up to 10 and with a period of 20 to 60 frames, so
+// that the pieces of the spheres scatter and pass through each other
+inline std::vector<triangle> animate_mesh(const std::vector<triangle> &mesh,
+                                          float t) {
+  std::vector<triangle> triangles = mesh;
+  for (size_t first = 0; first < triangles.size(); first += 100) {
+    std::mt19937 rng(uint32_t(first / 100));
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    vec3 direction(2 * unit(rng) - 1, 2 * unit(rng) - 1, 2 * unit(rng) - 1);
+    float period = 20 + 40 * unit(rng);
+    vec3 offset = 10 * std::sin(2 * float(M_PI) * t / period) * direction;
+    for (size_t i = first; i < std::min(first + 100, triangles.size());
+         i++) {
+      triangles[i].v0 = triangles[i].v0 + offset;
+      triangles[i].v1 = triangles[i].v1 + offset;
+      triangles[i].v2 = triangles[i].v2 + offset;
+    }
+  }
+  return triangles;
+}
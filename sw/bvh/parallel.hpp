@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Threads to use when a builder is asked for 0
+inline unsigned default_threads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Chunks [0, n) is split into by parallel_for: at most one per thread, and
+// none smaller than grain items
+inline unsigned parallel_chunks(size_t n, unsigned threads, size_t grain) {
+  size_t chunks = std::min<size_t>(threads, n / std::max<size_t>(grain, 1));
+  return unsigned(std::max<size_t>(chunks, 1));
+}
+
+// Runs fn(chunk, begin, end) on contiguous chunks of [0, n), one thread per
+// chunk. The calling thread takes chunk 0.
+template <typename F> void parallel_for(size_t n, unsigned chunks, F &&fn) {
+  std::vector<std::thread> workers;
+  for (unsigned c = 1; c < chunks; c++) {
+    workers.emplace_back(fn, c, n * c / chunks, n * (c + 1) / chunks);
+  }
+  fn(0u, size_t(0), n / chunks);
+  for (std::thread &w : workers) {
+    w.join();
+  }
+}
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Stable LSD radix sort of key-value pairs on the low `bits` bits of the
+// keys, RADIX_BITS per pass. Each pass counts digits per chunk in parallel,
+// takes the prefix sums in (digit, chunk) order, and scatters every chunk in
+// parallel to its own slots, so the order of equal keys is kept.
+
+#define RADIX_BITS 10
+
+inline void radix_sort(std::vector<uint32_t> &keys,
+                       std::vector<uint32_t> &values, int bits,
+                       unsigned threads, size_t grain = 1 << 14) {
+  constexpr uint32_t BUCKETS = 1u << RADIX_BITS;
+  size_t n = keys.size();
+  unsigned chunks = parallel_chunks(n, threads, grain);
+
+  std::vector<uint32_t> keys_tmp(n), values_tmp(n);
+  std::vector<size_t> offsets(size_t(chunks) * BUCKETS);
+  for (int shift = 0; shift < bits; shift += RADIX_BITS) {
+    parallel_for(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+      size_t *count = &offsets[size_t(c) * BUCKETS];
+      std::fill(count, count + BUCKETS, 0);
+      for (size_t i = begin; i < end; i++) {
+        count[keys[i] >> shift & (BUCKETS - 1)] += 1;
+      }
+    });
+
+    size_t sum = 0;
+    for (uint32_t d = 0; d < BUCKETS; d++) {
+      for (unsigned c = 0; c < chunks; c++) {
+        size_t count = offsets[size_t(c) * BUCKETS + d];
+        offsets[size_t(c) * BUCKETS + d] = sum;
+        sum += count;
+      }
+    }
+
+    parallel_for(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+      size_t *next = &offsets[size_t(c) * BUCKETS];
+      for (size_t i = begin; i < end; i++) {
+        size_t slot = next[keys[i] >> shift & (BUCKETS - 1)]++;
+        keys_tmp[slot] = keys[i];
+        values_tmp[slot] = values[i];
+      }
+    });
+    std::swap(keys, keys_tmp);
+    std::swap(values, values_tmp);
+  }
+}
@@ -0,0 +1,338 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "parallel.hpp"
+#include "sah_builder.hpp"
+#include "triangle.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// BVH of triangles that move but keep their number and order, as in
+// skinned or rigid animation.
+//
+// update() refits the bounds from the leaves up, in parallel: the second
+// child to arrive at a node fits it. Optionally, every small subtree then
+// tries the four rotations that swap a child with a grandchild on the other
+// side (Kopta et al., "Fast, Effective BVH Updates for Animated Scenes",
+// I3D 2012) and applies the one that shrinks that side the most. A rotated
+// subtree is written back into its own node range, so the depth-first
+// layout with implicit left children holds and nothing outside the range
+// moves.
+//
+// Refitting keeps the topology, so the tree degrades as triangles move
+// apart. update() rebuilds it with sah_builder once its SAH cost exceeds
+// rebuild_threshold times the cost right after the last build.
+//
+// Nodes whose words changed are tracked as dirty ranges, and upload()
+// writes only those into a serialise_nodes() image, e.g. the node array in
+// DDR read through rt_node_cache. The triangles move in every update, so
+// their words are always written in full with serialise_triangles().
+
+struct refit_options {
+  bool rotate = true;
+  uint32_t rotation_max_nodes = 63; // Largest subtree that is rotated
+  float rebuild_threshold = 1.5f;   // SAH growth that triggers a rebuild
+  unsigned threads = 0;             // 0 for one per core
+  size_t grain = 1 << 12;           // Smallest chunk of work for a thread
+  sah_options build;                // For the initial build and rebuilds
+};
+
+class dynamic_bvh {
+public:
+  explicit dynamic_bvh(const std::vector<triangle> &triangles,
+                       refit_options options = {})
+      : options(options), threads(options.threads ? options.threads
+                                                  : default_threads()) {
+    rebuild(triangles);
+  }
+
+  const bvh &tree() const { return b; }
+
+  // SAH cost now, against right after the last build
+  float degradation() const { return b.sah_cost() / built_cost; }
+
+  size_t rebuilds() const { return rebuild_count; }
+  size_t rotations() const { return rotation_count; }
+
+  // Follows the new positions of the triangles. Returns true if the tree
+  // was rebuilt.
+  bool update(const std::vector<triangle> &triangles) {
+    refit(triangles);
+    if (options.rotate) {
+      rotate();
+    }
+    if (b.sah_cost() > options.rebuild_threshold * built_cost) {
+      rebuild(triangles);
+      return true;
+    }
+    return false;
+  }
+
+  // Node ranges [first, end) changed since the last upload
+  std::vector<std::pair<uint32_t, uint32_t>> dirty_ranges() const {
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    for (uint32_t i = 0; i < dirty.size(); i++) {
+      if (!dirty[i]) {
+        continue;
+      }
+      if (!ranges.empty() && ranges.back().second == i) {
+        ranges.back().second = i + 1;
+      } else {
+        ranges.push_back({i, i + 1});
+      }
+    }
+    return ranges;
+  }
+
+  // Brings a serialise_nodes() image up to date, writing only the dirty
+  // nodes unless the size changed. Returns the words written.
+  size_t upload(std::vector<uint32_t> &image) {
+    size_t words = 0;
+    if (image.size() != b.nodes.size() * BVH_NODE_WORDS) {
+      image = b.serialise_nodes();
+      words = image.size();
+    } else {
+      for (auto [first, end] : dirty_ranges()) {
+        for (uint32_t i = first; i < end; i++) {
+          serialise_node(b.nodes[i], &image[size_t(i) * BVH_NODE_WORDS]);
+        }
+        words += size_t(end - first) * BVH_NODE_WORDS;
+      }
+    }
+    std::fill(dirty.begin(), dirty.end(), 0);
+    return words;
+  }
+
+private:
+  void rebuild(const std::vector<triangle> &triangles) {
+    sah_options build = options.build;
+    build.threads = threads;
+    b = sah_builder(build).build(triangles);
+    built_cost = std::max(b.sah_cost(), 1e-30f);
+    rebuild_count += 1;
+
+    size_t n = b.nodes.size();
+    parent.assign(n, 0);
+    size.assign(n, 1);
+    dirty.assign(n, 1);
+    arrived = std::make_unique<std::atomic<uint32_t>[]>(n);
+    link(0, uint32_t(n));
+    find_leaves();
+  }
+
+  // Parents and subtree sizes of the nodes in [first, end), which must be
+  // a whole subtree
+  void link(uint32_t first, uint32_t end) {
+    for (uint32_t i = end; i-- > first;) {
+      const bvh_node &n = b.nodes[i];
+      if (!n.leaf()) {
+        parent[i + 1] = i;
+        parent[n.offset] = i;
+        size[i] = 1 + size[i + 1] + size[n.offset];
+      } else {
+        size[i] = 1;
+      }
+    }
+  }
+
+  void find_leaves() {
+    leaves.clear();
+    for (uint32_t i = 0; i < b.nodes.size(); i++) {
+      if (b.nodes[i].leaf()) {
+        leaves.push_back(i);
+      }
+    }
+  }
+
+  void set_bounds(uint32_t i, const aabb &bounds) {
+    bvh_node &n = b.nodes[i];
+    bvh_node old = n;
+    n.set_bounds(bounds);
+    if (std::memcmp(old.min, n.min, sizeof(n.min)) != 0 ||
+        std::memcmp(old.max, n.max, sizeof(n.max)) != 0) {
+      dirty[i] = 1;
+    }
+  }
+
+  aabb children_bounds(uint32_t i) const {
+    aabb bounds = b.nodes[i + 1].bounds();
+    bounds.grow(b.nodes[b.nodes[i].offset].bounds());
+    return bounds;
+  }
+
+  void refit(const std::vector<triangle> &triangles) {
+    size_t n = b.nodes.size();
+    for (size_t i = 0; i < n; i++) {
+      arrived[i].store(0, std::memory_order_relaxed);
+    }
+
+    unsigned chunks = parallel_chunks(leaves.size(), threads, options.grain);
+    parallel_for(leaves.size(), chunks,
+                 [&](unsigned, size_t begin, size_t end) {
+                   for (size_t k = begin; k < end; k++) {
+                     uint32_t i = leaves[k];
+                     const bvh_node &leaf = b.nodes[i];
+                     aabb bounds;
+                     for (uint32_t t = leaf.offset;
+                          t < leaf.offset + leaf.count; t++) {
+                       bounds.grow(triangles[b.indices[t]].bounds());
+                     }
+                     set_bounds(i, bounds);
+
+                     // The second child to arrive fits the parent
+                     while (i != 0) {
+                       i = parent[i];
+                       if (arrived[i].fetch_add(
+                               1, std::memory_order_acq_rel) == 0) {
+                         break;
+                       }
+                       set_bounds(i, children_bounds(i));
+                     }
+                   }
+                 });
+  }
+
+  // Subtree of the rotated node: an existing subtree, or a new node over
+  // two existing subtrees
+  struct part {
+    uint32_t a;
+    uint32_t b = UINT32_MAX; // Second child of a new node
+  };
+
+  // Largest axis between the centroids of two boxes, for the near-first
+  // order of the traversal
+  static uint16_t split_axis(const aabb &l, const aabb &r) {
+    vec3 d = r.centroid() - l.centroid();
+    int axis = 0;
+    for (int a = 1; a < 3; a++) {
+      if (std::fabs(d.e[a]) > std::fabs(d.e[axis])) {
+        axis = a;
+      }
+    }
+    return uint16_t(axis);
+  }
+
+  // Copies subtree src of old to dst, moving its child links with it
+  uint32_t write_subtree(const std::vector<bvh_node> &old, uint32_t base,
+                         uint32_t src, uint32_t dst) {
+    uint32_t count = size[src];
+    for (uint32_t k = 0; k < count; k++) {
+      bvh_node n = old[src - base + k];
+      if (!n.leaf()) {
+        n.offset = n.offset - src + dst;
+      }
+      b.nodes[dst + k] = n;
+    }
+    return count;
+  }
+
+  // Writes node i as (left, right), with the subtrees in the old copy of
+  // the range from base
+  void write_rotated(uint32_t i, const std::vector<bvh_node> &old,
+                     uint32_t base, part left, part right) {
+    uint32_t at = i + 1;
+    aabb bounds[2];
+    const part parts[2] = {left, right};
+    for (int side = 0; side < 2; side++) {
+      const part &p = parts[side];
+      if (side == 1) {
+        b.nodes[i].offset = at;
+      }
+      if (p.b == UINT32_MAX) {
+        bounds[side] = old[p.a - base].bounds();
+        at += write_subtree(old, base, p.a, at);
+        continue;
+      }
+      uint32_t z = at++;
+      uint32_t left_size = write_subtree(old, base, p.a, at);
+      at += left_size;
+      uint32_t right_at = at;
+      at += write_subtree(old, base, p.b, at);
+
+      bvh_node &n = b.nodes[z];
+      n = {};
+      aabb zl = old[p.a - base].bounds(), zr = old[p.b - base].bounds();
+      bounds[side] = zl;
+      bounds[side].grow(zr);
+      n.set_bounds(bounds[side]);
+      n.offset = right_at;
+      n.axis = split_axis(zl, zr);
+    }
+    b.nodes[i].axis = split_axis(bounds[0], bounds[1]);
+  }
+
+  // Applies the best rotation of every small subtree, children first
+  void rotate() {
+    std::vector<bvh_node> old;
+    for (uint32_t i = uint32_t(b.nodes.size()); i-- > 0;) {
+      const bvh_node &n = b.nodes[i];
+      if (n.leaf() || size[i] > options.rotation_max_nodes) {
+        continue;
+      }
+      uint32_t l = i + 1, r = n.offset;
+
+      // Swapping child c of one side with the other side shrinks the first
+      // side to the union of the other side and the sibling of c
+      float best = 0;
+      part best_parts[2];
+      for (int side = 0; side < 2; side++) {
+        uint32_t inner = side ? r : l; // The side that changes
+        uint32_t other = side ? l : r;
+        if (b.nodes[inner].leaf()) {
+          continue;
+        }
+        uint32_t grandchildren[2] = {inner + 1, b.nodes[inner].offset};
+        float area = b.nodes[inner].bounds().surface_area();
+        for (int g = 0; g < 2; g++) {
+          aabb merged = b.nodes[other].bounds();
+          merged.grow(b.nodes[grandchildren[1 - g]].bounds());
+          float gain = area - merged.surface_area();
+          if (gain > best) {
+            // The grandchild takes the place of other, which takes its
+            // place under inner
+            best = gain;
+            best_parts[1 - side] = {grandchildren[g]};
+            best_parts[side] = {g ? grandchildren[0] : other,
+                                g ? other : grandchildren[1]};
+          }
+        }
+      }
+      if (best <= 0) {
+        continue;
+      }
+
+      uint32_t end = i + size[i];
+      old.assign(b.nodes.begin() + i, b.nodes.begin() + end);
+      write_rotated(i, old, i, best_parts[0], best_parts[1]);
+      std::fill(dirty.begin() + i, dirty.begin() + end, 1);
+      link(i, end);
+      rotation_count += 1;
+    }
+    find_leaves();
+  }
+
+  refit_options options;
+  unsigned threads;
+
+  bvh b;
+  float built_cost = 1;
+  size_t rebuild_count = 0;
+  size_t rotation_count = 0;
+
+  std::vector<uint32_t> parent;
+  std::vector<uint32_t> size; // Nodes in the subtree
+  std::vector<uint32_t> leaves;
+  std::vector<uint8_t> dirty;
+  std::unique_ptr<std::atomic<uint32_t>[]> arrived;
+};
@@ -0,0 +1,340 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "aabb.hpp"
+#include "bvh.hpp"
+#include "parallel.hpp"
+#include "triangle.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Top-down BVH build with the binned surface area heuristic.
+//
+// Each node bins the centroids of its triangles into `bins` equal slots per
+// axis and takes the split between two slots with the lowest SAH cost, or
+// makes a leaf if that is cheaper. Two kinds of parallelism are used: large
+// nodes near the root bin their triangles in chunks on all threads, and
+// below them, subtrees are built on separate threads while threads are
+// free. The build goes into a temporary tree first and is then flattened in
+// depth-first order, so the result does not depend on the thread count.
+
+struct sah_options {
+  int bins = 16;
+  int max_leaf_size = 8; // Larger leaves are always split
+  sah_costs costs;
+  unsigned threads = 0; // 0 for one per core
+
+  // Nodes with at least this many triangles bin them in parallel
+  size_t parallel_bin_grain = 1 << 16;
+  // Subtrees with at least this many triangles may go to another thread
+  size_t parallel_subtree_grain = 1 << 12;
+};
+
+class sah_builder {
+public:
+  explicit sah_builder(sah_options options = {})
+      : options(options), threads(options.threads ? options.threads
+                                                  : default_threads()) {}
+
+  bvh build(const std::vector<triangle> &triangles) {
+    size_t n = triangles.size();
+    bvh result;
+    if (n == 0) {
+      return result;
+    }
+
+    bounds.resize(n);
+    centroids.resize(n);
+    result.indices.resize(n);
+    indices = result.indices.data();
+
+    // Triangle bounds, and the bounds of the root
+    unsigned chunks = parallel_chunks(n, threads, options.parallel_bin_grain);
+    std::vector<aabb> root_bounds(chunks), root_centroids(chunks);
+    parallel_for(n, chunks, [&](unsigned c, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        bounds[i] = triangles[i].bounds();
+        centroids[i] = bounds[i].centroid();
+        indices[i] = uint32_t(i);
+        root_bounds[c].grow(bounds[i]);
+        root_centroids[c].grow(centroids[i]);
+      }
+    });
+    for (unsigned c = 1; c < chunks; c++) {
+      root_bounds[0].grow(root_bounds[c]);
+      root_centroids[0].grow(root_centroids[c]);
+    }
+
+    tree.resize(2 * n - 1);
+    next_node = 1;
+    spare_threads = int(threads) - 1;
+    subdivide(0, 0, uint32_t(n), root_bounds[0], root_centroids[0], 1);
+
+    flatten(result);
+    tree.clear();
+    bounds.clear();
+    centroids.clear();
+    return result;
+  }
+
+private:
+  // Node of the temporary tree; children are allocated concurrently
+  struct build_node {
+    aabb bounds;
+    uint32_t first;
+    uint32_t count; // 0 for interior nodes
+    uint32_t child[2];
+    uint16_t axis;
+  };
+
+  struct bin {
+    aabb bounds;
+    aabb centroids;
+    uint32_t count = 0;
+  };
+
+  struct split {
+    int axis = -1;
+    int bin = 0; // Triangles in bins [0, bin] go left
+    float cost = INFINITY;
+    aabb bounds[2];
+    aabb centroids[2];
+  };
+
+  int bin_of(const vec3 &c, int axis, const aabb &centroid_bounds,
+             float scale) const {
+    int b = int((c.e[axis] - centroid_bounds.min.e[axis]) * scale);
+    return std::clamp(b, 0, options.bins - 1);
+  }
+
+  void bin_range(uint32_t first, uint32_t count, const aabb &cb,
+                 const float scale[3], bin *out) const {
+    for (uint32_t i = first; i < first + count; i++) {
+      uint32_t t = indices[i];
+      for (int a = 0; a < 3; a++) {
+        bin &b = out[a * options.bins + bin_of(centroids[t], a, cb, scale[a])];
+        b.bounds.grow(bounds[t]);
+        b.centroids.grow(centroids[t]);
+        b.count += 1;
+      }
+    }
+  }
+
+  split find_split(uint32_t first, uint32_t count, const aabb &node_bounds,
+                   const aabb &cb) const {
+    int nb = options.bins;
+    float scale[3];
+    for (int a = 0; a < 3; a++) {
+      float extent = cb.max.e[a] - cb.min.e[a];
+      scale[a] = extent > 0 ? nb / extent : 0;
+    }
+
+    std::vector<bin> bins(3 * nb);
+    unsigned chunks =
+        parallel_chunks(count, threads, options.parallel_bin_grain);
+    if (chunks > 1) {
+      std::vector<std::vector<bin>> partial(chunks, std::vector<bin>(3 * nb));
+      parallel_for(count, chunks, [&](unsigned c, size_t begin, size_t end) {
+        bin_range(first + uint32_t(begin), uint32_t(end - begin), cb, scale,
+                  partial[c].data());
+      });
+      for (unsigned c = 0; c < chunks; c++) {
+        for (int i = 0; i < 3 * nb; i++) {
+          bins[i].bounds.grow(partial[c][i].bounds);
+          bins[i].centroids.grow(partial[c][i].centroids);
+          bins[i].count += partial[c][i].count;
+        }
+      }
+    } else {
+      bin_range(first, count, cb, scale, bins.data());
+    }
+
+    // Sweep from the right, then from the left
+    split best;
+    float inv_area = 1.0f / node_bounds.surface_area();
+    std::vector<float> right_area(nb);
+    std::vector<uint32_t> right_count(nb);
+    for (int a = 0; a < 3; a++) {
+      if (scale[a] == 0) {
+        continue;
+      }
+      const bin *b = &bins[a * nb];
+      aabb acc;
+      uint32_t n = 0;
+      for (int i = nb - 1; i > 0; i--) {
+        acc.grow(b[i].bounds);
+        n += b[i].count;
+        right_area[i] = acc.surface_area();
+        right_count[i] = n;
+      }
+      acc = aabb();
+      n = 0;
+      for (int i = 0; i < nb - 1; i++) {
+        acc.grow(b[i].bounds);
+        n += b[i].count;
+        if (n == 0 || right_count[i + 1] == 0) {
+          continue;
+        }
+        float cost = options.costs.traversal +
+                     options.costs.intersection * inv_area *
+                         (acc.surface_area() * n +
+                          right_area[i + 1] * right_count[i + 1]);
+        if (cost < best.cost) {
+          best.axis = a;
+          best.bin = i;
+          best.cost = cost;
+        }
+      }
+    }
+
+    if (best.axis >= 0) {
+      const bin *b = &bins[best.axis * nb];
+      for (int i = 0; i < nb; i++) {
+        int side = i > best.bin;
+        best.bounds[side].grow(b[i].bounds);
+        best.centroids[side].grow(b[i].centroids);
+      }
+    }
+    return best;
+  }
+
+  // Bounds of the triangles in a range
+  void range_bounds(uint32_t first, uint32_t count, aabb &b,
+                    aabb &cb) const {
+    for (uint32_t i = first; i < first + count; i++) {
+      b.grow(bounds[indices[i]]);
+      cb.grow(centroids[indices[i]]);
+    }
+  }
+
+  void subdivide(uint32_t node, uint32_t first, uint32_t count,
+                 const aabb &node_bounds, const aabb &cb, int depth) {
+    build_node &n = tree[node];
+    n.bounds = node_bounds;
+    n.first = first;
+    n.count = count;
+
+    if (count == 1) {
+      return;
+    }
+
+    // Deep trees come from degenerate inputs; halve them by count so that
+    // the traversal stack holds
+    split s;
+    if (depth < BVH_MAX_DEPTH - 32) {
+      s = find_split(first, count, node_bounds, cb);
+    }
+
+    uint32_t left_count;
+    if (s.axis >= 0 &&
+        (count > uint32_t(options.max_leaf_size) ||
+         s.cost < options.costs.intersection * count)) {
+      float scale = options.bins / (cb.max.e[s.axis] - cb.min.e[s.axis]);
+      uint32_t *mid = std::partition(
+          indices + first, indices + first + count, [&](uint32_t t) {
+            return bin_of(centroids[t], s.axis, cb, scale) <= s.bin;
+          });
+      left_count = uint32_t(mid - (indices + first));
+    } else if (count > uint32_t(options.max_leaf_size)) {
+      // All centroids in one spot, or too deep: split by count along the
+      // longest axis
+      vec3 e = cb.extent();
+      s.axis = e.e[0] > e.e[1] ? (e.e[0] > e.e[2] ? 0 : 2)
+                               : (e.e[1] > e.e[2] ? 1 : 2);
+      left_count = count / 2;
+      std::nth_element(indices + first, indices + first + left_count,
+                       indices + first + count, [&](uint32_t a, uint32_t b) {
+                         return centroids[a].e[s.axis] <
+                                centroids[b].e[s.axis];
+                       });
+      for (int side = 0; side < 2; side++) {
+        s.bounds[side] = aabb();
+        s.centroids[side] = aabb();
+      }
+      range_bounds(first, left_count, s.bounds[0], s.centroids[0]);
+      range_bounds(first + left_count, count - left_count, s.bounds[1],
+                   s.centroids[1]);
+    } else {
+      return; // Leaf
+    }
+
+    uint32_t child = next_node.fetch_add(2);
+    n.count = 0;
+    n.axis = uint16_t(s.axis);
+    n.child[0] = child;
+    n.child[1] = child + 1;
+
+    uint32_t right_count = count - left_count;
+    auto right = [&] {
+      subdivide(child + 1, first + left_count, right_count, s.bounds[1],
+                s.centroids[1], depth + 1);
+    };
+
+    // Hand the right subtree to another thread if one is free
+    std::thread worker;
+    if (right_count >= options.parallel_subtree_grain &&
+        left_count >= options.parallel_subtree_grain) {
+      if (spare_threads.fetch_sub(1) > 0) {
+        worker = std::thread(right);
+      } else {
+        spare_threads.fetch_add(1);
+      }
+    }
+    subdivide(child, first, left_count, s.bounds[0], s.centroids[0],
+              depth + 1);
+    if (worker.joinable()) {
+      worker.join();
+      spare_threads.fetch_add(1);
+    } else {
+      right();
+    }
+  }
+
+  // Depth-first copy of the temporary tree, the left child next to its
+  // parent
+  void flatten(bvh &result) const {
+    result.nodes.clear();
+    result.nodes.reserve(next_node);
+
+    // Temporary node, and the node whose right child it is
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, UINT32_MAX}};
+    while (!stack.empty()) {
+      auto [b, parent] = stack.back();
+      stack.pop_back();
+      uint32_t index = uint32_t(result.nodes.size());
+      if (parent != UINT32_MAX) {
+        result.nodes[parent].offset = index;
+      }
+
+      const build_node &bn = tree[b];
+      bvh_node n = {};
+      n.set_bounds(bn.bounds);
+      if (bn.count) {
+        n.offset = bn.first;
+        n.count = uint16_t(bn.count);
+      } else {
+        n.axis = bn.axis;
+        stack.push_back({bn.child[1], index});
+        stack.push_back({bn.child[0], UINT32_MAX});
+      }
+      result.nodes.push_back(n);
+    }
+  }
+
+  sah_options options;
+  unsigned threads;
+
+  std::vector<aabb> bounds;   // Per triangle
+  std::vector<vec3> centroids; // Per triangle
+  uint32_t *indices = nullptr;
+
+  std::vector<build_node> tree;
+  std::atomic<uint32_t> next_node;
+  std::atomic<int> spare_threads;
+};
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Checks shared by the tests of the BVH builders
+
+#pragma once
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bvh.hpp"
+
+// Structure of a flattened BVH: implicit left children, bounds that contain
+// the children and triangles, and every triangle in exactly one leaf
+inline void expect_valid(const bvh &b,
+                         const std::vector<triangle> &triangles,
+                         int max_leaf_size) {
+  ASSERT_FALSE(b.nodes.empty());
+  ASSERT_EQ(b.indices.size(), triangles.size());
+  EXPECT_LT(b.depth(), BVH_MAX_DEPTH);
+
+  std::vector<int> seen(triangles.size(), 0);
+  std::vector<int> parents(b.nodes.size(), 0);
+  parents[0] = 1;
+  for (uint32_t i = 0; i < b.nodes.size(); i++) {
+    const bvh_node &n = b.nodes[i];
+    aabb bounds = n.bounds();
+    if (n.leaf()) {
+      EXPECT_LE(n.count, max_leaf_size);
+      ASSERT_LE(n.offset + n.count, b.indices.size());
+      for (uint32_t k = n.offset; k < n.offset + n.count; k++) {
+        seen[b.indices[k]] += 1;
+        EXPECT_TRUE(bounds.contains(triangles[b.indices[k]].bounds()));
+      }
+      continue;
+    }
+    ASSERT_LT(n.axis, 3);
+    ASSERT_GT(n.offset, i + 1);
+    ASSERT_LT(n.offset, b.nodes.size());
+    parents[i + 1] += 1;
+    parents[n.offset] += 1;
+    EXPECT_TRUE(bounds.contains(b.nodes[i + 1].bounds()));
+    EXPECT_TRUE(bounds.contains(b.nodes[n.offset].bounds()));
+  }
+  for (size_t i = 0; i < seen.size(); i++) {
+    ASSERT_EQ(seen[i], 1) << "triangle " << i;
+  }
+  for (size_t i = 0; i < parents.size(); i++) {
+    ASSERT_EQ(parents[i], 1) << "node " << i;
+  }
+}
+
+// Nearest hit by testing every triangle
+inline bool brute_force(const std::vector<triangle> &triangles,
+                        const ray &r, bvh_hit &result) {
+  bool found = false;
+  interval ray_t(0.001f, INFINITY);
+  for (uint32_t i = 0; i < triangles.size(); i++) {
+    float t;
+    if (triangles[i].hit(r, ray_t, t)) {
+      ray_t.max = t;
+      result = {t, i};
+      found = true;
+    }
+  }
+  return found;
+}
+
+// Rays from around the scene towards random triangles, so that most hit
+inline std::vector<ray> random_rays(const std::vector<triangle> &triangles,
+                                    int count) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> coord(-80, 80);
+  std::vector<ray> rays;
+  for (int i = 0; i < count; i++) {
+    const triangle &t = triangles[rng() % triangles.size()];
+    point3 origin(coord(rng), coord(rng), coord(rng));
+    rays.emplace_back(origin, t.centroid() - origin);
+  }
+  return rays;
+}
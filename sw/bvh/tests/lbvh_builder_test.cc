@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "bvh.hpp"
+#include "bvh_checks.hpp"
+#include "lbvh_builder.hpp"
+#include "mesh.hpp"
+#include "radix_sort.hpp"
+#include "sah_builder.hpp"
+
+namespace {
+
+#pragma mark - Unit Test
+
+class LbvhBuilderTest : public testing::Test {};
+
+TEST_F(LbvhBuilderTest, MortonCode) {
+  EXPECT_EQ(morton_expand(0x3ff), 0x09249249u);
+  EXPECT_EQ(morton_code(vec3(0, 0, 0)), 0u);
+  EXPECT_EQ(morton_code(vec3(1, 1, 1)), 0x3fffffffu);
+  // x is the most significant of each triple
+  EXPECT_EQ(morton_code(vec3(0.5f, 0, 0)), 1u << 29);
+  EXPECT_EQ(morton_code(vec3(0, 0.5f, 0)), 1u << 28);
+  EXPECT_EQ(morton_code(vec3(0, 0, 0.5f)), 1u << 27);
+}
+
+// Equal keys keep their order, on any number of threads
+TEST_F(LbvhBuilderTest, RadixSortIsStable) {
+  std::mt19937 rng(3);
+  std::vector<uint32_t> keys(100000);
+  for (uint32_t &k : keys) {
+    k = rng() & 0x3fff0fff; // Many duplicates
+  }
+
+  std::vector<uint32_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::vector<uint32_t> expected = order;
+  std::stable_sort(expected.begin(), expected.end(),
+                   [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+  for (unsigned threads : {1, 3, 8}) {
+    std::vector<uint32_t> k = keys, v = order;
+    radix_sort(k, v, 30, threads, 1000);
+    EXPECT_EQ(v, expected) << threads << " threads";
+    EXPECT_TRUE(std::is_sorted(k.begin(), k.end()));
+  }
+}
+
+TEST_F(LbvhBuilderTest, Structure) {
+  std::vector<triangle> triangles = random_mesh(20000);
+  lbvh_options options;
+  bvh b = lbvh_builder(options).build(triangles);
+  expect_valid(b, triangles, options.max_leaf_size);
+
+  float sah = sah_builder().build(triangles).sah_cost();
+  std::printf("20k triangles: %zu nodes, depth %d, SAH cost %.2f (binned SAH "
+              "%.2f)\n",
+              b.nodes.size(), b.depth(), b.sah_cost(), sah);
+  EXPECT_LT(b.sah_cost(), 2 * sah);
+}
+
+TEST_F(LbvhBuilderTest, HitsMatchBruteForce) {
+  std::vector<triangle> triangles = random_mesh(5000, 3);
+  bvh b = lbvh_builder().build(triangles);
+
+  for (const ray &r : random_rays(triangles, 500)) {
+    bvh_hit expected, actual;
+    bool found = brute_force(triangles, r, expected);
+    ASSERT_EQ(b.hit(triangles, r, interval(0.001f, INFINITY), actual), found);
+    if (found) {
+      EXPECT_EQ(actual.t, expected.t);
+    }
+  }
+}
+
+TEST_F(LbvhBuilderTest, SameTreeOnAnyThreadCount) {
+  std::vector<triangle> triangles = random_mesh(30000, 5);
+
+  lbvh_options options;
+  options.threads = 1;
+  bvh serial = lbvh_builder(options).build(triangles);
+
+  options.threads = 5;
+  options.grain = 100;
+  bvh parallel = lbvh_builder(options).build(triangles);
+
+  ASSERT_EQ(serial.nodes.size(), parallel.nodes.size());
+  EXPECT_EQ(std::memcmp(serial.nodes.data(), parallel.nodes.data(),
+                        serial.nodes.size() * sizeof(bvh_node)),
+            0);
+  EXPECT_EQ(serial.indices, parallel.indices);
+}
+
+// Equal Morton codes are split by triangle order
+TEST_F(LbvhBuilderTest, Degenerate) {
+  triangle t = {point3(0, 0, -1), point3(1, 0, -1), point3(0, 1, -1)};
+  std::vector<triangle> triangles(1000, t);
+  lbvh_options options;
+  bvh b = lbvh_builder(options).build(triangles);
+  expect_valid(b, triangles, options.max_leaf_size);
+
+  EXPECT_TRUE(lbvh_builder().build({}).nodes.empty());
+  for (size_t n = 1; n < 12; n++) {
+    std::vector<triangle> few = random_mesh(n);
+    expect_valid(lbvh_builder().build(few), few, options.max_leaf_size);
+  }
+}
+
+} // namespace
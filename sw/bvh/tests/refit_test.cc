@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bvh.hpp"
+#include "bvh_checks.hpp"
+#include "mesh.hpp"
+#include "refit.hpp"
+
+namespace {
+
+#pragma mark - Unit Test
+
+class RefitTest : public testing::Test {};
+
+TEST_F(RefitTest, FollowsTriangles) {
+  std::vector<triangle> mesh = random_mesh(10000, 3);
+  refit_options options;
+  options.rebuild_threshold = INFINITY;
+  dynamic_bvh d(mesh, options);
+
+  std::vector<triangle> triangles;
+  for (int frame = 1; frame <= 10; frame++) {
+    triangles = animate_mesh(mesh, float(frame));
+    EXPECT_FALSE(d.update(triangles));
+    expect_valid(d.tree(), triangles, options.build.max_leaf_size);
+  }
+  EXPECT_EQ(d.rebuilds(), 1u);
+  EXPECT_GT(d.degradation(), 1);
+
+  for (const ray &r : random_rays(triangles, 500)) {
+    bvh_hit expected, actual;
+    bool found = brute_force(triangles, r, expected);
+    ASSERT_EQ(
+        d.tree().hit(triangles, r, interval(0.001f, INFINITY), actual),
+        found);
+    if (found) {
+      EXPECT_EQ(actual.t, expected.t);
+    }
+  }
+}
+
+TEST_F(RefitTest, RotationsSlowDegradation) {
+  std::vector<triangle> mesh = random_mesh(20000, 5);
+  refit_options options;
+  options.rebuild_threshold = INFINITY;
+  options.rotate = false;
+  dynamic_bvh refit(mesh, options);
+  options.rotate = true;
+  dynamic_bvh rotated(mesh, options);
+
+  for (int frame = 1; frame <= 20; frame++) {
+    std::vector<triangle> triangles = animate_mesh(mesh, float(frame));
+    refit.update(triangles);
+    rotated.update(triangles);
+    expect_valid(rotated.tree(), triangles, options.build.max_leaf_size);
+  }
+  std::printf("after 20 frames: SAH cost x%.2f refitted, x%.2f with %zu "
+              "rotations\n",
+              refit.degradation(), rotated.degradation(),
+              rotated.rotations());
+  EXPECT_GT(rotated.rotations(), 0u);
+  EXPECT_LE(rotated.degradation(), refit.degradation());
+}
+
+// Only the moved object and its ancestors are uploaded again
+TEST_F(RefitTest, UploadsDirtyNodes) {
+  std::vector<triangle> triangles = random_mesh(20000, 7);
+  // Rotations would also touch nodes that did not move
+  refit_options options;
+  options.rotate = false;
+  dynamic_bvh d(triangles, options);
+
+  std::vector<uint32_t> image;
+  EXPECT_EQ(d.upload(image), d.tree().nodes.size() * BVH_NODE_WORDS);
+  EXPECT_TRUE(d.dirty_ranges().empty());
+
+  // Nothing moved
+  d.update(triangles);
+  EXPECT_TRUE(d.dirty_ranges().empty());
+  EXPECT_EQ(d.upload(image), 0u);
+
+  for (size_t i = 0; i < 1000; i++) {
+    triangles[i].v0 = triangles[i].v0 + vec3(0.5f, 0, 0);
+    triangles[i].v1 = triangles[i].v1 + vec3(0.5f, 0, 0);
+    triangles[i].v2 = triangles[i].v2 + vec3(0.5f, 0, 0);
+  }
+  EXPECT_FALSE(d.update(triangles));
+  EXPECT_FALSE(d.dirty_ranges().empty());
+  size_t words = d.upload(image);
+  std::printf("moving 1 of 20 objects uploads %zu of %zu node words\n",
+              words, image.size());
+  EXPECT_GT(words, 0u);
+  EXPECT_LT(words, image.size() / 4);
+  EXPECT_EQ(image, d.tree().serialise_nodes());
+}
+
+TEST_F(RefitTest, RebuildsPastThreshold) {
+  std::vector<triangle> mesh = random_mesh(10000, 9);
+  refit_options options;
+  options.rebuild_threshold = 1.2f;
+  dynamic_bvh d(mesh, options);
+
+  std::vector<uint32_t> image;
+  d.upload(image);
+  int frame = 1;
+  while (!d.update(animate_mesh(mesh, float(frame)))) {
+    EXPECT_LE(d.degradation(), options.rebuild_threshold);
+    ASSERT_LT(frame++, 100);
+  }
+  EXPECT_EQ(d.rebuilds(), 2u);
+  EXPECT_FLOAT_EQ(d.degradation(), 1);
+  expect_valid(d.tree(), animate_mesh(mesh, float(frame)),
+               options.build.max_leaf_size);
+
+  // The new tree is uploaded in full
+  d.upload(image);
+  EXPECT_EQ(image, d.tree().serialise_nodes());
+}
+
+TEST_F(RefitTest, SameTreeOnAnyThreadCount) {
+  std::vector<triangle> mesh = random_mesh(20000, 11);
+  refit_options options;
+  options.rebuild_threshold = INFINITY;
+  options.threads = 1;
+  dynamic_bvh serial(mesh, options);
+  options.threads = 5;
+  options.grain = 100;
+  dynamic_bvh parallel(mesh, options);
+
+  for (int frame = 1; frame <= 5; frame++) {
+    std::vector<triangle> triangles = animate_mesh(mesh, float(frame));
+    serial.update(triangles);
+    parallel.update(triangles);
+  }
+  const bvh &a = serial.tree(), &b = parallel.tree();
+  ASSERT_EQ(a.nodes.size(), b.nodes.size());
+  EXPECT_EQ(std::memcmp(a.nodes.data(), b.nodes.data(),
+                        a.nodes.size() * sizeof(bvh_node)),
+            0);
+}
+
+} // namespace
@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bvh.hpp"
+#include "bvh_checks.hpp"
+#include "mesh.hpp"
+#include "sah_builder.hpp"
+
+namespace {
+
+#pragma mark - Unit Test
+
+class SahBuilderTest : public testing::Test {};
+
+TEST_F(SahBuilderTest, Structure) {
+  std::vector<triangle> triangles = random_mesh(20000);
+  sah_options options;
+  bvh b = sah_builder(options).build(triangles);
+  expect_valid(b, triangles, options.max_leaf_size);
+
+  // A leaf holding everything costs one intersection per triangle
+  EXPECT_LT(b.sah_cost(), 0.01f * triangles.size());
+  std::printf("20k triangles: %zu nodes, depth %d, SAH cost %.2f, %.1f "
+              "bytes/triangle\n",
+              b.nodes.size(), b.depth(), b.sah_cost(),
+              double(b.memory()) / triangles.size());
+}
+
+TEST_F(SahBuilderTest, HitsMatchBruteForce) {
+  std::vector<triangle> triangles = random_mesh(5000, 3);
+  bvh b = sah_builder().build(triangles);
+
+  int hits = 0;
+  for (const ray &r : random_rays(triangles, 500)) {
+    bvh_hit expected, actual;
+    bool found = brute_force(triangles, r, expected);
+    ASSERT_EQ(b.hit(triangles, r, interval(0.001f, INFINITY), actual), found);
+    if (found) {
+      EXPECT_EQ(actual.t, expected.t);
+      hits += 1;
+    }
+  }
+  EXPECT_GT(hits, 400);
+}
+
+// Subtrees and binning go to other threads, but the tree is the same
+TEST_F(SahBuilderTest, SameTreeOnAnyThreadCount) {
+  std::vector<triangle> triangles = random_mesh(30000, 5);
+
+  sah_options options;
+  options.threads = 1;
+  bvh serial = sah_builder(options).build(triangles);
+
+  options.threads = 4;
+  options.parallel_bin_grain = 1000;
+  options.parallel_subtree_grain = 100;
+  bvh parallel = sah_builder(options).build(triangles);
+
+  ASSERT_EQ(serial.nodes.size(), parallel.nodes.size());
+  EXPECT_EQ(std::memcmp(serial.nodes.data(), parallel.nodes.data(),
+                        serial.nodes.size() * sizeof(bvh_node)),
+            0);
+  EXPECT_EQ(serial.indices, parallel.indices);
+}
+
+// Identical triangles cannot be split by their centroids
+TEST_F(SahBuilderTest, Degenerate) {
+  triangle t = {point3(0, 0, -1), point3(1, 0, -1), point3(0, 1, -1)};
+  std::vector<triangle> triangles(1000, t);
+  sah_options options;
+  bvh b = sah_builder(options).build(triangles);
+  expect_valid(b, triangles, options.max_leaf_size);
+
+  bvh_hit hit;
+  ray r(point3(0.2f, 0.2f, 0), vec3(0, 0, -1));
+  ASSERT_TRUE(b.hit(triangles, r, interval(0.001f, INFINITY), hit));
+  EXPECT_FLOAT_EQ(hit.t, 1.0f);
+
+  EXPECT_TRUE(sah_builder().build({}).nodes.empty());
+  bvh single = sah_builder().build({t});
+  ASSERT_EQ(single.nodes.size(), 1u);
+  EXPECT_EQ(single.nodes[0].count, 1);
+}
+
+// The 16.16 words of a node contain its float bounds, and the triangles are
+// written in leaf order
+TEST_F(SahBuilderTest, Serialise) {
+  std::vector<triangle> triangles = random_mesh(2000, 9);
+  bvh b = sah_builder().build(triangles);
+
+  std::vector<uint32_t> nodes = b.serialise_nodes();
+  ASSERT_EQ(nodes.size(), b.nodes.size() * BVH_NODE_WORDS);
+  for (size_t i = 0; i < b.nodes.size(); i++) {
+    const bvh_node &n = b.nodes[i];
+    const uint32_t *w = &nodes[i * BVH_NODE_WORDS];
+    for (int a = 0; a < 3; a++) {
+      EXPECT_LE(double(int32_t(w[a])) / FP_2_POW_QW, n.min[a]);
+      EXPECT_GE(double(int32_t(w[3 + a])) / FP_2_POW_QW, n.max[a]);
+      // And are no more than a step larger on each side
+      EXPECT_LE(double(int32_t(w[3 + a]) - int32_t(w[a])) / FP_2_POW_QW,
+                n.max[a] - n.min[a] + 2.0 / FP_2_POW_QW);
+    }
+    EXPECT_EQ(w[6], n.offset);
+    EXPECT_EQ(w[7] & 0xffff, n.count);
+    EXPECT_EQ(w[7] >> 16, n.count ? 0 : n.axis);
+  }
+
+  std::vector<uint32_t> words = b.serialise_triangles(triangles);
+  ASSERT_EQ(words.size(), triangles.size() * BVH_TRIANGLE_WORDS);
+  for (size_t i = 0; i < b.indices.size(); i++) {
+    const triangle &t = triangles[b.indices[i]];
+    const uint32_t *w = &words[i * BVH_TRIANGLE_WORDS];
+    EXPECT_EQ(w[0], uint32_t(FLOAT_2_FIX(t.v0.x())));
+    EXPECT_EQ(w[4], uint32_t(FLOAT_2_FIX(t.v1.y())));
+    EXPECT_EQ(w[8], uint32_t(FLOAT_2_FIX(t.v2.z())));
+  }
+}
+
+} // namespace
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bvh.hpp"
+#include "mesh.hpp"
+#include "sah_builder.hpp"
+#include "wide_bvh.hpp"
+
+#pragma mark - Helpers
+
+namespace {
+
+// Rays from around the scene towards random triangles, and some at random
+std::vector<ray> random_rays(const std::vector<triangle> &triangles,
+                             int count) {
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> coord(-80, 80);
+  std::vector<ray> rays;
+  for (int i = 0; i < count; i++) {
+    point3 origin(coord(rng), coord(rng), coord(rng));
+    if (i % 4 == 0) {
+      rays.emplace_back(origin, vec3(coord(rng), coord(rng), coord(rng)));
+    } else {
+      const triangle &t = triangles[rng() % triangles.size()];
+      rays.emplace_back(origin, t.centroid() - origin);
+    }
+  }
+  return rays;
+}
+
+// Walks the wide BVH, checking that every quantised box contains the exact
+// bounds of its subtree, that every triangle is in one leaf, and that no
+// node is referenced twice
+void expect_valid(const wide_bvh &w, const std::vector<triangle> &triangles) {
+  ASSERT_EQ(w.indices.size(), triangles.size());
+  std::vector<int> seen(triangles.size(), 0);
+  std::vector<int> referenced(w.nodes(), 0);
+  referenced[0] = 1;
+
+  for (size_t node = 0; node < w.nodes(); node++) {
+    wide_child children[8];
+    int n = decode_wide_node(&w.words[node * wide_bvh::node_words(w.width)],
+                             w.width, children);
+    ASSERT_GE(n, 1);
+    for (int c = 0; c < n; c++) {
+      const wide_child &child = children[c];
+
+      // Exact bounds of everything below the child
+      aabb exact;
+      std::vector<uint32_t> pending;
+      if (child.internal) {
+        ASSERT_LT(child.node, w.nodes());
+        referenced[child.node] += 1;
+        pending.push_back(child.node);
+      } else {
+        ASSERT_LE(child.first + child.count, w.indices.size());
+        for (uint32_t i = child.first; i < child.first + child.count; i++) {
+          seen[w.indices[i]] += 1;
+          exact.grow(triangles[w.indices[i]].bounds());
+        }
+      }
+      while (!pending.empty()) {
+        uint32_t p = pending.back();
+        pending.pop_back();
+        wide_child below[8];
+        int m = decode_wide_node(&w.words[p * wide_bvh::node_words(w.width)],
+                                 w.width, below);
+        for (int k = 0; k < m; k++) {
+          if (below[k].internal) {
+            pending.push_back(below[k].node);
+          } else {
+            for (uint32_t i = below[k].first;
+                 i < below[k].first + below[k].count; i++) {
+              exact.grow(triangles[w.indices[i]].bounds());
+            }
+          }
+        }
+      }
+      for (int a = 0; a < 3; a++) {
+        EXPECT_LE(child.min[a], exact.min.e[a]);
+        EXPECT_GE(child.max[a], exact.max.e[a]);
+      }
+    }
+  }
+  for (size_t i = 0; i < seen.size(); i++) {
+    ASSERT_EQ(seen[i], 1) << "triangle " << i;
+  }
+  for (size_t i = 0; i < referenced.size(); i++) {
+    ASSERT_EQ(referenced[i], 1) << "node " << i;
+  }
+}
+
+#pragma mark - Unit Test
+
+class WideBvhTest : public testing::Test {};
+
+TEST_F(WideBvhTest, Structure) {
+  std::vector<triangle> triangles = random_mesh(20000, 2);
+  bvh b = sah_builder().build(triangles);
+
+  for (int width : {4, 8}) {
+    wide_bvh w;
+    ASSERT_TRUE(w.encode(b, width));
+    expect_valid(w, triangles);
+  }
+}
+
+// Quantised boxes are conservative, so every hit of the binary BVH is found
+TEST_F(WideBvhTest, HitsMatchBinary) {
+  std::vector<triangle> triangles = random_mesh(20000, 4);
+  bvh b = sah_builder().build(triangles);
+  std::vector<ray> rays = random_rays(triangles, 2000);
+
+  traversal_stats binary_stats;
+  for (int width : {4, 8}) {
+    wide_bvh w;
+    ASSERT_TRUE(w.encode(b, width));
+
+    traversal_stats stats;
+    for (const ray &r : rays) {
+      bvh_hit expected, actual;
+      bool found = b.hit(triangles, r, interval(0.001f, INFINITY), expected,
+                         width == 4 ? &binary_stats : nullptr);
+      ASSERT_EQ(w.hit(triangles, r, interval(0.001f, INFINITY), actual,
+                      &stats),
+                found);
+      if (found) {
+        EXPECT_EQ(actual.t, expected.t);
+      }
+    }
+    std::printf("BVH%d: %.1f nodes/KB (binary %.1f), %.1f bytes/triangle "
+                "(binary %.1f), %.1f nodes, %.1f boxes, %.1f triangles per "
+                "ray (binary %.1f, %.1f, %.1f)\n",
+                width, 1024.0 * w.nodes() / w.memory(),
+                1024.0 * b.nodes.size() / b.memory(),
+                double(w.memory()) / triangles.size(),
+                double(b.memory()) / triangles.size(),
+                double(stats.nodes) / rays.size(),
+                double(stats.boxes) / rays.size(),
+                double(stats.triangles) / rays.size(),
+                double(binary_stats.nodes) / rays.size(),
+                double(binary_stats.boxes) / rays.size(),
+                double(binary_stats.triangles) / rays.size());
+    EXPECT_LT(stats.nodes, binary_stats.nodes / 2);
+    EXPECT_LT(w.memory(), b.memory());
+  }
+}
+
+// Boxes far from the origin and tiny boxes need large and small exponents
+TEST_F(WideBvhTest, Scales) {
+  std::vector<triangle> triangles;
+  for (int i = 0; i < 64; i++) {
+    float x = 20000.0f * (i % 2 ? 1 : -1) + i;
+    float s = i < 32 ? 1e-4f : 10.0f;
+    triangles.push_back(
+        {point3(x, 0, -1), point3(x + s, 0, -1), point3(x, s, -1)});
+  }
+  bvh b = sah_builder().build(triangles);
+  for (int width : {4, 8}) {
+    wide_bvh w;
+    ASSERT_TRUE(w.encode(b, width));
+    expect_valid(w, triangles);
+  }
+}
+
+TEST_F(WideBvhTest, LargeLeaves) {
+  std::vector<triangle> triangles = random_mesh(1000);
+  sah_options options;
+  options.max_leaf_size = 64;
+  options.costs.traversal = 100; // Prefer leaves
+  bvh b = sah_builder(options).build(triangles);
+
+  wide_bvh w;
+  EXPECT_FALSE(w.encode(b, 4));
+}
+
+} // namespace
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "aabb.hpp"
+#include "interval.hpp"
+#include "ray.hpp"
+#include "vec3.hpp"
+
+#include <cmath>
+
+struct triangle {
+  point3 v0, v1, v2;
+
+  aabb bounds() const {
+    aabb b;
+    b.grow(v0);
+    b.grow(v1);
+    b.grow(v2);
+    return b;
+  }
+
+  point3 centroid() const { return (1.0f / 3.0f) * (v0 + v1 + v2); }
+
+  // Möller-Trumbore. On a hit within ray_t, t is the ray parameter of the
+  // hit.
+  bool hit(const ray &r, const interval &ray_t, float &t) const {
+    vec3 e1 = v1 - v0;
+    vec3 e2 = v2 - v0;
+    vec3 p = cross(r.direction(), e2);
+    float det = dot(e1, p);
+    if (std::fabs(det) < 1e-12f) {
+      return false; // Parallel to the triangle
+    }
+    float inv_det = 1.0f / det;
+
+    vec3 s = r.origin() - v0;
+    float u = dot(s, p) * inv_det;
+    if (u < 0 || u > 1) {
+      return false;
+    }
+    vec3 q = cross(s, e1);
+    float v = dot(r.direction(), q) * inv_det;
+    if (v < 0 || u + v > 1) {
+      return false;
+    }
+
+    float t_hit = dot(e2, q) * inv_det;
+    if (!ray_t.surrounds(t_hit)) {
+      return false;
+    }
+    t = t_hit;
+    return true;
+  }
+};
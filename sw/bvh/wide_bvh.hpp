@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "bvh.hpp"
+#include "interval.hpp"
+#include "ray.hpp"
+#include "triangle.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Compressed 4- and 8-wide BVH for the node memory of the coprocessor.
+//
+// A binary BVH is collapsed into nodes of up to WIDTH children by
+// repeatedly opening the child with the largest surface area. Child bounds
+// are stored as 8-bit offsets from the node origin, in steps of a power of
+// two per axis, rounded outwards, so a quantised box always contains the
+// exact one and traversal never misses a hit. All offsets are in 16.16 and
+// decode exactly.
+//
+// A node is node_words(WIDTH) 32-bit words, a whole number of 32-byte node
+// cache lines (64 bytes for BVH4, 96 bytes for BVH8):
+//
+//   word 0-2   origin x, y, z, 16.16
+//   word 3     bits 7:0, 15:8, 23:16: exponents ex, ey, ez;
+//              bits 31:24: mask of the valid children
+//   word 4     index of the first internal child node
+//   word 5     index of the first triangle of the leaf children
+//   word 6+2c  child c: bits 7:0, 15:8, 23:16: qlo x, y, z;
+//              bits 31:24: qhi x
+//   word 7+2c  bits 7:0, 15:8: qhi y, z; bits 31:16: meta
+//
+// Child c covers origin + (qlo << e) to origin + (qhi << e) in 16.16 along
+// each axis. meta bit 15 marks an internal child, whose node is word 4
+// plus bits 2:0. Otherwise the child is a leaf of bits 4:0 triangles (at
+// most 31), starting at word 5 plus bits 14:5. Internal children of a node
+// are consecutive nodes, and so are the triangles of its leaves, in the
+// order of wide_bvh::indices. Unused words are 0.
+
+#define WIDE_BVH_HEADER_WORDS 6
+#define WIDE_BVH_MAX_LEAF 31
+
+struct wide_child {
+  double min[3]; // Decoded bounds, exact
+  double max[3];
+  bool internal;
+  uint32_t node;  // Internal child
+  uint32_t first; // Leaf child
+  uint32_t count;
+};
+
+// Decodes the valid children of a node, returning how many there are
+inline int decode_wide_node(const uint32_t *w, int width, wide_child *out) {
+  int n = 0;
+  for (int c = 0; c < width; c++) {
+    if (!(w[3] >> (24 + c) & 1)) {
+      continue;
+    }
+    uint32_t lo = w[WIDE_BVH_HEADER_WORDS + 2 * c];
+    uint32_t hi = w[WIDE_BVH_HEADER_WORDS + 2 * c + 1];
+    uint32_t qlo[3] = {lo & 0xff, lo >> 8 & 0xff, lo >> 16 & 0xff};
+    uint32_t qhi[3] = {lo >> 24, hi & 0xff, hi >> 8 & 0xff};
+    uint32_t meta = hi >> 16;
+
+    wide_child &child = out[n++];
+    for (int a = 0; a < 3; a++) {
+      int64_t origin = int32_t(w[a]);
+      int e = w[3] >> (8 * a) & 0xff;
+      child.min[a] = double(origin + (int64_t(qlo[a]) << e)) / FP_2_POW_QW;
+      child.max[a] = double(origin + (int64_t(qhi[a]) << e)) / FP_2_POW_QW;
+    }
+    child.internal = meta >> 15;
+    child.node = w[4] + (meta & 0x7);
+    child.first = w[5] + (meta >> 5 & 0x3ff);
+    child.count = meta & 0x1f;
+  }
+  return n;
+}
+
+class wide_bvh {
+public:
+  int width = 4;               // 4 or 8
+  std::vector<uint32_t> words; // Nodes, node_words(width) each
+  std::vector<uint32_t> indices; // Triangles of the leaves
+
+  // Header and children, padded to whole 32-byte lines
+  static int node_words(int width) {
+    int words = WIDE_BVH_HEADER_WORDS + 2 * width;
+    return (words + BVH_NODE_WORDS - 1) / BVH_NODE_WORDS * BVH_NODE_WORDS;
+  }
+
+  size_t nodes() const { return words.size() / node_words(width); }
+
+  // Bytes of nodes and indices
+  size_t memory() const {
+    return (words.size() + indices.size()) * sizeof(uint32_t);
+  }
+
+  // Collapses b into width-wide nodes. Fails if a leaf of b has more than
+  // WIDE_BVH_MAX_LEAF triangles.
+  bool encode(const bvh &b, int width) {
+    this->width = width;
+    words.clear();
+    indices.clear();
+    if (b.nodes.empty()) {
+      return true;
+    }
+    for (const bvh_node &n : b.nodes) {
+      if (n.count > WIDE_BVH_MAX_LEAF) {
+        return false;
+      }
+    }
+
+    // Wide node, and the binary node it stands for
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 0}};
+    words.resize(node_words(width));
+    while (!stack.empty()) {
+      auto [w, node] = stack.back();
+      stack.pop_back();
+
+      // Open the largest internal child until the node is full
+      std::vector<uint32_t> children;
+      if (b.nodes[node].leaf()) {
+        children.push_back(node);
+      } else {
+        children = {node + 1, b.nodes[node].offset};
+      }
+      while (int(children.size()) < width) {
+        int largest = -1;
+        float area = -1;
+        for (int c = 0; c < int(children.size()); c++) {
+          const bvh_node &n = b.nodes[children[c]];
+          if (!n.leaf() && n.bounds().surface_area() > area) {
+            largest = c;
+            area = n.bounds().surface_area();
+          }
+        }
+        if (largest < 0) {
+          break;
+        }
+        uint32_t opened = children[largest];
+        children[largest] = opened + 1;
+        children.insert(children.begin() + largest + 1,
+                        b.nodes[opened].offset);
+      }
+
+      uint32_t child_base = uint32_t(nodes());
+      uint32_t triangle_base = uint32_t(indices.size());
+      int internal = 0;
+      for (uint32_t c : children) {
+        internal += !b.nodes[c].leaf();
+      }
+      words.resize(words.size() + internal * node_words(width));
+
+      uint32_t *out = &words[size_t(w) * node_words(width)];
+      out[4] = child_base;
+      out[5] = triangle_base;
+
+      // The origin and the steps come from the bounds of the node
+      aabb bounds;
+      for (uint32_t c : children) {
+        bounds.grow(b.nodes[c].bounds());
+      }
+      int64_t origin[3];
+      int e[3];
+      for (int a = 0; a < 3; a++) {
+        origin[a] = int32_t(fix_floor(bounds.min.e[a]));
+        int64_t span = int64_t(int32_t(fix_ceil(bounds.max.e[a]))) - origin[a];
+        e[a] = 0;
+        while ((span + (int64_t(1) << e[a]) - 1) >> e[a] > 255) {
+          e[a] += 1;
+        }
+        out[a] = uint32_t(origin[a]);
+        out[3] |= uint32_t(e[a]) << (8 * a);
+      }
+
+      int slot = 0;
+      for (int c = 0; c < int(children.size()); c++) {
+        const bvh_node &n = b.nodes[children[c]];
+        uint32_t qlo[3], qhi[3];
+        for (int a = 0; a < 3; a++) {
+          int64_t lo = int64_t(int32_t(fix_floor(n.min[a]))) - origin[a];
+          int64_t hi = int64_t(int32_t(fix_ceil(n.max[a]))) - origin[a];
+          qlo[a] = uint32_t(lo >> e[a]);
+          qhi[a] = uint32_t((hi + (int64_t(1) << e[a]) - 1) >> e[a]);
+        }
+
+        uint32_t meta;
+        if (n.leaf()) {
+          meta = uint32_t(indices.size() - triangle_base) << 5 | n.count;
+          indices.insert(indices.end(), b.indices.begin() + n.offset,
+                         b.indices.begin() + n.offset + n.count);
+        } else {
+          meta = 0x8000 | uint32_t(slot);
+          stack.push_back({child_base + slot, children[c]});
+          slot += 1;
+        }
+
+        out[3] |= uint32_t(1) << (24 + c);
+        out[WIDE_BVH_HEADER_WORDS + 2 * c] =
+            qlo[0] | qlo[1] << 8 | qlo[2] << 16 | qhi[0] << 24;
+        out[WIDE_BVH_HEADER_WORDS + 2 * c + 1] =
+            qhi[1] | qhi[2] << 8 | meta << 16;
+      }
+    }
+    return true;
+  }
+
+  // Nearest hit within ray_t, decoding the nodes like the hardware would.
+  // Children are visited nearest entry first.
+  bool hit(const std::vector<triangle> &triangles, const ray &r,
+           interval ray_t, bvh_hit &result,
+           traversal_stats *stats = nullptr) const {
+    if (words.empty()) {
+      return false;
+    }
+    double origin[3], inv_dir[3];
+    for (int a = 0; a < 3; a++) {
+      origin[a] = r.origin().e[a];
+      inv_dir[a] = 1 / double(r.direction().e[a]);
+    }
+
+    struct entry {
+      bool internal;
+      uint32_t ref; // Node or first triangle
+      uint32_t count;
+    };
+    entry stack[BVH_MAX_DEPTH * 8];
+    int top = 0;
+    stack[top++] = {true, 0, 0};
+
+    bool found = false;
+    while (top > 0) {
+      entry e = stack[--top];
+      if (!e.internal) {
+        if (stats) {
+          stats->triangles += e.count;
+        }
+        for (uint32_t i = e.ref; i < e.ref + e.count; i++) {
+          float t;
+          if (triangles[indices[i]].hit(r, ray_t, t)) {
+            ray_t.max = t;
+            result = {t, indices[i]};
+            found = true;
+          }
+        }
+        continue;
+      }
+
+      wide_child children[8];
+      int n = decode_wide_node(&words[size_t(e.ref) * node_words(width)],
+                               width, children);
+      if (stats) {
+        stats->nodes += 1;
+        stats->boxes += n;
+      }
+
+      // Children that are hit, by entry distance
+      std::pair<double, int> order[8];
+      int hits = 0;
+      for (int c = 0; c < n; c++) {
+        double t_min = ray_t.min, t_max = ray_t.max;
+        for (int a = 0; a < 3; a++) {
+          double t0 = (children[c].min[a] - origin[a]) * inv_dir[a];
+          double t1 = (children[c].max[a] - origin[a]) * inv_dir[a];
+          if (inv_dir[a] < 0) {
+            std::swap(t0, t1);
+          }
+          t_min = t0 > t_min ? t0 : t_min;
+          t_max = t1 < t_max ? t1 : t_max;
+        }
+        if (t_min <= t_max) {
+          order[hits++] = {t_min, c};
+        }
+      }
+      std::sort(order, order + hits);
+      for (int i = hits - 1; i >= 0; i--) {
+        const wide_child &c = children[order[i].second];
+        stack[top++] = c.internal ? entry{true, c.node, 0}
+                                  : entry{false, c.first, c.count};
+      }
+    }
+    return found;
+  }
+
+  std::vector<uint32_t>
+  serialise_triangles(const std::vector<triangle> &triangles) const {
+    return ::serialise_triangles(triangles, indices);
+  }
+};
@@ -0,0 +1,313 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Cycle-approximate performance model of coprocessor.v.
+//
+// The model follows the registers that decide the timing of a frame, and
+// none of the datapath:
+// - the AXIS slave FSM (IDLE, RECV_SCENE, RECV_OBJECTS, SEND_FRAGMENT) and
+//   the length of the camera configuration and of the scene objects
+// - the rt_controller state machine (IDLE, READY, DRAIN)
+// - the valid shift register of the RGU pipeline
+// - the output register (and optional FIFO) in front of m_axis, and the
+//   stall it feeds back into rt_core
+//
+// With the default configuration the model is cycle-exact with Vcoprocessor
+// writing to its AXIS master (fb_enable low):
+// coprocessor_test.cc compares both under the same tvalid/tready patterns.
+// Other configurations describe hardware that does not exist yet:
+// - lanes: pixels generated per cycle, sent as one beat of lanes words
+// - depth: RGU pipeline stages
+// - fifo_depth: entries in front of the output register. Without a FIFO
+//   m_axis_tready stalls rt_core combinationally, as in coprocessor.v. With
+//   a FIFO the stall is registered (FIFO full), which removes tready from
+//   the critical path of the pipeline.
+
+#define COPROCESSOR_PAYLOAD_WORDS 27 // SCENE_PAYLOAD_SIZE
+#define COPROCESSOR_WORD_BITS 32     // FP_WL
+
+struct coprocessor_config {
+  uint32_t lanes = 1;
+  uint32_t depth = 5;      // rt_rgu_5_stage
+  uint32_t fifo_depth = 0; // coprocessor.v has only the output register
+  double clock_mhz = 100.0;
+
+  // Objects sent after the camera: a length header and scene_words words,
+  // accepted at one word per clock
+  bool scene_upload = false;
+  uint32_t scene_words = 0;
+
+  // A frame without a handshake for this many cycles is given up, e.g.
+  // when ready() never returns true
+  uint64_t max_idle_cycles = 1000000;
+
+  // Words of the configuration packet
+  uint32_t upload_words() const {
+    return COPROCESSOR_PAYLOAD_WORDS + (scene_upload ? 1 + scene_words : 0);
+  }
+
+  // Flip-flops in the RGU stage registers and the output FIFO. rt_rgu_5_stage
+  // keeps x, y and the ray origin, plus three words per stage.
+  uint64_t register_bits() const {
+    uint64_t pipeline_words = 5 + 3 * uint64_t(depth);
+    uint64_t fifo_words = uint64_t(fifo_depth) + 1;
+    return uint64_t(lanes) * (pipeline_words + fifo_words) *
+           COPROCESSOR_WORD_BITS;
+  }
+};
+
+// Cycle counts of one frame, with the same definitions as
+// hw/rt/bench/coprocessor_bench.cc. Cycles are numbered from the first
+// cycle after reset, in which the configuration is offered.
+struct frame_timing {
+  uint64_t pixels = 0;
+  uint64_t beats = 0;
+
+  uint64_t upload_cycles = 0; // First to last configuration handshake
+  uint64_t fill_cycles = 0;   // Until the first beat is valid
+  uint64_t stream_cycles = 0; // First valid beat to the tlast handshake
+  uint64_t drain_cycles = 0;  // Until the next configuration is accepted
+
+  uint64_t stalls = 0;      // Cycles with m_axis_tvalid && !m_axis_tready
+  uint64_t core_stalls = 0; // Cycles rt_core was stalled
+
+  // Absolute cycles of the handshakes, for comparison with a simulation
+  uint64_t first_upload = 0;
+  uint64_t last_upload = 0;
+  uint64_t first_valid = 0;
+  uint64_t last_beat = 0;
+
+  // The frame did not complete within max_idle_cycles of the last
+  // handshake. The other counts are then meaningless.
+  bool timed_out = false;
+
+  // Cycles between two back-to-back frames
+  uint64_t period() const {
+    return upload_cycles + fill_cycles + stream_cycles + drain_cycles;
+  }
+  double cycles_per_pixel() const {
+    return pixels ? double(period()) / double(pixels) : 0.0;
+  }
+  double fps(double clock_mhz) const {
+    return clock_mhz * 1e6 / double(period());
+  }
+};
+
+class coprocessor_model {
+public:
+  explicit coprocessor_model(coprocessor_config config = {})
+      : config(config) {}
+
+  const coprocessor_config &configuration() const { return config; }
+
+  // Render one frame. valid() decides whether the DMA offers the next
+  // configuration word and ready() whether it accepts a beat, both called
+  // the same way as axis_master and axis_slave call their patterns.
+  //
+  // If max_beats is non-zero and the frame has more beats, only max_beats
+  // beats are simulated and the stream is extrapolated to the full frame.
+  // An empty frame returns all zeros.
+  template <typename Valid, typename Ready>
+  frame_timing run(uint32_t width, uint32_t height, Valid &&valid,
+                   Ready &&ready, uint64_t max_beats = 0) const {
+    uint64_t pixels = uint64_t(width) * uint64_t(height);
+    if (pixels == 0) {
+      return frame_timing();
+    }
+    uint64_t beats = (pixels + config.lanes - 1) / config.lanes;
+    uint64_t simulated = max_beats && beats > max_beats ? max_beats : beats;
+
+    frame_timing t = simulate(simulated, valid, ready);
+    if (simulated != beats && !t.timed_out) {
+      double scale = double(beats) / double(simulated);
+      t.stream_cycles = uint64_t(double(t.stream_cycles) * scale + 0.5);
+      t.stalls = uint64_t(double(t.stalls) * scale + 0.5);
+      t.core_stalls = uint64_t(double(t.core_stalls) * scale + 0.5);
+      t.last_beat = t.first_valid + t.stream_cycles - 1;
+    }
+    t.pixels = pixels;
+    t.beats = beats;
+    return t;
+  }
+
+  // DMA that never throttles
+  frame_timing run(uint32_t width, uint32_t height,
+                   uint64_t max_beats = 0) const {
+    auto always = [] { return true; };
+    return run(width, height, always, always, max_beats);
+  }
+
+private:
+  enum cop_state { COP_IDLE, COP_RECV_SCENE, COP_SEND_FRAGMENT };
+  enum ctrl_state { CTRL_IDLE, CTRL_READY, CTRL_DRAIN };
+
+  template <typename Valid, typename Ready>
+  frame_timing simulate(uint64_t beats, Valid &valid, Ready &ready) const {
+    const uint64_t capacity = uint64_t(config.fifo_depth) + 1;
+    const uint32_t depth = std::clamp(config.depth, 1u, 63u);
+    const uint64_t depth_mask = (uint64_t(1) << depth) - 1;
+    const uint32_t payload = config.upload_words();
+
+    frame_timing t;
+
+    // Configuration master
+    uint32_t words_sent = 0;
+    bool offered = false;
+    bool accepted = false;
+
+    // coprocessor.v
+    cop_state cop = COP_IDLE;
+    bool s_tready = false;
+    uint32_t recv_counter = 0;
+    bool render_start = false;
+
+    // rt_controller
+    ctrl_state ctrl = CTRL_IDLE;
+    uint64_t x = 0;
+    bool rgu_start = false;
+    uint32_t cycle_count = 0;
+
+    // rt_rgu_5_stage valid shift register
+    uint64_t pipe_valid = 0;
+
+    // Output register and FIFO
+    uint64_t occupancy = 0;
+    uint64_t popped = 0;
+
+    bool done = false;
+    uint64_t done_cycle = 0;
+    uint64_t handshake_cycle = 0;
+
+    for (uint64_t cycle = 0;; cycle++) {
+      if (cycle - handshake_cycle > config.max_idle_cycles) {
+        t.timed_out = true;
+        return t;
+      }
+
+      // Drive the DMA side
+      if (accepted) {
+        accepted = false;
+        offered = false;
+        words_sent += 1;
+      }
+      if (!done && !offered && words_sent < payload &&
+          valid()) {
+        offered = true;
+      }
+      bool m_tready = !done && ready();
+
+      if (done) {
+        // The next configuration is offered right after the frame
+        if (s_tready) {
+          t.drain_cycles = cycle - done_cycle - 1;
+          break;
+        }
+        offered = true;
+      }
+
+      // Combinational
+      bool m_tvalid = occupancy > 0;
+      bool pop = m_tvalid && m_tready;
+      bool core_stall = config.fifo_depth == 0
+                            ? occupancy == capacity && !pop
+                            : occupancy == capacity;
+      bool render_valid = (pipe_valid >> (depth - 1)) & 1;
+      bool upload = offered && s_tready;
+
+      if (m_tvalid && !m_tready) {
+        t.stalls += 1;
+      }
+      if (core_stall) {
+        t.core_stalls += 1;
+      }
+      if (upload || pop) {
+        handshake_cycle = cycle;
+      }
+      if (upload) {
+        if (words_sent == 0) {
+          t.first_upload = cycle;
+        }
+        t.last_upload = cycle;
+        accepted = true;
+      }
+      if (m_tvalid && popped == 0 && t.first_valid == 0) {
+        t.first_valid = cycle;
+      }
+      bool last = pop && popped == beats - 1;
+
+      // Clock edge: coprocessor.v
+      bool start = render_start;
+      render_start = false;
+      switch (cop) {
+      case COP_IDLE:
+        s_tready = offered;
+        recv_counter = 0;
+        cop = offered ? COP_RECV_SCENE : COP_IDLE;
+        break;
+      case COP_RECV_SCENE:
+        // RECV_OBJECTS continues at the same rate
+        if (offered) {
+          if (recv_counter == payload - 1) {
+            s_tready = false;
+            render_start = true;
+            cop = COP_SEND_FRAGMENT;
+          } else {
+            recv_counter += 1;
+          }
+        }
+        break;
+      case COP_SEND_FRAGMENT:
+        cop = last ? COP_IDLE : COP_SEND_FRAGMENT;
+        break;
+      }
+
+      occupancy -= pop ? 1 : 0;
+      popped += pop ? 1 : 0;
+      if (render_valid && !core_stall) {
+        occupancy += 1;
+      }
+
+      // Clock edge: rt_controller and RGU
+      if (!core_stall) {
+        pipe_valid = ((pipe_valid << 1) | (rgu_start ? 1 : 0)) & depth_mask;
+
+        switch (ctrl) {
+        case CTRL_IDLE:
+          rgu_start = start;
+          x = 0;
+          cycle_count = 0;
+          ctrl = start ? CTRL_READY : CTRL_IDLE;
+          break;
+        case CTRL_READY:
+          rgu_start = x != beats - 1;
+          ctrl = x == beats - 1 ? CTRL_DRAIN : CTRL_READY;
+          x += 1;
+          break;
+        case CTRL_DRAIN:
+          rgu_start = false;
+          ctrl = cycle_count == depth - 1 ? CTRL_IDLE : CTRL_DRAIN;
+          cycle_count += 1;
+          break;
+        }
+      }
+
+      if (last) {
+        t.last_beat = cycle;
+        done = true;
+        done_cycle = cycle;
+      }
+    }
+
+    t.upload_cycles = t.last_upload - t.first_upload + 1;
+    t.fill_cycles = t.first_valid - t.last_upload - 1;
+    t.stream_cycles = t.last_beat - t.first_valid + 1;
+    return t;
+  }
+
+  coprocessor_config config;
+};
@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "scene.hpp"
+
+// Bit-accurate emulation of the fixed-point datapath at any IW.QW, used to
+// pick the narrowest format that still renders correctly.
+//
+// Values are held as int64_t with the format kept alongside. The operations
+// follow hw/math/fp_core:
+// - sfp_mul builds the full (IW1 + IW2).(QW1 + QW2) product, or with
+//   DSP = 1 the product of the operands narrowed to 27 and 18 bits
+// - sfp_add/sfp_sub widen by one integer bit
+// - sfp_resize truncates fractional bits (floor toward -inf) or rounds them
+//   as selected by ROUND and, with CLIP = 0 as in rt_rgu_5_stage, drops
+//   integer bits (wraps)
+//
+// Formats up to 62 bits are supported; products are formed in __int128.
+
+struct sfp_format {
+  int iw;
+  int qw;
+
+  int wl() const { return iw + qw; }
+  bool operator==(const sfp_format &o) const {
+    return iw == o.iw && qw == o.qw;
+  }
+};
+
+// Keep the low wl bits of v as a signed number
+inline int64_t sfp_wrap(__int128 v, int wl) {
+  unsigned __int128 mask = (unsigned __int128)1 << wl;
+  unsigned __int128 u = (unsigned __int128)v & (mask - 1);
+  if (u & (mask >> 1)) {
+    return int64_t(__int128(u) - __int128(mask));
+  }
+  return int64_t(u);
+}
+
+// ROUND of sfp_resize
+enum sfp_round {
+  SFP_TRUNCATE = 0,
+  SFP_ROUND_HALF_UP = 1,  // Ties toward +inf
+  SFP_ROUND_HALF_EVEN = 2 // Ties to the even neighbour
+};
+
+// The fractional bits of sfp_resize. As in hardware, rounding adds half an
+// output LSB (less one if the kept LSB is even and ties go to even) and
+// then floors.
+inline __int128 sfp_align(__int128 v, int in_qw, int out_qw,
+                          sfp_round round) {
+  if (in_qw < out_qw) {
+    return v * ((__int128)1 << (out_qw - in_qw));
+  }
+  int drop = in_qw - out_qw;
+  if (drop > 0 && round != SFP_TRUNCATE) {
+    __int128 half = (__int128)1 << (drop - 1);
+    if (round == SFP_ROUND_HALF_EVEN) {
+      half += ((v >> drop) & 1) - 1;
+    }
+    v += half;
+  }
+  return v >> drop; // Arithmetic shift: floor
+}
+
+// sfp_resize with clip = 0
+inline int64_t sfp_resize(__int128 v, sfp_format in, sfp_format out,
+                          sfp_round round = SFP_TRUNCATE) {
+  return sfp_wrap(sfp_align(v, in.qw, out.qw, round), out.wl());
+}
+
+inline int64_t sfp_mul(int64_t a, int64_t b, sfp_format f,
+                       sfp_round round = SFP_TRUNCATE) {
+  return sfp_resize(__int128(a) * __int128(b), {2 * f.iw, 2 * f.qw}, f,
+                    round);
+}
+
+// sfp_resize with clip = 1
+inline int64_t sfp_resize_clip(__int128 v, sfp_format in, sfp_format out,
+                               sfp_round round = SFP_TRUNCATE) {
+  v = sfp_align(v, in.qw, out.qw, round);
+  __int128 max = ((__int128)1 << (out.wl() - 1)) - 1;
+  return int64_t(std::clamp(v, -max - 1, max));
+}
+
+// sfp_mul with DSP = 1: x narrowed to DSP_X_IW.(27 - DSP_X_IW), y to
+// DSP_Y_IW.(18 - DSP_Y_IW)
+inline int64_t sfp_mul_dsp(int64_t x, int64_t y, sfp_format f, int dsp_x_iw,
+                           int dsp_y_iw, sfp_round round = SFP_TRUNCATE) {
+  sfp_format xf = {dsp_x_iw, 27 - dsp_x_iw};
+  sfp_format yf = {dsp_y_iw, 18 - dsp_y_iw};
+  int64_t xn = sfp_resize_clip(x, f, xf, round);
+  int64_t yn = sfp_resize_clip(y, f, yf, round);
+  return sfp_resize(__int128(xn) * __int128(yn),
+                    {xf.iw + yf.iw, xf.qw + yf.qw}, f, round);
+}
+
+// Both operands in f: the sum keeps every fractional bit, ROUND has no effect
+inline int64_t sfp_add(int64_t a, int64_t b, sfp_format f) {
+  return sfp_resize(__int128(a) + __int128(b), {f.iw + 1, f.qw}, f);
+}
+inline int64_t sfp_sub(int64_t a, int64_t b, sfp_format f) {
+  return sfp_resize(__int128(a) - __int128(b), {f.iw + 1, f.qw}, f);
+}
+
+// FLOAT_2_FIX: truncate toward zero, then store in wl bits. The rounding
+// modes round to the nearest representable value instead.
+inline int64_t sfp_from_float(double v, sfp_format f,
+                              sfp_round round = SFP_TRUNCATE) {
+  double scaled = std::ldexp(v, f.qw);
+  switch (round) {
+  case SFP_ROUND_HALF_UP:
+    scaled = std::floor(scaled + 0.5);
+    break;
+  case SFP_ROUND_HALF_EVEN:
+    scaled = std::nearbyint(scaled);
+    break;
+  default:
+    break;
+  }
+  return sfp_wrap(__int128(scaled), f.wl());
+}
+inline double sfp_to_double(int64_t v, sfp_format f) {
+  return std::ldexp(double(v), -f.qw);
+}
+
+// DSP48E2 slices for a full signed a x b bit multiplier, tiled from 26 x 17
+// bit unsigned partial products plus the sign bits, e.g. 4 slices for 32x32.
+inline int dsp48e2_per_multiplier(int a, int b) {
+  auto tiles = [](int a, int b) {
+    return (std::max(a - 1, 1) + 25) / 26 * ((std::max(b - 1, 1) + 16) / 17);
+  };
+  return std::min(tiles(a, b), tiles(b, a));
+}
+
+#pragma mark - Ray generation
+
+// Camera registers as received by rt_rgu_5_stage
+struct rgu_camera {
+  int64_t pixel_00_loc[3];
+  int64_t pixel_delta_u[3];
+  int64_t pixel_delta_v[3];
+  int64_t camera_center[3];
+};
+
+inline rgu_camera rgu_quantise(const Scene &scene, sfp_format f,
+                               sfp_round round = SFP_TRUNCATE) {
+  rgu_camera cam;
+  for (int i = 0; i < 3; i++) {
+    cam.pixel_00_loc[i] = sfp_from_float(scene.pixel_00_loc[i], f, round);
+    cam.pixel_delta_u[i] = sfp_from_float(scene.pixel_delta_u[i], f, round);
+    cam.pixel_delta_v[i] = sfp_from_float(scene.pixel_delta_v[i], f, round);
+    cam.camera_center[i] = sfp_from_float(scene.camera_center[i], f, round);
+  }
+  return cam;
+}
+
+// RGU_DSP in rt_rgu_5_stage: every product maps onto one DSP48E2
+inline bool rgu_uses_dsp(sfp_format f) { return f.qw <= 26 && f.iw <= 18; }
+
+inline int64_t rgu_mul(int64_t delta, int64_t coordinate, sfp_format f,
+                       sfp_round round = SFP_TRUNCATE) {
+  if (rgu_uses_dsp(f)) {
+    return sfp_mul_dsp(delta, coordinate, f, 27 - f.qw, f.iw, round);
+  }
+  return sfp_mul(delta, coordinate, f, round);
+}
+
+// rt_rgu_5_stage: the four arithmetic stages for one pixel. The coordinates
+// are integers, so every stage is exact and only the quantisation of the
+// camera registers contributes to the error.
+inline void rgu_ray_direction(const rgu_camera &cam, sfp_format f, int x,
+                              int y, int64_t direction[3],
+                              sfp_round round = SFP_TRUNCATE) {
+  // x_reg = {1'b0, x, QW'b0}
+  int64_t x_fp = sfp_wrap(__int128(x) << f.qw, f.wl());
+  int64_t y_fp = sfp_wrap(__int128(y) << f.qw, f.wl());
+
+  for (int i = 0; i < 3; i++) {
+    int64_t x_delta_u = rgu_mul(cam.pixel_delta_u[i], x_fp, f, round);
+    int64_t y_delta_v = rgu_mul(cam.pixel_delta_v[i], y_fp, f, round);
+    int64_t pixel_off = sfp_add(x_delta_u, y_delta_v, f);
+    int64_t pixel_center = sfp_add(cam.pixel_00_loc[i], pixel_off, f);
+    direction[i] = sfp_sub(pixel_center, cam.camera_center[i], f);
+  }
+}
+
+#pragma mark - Error
+
+struct precision_error {
+  double max = 0;    // Largest component error, world units
+  double rms = 0;    // Over all components of all pixels
+  double pixels = 0; // max relative to the pixel pitch
+  uint64_t samples = 0;
+  bool exceeded = false; // Stopped early, rms covers the samples so far
+};
+
+// Compare the ray directions of every stride-th pixel with the float model
+// of the scene (evaluated in double). Stops as soon as the error exceeds
+// budget_pixels, if given. round applies to the camera registers and to
+// every resize of the datapath.
+inline precision_error rgu_error(Scene &scene, sfp_format f, int stride = 1,
+                                 double budget_pixels = 0,
+                                 sfp_round round = SFP_TRUNCATE) {
+  rgu_camera cam = rgu_quantise(scene, f, round);
+  double pitch = std::min(std::fabs(double(scene.pixel_delta_u[0])),
+                          std::fabs(double(scene.pixel_delta_v[1])));
+  int width = int(scene.image_width);
+  int height = int(scene.image_height);
+
+  precision_error e;
+  double sum = 0;
+  for (int y = 0; y < height; y += stride) {
+    for (int x = 0; x < width; x += stride) {
+      int64_t direction[3];
+      rgu_ray_direction(cam, f, x, y, direction, round);
+
+      for (int i = 0; i < 3; i++) {
+        double reference = double(scene.pixel_00_loc[i]) +
+                           x * double(scene.pixel_delta_u[i]) +
+                           y * double(scene.pixel_delta_v[i]) -
+                           double(scene.camera_center[i]);
+        double d = std::fabs(sfp_to_double(direction[i], f) - reference);
+        e.max = std::max(e.max, d);
+        sum += d * d;
+      }
+      e.samples += 1;
+    }
+
+    if (budget_pixels > 0 && e.max > budget_pixels * pitch) {
+      e.exceeded = true;
+      break;
+    }
+  }
+
+  e.rms = e.samples ? std::sqrt(sum / double(3 * e.samples)) : 0;
+  e.pixels = e.max / pitch;
+  return e;
+}
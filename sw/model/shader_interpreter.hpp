@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "precision.hpp"
+#include "shader_isa.hpp"
+
+// Bit-accurate reference interpreter of rt_shader_core. Runs one fragment
+// at a time; the hardware runs the same program on many fragments at once
+// but every fragment sees the results below.
+
+using shader_vec = std::array<int64_t, 3>;
+
+#pragma mark - rsqrt
+
+// rt_rsqrt_est: for s = 2^m * (1 + f), 2^(-m/2) / sqrt(1 + f) from a table
+// indexed by the parity of m and the four bits of f below the leading one.
+// The table holds the value at the centre of each interval, within 1.6 %.
+inline int64_t shader_rsqrt_table(int parity, int index, sfp_format f) {
+  double scale = parity ? 2.0 : 1.0;
+  return std::llround(std::ldexp(1.0, f.qw) /
+                      std::sqrt(scale * (1.0 + (index + 0.5) / 16.0)));
+}
+
+inline int64_t shader_rsqrt_estimate(int64_t s, sfp_format f) {
+  int p = 63 - __builtin_clzll(uint64_t(s)); // Leading one, s > 0
+  int m = p - f.qw;
+  int index = int(((uint64_t(s) << 4) >> p) & 15);
+  int k = m >> 1; // Floor, m = 2k + parity
+  int64_t lut = shader_rsqrt_table(m & 1, index, f);
+  return sfp_wrap(k >= 0 ? __int128(lut) >> k : __int128(lut) << -k, f.wl());
+}
+
+// goldschmidt: one iteration on the estimate,
+// y1 = y0 * (3 - (s * y0) * y0) / 2. s * y0 ~ sqrt(s) keeps more bits than
+// y0^2 for large s.
+inline int64_t shader_rsqrt(int64_t s, sfp_format f) {
+  if (s <= 0) {
+    return 0;
+  }
+  int64_t y0 = shader_rsqrt_estimate(s, f);
+  int64_t g0 = sfp_mul(s, y0, f);
+  int64_t b1 = sfp_mul(g0, y0, f);
+  int64_t three = sfp_wrap(__int128(3) << f.qw, f.wl());
+  // sfp_sub with CLIP = 1
+  int64_t t = sfp_resize_clip(__int128(three) - b1, {f.iw + 1, f.qw}, f);
+  return sfp_mul(y0, t >> 1, f);
+}
+
+#pragma mark - Interpreter
+
+class shader_interpreter {
+public:
+  explicit shader_interpreter(const shader_program &program,
+                              sfp_format f = {FP_IW, FP_QW})
+      : program(program), f(f) {}
+
+  // Run the program on one fragment and return r0
+  shader_vec run(const shader_vec &direction, const shader_vec &origin) {
+    regs = {};
+    regs[0] = direction;
+    regs[1] = origin;
+    for (uint32_t word : program.code) {
+      execute(shader_inst::decode(word));
+    }
+    return regs[0];
+  }
+
+  const shader_vec &reg(uint32_t r) const { return regs[r % SHADER_REGS]; }
+
+  void execute(const shader_inst &i) {
+    const shader_vec &a = regs[i.a % SHADER_REGS];
+    const shader_vec &b = regs[i.b % SHADER_REGS];
+    const shader_vec &c = regs[i.c % SHADER_REGS];
+    shader_vec r;
+
+    switch (i.op) {
+    case SHADER_ADD:
+      for (int n = 0; n < 3; n++) {
+        r[n] = sfp_add(a[n], b[n], f);
+      }
+      break;
+    case SHADER_SUB:
+      for (int n = 0; n < 3; n++) {
+        r[n] = sfp_sub(a[n], b[n], f);
+      }
+      break;
+    case SHADER_MUL:
+      for (int n = 0; n < 3; n++) {
+        r[n] = sfp_mul(a[n], b[n], f);
+      }
+      break;
+    case SHADER_DOT: {
+      // sfp_vec3_dot: full products, summed in 2 * FP_WL bits
+      __int128 sum = 0;
+      for (int n = 0; n < 3; n++) {
+        sum += __int128(a[n]) * __int128(b[n]);
+      }
+      int unused = 128 - 2 * f.wl();
+      sum = (sum << unused) >> unused;
+      r.fill(sfp_resize(sum, {2 * f.iw, 2 * f.qw}, f));
+      break;
+    }
+    case SHADER_LERP:
+      // sfp_vec_lerp with PREADD = 1, b - a keeps one more integer bit
+      for (int n = 0; n < 3; n++) {
+        __int128 diff = __int128(b[n]) - __int128(a[n]);
+        int64_t prod =
+            sfp_resize(diff * __int128(c[n]), {2 * f.iw + 1, 2 * f.qw}, f);
+        r[n] = sfp_add(a[n], prod, f);
+      }
+      break;
+    case SHADER_RSQ:
+      r.fill(shader_rsqrt(a[0], f));
+      break;
+    case SHADER_MAX:
+      for (int n = 0; n < 3; n++) {
+        r[n] = std::max(a[n], b[n]);
+      }
+      break;
+    case SHADER_MIN:
+      for (int n = 0; n < 3; n++) {
+        r[n] = std::min(a[n], b[n]);
+      }
+      break;
+    case SHADER_MOV:
+      r = a;
+      break;
+    case SHADER_CONST:
+      r = i.k < program.constants.size() ? program.constants[i.k]
+                                         : shader_vec{};
+      break;
+    case SHADER_SPLAT:
+      r.fill(a[i.k < 3 ? i.k : 0]);
+      break;
+    default: // nop and unused opcodes
+      return;
+    }
+    regs[i.d % SHADER_REGS] = r;
+  }
+
+private:
+  shader_program program;
+  sfp_format f;
+  std::array<shader_vec, SHADER_REGS> regs = {};
+};
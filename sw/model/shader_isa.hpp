@@ -0,0 +1,317 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "precision.hpp"
+
+// Instruction set of rt_shader_core (hw/rt/shader_isa.vh).
+//
+// Every instruction operates on vec3 registers in the FP_IW.FP_QW format of
+// the datapath and writes one register:
+//
+//   31   28 27   24 23   20 19   16 15   12 11          4 3     0
+//  |  op   |   d   |   a   |   b   |   c   |  reserved   |   k   |
+//
+// | Op    | Assembly           | Result                             |
+// |-------|--------------------|------------------------------------|
+// | nop   | nop                | -                                  |
+// | add   | add  rd, ra, rb    | a + b                              |
+// | sub   | sub  rd, ra, rb    | a - b                              |
+// | mul   | mul  rd, ra, rb    | a * b (per component)              |
+// | dot   | dot  rd, ra, rb    | (a . b).xxx                        |
+// | lerp  | lerp rd, ra, rb, rc| a + c * (b - a) (per component)    |
+// | rsq   | rsq  rd, ra        | (1 / sqrt(a.x)).xxx, 0 if a.x <= 0 |
+// | max   | max  rd, ra, rb    | max(a, b) (per component)          |
+// | min   | min  rd, ra, rb    | min(a, b) (per component)          |
+// | mov   | mov  rd, ra        | a                                  |
+// | const | const rd, name     | constant k                         |
+// | splat | splat rd, ra.y     | a[k].xxx                           |
+//
+// Arithmetic wraps (CLIP = 0) and truncates, as in rt_rgu_5_stage. A
+// fragment starts with the ray direction in r0 and the ray origin in r1,
+// the other registers are undefined. r0 holds the result.
+//
+// The program is loaded over the configuration stream of the core: a
+// header word {constants, instructions} (16 bits each), the instructions,
+// then three words per constant.
+
+#define SHADER_REGS 8
+#define SHADER_CONSTS 16
+#define SHADER_IMEM_DEPTH 256
+#define SHADER_INPUT_REGS 2 // r0 = ray direction, r1 = ray origin
+
+enum shader_op {
+  SHADER_NOP = 0,
+  SHADER_ADD = 1,
+  SHADER_SUB = 2,
+  SHADER_MUL = 3,
+  SHADER_DOT = 4,
+  SHADER_LERP = 5,
+  SHADER_RSQ = 6,
+  SHADER_MAX = 7,
+  SHADER_MIN = 8,
+  SHADER_MOV = 9,
+  SHADER_CONST = 10,
+  SHADER_SPLAT = 11,
+};
+
+struct shader_inst {
+  shader_op op = SHADER_NOP;
+  uint32_t d = 0;
+  uint32_t a = 0;
+  uint32_t b = 0;
+  uint32_t c = 0;
+  uint32_t k = 0;
+
+  uint32_t encode() const {
+    return (uint32_t(op) & 0xf) << 28 | (d & 0xf) << 24 | (a & 0xf) << 20 |
+           (b & 0xf) << 16 | (c & 0xf) << 12 | (k & 0xf);
+  }
+
+  static shader_inst decode(uint32_t word) {
+    shader_inst i;
+    i.op = shader_op(word >> 28);
+    i.d = (word >> 24) & 0xf;
+    i.a = (word >> 20) & 0xf;
+    i.b = (word >> 16) & 0xf;
+    i.c = (word >> 12) & 0xf;
+    i.k = word & 0xf;
+    return i;
+  }
+};
+
+struct shader_program {
+  std::vector<uint32_t> code;
+  std::vector<std::array<int64_t, 3>> constants; // Raw fixed-point values
+
+  // Words of the configuration stream
+  std::vector<uint32_t> stream() const {
+    std::vector<uint32_t> words;
+    words.push_back(uint32_t(constants.size()) << 16 | uint32_t(code.size()));
+    words.insert(words.end(), code.begin(), code.end());
+    for (const auto &k : constants) {
+      for (int64_t v : k) {
+        words.push_back(uint32_t(v));
+      }
+    }
+    return words;
+  }
+};
+
+#pragma mark - Assembler
+
+struct shader_mnemonic {
+  const char *name;
+  shader_op op;
+  const char *operands; // d = register, a/b/c = register, k = constant
+};
+
+static const shader_mnemonic SHADER_MNEMONICS[] = {
+    {"nop", SHADER_NOP, ""},        {"add", SHADER_ADD, "dab"},
+    {"sub", SHADER_SUB, "dab"},     {"mul", SHADER_MUL, "dab"},
+    {"dot", SHADER_DOT, "dab"},     {"lerp", SHADER_LERP, "dabc"},
+    {"rsq", SHADER_RSQ, "da"},      {"max", SHADER_MAX, "dab"},
+    {"min", SHADER_MIN, "dab"},     {"mov", SHADER_MOV, "da"},
+    {"const", SHADER_CONST, "dk"},  {"splat", SHADER_SPLAT, "ds"},
+};
+
+inline std::string shader_disassemble(uint32_t word) {
+  shader_inst i = shader_inst::decode(word);
+  for (const shader_mnemonic &m : SHADER_MNEMONICS) {
+    if (m.op != i.op) {
+      continue;
+    }
+    std::string s = m.name;
+    const char *sep = " ";
+    for (const char *o = m.operands; *o; o++) {
+      s += sep;
+      sep = ", ";
+      switch (*o) {
+      case 'd':
+        s += "r" + std::to_string(i.d);
+        break;
+      case 'a':
+        s += "r" + std::to_string(i.a);
+        break;
+      case 'b':
+        s += "r" + std::to_string(i.b);
+        break;
+      case 'c':
+        s += "r" + std::to_string(i.c);
+        break;
+      case 'k':
+        s += "c" + std::to_string(i.k);
+        break;
+      case 's':
+        s += "r" + std::to_string(i.a) + "." + "xyz"[i.k % 3];
+        break;
+      }
+    }
+    return s;
+  }
+  return "?";
+}
+
+// Assemble one instruction per line. ';' starts a comment. Constants are
+// declared before use with ".const <name> <x> <y> <z>", rounded to the
+// nearest value in f, and referenced by name or as cN. Returns false with
+// the line number in error.
+inline bool shader_assemble(const std::string &source, shader_program &program,
+                            std::string &error,
+                            sfp_format f = {FP_IW, FP_QW}) {
+  program = shader_program();
+  std::vector<std::string> constant_names;
+
+  auto fail = [&](int line, const std::string &message) {
+    error = "line " + std::to_string(line) + ": " + message;
+    return false;
+  };
+
+  auto parse_register = [](const std::string &s, uint32_t &r) {
+    char *end;
+    if (s.size() < 2 || s[0] != 'r') {
+      return false;
+    }
+    unsigned long v = std::strtoul(s.c_str() + 1, &end, 10);
+    if (*end || v >= SHADER_REGS) {
+      return false;
+    }
+    r = uint32_t(v);
+    return true;
+  };
+
+  std::istringstream in(source);
+  std::string text;
+  int line = 0;
+  while (std::getline(in, text)) {
+    line += 1;
+    text = text.substr(0, text.find(';'));
+    for (char &ch : text) {
+      if (ch == ',') {
+        ch = ' ';
+      }
+    }
+    std::istringstream tokens(text);
+    std::vector<std::string> t;
+    for (std::string s; tokens >> s;) {
+      t.push_back(s);
+    }
+    if (t.empty()) {
+      continue;
+    }
+
+    if (t[0] == ".const") {
+      if (t.size() != 5) {
+        return fail(line, "expected .const <name> <x> <y> <z>");
+      }
+      if (program.constants.size() == SHADER_CONSTS) {
+        return fail(line, "more than " + std::to_string(SHADER_CONSTS) +
+                              " constants");
+      }
+      std::array<int64_t, 3> k;
+      for (int i = 0; i < 3; i++) {
+        char *end;
+        double v = std::strtod(t[2 + i].c_str(), &end);
+        if (*end) {
+          return fail(line, "invalid number " + t[2 + i]);
+        }
+        k[i] = sfp_from_float(v, f, SFP_ROUND_HALF_EVEN);
+      }
+      constant_names.push_back(t[1]);
+      program.constants.push_back(k);
+      continue;
+    }
+
+    const shader_mnemonic *m = nullptr;
+    for (const shader_mnemonic &candidate : SHADER_MNEMONICS) {
+      if (t[0] == candidate.name) {
+        m = &candidate;
+      }
+    }
+    if (!m) {
+      return fail(line, "unknown instruction " + t[0]);
+    }
+    std::string operands = m->operands;
+    if (t.size() != operands.size() + 1) {
+      return fail(line, t[0] + " takes " + std::to_string(operands.size()) +
+                            " operands");
+    }
+
+    shader_inst inst;
+    inst.op = m->op;
+    for (size_t i = 0; i < operands.size(); i++) {
+      const std::string &s = t[i + 1];
+      bool ok = true;
+      switch (operands[i]) {
+      case 'd':
+        ok = parse_register(s, inst.d);
+        break;
+      case 'a':
+        ok = parse_register(s, inst.a);
+        break;
+      case 'b':
+        ok = parse_register(s, inst.b);
+        break;
+      case 'c':
+        ok = parse_register(s, inst.c);
+        break;
+      case 'k': {
+        ok = false;
+        for (size_t n = 0; n < constant_names.size(); n++) {
+          if (constant_names[n] == s) {
+            inst.k = uint32_t(n);
+            ok = true;
+          }
+        }
+        // cN as printed by shader_disassemble
+        char *end;
+        unsigned long n = std::strtoul(s.c_str() + 1, &end, 10);
+        if (!ok && s.size() > 1 && s[0] == 'c' && !*end &&
+            n < program.constants.size()) {
+          inst.k = uint32_t(n);
+          ok = true;
+        }
+        if (!ok) {
+          return fail(line, "undefined constant " + s);
+        }
+        break;
+      }
+      case 's': {
+        static const char axes[] = "xyz";
+        size_t dot = s.find('.');
+        ok = dot != std::string::npos && dot + 2 == s.size() &&
+             parse_register(s.substr(0, dot), inst.a);
+        const char *component = ok ? std::strchr(axes, s[dot + 1]) : nullptr;
+        ok = ok && component;
+        if (ok) {
+          inst.k = uint32_t(component - axes);
+        }
+        break;
+      }
+      }
+      if (!ok) {
+        return fail(line, "invalid operand " + s);
+      }
+    }
+
+    if (program.code.size() == SHADER_IMEM_DEPTH) {
+      return fail(line, "more than " + std::to_string(SHADER_IMEM_DEPTH) +
+                            " instructions");
+    }
+    program.code.push_back(inst.encode());
+  }
+
+  if (program.code.empty()) {
+    return fail(line, "empty program");
+  }
+  return true;
+}
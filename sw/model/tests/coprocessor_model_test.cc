@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+
+#include "coprocessor_model.hpp"
+
+namespace {
+
+class CoprocessorModelTest : public testing::Test {};
+
+// Cycle counts of coprocessor_bench for the current RTL
+TEST_F(CoprocessorModelTest, MatchesRtlWithoutBackpressure) {
+  coprocessor_model model;
+  frame_timing t = model.run(16, 9);
+
+  EXPECT_EQ(t.pixels, 144u);
+  EXPECT_EQ(t.beats, 144u);
+  EXPECT_EQ(t.first_upload, 1u);
+  EXPECT_EQ(t.upload_cycles, uint64_t(COPROCESSOR_PAYLOAD_WORDS));
+  EXPECT_EQ(t.fill_cycles, 7u);
+  EXPECT_EQ(t.stream_cycles, 144u);
+  EXPECT_EQ(t.drain_cycles, 1u);
+  EXPECT_EQ(t.stalls, 0u);
+  EXPECT_EQ(t.period(), 144u + 35u);
+}
+
+// The objects of the scene extend the upload by one word per clock
+TEST_F(CoprocessorModelTest, SceneUpload) {
+  coprocessor_config config;
+  config.scene_upload = true;
+  config.scene_words = 300;
+  frame_timing t = coprocessor_model(config).run(16, 9);
+  frame_timing camera = coprocessor_model().run(16, 9);
+
+  EXPECT_EQ(t.upload_cycles, uint64_t(COPROCESSOR_PAYLOAD_WORDS + 301));
+  EXPECT_EQ(t.fill_cycles, camera.fill_cycles);
+  EXPECT_EQ(t.period(), camera.period() + 301);
+}
+
+TEST_F(CoprocessorModelTest, EmptyFrame) {
+  coprocessor_model model;
+  for (frame_timing t : {model.run(0, 9), model.run(16, 0)}) {
+    EXPECT_FALSE(t.timed_out);
+    EXPECT_EQ(t.pixels, 0u);
+    EXPECT_EQ(t.period(), 0u);
+  }
+}
+
+// A DMA that never accepts a beat ends the simulation instead of hanging it
+TEST_F(CoprocessorModelTest, StalledSinkTimesOut) {
+  coprocessor_config config;
+  config.max_idle_cycles = 1000;
+  frame_timing t = coprocessor_model(config).run(
+      16, 9, [] { return true; }, [] { return false; });
+  EXPECT_TRUE(t.timed_out);
+
+  t = coprocessor_model(config).run(16, 9, [] { return false; },
+                                    [] { return true; });
+  EXPECT_TRUE(t.timed_out);
+  EXPECT_FALSE(coprocessor_model(config).run(16, 9).timed_out);
+}
+
+TEST_F(CoprocessorModelTest, BackpressureStallsThePipeline) {
+  std::mt19937 rng(3);
+  std::bernoulli_distribution half(0.5);
+  auto always = [] { return true; };
+  auto random = [&] { return half(rng); };
+
+  coprocessor_model model;
+  frame_timing t = model.run(64, 36, always, random);
+
+  // Without a FIFO every stall on m_axis stalls rt_core, and no beat is lost
+  EXPECT_GT(t.stalls, 0u);
+  EXPECT_EQ(t.core_stalls, t.stalls);
+  EXPECT_EQ(t.stream_cycles, t.beats + t.stalls);
+  EXPECT_EQ(t.fill_cycles, 7u);
+}
+
+TEST_F(CoprocessorModelTest, StarvedUpload) {
+  int cycle = 0;
+  auto every_third = [&] { return cycle++ % 3 == 0; };
+  auto always = [] { return true; };
+
+  coprocessor_model model;
+  frame_timing t = model.run(16, 9, every_third, always);
+  EXPECT_GT(t.upload_cycles, uint64_t(2 * COPROCESSOR_PAYLOAD_WORDS));
+  EXPECT_EQ(t.fill_cycles, 7u);
+  EXPECT_EQ(t.stream_cycles, 144u);
+}
+
+TEST_F(CoprocessorModelTest, LanesAndDepth) {
+  coprocessor_model wide({.lanes = 4});
+  frame_timing t = wide.run(1920, 1080);
+  EXPECT_EQ(t.beats, 1920u * 1080u / 4);
+  EXPECT_EQ(t.stream_cycles, t.beats);
+
+  // Ragged last beat
+  EXPECT_EQ(wide.run(7, 1).beats, 2u);
+
+  for (uint32_t depth = 1; depth <= 12; depth++) {
+    coprocessor_model model({.depth = depth});
+    frame_timing d = model.run(16, 9);
+    EXPECT_EQ(d.fill_cycles, depth + 2) << "depth " << depth;
+    EXPECT_EQ(d.stream_cycles, 144u) << "depth " << depth;
+  }
+}
+
+TEST_F(CoprocessorModelTest, FifoAbsorbsBackpressure) {
+  // The DMA pauses once for four cycles shortly after the first beat
+  auto make_ready = [](int &cycle) {
+    return [&cycle] {
+      int c = cycle++;
+      return c < 40 || c >= 44;
+    };
+  };
+  auto always = [] { return true; };
+
+  int c0 = 0;
+  frame_timing direct =
+      coprocessor_model().run(64, 36, always, make_ready(c0));
+  EXPECT_EQ(direct.stalls, 4u);
+  EXPECT_EQ(direct.core_stalls, 4u);
+
+  int c1 = 0;
+  frame_timing fifo =
+      coprocessor_model({.fifo_depth = 8}).run(64, 36, always, make_ready(c1));
+  EXPECT_EQ(fifo.stalls, 4u);
+  EXPECT_EQ(fifo.core_stalls, 0u);
+
+  // A registered full flag still sustains one beat per cycle
+  frame_timing full_rate = coprocessor_model({.fifo_depth = 1}).run(64, 36);
+  EXPECT_EQ(full_rate.stream_cycles, full_rate.beats);
+  EXPECT_EQ(full_rate.core_stalls, 0u);
+}
+
+TEST_F(CoprocessorModelTest, SampledFrameIsExtrapolated) {
+  coprocessor_model model;
+  frame_timing full = model.run(1280, 720);
+  frame_timing sampled = model.run(1280, 720, 4096);
+  EXPECT_EQ(sampled.period(), full.period());
+  EXPECT_EQ(sampled.beats, full.beats);
+
+  std::mt19937 rng_full(9), rng_sampled(9);
+  std::bernoulli_distribution p(0.75);
+  auto always = [] { return true; };
+  auto ready_full = [&] { return p(rng_full); };
+  auto ready_sampled = [&] { return p(rng_sampled); };
+
+  full = model.run(1280, 720, always, ready_full);
+  sampled = model.run(1280, 720, always, ready_sampled, 65536);
+  EXPECT_NEAR(double(sampled.period()) / double(full.period()), 1.0, 0.01);
+}
+
+TEST_F(CoprocessorModelTest, RegisterEstimate) {
+  // rt_rgu_5_stage: 20 words of stage registers, plus the output register
+  EXPECT_EQ(coprocessor_config{}.register_bits(), 21u * 32u);
+  EXPECT_EQ(coprocessor_config({.lanes = 2, .fifo_depth = 3}).register_bits(),
+            2u * 24u * 32u);
+}
+
+} // namespace
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+#include "precision.hpp"
+#include "scene.hpp"
+
+namespace {
+
+class PrecisionTest : public testing::Test {};
+
+TEST_F(PrecisionTest, ResizeTruncatesAndWraps) {
+  sfp_format f = {4, 4};
+
+  // -0.5 * 0.0625: floor toward -inf
+  int64_t a = sfp_from_float(-0.5, f);
+  int64_t b = sfp_from_float(0.0625, f);
+  EXPECT_EQ(sfp_mul(a, b, f), -1);
+  EXPECT_EQ(sfp_mul(-a, b, f), 0);
+
+  // 7.5 + 1 wraps to -7.5 in 4.4
+  EXPECT_EQ(sfp_to_double(sfp_add(sfp_from_float(7.5, f),
+                                  sfp_from_float(1.0, f), f),
+                          f),
+            -7.5);
+
+  // FLOAT_2_FIX truncates toward zero
+  EXPECT_EQ(sfp_from_float(-0.03, f), 0);
+  EXPECT_EQ(sfp_from_float(0.99, f), 15);
+}
+
+TEST_F(PrecisionTest, ResizeRounding) {
+  sfp_format in = {4, 4};
+  sfp_format out = {4, 2};
+
+  // Raw values in 4.4 and their 4.2 results: truncate, half up, half even
+  const int64_t cases[][4] = {
+      {5, 1, 1, 1},        // 0.3125
+      {6, 1, 2, 2},        // 0.375, tie
+      {2, 0, 1, 0},        // 0.125, tie to even
+      {-6, -2, -1, -2},    // -0.375, tie
+      {-7, -2, -2, -2},    // -0.4375
+      {127, 31, -32, -32}, // 7.9375 carries out of 4.2 and wraps
+  };
+  for (const auto &c : cases) {
+    EXPECT_EQ(sfp_resize(c[0], in, out, SFP_TRUNCATE), c[1]) << c[0];
+    EXPECT_EQ(sfp_resize(c[0], in, out, SFP_ROUND_HALF_UP), c[2]) << c[0];
+    EXPECT_EQ(sfp_resize(c[0], in, out, SFP_ROUND_HALF_EVEN), c[3]) << c[0];
+  }
+  EXPECT_EQ(sfp_resize_clip(127, in, out, SFP_ROUND_HALF_UP), 31);
+
+  // Unbiased on average, unlike truncation
+  int64_t sum[3] = {};
+  for (int64_t v = -128; v < 128; v++) {
+    for (int r = 0; r < 3; r++) {
+      sum[r] += sfp_resize_clip(v, {8, 4}, {8, 2}, sfp_round(r)) * 4 - v;
+    }
+  }
+  EXPECT_EQ(sum[SFP_TRUNCATE], -256 * 3 / 2);
+  EXPECT_EQ(sum[SFP_ROUND_HALF_EVEN], 0);
+
+  EXPECT_EQ(sfp_from_float(-0.03, in, SFP_ROUND_HALF_UP), 0);
+  EXPECT_EQ(sfp_from_float(0.99, in, SFP_ROUND_HALF_UP), 16);
+  EXPECT_EQ(sfp_from_float(0.09375, in, SFP_ROUND_HALF_EVEN), 2);
+}
+
+// Rounded pixel deltas drift half as fast as truncated ones
+TEST_F(PrecisionTest, RoundingNarrowsTheFormat) {
+  Scene scene(1920.0f, 16.0f / 9.0f, 1.0f);
+  EXPECT_GT(rgu_error(scene, {12, 19}, 4).pixels, 0.25);
+  EXPECT_LT(rgu_error(scene, {12, 19}, 1, 0, SFP_ROUND_HALF_EVEN).pixels,
+            0.25);
+}
+
+// Same values as the serialised camera and the coprocessor output
+TEST_F(PrecisionTest, MatchesTheRtlFormat) {
+  sfp_format f = {FP_IW, FP_QW};
+  Scene scene(400.0f, 16.0f / 9.0f, 1.0f);
+  rgu_camera cam = rgu_quantise(scene, f);
+  Scene::camera raw = scene.raw_camera();
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(uint32_t(cam.pixel_00_loc[i]), raw.pixel_00_loc[i]);
+    EXPECT_EQ(uint32_t(cam.pixel_delta_u[i]), raw.pixel_delta_u[i]);
+    EXPECT_EQ(uint32_t(cam.pixel_delta_v[i]), raw.pixel_delta_v[i]);
+  }
+
+  // The frame and tolerance of coprocessor_test.cc
+  Scene small(10.0f, 16.0f / 9.0f, 1.0f);
+  precision_error e = rgu_error(small, f);
+  EXPECT_EQ(e.samples, 10u * 5u);
+  EXPECT_LT(e.max, 0.00005);
+  EXPECT_FALSE(e.exceeded);
+
+  // The truncated pixel deltas accumulate along a row
+  precision_error wide = rgu_error(scene, f);
+  EXPECT_EQ(wide.samples, 400u * 225u);
+  EXPECT_GT(wide.max, e.max);
+}
+
+TEST_F(PrecisionTest, NarrowFormats) {
+  Scene scene(1920.0f, 16.0f / 9.0f, 1.0f);
+
+  // x = 1919 does not fit into 8 integer bits
+  EXPECT_TRUE(rgu_error(scene, {8, 16}, 1, 0.5).exceeded);
+
+  // Fewer fractional bits, larger error
+  double previous = 0;
+  for (int qw = 20; qw >= 8; qw -= 4) {
+    precision_error e = rgu_error(scene, {13, qw}, 7);
+    EXPECT_GT(e.max, previous) << "qw " << qw;
+    EXPECT_GE(e.max, e.rms);
+    previous = e.max;
+  }
+}
+
+// The RGU products keep all bits in the 27x18 DSP48E2 operands
+TEST_F(PrecisionTest, RguDspProductsAreExact) {
+  const sfp_format formats[] = {{16, 16}, {13, 23}, {12, 21}, {11, 14}};
+  for (sfp_format f : formats) {
+    ASSERT_TRUE(rgu_uses_dsp(f));
+    for (float focal : {0.5f, 4.0f}) {
+      Scene scene(3840.0f, 16.0f / 9.0f, focal);
+      rgu_camera cam = rgu_quantise(scene, f);
+      for (int x = 0; x < int(scene.image_width); x++) {
+        int64_t x_fp = sfp_wrap(__int128(x) << f.qw, f.wl());
+        for (int i = 0; i < 3; i++) {
+          ASSERT_EQ(sfp_mul_dsp(cam.pixel_delta_u[i], x_fp, f, 27 - f.qw,
+                                f.iw),
+                    sfp_mul(cam.pixel_delta_u[i], x_fp, f))
+              << f.iw << "." << f.qw << " x " << x;
+        }
+      }
+    }
+  }
+}
+
+// Outside the narrow formats the error is bounded as documented in sfp_mul
+TEST_F(PrecisionTest, DspProductError) {
+  sfp_format f = {16, 16};
+  int64_t x = sfp_from_float(3.14159, f); // 11.16: exact
+  int64_t y = sfp_from_float(2.71828, f); // 16.2: truncated
+  double exact = sfp_to_double(x, f) * sfp_to_double(y, f);
+  double narrow = sfp_to_double(sfp_mul_dsp(x, y, f, 11, 16), f);
+  double bound = std::fabs(sfp_to_double(x, f)) * 0.25 + std::ldexp(1.0, -18) +
+                 std::ldexp(1.0, -16);
+  EXPECT_NE(narrow, exact);
+  EXPECT_LE(std::fabs(narrow - exact), bound);
+
+  // Saturation of the operands
+  int64_t big = sfp_from_float(2000.0, f);
+  EXPECT_EQ(sfp_mul_dsp(big, sfp_from_float(1.0, f), f, 11, 16),
+            sfp_from_float(1024.0, f) - 1);
+}
+
+TEST_F(PrecisionTest, Dsp48e2Tiling) {
+  EXPECT_EQ(dsp48e2_per_multiplier(16, 16), 1);
+  EXPECT_EQ(dsp48e2_per_multiplier(27, 18), 1);
+  EXPECT_EQ(dsp48e2_per_multiplier(18, 27), 1);
+  EXPECT_EQ(dsp48e2_per_multiplier(24, 24), 2);
+  EXPECT_EQ(dsp48e2_per_multiplier(32, 32), 4);
+}
+
+} // namespace
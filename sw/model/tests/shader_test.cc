@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "shader_interpreter.hpp"
+#include "shader_isa.hpp"
+
+namespace {
+
+class ShaderTest : public testing::Test {
+protected:
+  sfp_format f = {FP_IW, FP_QW};
+
+  shader_vec vec(double x, double y, double z) {
+    return {sfp_from_float(x, f), sfp_from_float(y, f), sfp_from_float(z, f)};
+  }
+
+  shader_program assemble(const std::string &source) {
+    shader_program program;
+    std::string error;
+    EXPECT_TRUE(shader_assemble(source, program, error)) << error;
+    return program;
+  }
+};
+
+TEST_F(ShaderTest, AssemblerRoundTrip) {
+  shader_program p = assemble(".const sky 0.5 0.7 1.0\n"
+                              "add r2, r0, r1 ; comment\n"
+                              "lerp r0, r3, r4, r2\n"
+                              "const r5, sky\n"
+                              "splat r6, r7.z\n"
+                              "rsq r2, r2\n"
+                              "nop\n");
+  ASSERT_EQ(p.code.size(), 6u);
+  ASSERT_EQ(p.constants.size(), 1u);
+  EXPECT_EQ(p.code[0], 0x12010000u);
+  EXPECT_EQ(shader_disassemble(p.code[1]), "lerp r0, r3, r4, r2");
+  EXPECT_EQ(shader_disassemble(p.code[2]), "const r5, c0");
+  EXPECT_EQ(shader_disassemble(p.code[3]), "splat r6, r7.z");
+
+  // The disassembly assembles to the same words
+  std::string source = ".const sky 0.5 0.7 1.0\n";
+  for (uint32_t word : p.code) {
+    source += shader_disassemble(word) + "\n";
+  }
+  EXPECT_EQ(assemble(source).code, p.code);
+
+  // Header, code, constants
+  std::vector<uint32_t> words = p.stream();
+  ASSERT_EQ(words.size(), 1u + 6u + 3u);
+  EXPECT_EQ(words[0], (1u << 16) | 6u);
+  EXPECT_EQ(words[7], uint32_t(sfp_from_float(0.5, f)));
+}
+
+TEST_F(ShaderTest, AssemblerErrors) {
+  const std::pair<const char *, const char *> cases[] = {
+      {"add r0, r1", "line 1: add takes 3 operands"},
+      {"\nfoo r0", "line 2: unknown instruction foo"},
+      {"mov r8, r0", "line 1: invalid operand r8"},
+      {"const r0, sky", "line 1: undefined constant sky"},
+      {"splat r0, r1.w", "line 1: invalid operand r1.w"},
+      {".const one 1 1", "line 1: expected .const <name> <x> <y> <z>"},
+      {"; nothing", "line 1: empty program"},
+  };
+  for (const auto &[source, message] : cases) {
+    shader_program p;
+    std::string error;
+    EXPECT_FALSE(shader_assemble(source, p, error)) << source;
+    EXPECT_EQ(error, message);
+  }
+}
+
+TEST_F(ShaderTest, Operations) {
+  shader_program p = assemble(".const k 2 -3 0.25\n"
+                              "add r2, r0, r1\n"
+                              "sub r3, r0, r1\n"
+                              "mul r4, r0, r1\n"
+                              "dot r5, r0, r1\n"
+                              "max r6, r0, r1\n"
+                              "min r7, r0, r1\n");
+  shader_interpreter shader(p);
+  shader.run(vec(1.5, -2, 0.5), vec(0.5, 4, -1));
+  EXPECT_EQ(shader.reg(2), vec(2, 2, -0.5));
+  EXPECT_EQ(shader.reg(3), vec(1, -6, 1.5));
+  EXPECT_EQ(shader.reg(4), vec(0.75, -8, -0.5));
+  EXPECT_EQ(shader.reg(5), vec(-8. + 0.25, -8 + 0.25, -8 + 0.25));
+  EXPECT_EQ(shader.reg(6), vec(1.5, 4, 0.5));
+  EXPECT_EQ(shader.reg(7), vec(0.5, -2, -1));
+
+  p = assemble(".const k 2 -3 0.25\n"
+               "const r2, k\n"
+               "splat r3, r2.y\n"
+               "lerp r4, r0, r1, r2\n"
+               "mov r0, r4\n");
+  shader_interpreter lerp(p);
+  shader_vec r = lerp.run(vec(1, 1, 1), vec(3, 5, -1));
+  EXPECT_EQ(lerp.reg(2), vec(2, -3, 0.25));
+  EXPECT_EQ(lerp.reg(3), vec(-3, -3, -3));
+  EXPECT_EQ(r, vec(5, -11, 0.5));
+}
+
+// Wraps like the rest of the datapath
+TEST_F(ShaderTest, Wraps) {
+  shader_interpreter shader(assemble("add r0, r0, r1\n"));
+  double max = std::ldexp(1.0, FP_IW - 1);
+  shader_vec r = shader.run(vec(max - 1, 0, 0), vec(1, 0, 0));
+  EXPECT_EQ(sfp_to_double(r[0], f), -max);
+}
+
+TEST_F(ShaderTest, Rsqrt) {
+  // One Goldschmidt iteration on a 16-entry table: within 0.04 % plus the
+  // truncation of the three products
+  double worst = 0;
+  for (double s = 1.0 / 256; s < 16384; s *= 1.0137) {
+    int64_t v = sfp_from_float(s, f);
+    double exact = 1.0 / std::sqrt(sfp_to_double(v, f));
+    double est = sfp_to_double(shader_rsqrt_estimate(v, f), f);
+    double y = sfp_to_double(shader_rsqrt(v, f), f);
+    ASSERT_LT(std::fabs(est - exact) / exact, 0.032) << s;
+    double error = std::fabs(y - exact) - 4 * std::ldexp(1.0, -FP_QW);
+    worst = std::max(worst, error / exact);
+  }
+  EXPECT_LT(worst, 0.0004);
+
+  EXPECT_EQ(shader_rsqrt(0, f), 0);
+  EXPECT_EQ(shader_rsqrt(sfp_from_float(-4, f), f), 0);
+  EXPECT_NEAR(sfp_to_double(shader_rsqrt(sfp_from_float(4, f), f), f), 0.5,
+              0.5 * 0.0004);
+}
+
+// sw/shaders/sky.s, the background of "Ray Tracing in One Weekend"
+TEST_F(ShaderTest, Sky) {
+  shader_program p = assemble(".const one 1.0 1.0 1.0\n"
+                              ".const half 0.5 0.5 0.5\n"
+                              ".const blue 0.5 0.7 1.0\n"
+                              "dot r2, r0, r0\n"
+                              "rsq r2, r2\n"
+                              "mul r2, r0, r2\n"
+                              "splat r2, r2.y\n"
+                              "const r3, one\n"
+                              "add r2, r2, r3\n"
+                              "const r4, half\n"
+                              "mul r2, r2, r4\n"
+                              "const r4, blue\n"
+                              "lerp r0, r3, r4, r2\n");
+  shader_interpreter shader(p);
+  for (double y : {-1.0, -0.3, 0.0, 0.4, 1.0}) {
+    shader_vec r = shader.run(vec(0.3, y, -1), {});
+    double a = 0.5 * (y / std::sqrt(0.09 + y * y + 1) + 1);
+    EXPECT_NEAR(sfp_to_double(r[0], f), 1 - 0.5 * a, 0.001) << y;
+    EXPECT_NEAR(sfp_to_double(r[1], f), 1 - 0.3 * a, 0.001) << y;
+    EXPECT_NEAR(sfp_to_double(r[2], f), 1, 0.001) << y;
+  }
+}
+
+} // namespace
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "frame_export.hpp"
+
+// Sky gradient as rendered by the MPSoC application: every row is a single
+// colour, lerped from white in the top row towards #7FB2FF in the bottom row.
+static frame gradient_frame(int width, int height) {
+  frame f(width, height);
+  for (int h = 0; h < height; h++) {
+    float a = float(h) / float(height);
+    uint8_t r = uint8_t(255 - a * 128);
+    uint8_t g = uint8_t(255 - a * 77);
+    for (int w = 0; w < width; w++) {
+      f.set(w, h, r, g, 255);
+    }
+  }
+  return f;
+}
+
+// Incompressible worst case
+static frame noise_frame(int width, int height) {
+  frame f(width, height);
+  std::mt19937 rng(42);
+  for (auto &c : f.rgb) {
+    c = uint8_t(rng());
+  }
+  return f;
+}
+
+static void BM_ExportFrame(benchmark::State &state,
+                           frame (*image)(int, int), frame_format format) {
+  int width = state.range(0);
+  int height = state.range(1);
+  frame f = image(width, height);
+  std::vector<uint8_t> out;
+  out.reserve(sizeof(frame_header) + qoi_max_size(width, height));
+
+  for (auto _ : state) {
+    out.clear();
+    export_frame(f, format, out);
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * f.rgb.size());
+  state.counters["bytes_per_frame"] = out.size();
+  state.counters["ratio"] = double(f.rgb.size()) / out.size();
+}
+
+static void BM_DecodeQoi(benchmark::State &state) {
+  frame f = gradient_frame(state.range(0), state.range(1));
+  std::vector<uint8_t> encoded;
+  encode_qoi(f, encoded);
+
+  frame decoded;
+  for (auto _ : state) {
+    decode_qoi(encoded.data(), encoded.size(), decoded);
+    benchmark::DoNotOptimize(decoded.rgb.data());
+  }
+  state.SetBytesProcessed(state.iterations() * f.rgb.size());
+}
+
+static void frame_sizes(benchmark::internal::Benchmark *b) {
+  b->Args({64, 32})->Args({400, 225})->Args({1280, 720})->Args({1920, 1080});
+}
+
+BENCHMARK_CAPTURE(BM_ExportFrame, ppm, gradient_frame, FRAME_FORMAT_PPM)
+    ->Apply(frame_sizes);
+BENCHMARK_CAPTURE(BM_ExportFrame, qoi, gradient_frame, FRAME_FORMAT_QOI)
+    ->Apply(frame_sizes);
+BENCHMARK_CAPTURE(BM_ExportFrame, qoi_noise, noise_frame, FRAME_FORMAT_QOI)
+    ->Apply(frame_sizes);
+BENCHMARK(BM_DecodeQoi)->Apply(frame_sizes);
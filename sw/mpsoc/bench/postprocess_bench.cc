@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "postprocess.hpp"
+#include "scene.hpp"
+
+// Coprocessor output for a frame of the given size
+static std::vector<uint32_t> rx_frame(int width) {
+  Scene scene(width, 16.0f / 9.0f, 1.0f);
+  std::vector<uint32_t> rx;
+  for (int h = 0; h < int(scene.image_height); h++) {
+    for (int w = 0; w < width; w++) {
+      vec3 ray_direction = scene.pixel_center(w, h) - scene.camera_center;
+      rx.push_back(uint32_t(FLOAT_2_FIX(ray_direction[1])));
+    }
+  }
+  return rx;
+}
+
+static void shade_frame_reference(const std::vector<uint32_t> &rx,
+                                  std::vector<uint8_t> &out) {
+  for (size_t i = 0; i < rx.size(); i++) {
+    rgb p = shade_sky_reference(rx[i]);
+    out[i * 3 + 0] = p.r;
+    out[i * 3 + 1] = p.g;
+    out[i * 3 + 2] = p.b;
+  }
+  benchmark::DoNotOptimize(out.data());
+}
+
+static void BM_ShadeReference(benchmark::State &state) {
+  std::vector<uint32_t> rx = rx_frame(state.range(0));
+  std::vector<uint8_t> out(rx.size() * 3);
+
+  for (auto _ : state) {
+    shade_frame_reference(rx, out);
+  }
+  state.SetItemsProcessed(state.iterations() * rx.size());
+}
+
+// "speedup" is the time per frame of the per-pixel reference, measured
+// before the run, over that of shade_sky()
+static void BM_ShadeBatch(benchmark::State &state) {
+  using clock = std::chrono::steady_clock;
+  std::vector<uint32_t> rx = rx_frame(state.range(0));
+  std::vector<uint8_t> out(rx.size() * 3);
+  default_gamma_lut();
+
+  int frames = 0;
+  clock::time_point start = clock::now();
+  while (clock::now() - start < std::chrono::milliseconds(100)) {
+    shade_frame_reference(rx, out);
+    frames += 1;
+  }
+  double reference = std::chrono::duration<double>(clock::now() - start)
+                         .count() / frames;
+
+  start = clock::now();
+  for (auto _ : state) {
+    shade_sky(rx.data(), rx.size(), out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  double batch = std::chrono::duration<double>(clock::now() - start).count() /
+                 double(state.iterations());
+
+  state.SetItemsProcessed(state.iterations() * rx.size());
+  state.counters["speedup"] = reference / batch;
+}
+
+BENCHMARK(BM_ShadeReference)->Arg(64)->Arg(400)->Arg(1280)->Arg(1920);
+BENCHMARK(BM_ShadeBatch)->Arg(64)->Arg(400)->Arg(1280)->Arg(1920);
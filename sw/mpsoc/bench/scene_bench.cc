@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <sstream>
+#include <vector>
+
+#include "color.hpp"
+#include "postprocess.hpp"
+#include "ray.hpp"
+#include "scene.hpp"
+#include "vec3.hpp"
+
+// Baseline for the per-pixel software path of the MPSoC application. All
+// kernels report pixels per second (items_per_second) for resolutions from
+// 64x32 up to 4K.
+
+static void resolutions(benchmark::internal::Benchmark *b) {
+  b->Args({64, 32})
+      ->Args({400, 225})
+      ->Args({1280, 720})
+      ->Args({1920, 1080})
+      ->Args({3840, 2160});
+}
+
+static Scene make_scene(benchmark::State &state) {
+  float width = state.range(0);
+  float height = state.range(1);
+  return Scene(width, width / height, 1.0f);
+}
+
+static size_t pixels(const Scene &scene) {
+  return size_t(scene.image_width) * size_t(scene.image_height);
+}
+
+// Coprocessor output: ray direction y per pixel in 16.16
+static std::vector<uint32_t> rx_frame(Scene &scene) {
+  std::vector<uint32_t> rx;
+  rx.reserve(pixels(scene));
+  for (int h = 0; h < int(scene.image_height); h++) {
+    for (int w = 0; w < int(scene.image_width); w++) {
+      vec3 ray_direction = scene.pixel_center(w, h) - scene.camera_center;
+      rx.push_back(uint32_t(FLOAT_2_FIX(ray_direction[1])));
+    }
+  }
+  return rx;
+}
+
+static std::vector<color> ray_colors(Scene &scene) {
+  std::vector<color> colors;
+  colors.reserve(pixels(scene));
+  for (uint32_t raw : rx_frame(scene)) {
+    ray r(vec3(0, 0, 0), vec3(0, FIX_2_FLOAT(raw), -1));
+    colors.push_back(ray_color(r));
+  }
+  return colors;
+}
+
+// Per frame cost, reported once per frame rather than per pixel
+static void BM_SceneConstruct(benchmark::State &state) {
+  float width = state.range(0);
+  float height = state.range(1);
+
+  for (auto _ : state) {
+    Scene scene(width, width / height, 1.0f);
+    benchmark::DoNotOptimize(scene);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_SceneSerialise(benchmark::State &state) {
+  Scene scene = make_scene(state);
+  uint32_t tx[SCENE_PAYLOAD_SIZE];
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scene);
+    uint32_t *cam = scene.serialised();
+    for (int i = 0; i < SCENE_PAYLOAD_SIZE; i++) {
+      tx[i] = cam[i];
+    }
+    benchmark::DoNotOptimize(tx);
+  }
+  state.SetBytesProcessed(state.iterations() * sizeof(tx));
+}
+
+static void BM_PixelCenter(benchmark::State &state) {
+  Scene scene = make_scene(state);
+  int width = int(scene.image_width);
+  int height = int(scene.image_height);
+
+  for (auto _ : state) {
+    for (int h = 0; h < height; h++) {
+      for (int w = 0; w < width; w++) {
+        vec3 p = scene.pixel_center(w, h);
+        benchmark::DoNotOptimize(p);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pixels(scene));
+}
+
+// The ray generation loop of the software reference in main.cc
+static void BM_RayLoop(benchmark::State &state) {
+  Scene scene = make_scene(state);
+  int width = int(scene.image_width);
+  int height = int(scene.image_height);
+
+  for (auto _ : state) {
+    for (int h = 0; h < height; h++) {
+      for (int w = 0; w < width; w++) {
+        auto pixel_center = scene.pixel_00_loc + (w * scene.pixel_delta_u) +
+                            (h * scene.pixel_delta_v);
+        auto ray_direction = pixel_center - scene.camera_center;
+        ray r(scene.camera_center, ray_direction);
+        benchmark::DoNotOptimize(r);
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * pixels(scene));
+}
+
+static void BM_FixToFloat(benchmark::State &state) {
+  Scene scene = make_scene(state);
+  std::vector<uint32_t> rx = rx_frame(scene);
+  std::vector<float> out(rx.size());
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < rx.size(); i++) {
+      out[i] = FIX_2_FLOAT(rx[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rx.size());
+}
+
+static void BM_RayColor(benchmark::State &state) {
+  Scene scene = make_scene(state);
+  std::vector<uint32_t> rx = rx_frame(scene);
+  std::vector<color> out(rx.size());
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < rx.size(); i++) {
+      ray r(vec3(0, 0, 0), vec3(0, FIX_2_FLOAT(rx[i]), -1));
+      out[i] = ray_color(r);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rx.size());
+}
+
+static void BM_GetRgb(benchmark::State &state) {
+  Scene scene = make_scene(state);
+  std::vector<color> colors = ray_colors(scene);
+  std::vector<rgb> out(colors.size());
+
+  for (auto _ : state) {
+    for (size_t i = 0; i < colors.size(); i++) {
+      out[i] = get_rgb(colors[i]);
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * colors.size());
+}
+
+// Text output as used by the former P3 export
+static void BM_WriteColor(benchmark::State &state) {
+  Scene scene = make_scene(state);
+  std::vector<color> colors = ray_colors(scene);
+  std::ostringstream out;
+
+  for (auto _ : state) {
+    out.str("");
+    for (const color &c : colors) {
+      write_color(out, c);
+    }
+    benchmark::DoNotOptimize(out.tellp());
+  }
+  state.SetItemsProcessed(state.iterations() * colors.size());
+}
+
+BENCHMARK(BM_SceneConstruct)->Apply(resolutions);
+BENCHMARK(BM_SceneSerialise)->Apply(resolutions);
+BENCHMARK(BM_PixelCenter)->Apply(resolutions);
+BENCHMARK(BM_RayLoop)->Apply(resolutions);
+BENCHMARK(BM_FixToFloat)->Apply(resolutions);
+BENCHMARK(BM_RayColor)->Apply(resolutions);
+BENCHMARK(BM_GetRgb)->Apply(resolutions);
+BENCHMARK(BM_WriteColor)->Apply(resolutions);
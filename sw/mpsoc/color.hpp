@@ -20,7 +20,7 @@ struct rgb {
   uint8_t b;
 };
 
-rgb get_rgb(const color &pixel_color) {
+inline rgb get_rgb(const color &pixel_color) {
   auto r = pixel_color.x();
   auto g = pixel_color.y();
   auto b = pixel_color.z();
@@ -40,7 +40,7 @@ rgb get_rgb(const color &pixel_color) {
   return s;
 }
 
-void write_color(std::ostream &out, const color &pixel_color) {
+inline void write_color(std::ostream &out, const color &pixel_color) {
   auto p = get_rgb(pixel_color);
   // Write out the pixel color components.
   out << unsigned(p.r) << ' ' << unsigned(p.g) << ' ' << unsigned(p.b) << '\n';
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Scatter-gather descriptor ring for the AXI DMA.
+//
+// The descriptor layout matches the AXI DMA buffer descriptor (PG021). On the
+// board, main.cc drives the real engine through the XAxiDma_BdRing API. This
+// header keeps a hardware-independent model of the same ring, so the
+// submission/completion bookkeeping can be tested on Linux.
+
+#define DMA_DESC_ALIGNMENT 64
+
+#define DMA_DESC_LEN_MASK 0x03ffffff // 26 bit buffer length
+#define DMA_DESC_CTRL_SOF (1u << 27)
+#define DMA_DESC_CTRL_EOF (1u << 26)
+
+#define DMA_DESC_STS_CMPLT (1u << 31)
+#define DMA_DESC_STS_DECERR (1u << 30)
+#define DMA_DESC_STS_SLVERR (1u << 29)
+#define DMA_DESC_STS_INTERR (1u << 28)
+#define DMA_DESC_STS_RXSOF (1u << 27)
+#define DMA_DESC_STS_RXEOF (1u << 26)
+#define DMA_DESC_STS_ERR_MASK                                                  \
+  (DMA_DESC_STS_DECERR | DMA_DESC_STS_SLVERR | DMA_DESC_STS_INTERR)
+
+struct __attribute__((aligned(DMA_DESC_ALIGNMENT))) dma_desc {
+  uint32_t next_desc;
+  uint32_t next_desc_msb;
+  uint32_t buffer_addr;
+  uint32_t buffer_addr_msb;
+  uint32_t reserved[2];
+  uint32_t control;
+  uint32_t status;
+  uint32_t app[5];
+
+  // Software only, ignored by the engine
+  uint32_t id;
+  uint32_t sw_reserved[2];
+
+  uintptr_t buffer() const {
+    return uintptr_t((uint64_t(buffer_addr_msb) << 32) | buffer_addr);
+  }
+  uint32_t length() const { return control & DMA_DESC_LEN_MASK; }
+  uint32_t transferred() const { return status & DMA_DESC_LEN_MASK; }
+  bool complete() const { return status & DMA_DESC_STS_CMPLT; }
+};
+
+static_assert(sizeof(dma_desc) == DMA_DESC_ALIGNMENT,
+              "Descriptor must fill exactly one alignment slot");
+
+// Number of descriptors needed to move len bytes when a single descriptor can
+// carry at most max_len bytes.
+inline size_t dma_desc_count(size_t len, size_t max_len) {
+  return len == 0 ? 1 : (len + max_len - 1) / max_len;
+}
+
+class dma_ring {
+public:
+  // descs must point to count descriptors aligned to DMA_DESC_ALIGNMENT.
+  // max_len is the largest buffer a single descriptor may carry (the
+  // "buffer length register width" of the engine).
+  dma_ring(dma_desc *descs, size_t count, uint32_t max_len = DMA_DESC_LEN_MASK)
+      : descs(descs), count(count), max_len(max_len & DMA_DESC_LEN_MASK) {
+    std::memset(descs, 0, count * sizeof(dma_desc));
+
+    // Link the descriptors into a circle
+    for (size_t i = 0; i < count; i++) {
+      uint64_t next = uint64_t(uintptr_t(&descs[(i + 1) % count]));
+      descs[i].next_desc = uint32_t(next);
+      descs[i].next_desc_msb = uint32_t(next >> 32);
+    }
+  }
+
+  size_t size() const { return count; }
+  size_t pending() const { return used; }
+  size_t free() const { return count - used; }
+  uint32_t max_length() const { return max_len; }
+
+  dma_desc &operator[](size_t i) { return descs[i % count]; }
+  const dma_desc &operator[](size_t i) const { return descs[i % count]; }
+
+  // Oldest descriptor that has not been reclaimed yet (the engine's CURDESC)
+  dma_desc *head() { return &descs[head_idx]; }
+  // Most recently submitted descriptor (the engine's TAILDESC)
+  dma_desc *tail() { return &descs[(head_idx + count + used - 1) % count]; }
+
+  // Queue len bytes at addr. Buffers longer than max_length() are split over
+  // several descriptors; SOF is placed on the first and EOF on the last of
+  // them when requested through flags. All descriptors carry the same id.
+  // Returns false, without queueing anything, if len is 0 or the ring is too
+  // full.
+  bool submit(uintptr_t addr, size_t len, uint32_t flags, uint32_t id) {
+    size_t needed = dma_desc_count(len, max_len);
+    if (len == 0 || needed > free()) {
+      return false;
+    }
+
+    for (size_t i = 0; i < needed; i++) {
+      size_t chunk = len > max_len ? max_len : len;
+      dma_desc &d = descs[(head_idx + used) % count];
+
+      uint32_t control = uint32_t(chunk);
+      if (i == 0) {
+        control |= flags & DMA_DESC_CTRL_SOF;
+      }
+      if (i == needed - 1) {
+        control |= flags & DMA_DESC_CTRL_EOF;
+      }
+
+      d.buffer_addr = uint32_t(uint64_t(addr));
+      d.buffer_addr_msb = uint32_t(uint64_t(addr) >> 32);
+      d.control = control;
+      d.status = 0;
+      d.id = id;
+
+      addr += chunk;
+      len -= chunk;
+      used += 1;
+    }
+    return true;
+  }
+
+  // Hand completed descriptors back to software, oldest first. Stops at the
+  // first descriptor the engine has not finished. For every descriptor
+  // on_complete(const dma_desc &) is called before its slot is reused.
+  // Returns the number of reclaimed descriptors.
+  template <typename F> size_t reclaim(F &&on_complete) {
+    size_t n = 0;
+    while (used > 0 && descs[head_idx].complete()) {
+      on_complete(static_cast<const dma_desc &>(descs[head_idx]));
+      descs[head_idx].status = 0;
+      head_idx = (head_idx + 1) % count;
+      used -= 1;
+      n += 1;
+    }
+    return n;
+  }
+
+private:
+  dma_desc *descs;
+  size_t count;
+  uint32_t max_len;
+
+  size_t head_idx = 0;
+  size_t used = 0;
+};
+
+// Functional model of one AXI DMA channel in scatter-gather mode. It walks
+// the descriptor chain from the ring head to the ring tail, exactly as the
+// engine follows CURDESC to TAILDESC, and writes back the status words.
+class dma_engine_model {
+public:
+  explicit dma_engine_model(dma_ring &ring) : ring(ring) {}
+
+  // S2MM: scatter one AXIS packet (terminated by tlast) into the queued
+  // buffers. Returns the number of bytes written. If the ring runs out of
+  // descriptors before the packet ends, the remainder is not consumed, like
+  // the engine holding tready low; the next call continues the packet with
+  // the bytes that were left over.
+  size_t s2mm(const void *packet, size_t len) {
+    const uint8_t *src = static_cast<const uint8_t *>(packet);
+    size_t written = 0;
+    bool sof = !in_packet;
+
+    for (size_t i = 0; i < ring.pending() && written < len; i++) {
+      dma_desc &d = ring[index(ring.head()) + i];
+      if (d.complete()) {
+        continue;
+      }
+
+      size_t chunk = d.length();
+      if (chunk > len - written) {
+        chunk = len - written;
+      }
+      std::memcpy(reinterpret_cast<void *>(d.buffer()), src + written, chunk);
+      written += chunk;
+
+      uint32_t status = DMA_DESC_STS_CMPLT | uint32_t(chunk);
+      if (sof) {
+        status |= DMA_DESC_STS_RXSOF;
+        sof = false;
+      }
+      if (written == len) {
+        status |= DMA_DESC_STS_RXEOF;
+      }
+      d.status = status;
+    }
+    in_packet = written < len;
+    return written;
+  }
+
+  // MM2S: gather the queued buffers into out until a descriptor with EOF has
+  // been sent. Returns the number of bytes read.
+  size_t mm2s(void *out, size_t capacity) {
+    uint8_t *dst = static_cast<uint8_t *>(out);
+    size_t read = 0;
+
+    for (size_t i = 0; i < ring.pending(); i++) {
+      dma_desc &d = ring[index(ring.head()) + i];
+      if (d.complete()) {
+        continue;
+      }
+
+      size_t chunk = d.length();
+      if (chunk > capacity - read) {
+        break;
+      }
+      std::memcpy(dst + read, reinterpret_cast<const void *>(d.buffer()),
+                  chunk);
+      read += chunk;
+      d.status = DMA_DESC_STS_CMPLT | uint32_t(chunk);
+
+      if (d.control & DMA_DESC_CTRL_EOF) {
+        break;
+      }
+    }
+    return read;
+  }
+
+  // Mark the next outstanding descriptor as failed with the given error bits
+  void fail_next(uint32_t error) {
+    for (size_t i = 0; i < ring.pending(); i++) {
+      dma_desc &d = ring[index(ring.head()) + i];
+      if (!d.complete()) {
+        d.status = DMA_DESC_STS_CMPLT | (error & DMA_DESC_STS_ERR_MASK);
+        return;
+      }
+    }
+  }
+
+private:
+  size_t index(const dma_desc *d) { return size_t(d - &ring[0]); }
+
+  dma_ring &ring;
+  bool in_packet = false;
+};
@@ -0,0 +1,393 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Binary frame export.
+//
+// A frame is a packed RGB888 buffer that is encoded either as a binary PPM
+// (P6) or with the QOI lossless image format (https://qoiformat.org). The
+// encoded image is prefixed with a small header, so the host can find frames
+// inside a UART capture that also contains log output, and then written with
+// a single bulk write.
+//
+// Log text and stage profiles (profile.hpp) are records of the same stream,
+// with their own formats and a width and height of 0. The host walks the
+// records in order and never searches inside a payload, so bytes of a frame
+// cannot be taken for another record. On the board, main.cc sends the stream
+// with outbyte() instead, since stdout would insert '\r' before every 0x0A
+// byte.
+
+#define FRAME_MAGIC "RTFB"
+
+enum frame_format : uint8_t {
+  FRAME_FORMAT_PPM = 0,
+  FRAME_FORMAT_QOI = 1,
+  FRAME_FORMAT_PROFILE = 2, // See export_profile()
+  FRAME_FORMAT_TEXT = 3,
+};
+
+// All fields are little-endian
+struct __attribute__((packed)) frame_header {
+  char magic[4];
+  uint8_t format;
+  uint8_t reserved[3];
+  uint16_t width;
+  uint16_t height;
+  uint32_t payload_length;
+};
+
+static_assert(sizeof(frame_header) == 16, "Header layout changed");
+
+struct frame {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgb; // width * height * 3 bytes
+
+  frame() {}
+  frame(int width, int height)
+      : width(width), height(height), rgb(size_t(width) * height * 3) {}
+
+  uint8_t *pixel(int x, int y) { return &rgb[(size_t(y) * width + x) * 3]; }
+  const uint8_t *pixel(int x, int y) const {
+    return &rgb[(size_t(y) * width + x) * 3];
+  }
+
+  void set(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t *p = pixel(x, y);
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+  }
+};
+
+#pragma mark - PPM
+
+inline size_t ppm_header(int width, int height, char *out, size_t len) {
+  return size_t(std::snprintf(out, len, "P6\n%d %d\n255\n", width, height));
+}
+
+inline void encode_ppm(const frame &f, std::vector<uint8_t> &out) {
+  char header[32];
+  size_t header_len = ppm_header(f.width, f.height, header, sizeof(header));
+
+  out.insert(out.end(), header, header + header_len);
+  out.insert(out.end(), f.rgb.begin(), f.rgb.end());
+}
+
+inline bool decode_ppm(const uint8_t *data, size_t len, frame &f) {
+  int width, height, maxval, consumed = 0;
+  std::string text(reinterpret_cast<const char *>(data),
+                   len < 32 ? len : 32);
+  if (std::sscanf(text.c_str(), "P6 %d %d %d%n", &width, &height, &maxval,
+                  &consumed) != 3 ||
+      maxval != 255 || width <= 0 || height <= 0) {
+    return false;
+  }
+  // Exactly one whitespace character separates maxval from the raster
+  size_t offset = size_t(consumed) + 1;
+  f = frame(width, height);
+  if (offset > len || len - offset < f.rgb.size()) {
+    return false;
+  }
+  std::memcpy(f.rgb.data(), data + offset, f.rgb.size());
+  return true;
+}
+
+#pragma mark - QOI
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+
+inline int qoi_hash(uint8_t r, uint8_t g, uint8_t b) {
+  // Alpha is always 255
+  return (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+}
+
+inline uint32_t qoi_get_be32(const uint8_t *p) {
+  return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) |
+         (uint32_t(p[2]) << 8) | p[3];
+}
+
+// Worst case: one QOI_OP_RGB (4 bytes) per pixel
+inline size_t qoi_max_size(int width, int height) {
+  return QOI_HEADER_SIZE + size_t(width) * height * 4 + QOI_PADDING_SIZE;
+}
+
+inline void encode_qoi(const frame &f, std::vector<uint8_t> &out) {
+  size_t start = out.size();
+  out.resize(start + qoi_max_size(f.width, f.height));
+  uint8_t *dst = out.data() + start;
+  size_t p = 0;
+
+  std::memcpy(dst, "qoif", 4);
+  dst[4] = uint8_t(f.width >> 24);
+  dst[5] = uint8_t(f.width >> 16);
+  dst[6] = uint8_t(f.width >> 8);
+  dst[7] = uint8_t(f.width);
+  dst[8] = uint8_t(f.height >> 24);
+  dst[9] = uint8_t(f.height >> 16);
+  dst[10] = uint8_t(f.height >> 8);
+  dst[11] = uint8_t(f.height);
+  dst[12] = 3; // RGB
+  dst[13] = 0; // sRGB with linear alpha
+  p = QOI_HEADER_SIZE;
+
+  uint8_t index[64][3] = {};
+  uint8_t pr = 0, pg = 0, pb = 0;
+  int run = 0;
+
+  const uint8_t *px = f.rgb.data();
+  const size_t len = f.rgb.size();
+  for (size_t i = 0; i < len; i += 3) {
+    uint8_t r = px[i], g = px[i + 1], b = px[i + 2];
+
+    if (r == pr && g == pg && b == pb) {
+      run += 1;
+      if (run == 62 || i + 3 == len) {
+        dst[p++] = QOI_OP_RUN | (run - 1);
+        run = 0;
+      }
+      continue;
+    }
+
+    if (run > 0) {
+      dst[p++] = QOI_OP_RUN | (run - 1);
+      run = 0;
+    }
+
+    int h = qoi_hash(r, g, b);
+    if (index[h][0] == r && index[h][1] == g && index[h][2] == b) {
+      dst[p++] = QOI_OP_INDEX | h;
+    } else {
+      index[h][0] = r;
+      index[h][1] = g;
+      index[h][2] = b;
+
+      int8_t vr = int8_t(r - pr);
+      int8_t vg = int8_t(g - pg);
+      int8_t vb = int8_t(b - pb);
+      int8_t vg_r = int8_t(vr - vg);
+      int8_t vg_b = int8_t(vb - vg);
+
+      if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+        dst[p++] = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+      } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 &&
+                 vg_b < 8) {
+        dst[p++] = QOI_OP_LUMA | (vg + 32);
+        dst[p++] = (vg_r + 8) << 4 | (vg_b + 8);
+      } else {
+        dst[p++] = QOI_OP_RGB;
+        dst[p++] = r;
+        dst[p++] = g;
+        dst[p++] = b;
+      }
+    }
+
+    pr = r;
+    pg = g;
+    pb = b;
+  }
+
+  static const uint8_t padding[QOI_PADDING_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+  std::memcpy(dst + p, padding, QOI_PADDING_SIZE);
+  p += QOI_PADDING_SIZE;
+
+  out.resize(start + p);
+}
+
+inline bool decode_qoi(const uint8_t *data, size_t len, frame &f) {
+  if (len < QOI_HEADER_SIZE + QOI_PADDING_SIZE ||
+      std::memcmp(data, "qoif", 4) != 0) {
+    return false;
+  }
+
+  uint32_t width = qoi_get_be32(data + 4);
+  uint32_t height = qoi_get_be32(data + 8);
+  if (width == 0 || height == 0 || width > 0xffff || height > 0xffff) {
+    return false;
+  }
+  f = frame(int(width), int(height));
+
+  uint8_t index[64][3] = {};
+  uint8_t r = 0, g = 0, b = 0;
+  int run = 0;
+
+  size_t p = QOI_HEADER_SIZE;
+  size_t chunks_end = len - QOI_PADDING_SIZE;
+  for (size_t i = 0; i < f.rgb.size(); i += 3) {
+    if (run > 0) {
+      run -= 1;
+    } else if (p < chunks_end) {
+      uint8_t b1 = data[p++];
+
+      if (b1 == QOI_OP_RGBA) {
+        // Never produced for RGB images
+        return false;
+      } else if (b1 == QOI_OP_RGB) {
+        r = data[p++];
+        g = data[p++];
+        b = data[p++];
+      } else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+        r = index[b1][0];
+        g = index[b1][1];
+        b = index[b1][2];
+      } else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+        r += ((b1 >> 4) & 0x03) - 2;
+        g += ((b1 >> 2) & 0x03) - 2;
+        b += (b1 & 0x03) - 2;
+      } else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+        uint8_t b2 = data[p++];
+        int vg = (b1 & 0x3f) - 32;
+        r += vg - 8 + ((b2 >> 4) & 0x0f);
+        g += vg;
+        b += vg - 8 + (b2 & 0x0f);
+      } else {
+        run = b1 & 0x3f;
+      }
+
+      int h = qoi_hash(r, g, b);
+      index[h][0] = r;
+      index[h][1] = g;
+      index[h][2] = b;
+    } else {
+      return false;
+    }
+
+    f.rgb[i] = r;
+    f.rgb[i + 1] = g;
+    f.rgb[i + 2] = b;
+  }
+  return true;
+}
+
+#pragma mark - Export
+
+// Encode f and prepend a frame_header. The result is appended to out, so a
+// single bulk write can send it.
+inline void export_frame(const frame &f, frame_format format,
+                         std::vector<uint8_t> &out) {
+  size_t header_pos = out.size();
+  out.resize(header_pos + sizeof(frame_header));
+
+  if (format == FRAME_FORMAT_QOI) {
+    encode_qoi(f, out);
+  } else {
+    encode_ppm(f, out);
+  }
+
+  frame_header header = {};
+  std::memcpy(header.magic, FRAME_MAGIC, 4);
+  header.format = format;
+  header.width = uint16_t(f.width);
+  header.height = uint16_t(f.height);
+  header.payload_length =
+      uint32_t(out.size() - header_pos - sizeof(frame_header));
+  std::memcpy(out.data() + header_pos, &header, sizeof(header));
+}
+
+// Append a record that is not an image
+inline void export_record(frame_format format, const void *payload,
+                          size_t len, std::vector<uint8_t> &out) {
+  frame_header header = {};
+  std::memcpy(header.magic, FRAME_MAGIC, 4);
+  header.format = format;
+  header.payload_length = uint32_t(len);
+
+  const uint8_t *h = reinterpret_cast<const uint8_t *>(&header);
+  const uint8_t *p = static_cast<const uint8_t *>(payload);
+  out.insert(out.end(), h, h + sizeof(header));
+  out.insert(out.end(), p, p + len);
+}
+
+inline void export_text(const std::string &text, std::vector<uint8_t> &out) {
+  export_record(FRAME_FORMAT_TEXT, text.data(), text.size(), out);
+}
+
+// Find the next record in a byte stream starting at offset, skipping any
+// bytes before it. Images are decoded into f and must match their header.
+// On success, header describes the record, its payload starts at byte
+// payload, and offset is moved past it.
+inline bool import_record(const uint8_t *data, size_t len, size_t &offset,
+                          frame_header &header, size_t &payload, frame &f) {
+  while (offset + sizeof(frame_header) <= len) {
+    static const char magic[] = FRAME_MAGIC;
+    const uint8_t *found =
+        std::search(data + offset, data + len, magic, magic + 4);
+    if (found == data + len) {
+      offset = len;
+      return false;
+    }
+    offset = size_t(found - data);
+
+    if (offset + sizeof(header) > len) {
+      return false;
+    }
+    std::memcpy(&header, data + offset, sizeof(header));
+
+    payload = offset + sizeof(header);
+    bool ok = payload + header.payload_length <= len;
+    switch (header.format) {
+    case FRAME_FORMAT_PPM:
+      ok = ok && decode_ppm(data + payload, header.payload_length, f) &&
+           f.width == header.width && f.height == header.height;
+      break;
+    case FRAME_FORMAT_QOI:
+      ok = ok && decode_qoi(data + payload, header.payload_length, f) &&
+           f.width == header.width && f.height == header.height;
+      break;
+    case FRAME_FORMAT_PROFILE:
+    case FRAME_FORMAT_TEXT:
+      ok = ok && header.width == 0 && header.height == 0;
+      break;
+    default:
+      ok = false;
+    }
+
+    if (ok) {
+      offset = payload + header.payload_length;
+      return true;
+    }
+
+    // False positive in log output or truncated record, keep searching
+    offset += 1;
+  }
+  return false;
+}
+
+// Find the next exported frame in a byte stream starting at offset. On
+// success, the decoded frame is stored in f and offset is moved past it.
+inline bool import_frame(const uint8_t *data, size_t len, size_t &offset,
+                         frame &f) {
+  frame_header header;
+  size_t payload;
+  while (import_record(data, len, offset, header, payload, f)) {
+    if (header.format == FRAME_FORMAT_PPM ||
+        header.format == FRAME_FORMAT_QOI) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Write the whole buffer with one call
+inline bool write_frame(std::FILE *out, const std::vector<uint8_t> &buf) {
+  size_t written = std::fwrite(buf.data(), 1, buf.size(), out);
+  std::fflush(out);
+  return written == buf.size();
+}
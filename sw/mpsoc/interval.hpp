@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <limits>
 
 class interval {
@@ -29,5 +30,5 @@ public:
   static const interval empty, universe;
 };
 
-const interval interval::empty = interval(+INFINITY, -INFINITY);
-const interval interval::universe = interval(-INFINITY, +INFINITY);
+inline const interval interval::empty = interval(+INFINITY, -INFINITY);
+inline const interval interval::universe = interval(-INFINITY, +INFINITY);
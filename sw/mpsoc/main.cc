@@ -1,14 +1,20 @@
 
 #include "color.hpp"
+#include "dma_ring.hpp"
+#include "frame_export.hpp"
+#include "postprocess.hpp"
+#include "profile.hpp"
 #include "ray.hpp"
 #include "scene.hpp"
 #include "vec3.hpp"
 
 #include "xaxidma.h"
+#include "xil_printf.h"
 #include "xparameters.h"
 #include "xtmrctr.h"
 
 #include <iostream>
+#include <string>
 #include <vector>
 
 #define DMA_DEV_ID XPAR_AXIDMA_0_DEVICE_ID
@@ -18,8 +24,24 @@
 #define TX_BUFFER_BASE (MEM_BASE_ADDR + 0x00100000)
 #define RX_BUFFER_BASE (MEM_BASE_ADDR + 0x00300000)
 
+// Descriptor space for scatter-gather mode (one 64 byte BD per row)
+#define TX_BD_SPACE_BASE (MEM_BASE_ADDR + 0x00010000)
+#define RX_BD_SPACE_BASE (MEM_BASE_ADDR + 0x00020000)
+#define TX_BD_COUNT 16
+#define RX_BD_COUNT 1024
+
+// Polls of the engine before a reset or a transfer is given up
+#define RESET_TIMEOUT_COUNTER 10000
+#define POLL_TIMEOUT_COUNTER 100000000
+
 #define TIMER_COUNTER_0 0
 #define TMRCTR_DEVICE_ID XPAR_TMRCTR_0_DEVICE_ID
+#define TMRCTR_CLOCK_FREQ_HZ XPAR_TMRCTR_0_CLOCK_FREQ_HZ
+
+// Frames rendered per run. Every stage is timed on each frame.
+#define PROFILE_FRAMES 100
+
+typedef profiler<xtmrctr_clock> board_profiler;
 
 XAxiDma AxiDma;
 XTmrCtr TimerCounter;
@@ -31,7 +53,222 @@ static const int image_width = 32;
 static const float focal_length = 1.0f;
 static const float aspect_ratio = 1.0f;
 
-int dma_transfer(size_t tx_length, size_t rx_length, u16 DeviceId) {
+// QOI shrinks the gradient to a few bytes per row. FRAME_FORMAT_PPM sends the
+// uncompressed raster instead.
+static const frame_format export_format = FRAME_FORMAT_QOI;
+
+static int dma_sg_setup_ring(XAxiDma_BdRing *ring, UINTPTR bd_space,
+                             int bd_count) {
+  XAxiDma_Bd bd_template;
+  int Status;
+
+  XAxiDma_BdRingIntDisable(ring, XAXIDMA_IRQ_ALL_MASK);
+
+  Status = XAxiDma_BdRingCreate(ring, bd_space, bd_space,
+                                XAXIDMA_BD_MINIMUM_ALIGNMENT, bd_count);
+  if (Status != XST_SUCCESS) {
+    xil_printf("Failed to create BD ring %d\r\n", Status);
+    return XST_FAILURE;
+  }
+
+  XAxiDma_BdClear(&bd_template);
+  Status = XAxiDma_BdRingClone(ring, &bd_template);
+  if (Status != XST_SUCCESS) {
+    xil_printf("Failed to clone BD ring %d\r\n", Status);
+    return XST_FAILURE;
+  }
+
+  return XAxiDma_BdRingStart(ring);
+}
+
+/* Queue RX descriptors for the rows from row onwards, as many as the free
+ * descriptors allow, and move row past them. While the ring is empty the
+ * engine holds tready low, so the rest of the frame waits in the coprocessor
+ * until completed descriptors are queued again.
+ */
+static int dma_queue_rows(XAxiDma_BdRing *ring, uint32_t *const *rows,
+                          size_t row_count, size_t row_length,
+                          size_t desc_per_row, size_t &row) {
+  size_t n = XAxiDma_BdRingGetFreeCnt(ring) / desc_per_row;
+  if (n > row_count - row) {
+    n = row_count - row;
+  }
+  if (n == 0) {
+    return XST_SUCCESS;
+  }
+
+  XAxiDma_Bd *BdPtr;
+  int Status = XAxiDma_BdRingAlloc(ring, n * desc_per_row, &BdPtr);
+  if (Status != XST_SUCCESS) {
+    xil_printf("Failed to allocate RX descriptors\r\n");
+    return XST_FAILURE;
+  }
+
+  XAxiDma_Bd *First = BdPtr;
+  for (size_t r = row; r < row + n; r++) {
+    UINTPTR addr = (UINTPTR)rows[r];
+    size_t remaining = row_length;
+
+    Xil_DCacheInvalidateRange(addr, row_length);
+    for (size_t i = 0; i < desc_per_row; i++) {
+      size_t chunk = remaining > ring->MaxTransferLen ? ring->MaxTransferLen
+                                                      : remaining;
+      XAxiDma_BdSetBufAddr(BdPtr, addr);
+      XAxiDma_BdSetLength(BdPtr, chunk, ring->MaxTransferLen);
+      XAxiDma_BdSetCtrl(BdPtr, 0);
+      XAxiDma_BdSetId(BdPtr, r);
+
+      addr += chunk;
+      remaining -= chunk;
+      BdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(ring, BdPtr);
+    }
+  }
+
+  Status = XAxiDma_BdRingToHw(ring, n * desc_per_row, First);
+  if (Status != XST_SUCCESS) {
+    xil_printf("Failed to submit RX descriptors\r\n");
+    return XST_FAILURE;
+  }
+  row += n;
+  return XST_SUCCESS;
+}
+
+/* Scatter-gather transfer. The camera goes out as a single descriptor, the
+ * frame comes back with one descriptor per row, so rows may live in separate
+ * (or recycled) buffers and the frame size is no longer capped by the simple
+ * mode length register. Rows longer than the engine's maximum transfer length
+ * are split over several descriptors. A frame may have more rows than the
+ * RX ring has descriptors: they are reused as soon as they complete.
+ */
+static int dma_transfer_sg(size_t tx_length, uint32_t *const *rx_rows,
+                           size_t rx_row_count, size_t rx_row_length,
+                           board_profiler &prof) {
+  XAxiDma_BdRing *TxRing = XAxiDma_GetTxRing(&AxiDma);
+  XAxiDma_BdRing *RxRing = XAxiDma_GetRxRing(&AxiDma);
+  XAxiDma_Bd *BdPtr;
+  int Status;
+
+  size_t rx_desc_per_row =
+      dma_desc_count(rx_row_length, RxRing->MaxTransferLen);
+  size_t rx_desc_count = rx_row_count * rx_desc_per_row;
+  if (rx_desc_per_row > RX_BD_COUNT ||
+      dma_desc_count(tx_length, TxRing->MaxTransferLen) > TX_BD_COUNT) {
+    xil_printf("Row needs more descriptors than available\r\n");
+    return XST_FAILURE;
+  }
+
+  uint64_t start = prof.now();
+
+  /* Arm the receive ring first: the coprocessor starts streaming as soon as
+   * the camera has been received.
+   */
+  size_t rx_queued = 0;
+  if (dma_queue_rows(RxRing, rx_rows, rx_row_count, rx_row_length,
+                     rx_desc_per_row, rx_queued) != XST_SUCCESS) {
+    return XST_FAILURE;
+  }
+
+  // Send the camera configuration
+  size_t tx_desc_count = dma_desc_count(tx_length, TxRing->MaxTransferLen);
+  Status = XAxiDma_BdRingAlloc(TxRing, tx_desc_count, &BdPtr);
+  if (Status != XST_SUCCESS) {
+    xil_printf("Failed to allocate TX descriptors\r\n");
+    return XST_FAILURE;
+  }
+
+  Xil_DCacheFlushRange((UINTPTR)TxBufferPtr, tx_length);
+
+  XAxiDma_Bd *TxFirst = BdPtr;
+  UINTPTR tx_addr = (UINTPTR)TxBufferPtr;
+  size_t tx_remaining = tx_length;
+  for (size_t i = 0; i < tx_desc_count; i++) {
+    size_t chunk = tx_remaining > TxRing->MaxTransferLen
+                       ? TxRing->MaxTransferLen
+                       : tx_remaining;
+    u32 ctrl = 0;
+    if (i == 0) {
+      ctrl |= XAXIDMA_BD_CTRL_TXSOF_MASK;
+    }
+    if (i == tx_desc_count - 1) {
+      ctrl |= XAXIDMA_BD_CTRL_TXEOF_MASK;
+    }
+
+    XAxiDma_BdSetBufAddr(BdPtr, tx_addr);
+    XAxiDma_BdSetLength(BdPtr, chunk, TxRing->MaxTransferLen);
+    XAxiDma_BdSetCtrl(BdPtr, ctrl);
+    XAxiDma_BdSetId(BdPtr, i);
+
+    tx_addr += chunk;
+    tx_remaining -= chunk;
+    BdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(TxRing, BdPtr);
+  }
+
+  Status = XAxiDma_BdRingToHw(TxRing, tx_desc_count, TxFirst);
+  if (Status != XST_SUCCESS) {
+    xil_printf("Failed to send configuration to co-processor\n");
+    return XST_FAILURE;
+  }
+
+  // Reclaim descriptors as they complete. Each row is usable as soon as its
+  // descriptors are back. Transmit and receive overlap, the upload stage ends
+  // when the last camera descriptor has completed.
+  size_t tx_done = 0;
+  size_t rx_done = 0;
+  uint64_t uploaded = 0;
+  for (int polls = 0; tx_done < tx_desc_count || rx_done < rx_desc_count;
+       polls++) {
+    if (polls == POLL_TIMEOUT_COUNTER) {
+      xil_printf("DMA transfer timed out\r\n");
+      return XST_FAILURE;
+    }
+
+    int n = XAxiDma_BdRingFromHw(TxRing, XAXIDMA_ALL_BDS, &BdPtr);
+    if (n > 0) {
+      XAxiDma_Bd *Bd = BdPtr;
+      for (int i = 0; i < n; i++) {
+        if (XAxiDma_BdGetSts(Bd) & XAXIDMA_BD_STS_ALL_ERR_MASK) {
+          xil_printf("Failed to send configuration descriptor %d\n",
+                     (int)XAxiDma_BdGetId(Bd));
+          return XST_FAILURE;
+        }
+        Bd = (XAxiDma_Bd *)XAxiDma_BdRingNext(TxRing, Bd);
+      }
+      XAxiDma_BdRingFree(TxRing, n, BdPtr);
+      tx_done += n;
+      if (tx_done == tx_desc_count) {
+        uploaded = prof.now();
+        prof.record(STAGE_UPLOAD, uploaded - start);
+      }
+    }
+
+    n = XAxiDma_BdRingFromHw(RxRing, XAXIDMA_ALL_BDS, &BdPtr);
+    if (n > 0) {
+      XAxiDma_Bd *Bd = BdPtr;
+      for (int i = 0; i < n; i++) {
+        if (XAxiDma_BdGetSts(Bd) & XAXIDMA_BD_STS_ALL_ERR_MASK) {
+          xil_printf("Failed to receive row %d\n", (int)XAxiDma_BdGetId(Bd));
+          return XST_FAILURE;
+        }
+        Xil_DCacheInvalidateRange(
+            XAxiDma_BdGetBufAddr(Bd),
+            XAxiDma_BdGetLength(Bd, RxRing->MaxTransferLen));
+        Bd = (XAxiDma_Bd *)XAxiDma_BdRingNext(RxRing, Bd);
+      }
+      XAxiDma_BdRingFree(RxRing, n, BdPtr);
+      rx_done += n;
+
+      if (dma_queue_rows(RxRing, rx_rows, rx_row_count, rx_row_length,
+                         rx_desc_per_row, rx_queued) != XST_SUCCESS) {
+        return XST_FAILURE;
+      }
+    }
+  }
+  prof.record(STAGE_RENDER_RECEIVE, prof.now() - uploaded);
+
+  return XST_SUCCESS;
+}
+
+int dma_init(u16 DeviceId) {
   XAxiDma_Config *CfgPtr;
   int Status;
 
@@ -49,11 +286,58 @@ int dma_transfer(size_t tx_length, size_t rx_length, u16 DeviceId) {
     return XST_FAILURE;
   }
 
-  if (XAxiDma_HasSg(&AxiDma)) {
-    xil_printf("Device configured as SG mode \r\n");
+  if (!XAxiDma_HasSg(&AxiDma)) {
+    return XST_SUCCESS;
+  }
+
+  // The rings are built once, the engine must be halted for that. Frames
+  // only allocate and submit descriptors.
+  XAxiDma_Reset(&AxiDma);
+  int TimeOut = RESET_TIMEOUT_COUNTER;
+  while (!XAxiDma_ResetIsDone(&AxiDma)) {
+    if (--TimeOut == 0) {
+      xil_printf("DMA reset timed out\r\n");
+      return XST_FAILURE;
+    }
+  }
+
+  if (dma_sg_setup_ring(XAxiDma_GetTxRing(&AxiDma), TX_BD_SPACE_BASE,
+                        TX_BD_COUNT) != XST_SUCCESS ||
+      dma_sg_setup_ring(XAxiDma_GetRxRing(&AxiDma), RX_BD_SPACE_BASE,
+                        RX_BD_COUNT) != XST_SUCCESS) {
     return XST_FAILURE;
   }
 
+  return XST_SUCCESS;
+}
+
+// Polls until the channel is idle. Returns false if it stays busy.
+static bool dma_wait(int direction) {
+  for (int polls = 0; XAxiDma_Busy(&AxiDma, direction); polls++) {
+    if (polls == POLL_TIMEOUT_COUNTER) {
+      xil_printf("DMA transfer timed out\r\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+int dma_transfer(size_t tx_length, size_t rx_length, size_t rx_row_length,
+                 board_profiler &prof) {
+  int Status;
+
+  if (XAxiDma_HasSg(&AxiDma)) {
+    size_t rx_row_count = rx_length / rx_row_length;
+    std::vector<uint32_t *> rx_rows(rx_row_count);
+    for (size_t row = 0; row < rx_row_count; row++) {
+      rx_rows[row] = RxBufferPtr + row * (rx_row_length / sizeof(uint32_t));
+    }
+    return dma_transfer_sg(tx_length, rx_rows.data(), rx_row_count,
+                           rx_row_length, prof);
+  }
+
+  uint64_t start = prof.now();
+
   /* Disable interrupts, we use polling mode
    */
   XAxiDma_IntrDisable(&AxiDma, XAXIDMA_IRQ_ALL_MASK, XAXIDMA_DEVICE_TO_DMA);
@@ -72,9 +356,13 @@ int dma_transfer(size_t tx_length, size_t rx_length, u16 DeviceId) {
     return XST_FAILURE;
   }
 
-  while (XAxiDma_Busy(&AxiDma, XAXIDMA_DMA_TO_DEVICE)) {
+  if (!dma_wait(XAXIDMA_DMA_TO_DEVICE)) {
+    return XST_FAILURE;
   }
 
+  uint64_t uploaded = prof.now();
+  prof.record(STAGE_UPLOAD, uploaded - start);
+
   Xil_DCacheInvalidateRange((UINTPTR)RxBufferPtr, rx_length);
   Status = XAxiDma_SimpleTransfer(&AxiDma, (UINTPTR)RxBufferPtr, rx_length,
                                   XAXIDMA_DEVICE_TO_DMA);
@@ -84,8 +372,10 @@ int dma_transfer(size_t tx_length, size_t rx_length, u16 DeviceId) {
     return XST_FAILURE;
   }
 
-  while (XAxiDma_Busy(&AxiDma, XAXIDMA_DEVICE_TO_DMA)) {
+  if (!dma_wait(XAXIDMA_DEVICE_TO_DMA)) {
+    return XST_FAILURE;
   }
+  prof.record(STAGE_RENDER_RECEIVE, prof.now() - uploaded);
 
   /* Invalidate the DestBuffer before receiving the data, in case the
    * Data Cache is enabled
@@ -94,12 +384,6 @@ int dma_transfer(size_t tx_length, size_t rx_length, u16 DeviceId) {
   return XST_SUCCESS;
 }
 
-color ray_color(const ray &r) {
-  vec3 unit_direction = unit_vector(r.direction());
-  auto a = 0.5 * (unit_direction.y() + 1.0);
-  return (1.0 - a) * color(1.0, 1.0, 1.0) + a * color(0.5, 0.7, 1.0);
-}
-
 /*
 int main() {
         Scene scene(400.0f, 16.0f/9.0f, 1.0f);
@@ -123,6 +407,17 @@ int main() {
         std::cout << "Finished!" << std::endl;
  }*/
 
+/* Binary frames bypass stdout: write() of the standalone BSP sends '\r'
+ * before every 0x0A byte, which frame_decode cannot tell from frame data.
+ * outbyte() hands each byte to the UART unchanged.
+ */
+static void uart_write(const std::vector<uint8_t> &buf) {
+  std::fflush(stdout);
+  for (uint8_t b : buf) {
+    outbyte(char(b));
+  }
+}
+
 int main() {
   // Timer Configuration
   XTmrCtr *TmrCtrInstancePtr = &TimerCounter;
@@ -139,86 +434,84 @@ int main() {
 
   XTmrCtr_SetOptions(TmrCtrInstancePtr, TmrCtrNumber, XTC_AUTO_RELOAD_OPTION);
 
-  Scene scene(image_width, aspect_ratio, focal_length);
-  uint32_t *cam = scene.serialised();
-
-  for (int i = 0; i < SCENE_PAYLOAD_SIZE; i++) {
-    TxBufferPtr[i] = cam[i];
-  }
-
-  std::cout << "Starting DMA transaction...." << std::endl;
-  // Transfer the scene configuration to the co-processor
-  XTmrCtr_Start(TmrCtrInstancePtr, TmrCtrNumber);
-  u32 before_dma = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
-
-  size_t tx_len = SCENE_PAYLOAD_SIZE * 4;
-  size_t rx_len = int(scene.image_height) * int(scene.image_width) * 4;
-  int rc = dma_transfer(tx_len, rx_len, DMA_DEV_ID);
-
-  u32 after_dma = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
-  XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
-  if (rc != XST_SUCCESS) {
+  if (dma_init(DMA_DEV_ID) != XST_SUCCESS) {
     return -1;
   }
-  std::cout << "DMA Transaction finished" << std::endl;
 
-  uint32_t *RxBuffer = (u32 *)RX_BUFFER_BASE;
-  std::cout << "DMA took " << (after_dma - before_dma) << " times units"
-            << std::endl;
+  board_profiler prof(
+      xtmrctr_clock(TmrCtrInstancePtr, TmrCtrNumber, TMRCTR_CLOCK_FREQ_HZ));
+  XTmrCtr_Start(TmrCtrInstancePtr, TmrCtrNumber);
 
+  Scene scene(image_width, aspect_ratio, focal_length);
   int image_height = int(scene.image_height);
-  for (int i = 0; i < image_height * image_width; i++) {
-    xil_printf("0x%x,\n", RxBuffer[i]);
-  }
-
-  XTmrCtr_Start(TmrCtrInstancePtr, TmrCtrNumber);
-  u32 before_sw = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
+  uint32_t *RxBuffer = (u32 *)RX_BUFFER_BASE;
 
-  // Ray Generation in software
-  volatile size_t dummy_sum = 0; // do not optimise
-  for (int h = 0; h < image_height; ++h) {
-    for (int w = 0; w < image_width; ++w) {
-      auto pixel_center = scene.pixel_00_loc + (w * scene.pixel_delta_u) +
-                          (h * scene.pixel_delta_v);
-      auto ray_direction = pixel_center - scene.camera_center;
-      ray r(scene.camera_center, ray_direction);
-      dummy_sum += reinterpret_cast<size_t>(&r);
+  // Every hardware frame is sent as a binary frame, followed by the software
+  // reference and the profile. Log text is sent as text records of the same
+  // stream. Use sw/tools/frame_decode to extract them from the UART capture.
+  std::vector<uint8_t> export_buffer;
+  export_text("Rendering " + std::to_string(PROFILE_FRAMES) + " frames\n",
+              export_buffer);
+  uart_write(export_buffer);
+
+  frame hw_frame(image_width, image_height);
+  for (int i = 0; i < PROFILE_FRAMES; i++) {
+    {
+      auto t = prof.time(STAGE_CAMERA_SERIALISE);
+      scene = Scene(image_width, aspect_ratio, focal_length);
+      uint32_t *cam = scene.serialised();
+      for (int j = 0; j < SCENE_PAYLOAD_SIZE; j++) {
+        TxBufferPtr[j] = cam[j];
+      }
     }
-  }
-  u32 after_sw = XTmrCtr_GetValue(TmrCtrInstancePtr, TmrCtrNumber);
-  XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
 
-  std::cout << "SW took " << (after_sw - before_sw)
-            << " times units. after: " << after_sw << " before: " << before_sw
-            << std::endl;
+    // Transfer the scene configuration to the co-processor
+    size_t tx_len = SCENE_PAYLOAD_SIZE * 4;
+    size_t rx_row_len = int(scene.image_width) * 4;
+    size_t rx_len = image_height * rx_row_len;
+    if (dma_transfer(tx_len, rx_len, rx_row_len, prof) != XST_SUCCESS) {
+      return -1;
+    }
 
-  std::cout << "Image with rays from hardware" << std::endl;
+    {
+      auto t = prof.time(STAGE_SHADE);
+      shade_sky(RxBuffer, size_t(image_width) * image_height,
+                hw_frame.rgb.data());
+    }
 
-  std::cout << "P3\n" << image_width << ' ' << image_height << "\n255\n";
-  for (int h = 0; h < image_height; h++) {
-    for (int w = 0; w < image_width; w++) {
-      int32_t raw_y = RxBuffer[w + image_width * h];
-      vec3 ray_direction = vec3(0, FIX_2_FLOAT(raw_y), -1);
-      ray r(scene.camera_center, ray_direction);
-      write_color(std::cout, ray_color(r));
+    export_buffer.clear();
+    {
+      auto t = prof.time(STAGE_ENCODE);
+      export_frame(hw_frame, export_format, export_buffer);
+    }
+    {
+      auto t = prof.time(STAGE_OUTPUT);
+      uart_write(export_buffer);
     }
   }
-  puts("\n");
 
-  std::cout << "Image with rays from software" << std::endl;
+  XTmrCtr_Stop(TmrCtrInstancePtr, TmrCtrNumber);
+  XTmrCtr_SetOptions(TmrCtrInstancePtr, TmrCtrNumber, 0);
 
-  std::cout << "P3\n" << image_width << ' ' << image_height << "\n255\n";
+  frame sw_frame(image_width, image_height);
   for (int h = 0; h < image_height; h++) {
     for (int w = 0; w < image_width; w++) {
       auto pixel_center = scene.pixel_00_loc + (w * scene.pixel_delta_u) +
                           (h * scene.pixel_delta_v);
       auto ray_direction = pixel_center - scene.camera_center;
       ray r(scene.camera_center, vec3(0, ray_direction[1], -1));
-      write_color(std::cout, ray_color(r));
+      rgb p = get_rgb(ray_color(r));
+      sw_frame.set(w, h, p.r, p.g, p.b);
     }
   }
 
-  XTmrCtr_SetOptions(TmrCtrInstancePtr, TmrCtrNumber, 0);
+  std::vector<profile_record> summary = prof.summary();
+
+  export_buffer.clear();
+  export_frame(sw_frame, export_format, export_buffer);
+  export_text(format_profile_csv(prof.frequency(), summary), export_buffer);
+  export_profile(prof.frequency(), summary, export_buffer);
+  uart_write(export_buffer);
 
   return 0;
 }
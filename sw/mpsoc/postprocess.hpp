@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "color.hpp"
+#include "ray.hpp"
+#include "scene.hpp"
+#include "vec3.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Host-side post-processing of the frame received from the coprocessor.
+//
+// The coprocessor sends the y component of each ray direction in 16.16 fixed
+// point. shade_sky() turns a whole frame of these words into RGB888 in one
+// pass. It produces exactly the bytes of the per-pixel reference
+//
+//   get_rgb(ray_color(ray(origin, vec3(0, FIX_2_FLOAT(raw_y), -1))))
+//
+// as long as the compiler does not contract multiplies and adds into FMAs
+// (-ffp-contract=off, set on mpsoc_sw). The rewrites below are exact:
+// - FIX_2_FLOAT divides by a power of two, which equals multiplying by its
+//   inverse.
+// - ray_color computes a = 0.5 * (y + 1.0) in double. For a float y, both
+//   float(a) == (y + 1.0f) * 0.5f and float(1.0 - a) == (1.0f - y) * 0.5f.
+// - linear_to_gamma + clamp + quantisation is a monotone step function with
+//   256 steps, replaced by a LUT indexed by the bits of the float, whose
+//   buckets hold at most one step, plus one compare against its exact
+//   threshold.
+
+inline color ray_color(const ray &r) {
+  vec3 unit_direction = unit_vector(r.direction());
+  auto a = 0.5 * (unit_direction.y() + 1.0);
+  return (1.0 - a) * color(1.0, 1.0, 1.0) + a * color(0.5, 0.7, 1.0);
+}
+
+// Per-pixel reference for one coprocessor word
+inline rgb shade_sky_reference(uint32_t raw_y) {
+  vec3 ray_direction = vec3(0, FIX_2_FLOAT(raw_y), -1);
+  ray r(vec3(0, 0, 0), ray_direction);
+  return get_rgb(ray_color(r));
+}
+
+// Quantise a linear colour component exactly like get_rgb()
+class gamma_lut {
+public:
+  // Buckets are indexed by the exponent and the top MANTISSA_BITS of the
+  // float, from LOWEST up to 1. Below 1, the steps of the quantisation are
+  // more than 2^-7 of their value apart and a bucket spans at most 2^-8 of
+  // its start, so a bucket holds at most one threshold and one compare
+  // finds the byte.
+  //
+  // That takes 17 exponents, 4352 entries, rather than a 4096-entry table
+  // for [2^-16, 1). 2^-16 is exactly the threshold of byte 1, so the clamp
+  // needs a floor below it that still quantises to 0, and the floor must sit
+  // in a bucket of its own. The 17th exponent, [2^-17, 2^-16), is that
+  // bucket: every entry holds byte 0 and no split. It costs 1 KiB, where
+  // the alternative would be one more compare and select per lane.
+  static constexpr int MANTISSA_BITS = 8;
+  static constexpr int MIN_EXPONENT = -17;
+  static constexpr int SIZE = -MIN_EXPONENT << MANTISSA_BITS;
+
+  // Everything below LOWEST quantises to 0 and everything from HIGHEST up
+  // to 255
+  static constexpr float LOWEST = 0x1p-17f;
+  static constexpr float HIGHEST = 0x1.fffffep-1f; // Largest float below 1
+
+  static constexpr int SHIFT = 23 - MANTISSA_BITS;
+  static constexpr int FIRST = (127 + MIN_EXPONENT) << MANTISSA_BITS;
+  static constexpr uint32_t BUCKET = 1u << SHIFT; // Floats per bucket
+
+  gamma_lut() {
+    // thresholds[b] is the smallest float that quantises to b or more.
+    // reference() is monotone for non-negative floats, whose bit patterns
+    // are ordered like the values themselves.
+    thresholds[0] = -INFINITY;
+    for (int b = 1; b < 256; b++) {
+      uint32_t lo = 0;
+      uint32_t hi = bits(1.0f);
+      while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (reference(from_bits(mid)) >= b) {
+          hi = mid;
+        } else {
+          lo = mid + 1;
+        }
+      }
+      thresholds[b] = from_bits(lo);
+    }
+    thresholds[256] = INFINITY;
+
+    for (int i = 0; i < SIZE; i++) {
+      uint32_t first = uint32_t(FIRST + i) << SHIFT;
+      uint8_t byte = reference(from_bits(first));
+      uint32_t split = byte < 255 ? bits(thresholds[byte + 1]) - first : 0;
+      split = split > 0 && split < BUCKET ? split : BUCKET;
+      entries[i] = byte | (split - 1) << 8;
+    }
+  }
+
+  static uint8_t reference(float linear) {
+    static const interval intensity(0.000f, 0.999f);
+    return uint8_t(256 * intensity.clamp(linear_to_gamma(linear)));
+  }
+
+  // Into [LOWEST, HIGHEST], NaN to LOWEST
+  static float clamp(float x) {
+    x = x > LOWEST ? x : LOWEST;
+    return x < HIGHEST ? x : HIGHEST;
+  }
+
+  static int bucket(float clamped) {
+    return int(bits(clamped) >> SHIFT) - FIRST;
+  }
+
+  // Byte at the start of a bucket
+  uint8_t base(int idx) const { return uint8_t(entries[idx]); }
+
+  // x must be the bits of a clamped float
+  uint8_t lookup(uint32_t x) const {
+    uint32_t e = entries[(x >> SHIFT) - FIRST];
+    return uint8_t((e & 0xff) + ((x & (BUCKET - 1)) > e >> 8));
+  }
+
+  uint8_t operator()(float x) const { return lookup(bits(clamp(x))); }
+
+  float thresholds[257];
+
+  // Bits 7:0 are the byte at the start of a bucket. Bits 22:8 are the
+  // offset in the bucket of the float that steps to the next byte, minus
+  // one, or BUCKET - 1 if there is none.
+  uint32_t entries[SIZE];
+
+  static uint32_t bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+  }
+
+private:
+  static float from_bits(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+};
+
+inline const gamma_lut &default_gamma_lut() {
+  static const gamma_lut lut;
+  return lut;
+}
+
+// Sky colour for one ray y component, split into the three linear channels
+inline void sky_linear(float y, float &r, float &g, float &b) {
+  float inv_len = 1 / std::sqrt(y * y + 1.0f);
+  float unit_y = inv_len * y;
+  float a = (unit_y + 1.0f) * 0.5f;
+  float one_minus_a = (1.0f - unit_y) * 0.5f;
+  r = one_minus_a + a * 0.5f;
+  g = one_minus_a + a * 0.7f;
+  b = one_minus_a + a * 1.0f;
+}
+
+// Shade count coprocessor words into count packed RGB888 pixels
+inline void shade_sky(const uint32_t *rx, size_t count, uint8_t *out,
+                      const gamma_lut &gamma = default_gamma_lut()) {
+  const float scale = 1.0f / FP_2_POW_QW;
+  size_t i = 0;
+
+#if (defined(__ARM_NEON) && defined(__aarch64__)) || defined(__SSE2__)
+  // The LUT has no vector gather, so bucket indices go through memory and
+  // the entries are loaded per lane. The compares and the packing are
+  // vectorised.
+  alignas(16) uint32_t idx[4];
+  alignas(16) uint32_t rgb[4];
+  const uint32_t *entries = gamma.entries;
+
+  for (; i + 4 <= count; i += 4) {
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t y = vmulq_n_f32(
+        vcvtq_f32_s32(vreinterpretq_s32_u32(vld1q_u32(rx + i))), scale);
+    float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t half = vdupq_n_f32(0.5f);
+    float32x4_t len = vsqrtq_f32(vaddq_f32(vmulq_f32(y, y), one));
+    float32x4_t unit_y = vmulq_f32(vdivq_f32(one, len), y);
+    float32x4_t a = vmulq_f32(vaddq_f32(unit_y, one), half);
+    float32x4_t one_minus_a = vmulq_f32(vsubq_f32(one, unit_y), half);
+
+    float32x4_t c[3] = {
+        vaddq_f32(one_minus_a, vmulq_f32(a, half)),
+        vaddq_f32(one_minus_a, vmulq_f32(a, vdupq_n_f32(0.7f))),
+        vaddq_f32(one_minus_a, vmulq_f32(a, one)),
+    };
+    uint32x4_t pixels = vdupq_n_u32(0);
+    for (int ch = 0; ch < 3; ch++) {
+      // vmaxnmq sends NaN to LOWEST, like gamma_lut::clamp()
+      uint32x4_t x = vreinterpretq_u32_f32(
+          vminq_f32(vmaxnmq_f32(c[ch], vdupq_n_f32(gamma_lut::LOWEST)),
+                    vdupq_n_f32(gamma_lut::HIGHEST)));
+      vst1q_u32(idx, vsubq_u32(vshrq_n_u32(x, gamma_lut::SHIFT),
+                               vdupq_n_u32(gamma_lut::FIRST)));
+      uint32x4_t e = {entries[idx[0]], entries[idx[1]], entries[idx[2]],
+                      entries[idx[3]]};
+      uint32x4_t offset = vandq_u32(x, vdupq_n_u32(gamma_lut::BUCKET - 1));
+      // The compare is all ones where the byte steps up
+      uint32x4_t byte = vsubq_u32(vandq_u32(e, vdupq_n_u32(0xff)),
+                                  vcgtq_u32(offset, vshrq_n_u32(e, 8)));
+      pixels = vorrq_u32(pixels, vshlq_u32(byte, vdupq_n_s32(8 * ch)));
+    }
+    vst1q_u32(rgb, pixels);
+#else
+    __m128 y = _mm_mul_ps(
+        _mm_cvtepi32_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(rx + i))),
+        _mm_set1_ps(scale));
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(y, y), one));
+    __m128 unit_y = _mm_mul_ps(_mm_div_ps(one, len), y);
+    __m128 a = _mm_mul_ps(_mm_add_ps(unit_y, one), half);
+    __m128 one_minus_a = _mm_mul_ps(_mm_sub_ps(one, unit_y), half);
+
+    __m128 c[3] = {
+        _mm_add_ps(one_minus_a, _mm_mul_ps(a, half)),
+        _mm_add_ps(one_minus_a, _mm_mul_ps(a, _mm_set1_ps(0.7f))),
+        _mm_add_ps(one_minus_a, _mm_mul_ps(a, one)),
+    };
+    __m128i pixels = _mm_setzero_si128();
+    for (int ch = 0; ch < 3; ch++) {
+      // _mm_max_ps returns its second operand for NaN, like
+      // gamma_lut::clamp()
+      __m128i x = _mm_castps_si128(
+          _mm_min_ps(_mm_max_ps(c[ch], _mm_set1_ps(gamma_lut::LOWEST)),
+                     _mm_set1_ps(gamma_lut::HIGHEST)));
+      _mm_store_si128(reinterpret_cast<__m128i *>(idx),
+                      _mm_sub_epi32(_mm_srli_epi32(x, gamma_lut::SHIFT),
+                                    _mm_set1_epi32(gamma_lut::FIRST)));
+      __m128i e = _mm_set_epi32(entries[idx[3]], entries[idx[2]],
+                                entries[idx[1]], entries[idx[0]]);
+      __m128i offset = _mm_and_si128(x, _mm_set1_epi32(gamma_lut::BUCKET - 1));
+      // Offsets and entries are below 2^31, so the signed compare works. It
+      // is all ones where the byte steps up.
+      __m128i byte =
+          _mm_sub_epi32(_mm_and_si128(e, _mm_set1_epi32(0xff)),
+                        _mm_cmpgt_epi32(offset, _mm_srli_epi32(e, 8)));
+      pixels = _mm_or_si128(pixels, _mm_slli_epi32(byte, 8 * ch));
+    }
+    _mm_store_si128(reinterpret_cast<__m128i *>(rgb), pixels);
+#endif
+
+    // R, G and B are the first three bytes of a little-endian word
+    for (int lane = 0; lane < 4; lane++) {
+      std::memcpy(out + (i + lane) * 3, &rgb[lane], 3);
+    }
+  }
+#endif
+
+  // Scalar tail (and fallback without SIMD)
+  for (; i < count; i++) {
+    float y = float(int32_t(rx[i])) * scale;
+    float r, g, b;
+    sky_linear(y, r, g, b);
+
+    uint8_t *p = out + i * 3;
+    p[0] = gamma(r);
+    p[1] = gamma(g);
+    p[2] = gamma(b);
+  }
+}
@@ -0,0 +1,364 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#pragma once
+
+#include "frame_export.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#if __has_include("xtmrctr.h")
+#include "xtmrctr.h"
+#endif
+
+// Per-stage profiling of the frame pipeline.
+//
+// A profiler keeps one latency histogram per pipeline stage. Stages are timed
+// with a scoped_timer on top of a clock backend: xtmrctr_clock on the board,
+// rdtsc_clock or chrono_clock on Linux. After many frames, the min, mean and
+// p99 of every stage are written as CSV or as a compact binary record of the
+// frame_export.hpp stream, so both can be extracted from the same UART
+// capture.
+
+#define PROFILE_MAGIC "RTPF"
+
+enum profile_stage : uint8_t {
+  STAGE_CAMERA_SERIALISE = 0,
+  STAGE_UPLOAD = 1,
+  STAGE_RENDER_RECEIVE = 2,
+  STAGE_SHADE = 3,
+  STAGE_ENCODE = 4,
+  STAGE_OUTPUT = 5,
+  STAGE_COUNT
+};
+
+inline const char *profile_stage_name(int stage) {
+  static const char *names[STAGE_COUNT] = {
+      "camera_serialise", "upload", "render_receive",
+      "shade",            "encode", "output",
+  };
+  return stage >= 0 && stage < STAGE_COUNT ? names[stage] : "unknown";
+}
+
+#pragma mark - Histogram
+
+// Log-linear histogram of tick counts. Values below 32 are stored exactly,
+// larger values in 16 sub-buckets per power of two (at most 6.25% error).
+// Fixed size and allocation free, so it can live on the board.
+class latency_histogram {
+public:
+  static constexpr int SUB_BITS = 4;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+  static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+  latency_histogram() { reset(); }
+
+  void reset() {
+    count_ = 0;
+    sum_ = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+    std::memset(counts, 0, sizeof(counts));
+  }
+
+  void record(uint64_t ticks) {
+    count_ += 1;
+    sum_ += ticks;
+    min_ = std::min(min_, ticks);
+    max_ = std::max(max_, ticks);
+    counts[bucket(ticks)] += 1;
+  }
+
+  static int bucket(uint64_t v) {
+    if (v < SUB_BUCKETS) {
+      return int(v);
+    }
+    int e = 63 - __builtin_clzll(v);
+    return (e - SUB_BITS + 1) * SUB_BUCKETS +
+           int((v >> (e - SUB_BITS)) & (SUB_BUCKETS - 1));
+  }
+
+  // Largest value that falls into bucket b
+  static uint64_t bucket_upper(int b) {
+    if (b < 2 * SUB_BUCKETS) {
+      return uint64_t(b);
+    }
+    int shift = b / SUB_BUCKETS - 1;
+    uint64_t low = uint64_t(SUB_BUCKETS + b % SUB_BUCKETS) << shift;
+    return low + ((uint64_t(1) << shift) - 1);
+  }
+
+  // Smallest recorded value v such that a fraction q of the samples are <= v,
+  // rounded up to its bucket
+  uint64_t percentile(double q) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    uint64_t rank = uint64_t(std::ceil(q * count_));
+    rank = std::clamp<uint64_t>(rank, 1, count_);
+
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+      seen += counts[b];
+      if (seen >= rank) {
+        return std::clamp(bucket_upper(b), min_, max_);
+      }
+    }
+    return max_;
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t min() const { return count_ ? min_ : 0; }
+  uint64_t max() const { return max_; }
+  uint64_t sum() const { return sum_; }
+  double mean() const { return count_ ? double(sum_) / count_ : 0.0; }
+
+private:
+  uint64_t count_;
+  uint64_t sum_;
+  uint64_t min_;
+  uint64_t max_;
+  uint32_t counts[BUCKETS];
+};
+
+#pragma mark - Clocks
+
+// Portable fallback, nanosecond ticks
+struct chrono_clock {
+  uint64_t now() const {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+  }
+  uint64_t frequency() const { return 1000000000; }
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+// Time stamp counter. Assumes an invariant TSC; the frequency is calibrated
+// against steady_clock when the clock is created.
+class rdtsc_clock {
+public:
+  explicit rdtsc_clock(int calibration_ms = 10) {
+    chrono_clock ref;
+    uint64_t t0 = ref.now();
+    uint64_t c0 = __rdtsc();
+    while (ref.now() - t0 < uint64_t(calibration_ms) * 1000000) {
+    }
+    uint64_t t1 = ref.now();
+    uint64_t c1 = __rdtsc();
+    freq = uint64_t(double(c1 - c0) * 1e9 / double(t1 - t0));
+  }
+
+  uint64_t now() const { return __rdtsc(); }
+  uint64_t frequency() const { return freq; }
+
+private:
+  uint64_t freq;
+};
+#endif
+
+#if __has_include("xtmrctr.h")
+// AXI Timer running in auto reload mode. The 32-bit counter is extended to
+// 64 bits, which is correct as long as now() is called at least once per
+// counter period (about 43 s at 100 MHz).
+class xtmrctr_clock {
+public:
+  xtmrctr_clock(XTmrCtr *timer, u8 counter, uint64_t frequency_hz)
+      : timer(timer), counter(counter), freq(frequency_hz), last(0), high(0) {}
+
+  uint64_t now() {
+    u32 value = XTmrCtr_GetValue(timer, counter);
+    if (value < last) {
+      high += uint64_t(1) << 32;
+    }
+    last = value;
+    return high | value;
+  }
+  uint64_t frequency() const { return freq; }
+
+private:
+  XTmrCtr *timer;
+  u8 counter;
+  uint64_t freq;
+  u32 last;
+  uint64_t high;
+};
+#endif
+
+#pragma mark - Profiler
+
+// Summary of one stage. All fields are little-endian ticks.
+struct __attribute__((packed)) profile_record {
+  uint32_t count;
+  uint32_t reserved;
+  uint64_t min;
+  uint64_t mean;
+  uint64_t p99;
+  uint64_t max;
+};
+
+struct __attribute__((packed)) profile_header {
+  char magic[4];
+  uint8_t stage_count;
+  uint8_t reserved[3];
+  uint64_t frequency; // ticks per second
+};
+
+static_assert(sizeof(profile_header) == 16, "Header layout changed");
+static_assert(sizeof(profile_record) == 40, "Record layout changed");
+
+inline profile_record summarise(const latency_histogram &h) {
+  profile_record r = {};
+  r.count = uint32_t(h.count());
+  r.min = h.min();
+  r.mean = uint64_t(std::llround(h.mean()));
+  r.p99 = h.percentile(0.99);
+  r.max = h.max();
+  return r;
+}
+
+template <typename Clock> class profiler {
+public:
+  // Records the time between construction and destruction into one stage
+  class scoped_timer {
+  public:
+    scoped_timer(profiler &p, profile_stage stage)
+        : p(p), stage(stage), start(p.clock.now()) {}
+    ~scoped_timer() { p.record(stage, p.clock.now() - start); }
+
+    scoped_timer(const scoped_timer &) = delete;
+    scoped_timer &operator=(const scoped_timer &) = delete;
+
+  private:
+    profiler &p;
+    profile_stage stage;
+    uint64_t start;
+  };
+
+  explicit profiler(Clock clock = Clock()) : clock(clock) {}
+
+  scoped_timer time(profile_stage stage) { return scoped_timer(*this, stage); }
+
+  uint64_t now() { return clock.now(); }
+  uint64_t frequency() const { return clock.frequency(); }
+
+  // For stages that are not a lexical scope
+  void record(profile_stage stage, uint64_t ticks) {
+    stages[stage].record(ticks);
+  }
+
+  const latency_histogram &stage(profile_stage stage) const {
+    return stages[stage];
+  }
+
+  void reset() {
+    for (auto &h : stages) {
+      h.reset();
+    }
+  }
+
+  std::vector<profile_record> summary() const {
+    std::vector<profile_record> records(STAGE_COUNT);
+    for (int s = 0; s < STAGE_COUNT; s++) {
+      records[s] = summarise(stages[s]);
+    }
+    return records;
+  }
+
+  Clock clock;
+
+private:
+  latency_histogram stages[STAGE_COUNT];
+};
+
+#pragma mark - Output
+
+inline std::string
+format_profile_csv(uint64_t frequency,
+                   const std::vector<profile_record> &records) {
+  double us = 1e6 / double(frequency);
+  std::string csv = "stage,count,min_us,mean_us,p99_us,max_us\n";
+  for (size_t s = 0; s < records.size(); s++) {
+    const profile_record &r = records[s];
+    char line[128];
+    std::snprintf(line, sizeof(line), "%s,%u,%.3f,%.3f,%.3f,%.3f\n",
+                  profile_stage_name(int(s)), unsigned(r.count), r.min * us,
+                  r.mean * us, r.p99 * us, r.max * us);
+    csv += line;
+  }
+  return csv;
+}
+
+inline void write_profile_csv(std::FILE *out, uint64_t frequency,
+                              const std::vector<profile_record> &records) {
+  std::fputs(format_profile_csv(frequency, records).c_str(), out);
+}
+
+// Append a FRAME_FORMAT_PROFILE record: a profile_header followed by one
+// profile_record per stage
+inline void export_profile(uint64_t frequency,
+                           const std::vector<profile_record> &records,
+                           std::vector<uint8_t> &out) {
+  profile_header header = {};
+  std::memcpy(header.magic, PROFILE_MAGIC, 4);
+  header.stage_count = uint8_t(records.size());
+  header.frequency = frequency;
+
+  std::vector<uint8_t> payload(sizeof(header) +
+                               records.size() * sizeof(profile_record));
+  std::memcpy(payload.data(), &header, sizeof(header));
+  std::memcpy(payload.data() + sizeof(header), records.data(),
+              records.size() * sizeof(profile_record));
+  export_record(FRAME_FORMAT_PROFILE, payload.data(), payload.size(), out);
+}
+
+// Profile in the payload of a FRAME_FORMAT_PROFILE record
+inline bool parse_profile(const uint8_t *payload, size_t len,
+                          uint64_t &frequency,
+                          std::vector<profile_record> &records) {
+  profile_header header;
+  if (len < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, payload, sizeof(header));
+  size_t body_len = header.stage_count * sizeof(profile_record);
+  if (std::memcmp(header.magic, PROFILE_MAGIC, 4) != 0 ||
+      header.stage_count == 0 || header.frequency == 0 ||
+      sizeof(header) + body_len != len) {
+    return false;
+  }
+  frequency = header.frequency;
+  records.resize(header.stage_count);
+  std::memcpy(records.data(), payload + sizeof(header), body_len);
+  return true;
+}
+
+// Find the next profile record in a byte stream starting at offset, and
+// move offset past it. Other records are skipped whole.
+inline bool import_profile(const uint8_t *data, size_t len, size_t &offset,
+                           uint64_t &frequency,
+                           std::vector<profile_record> &records) {
+  frame_header header;
+  size_t payload;
+  frame f;
+  while (import_record(data, len, offset, header, payload, f)) {
+    if (header.format == FRAME_FORMAT_PROFILE &&
+        parse_profile(data + payload, header.payload_length, frequency,
+                      records)) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "dma_ring.hpp"
+
+namespace {
+
+class DmaRingTest : public testing::Test {
+protected:
+  static const int RING_SIZE = 8;
+  alignas(DMA_DESC_ALIGNMENT) dma_desc descs[RING_SIZE];
+};
+
+TEST_F(DmaRingTest, DescriptorsAreLinkedCircularly) {
+  dma_ring ring(descs, RING_SIZE);
+
+  for (int i = 0; i < RING_SIZE; i++) {
+    uint64_t next =
+        (uint64_t(descs[i].next_desc_msb) << 32) | descs[i].next_desc;
+    EXPECT_EQ(next, uint64_t(uintptr_t(&descs[(i + 1) % RING_SIZE])));
+  }
+  EXPECT_EQ(ring.free(), size_t(RING_SIZE));
+  EXPECT_EQ(ring.pending(), 0u);
+}
+
+TEST_F(DmaRingTest, SplitsBuffersLongerThanMaxLength) {
+  dma_ring ring(descs, RING_SIZE, 100);
+  std::vector<uint8_t> buf(250);
+
+  ASSERT_TRUE(ring.submit(uintptr_t(buf.data()), buf.size(),
+                          DMA_DESC_CTRL_SOF | DMA_DESC_CTRL_EOF, 7));
+  EXPECT_EQ(ring.pending(), 3u);
+
+  EXPECT_EQ(descs[0].length(), 100u);
+  EXPECT_EQ(descs[1].length(), 100u);
+  EXPECT_EQ(descs[2].length(), 50u);
+  EXPECT_EQ(descs[1].buffer(), uintptr_t(buf.data() + 100));
+
+  EXPECT_TRUE(descs[0].control & DMA_DESC_CTRL_SOF);
+  EXPECT_FALSE(descs[0].control & DMA_DESC_CTRL_EOF);
+  EXPECT_FALSE(descs[1].control & (DMA_DESC_CTRL_SOF | DMA_DESC_CTRL_EOF));
+  EXPECT_TRUE(descs[2].control & DMA_DESC_CTRL_EOF);
+  EXPECT_EQ(descs[2].id, 7u);
+  EXPECT_EQ(ring.tail(), &descs[2]);
+}
+
+TEST_F(DmaRingTest, RejectsSubmissionWhenFull) {
+  dma_ring ring(descs, RING_SIZE, 16);
+  std::vector<uint8_t> buf(16 * RING_SIZE + 1);
+
+  EXPECT_FALSE(ring.submit(uintptr_t(buf.data()), buf.size(), 0, 0));
+  EXPECT_EQ(ring.pending(), 0u);
+  EXPECT_TRUE(ring.submit(uintptr_t(buf.data()), buf.size() - 1, 0, 0));
+  EXPECT_EQ(ring.free(), 0u);
+}
+
+TEST_F(DmaRingTest, RejectsEmptyBuffer) {
+  dma_ring ring(descs, RING_SIZE);
+  uint8_t byte;
+
+  EXPECT_FALSE(ring.submit(uintptr_t(&byte), 0, DMA_DESC_CTRL_EOF, 0));
+  EXPECT_EQ(ring.pending(), 0u);
+}
+
+TEST_F(DmaRingTest, FrameScattersIntoNonContiguousRows) {
+  const int width = 10;
+  const int height = 4;
+  const size_t row_len = width * sizeof(uint32_t);
+  dma_ring ring(descs, RING_SIZE);
+  dma_engine_model engine(ring);
+
+  // Rows deliberately live in separate allocations, in reverse order
+  std::vector<std::vector<uint32_t>> rows(height, std::vector<uint32_t>(width));
+  for (int h = 0; h < height; h++) {
+    ASSERT_TRUE(ring.submit(uintptr_t(rows[height - 1 - h].data()), row_len, 0,
+                            h));
+  }
+
+  std::vector<uint32_t> frame(width * height);
+  std::iota(frame.begin(), frame.end(), 0);
+  EXPECT_EQ(engine.s2mm(frame.data(), frame.size() * sizeof(uint32_t)),
+            frame.size() * sizeof(uint32_t));
+
+  std::vector<uint32_t> completed;
+  size_t n = ring.reclaim([&](const dma_desc &d) {
+    EXPECT_EQ(d.transferred(), row_len);
+    EXPECT_EQ(bool(d.status & DMA_DESC_STS_RXSOF), d.id == 0);
+    EXPECT_EQ(bool(d.status & DMA_DESC_STS_RXEOF), d.id == height - 1);
+    completed.push_back(d.id);
+  });
+  EXPECT_EQ(n, size_t(height));
+  EXPECT_EQ(completed, (std::vector<uint32_t>{0, 1, 2, 3}));
+
+  for (int h = 0; h < height; h++) {
+    for (int w = 0; w < width; w++) {
+      EXPECT_EQ(rows[height - 1 - h][w], uint32_t(h * width + w));
+    }
+  }
+}
+
+TEST_F(DmaRingTest, PartialPacketCompletesRowsInOrder) {
+  const size_t row_len = 16;
+  dma_ring ring(descs, RING_SIZE);
+  dma_engine_model engine(ring);
+  std::vector<uint8_t> rows(row_len * 4);
+  std::vector<uint8_t> packet(row_len * 6, 0xab);
+
+  for (int h = 0; h < 4; h++) {
+    ASSERT_TRUE(ring.submit(uintptr_t(&rows[h * row_len]), row_len, 0, h));
+  }
+
+  // Only four rows fit: the engine backpressures the rest of the packet
+  EXPECT_EQ(engine.s2mm(packet.data(), packet.size()), row_len * 4);
+
+  // Nothing completes past a descriptor that is still outstanding
+  EXPECT_EQ(ring.reclaim([](const dma_desc &) {}), 4u);
+  EXPECT_EQ(ring.reclaim([](const dma_desc &) {}), 0u);
+}
+
+// A frame with more rows than the ring has descriptors, as main.cc receives
+// it: rows are queued again as soon as earlier rows complete
+TEST_F(DmaRingTest, FrameTallerThanRing) {
+  const int width = 5;
+  const int height = 3 * RING_SIZE + 1;
+  const size_t row_len = width * sizeof(uint32_t);
+  dma_ring ring(descs, RING_SIZE);
+  dma_engine_model engine(ring);
+
+  std::vector<uint32_t> frame(width * height);
+  std::iota(frame.begin(), frame.end(), 0);
+  std::vector<std::vector<uint32_t>> rows(height, std::vector<uint32_t>(width));
+
+  int queued = 0;
+  int done = 0;
+  size_t sent = 0;
+  const uint8_t *packet = reinterpret_cast<const uint8_t *>(frame.data());
+  size_t packet_len = frame.size() * sizeof(uint32_t);
+  for (int round = 0; done < height; round++) {
+    ASSERT_LT(round, height);
+    while (queued < height &&
+           ring.submit(uintptr_t(rows[queued].data()), row_len, 0, queued)) {
+      queued += 1;
+    }
+    EXPECT_TRUE(queued == height || ring.free() == 0);
+
+    sent += engine.s2mm(packet + sent, packet_len - sent);
+    ring.reclaim([&](const dma_desc &d) {
+      EXPECT_EQ(d.id, uint32_t(done));
+      EXPECT_EQ(bool(d.status & DMA_DESC_STS_RXSOF), d.id == 0);
+      EXPECT_EQ(bool(d.status & DMA_DESC_STS_RXEOF), d.id == height - 1);
+      done += 1;
+    });
+  }
+  EXPECT_EQ(sent, packet_len);
+
+  for (int h = 0; h < height; h++) {
+    for (int w = 0; w < width; w++) {
+      EXPECT_EQ(rows[h][w], uint32_t(h * width + w));
+    }
+  }
+}
+
+TEST_F(DmaRingTest, RecyclesDescriptorsAcrossFrames) {
+  const size_t row_len = 8;
+  dma_ring ring(descs, RING_SIZE);
+  dma_engine_model engine(ring);
+  std::vector<uint8_t> buffers[2] = {std::vector<uint8_t>(row_len * 3),
+                                     std::vector<uint8_t>(row_len * 3)};
+
+  // Three rows per frame on an eight entry ring wraps around several times
+  for (int frame = 0; frame < 10; frame++) {
+    std::vector<uint8_t> &buf = buffers[frame % 2];
+    for (int h = 0; h < 3; h++) {
+      ASSERT_TRUE(ring.submit(uintptr_t(&buf[h * row_len]), row_len, 0, h));
+    }
+
+    std::vector<uint8_t> packet(row_len * 3, uint8_t(frame));
+    EXPECT_EQ(engine.s2mm(packet.data(), packet.size()), packet.size());
+    EXPECT_EQ(ring.reclaim([](const dma_desc &) {}), 3u);
+    EXPECT_EQ(ring.pending(), 0u);
+    EXPECT_EQ(buf, packet);
+  }
+}
+
+TEST_F(DmaRingTest, GatherSceneBlob) {
+  dma_ring ring(descs, RING_SIZE, 12);
+  dma_engine_model engine(ring);
+
+  // Camera and scene objects are sent from separate buffers without a
+  // staging copy
+  std::vector<uint32_t> camera(7, 0x11111111);
+  std::vector<uint32_t> objects(5, 0x22222222);
+  ASSERT_TRUE(ring.submit(uintptr_t(camera.data()), camera.size() * 4,
+                          DMA_DESC_CTRL_SOF, 0));
+  ASSERT_TRUE(ring.submit(uintptr_t(objects.data()), objects.size() * 4,
+                          DMA_DESC_CTRL_EOF, 1));
+
+  std::vector<uint32_t> stream(12);
+  EXPECT_EQ(engine.mm2s(stream.data(), stream.size() * 4), 48u);
+  for (int i = 0; i < 12; i++) {
+    EXPECT_EQ(stream[i], i < 7 ? 0x11111111u : 0x22222222u);
+  }
+  EXPECT_EQ(ring.reclaim([](const dma_desc &) {}), 5u);
+}
+
+TEST_F(DmaRingTest, ReportsDescriptorErrors) {
+  dma_ring ring(descs, RING_SIZE);
+  dma_engine_model engine(ring);
+  std::vector<uint8_t> buf(32);
+
+  ASSERT_TRUE(ring.submit(uintptr_t(buf.data()), buf.size(), 0, 3));
+  engine.fail_next(DMA_DESC_STS_SLVERR);
+
+  int errors = 0;
+  ring.reclaim([&](const dma_desc &d) {
+    if (d.status & DMA_DESC_STS_ERR_MASK) {
+      errors += 1;
+      EXPECT_EQ(d.id, 3u);
+    }
+  });
+  EXPECT_EQ(errors, 1);
+}
+
+} // namespace
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame_export.hpp"
+
+namespace {
+
+frame random_frame(int width, int height, int levels) {
+  frame f(width, height);
+  std::mt19937 rng(1234);
+  for (auto &c : f.rgb) {
+    c = uint8_t(rng() % levels);
+  }
+  return f;
+}
+
+class FrameExportTest : public testing::Test {};
+
+TEST_F(FrameExportTest, PpmHeaderAndRaster) {
+  frame f(2, 1);
+  f.set(0, 0, 1, 2, 3);
+  f.set(1, 0, 4, 5, 6);
+
+  std::vector<uint8_t> out;
+  encode_ppm(f, out);
+
+  std::string header = "P6\n2 1\n255\n";
+  ASSERT_EQ(out.size(), header.size() + 6);
+  EXPECT_EQ(std::string(out.begin(), out.begin() + header.size()), header);
+  EXPECT_EQ(out.back(), 6);
+
+  frame decoded;
+  ASSERT_TRUE(decode_ppm(out.data(), out.size(), decoded));
+  EXPECT_EQ(decoded.rgb, f.rgb);
+}
+
+TEST_F(FrameExportTest, QoiRoundTrip) {
+  // Few levels exercise runs, index and diff chunks; many levels luma and rgb
+  for (int levels : {2, 5, 64, 256}) {
+    frame f = random_frame(37, 23, levels);
+    std::vector<uint8_t> out;
+    encode_qoi(f, out);
+    EXPECT_LE(out.size(), qoi_max_size(f.width, f.height));
+
+    frame decoded;
+    ASSERT_TRUE(decode_qoi(out.data(), out.size(), decoded));
+    EXPECT_EQ(decoded.width, f.width);
+    EXPECT_EQ(decoded.height, f.height);
+    EXPECT_EQ(decoded.rgb, f.rgb) << "levels: " << levels;
+  }
+}
+
+TEST_F(FrameExportTest, QoiCompressesGradient) {
+  frame f(400, 225);
+  for (int h = 0; h < f.height; h++) {
+    for (int w = 0; w < f.width; w++) {
+      f.set(w, h, uint8_t(255 - h / 2), uint8_t(255 - h / 3), 255);
+    }
+  }
+
+  std::vector<uint8_t> out;
+  encode_qoi(f, out);
+  // Long runs: a few bytes per row
+  EXPECT_LT(out.size(), size_t(f.height) * 16);
+
+  frame decoded;
+  ASSERT_TRUE(decode_qoi(out.data(), out.size(), decoded));
+  EXPECT_EQ(decoded.rgb, f.rgb);
+}
+
+TEST_F(FrameExportTest, ImportSkipsLogOutput) {
+  frame a = random_frame(8, 4, 16);
+  frame b = random_frame(3, 9, 256);
+
+  std::string log = "DMA took 1234 times units\nRTFB but not a frame\n";
+  std::vector<uint8_t> capture(log.begin(), log.end());
+  export_frame(a, FRAME_FORMAT_QOI, capture);
+  capture.push_back('\n');
+  export_frame(b, FRAME_FORMAT_PPM, capture);
+
+  size_t offset = 0;
+  frame f;
+  ASSERT_TRUE(import_frame(capture.data(), capture.size(), offset, f));
+  EXPECT_EQ(f.rgb, a.rgb);
+  ASSERT_TRUE(import_frame(capture.data(), capture.size(), offset, f));
+  EXPECT_EQ(f.rgb, b.rgb);
+  EXPECT_EQ(offset, capture.size());
+  EXPECT_FALSE(import_frame(capture.data(), capture.size(), offset, f));
+}
+
+TEST_F(FrameExportTest, ImportSkipsTextRecords) {
+  frame a = random_frame(8, 4, 16);
+  frame b = random_frame(3, 9, 256);
+
+  // A text record that happens to contain a whole exported frame
+  std::vector<uint8_t> inner;
+  export_frame(b, FRAME_FORMAT_PPM, inner);
+  std::vector<uint8_t> capture;
+  export_text("Rendering 100 frames\n", capture);
+  export_frame(a, FRAME_FORMAT_QOI, capture);
+  export_text(std::string(inner.begin(), inner.end()), capture);
+
+  size_t offset = 0;
+  frame_header header;
+  size_t payload;
+  frame f;
+  ASSERT_TRUE(import_record(capture.data(), capture.size(), offset, header,
+                            payload, f));
+  EXPECT_EQ(header.format, FRAME_FORMAT_TEXT);
+  EXPECT_EQ(std::string(reinterpret_cast<const char *>(&capture[payload]),
+                        header.payload_length),
+            "Rendering 100 frames\n");
+
+  offset = 0;
+  ASSERT_TRUE(import_frame(capture.data(), capture.size(), offset, f));
+  EXPECT_EQ(f.rgb, a.rgb);
+  EXPECT_FALSE(import_frame(capture.data(), capture.size(), offset, f));
+  EXPECT_EQ(offset, capture.size());
+}
+
+TEST_F(FrameExportTest, TruncatedFrameIsRejected) {
+  frame a = random_frame(8, 8, 256);
+  std::vector<uint8_t> capture;
+  export_frame(a, FRAME_FORMAT_QOI, capture);
+  capture.resize(capture.size() - 10);
+
+  size_t offset = 0;
+  frame f;
+  EXPECT_FALSE(import_frame(capture.data(), capture.size(), offset, f));
+}
+
+} // namespace
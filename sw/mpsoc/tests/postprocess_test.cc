@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "postprocess.hpp"
+#include "scene.hpp"
+
+namespace {
+
+void expect_matches_reference(const std::vector<uint32_t> &rx) {
+  std::vector<uint8_t> out(rx.size() * 3);
+  shade_sky(rx.data(), rx.size(), out.data());
+
+  for (size_t i = 0; i < rx.size(); i++) {
+    rgb expected = shade_sky_reference(rx[i]);
+    ASSERT_EQ(out[i * 3 + 0], expected.r) << "raw: " << int32_t(rx[i]);
+    ASSERT_EQ(out[i * 3 + 1], expected.g) << "raw: " << int32_t(rx[i]);
+    ASSERT_EQ(out[i * 3 + 2], expected.b) << "raw: " << int32_t(rx[i]);
+  }
+}
+
+class PostprocessTest : public testing::Test {};
+
+TEST_F(PostprocessTest, GammaThresholdsAreExact) {
+  const gamma_lut &lut = default_gamma_lut();
+
+  for (int b = 1; b < 256; b++) {
+    float t = lut.thresholds[b];
+    EXPECT_GE(gamma_lut::reference(t), b);
+    EXPECT_LT(gamma_lut::reference(std::nextafter(t, -1.0f)), b);
+  }
+}
+
+TEST_F(PostprocessTest, GammaBucketsHoldOneThreshold) {
+  // Together with exact thresholds, this makes the LUT exact for every float
+  const gamma_lut &lut = default_gamma_lut();
+
+  for (int i = 0; i < gamma_lut::SIZE; i++) {
+    uint32_t first = uint32_t(gamma_lut::FIRST + i) << gamma_lut::SHIFT;
+    uint32_t last = first + (1u << gamma_lut::SHIFT) - 1;
+    float lo, hi;
+    std::memcpy(&lo, &first, sizeof(lo));
+    std::memcpy(&hi, &last, sizeof(hi));
+    EXPECT_EQ(gamma_lut::bucket(lo), i);
+    EXPECT_EQ(gamma_lut::bucket(hi), i);
+    EXPECT_LE(gamma_lut::reference(hi), lut.base(i) + 1) << "bucket " << i;
+  }
+  EXPECT_EQ(gamma_lut::reference(std::nextafter(gamma_lut::LOWEST, 0.0f)), 0);
+  EXPECT_EQ(gamma_lut::reference(gamma_lut::HIGHEST), 255);
+}
+
+TEST_F(PostprocessTest, GammaMatchesReferenceAroundThresholds) {
+  const gamma_lut &lut = default_gamma_lut();
+
+  for (int b = 1; b < 256; b++) {
+    float x = lut.thresholds[b];
+    for (int i = 0; i < 4; i++) {
+      x = std::nextafter(x, -1.0f);
+    }
+    for (int i = 0; i < 8; i++) {
+      EXPECT_EQ(lut(x), gamma_lut::reference(x)) << x;
+      x = std::nextafter(x, 2.0f);
+    }
+  }
+
+  for (float x : {-1.0f, -0.0f, 0.0f, 0.999f, 1.0f, 2.0f, 1e30f, NAN}) {
+    EXPECT_EQ(lut(x), gamma_lut::reference(x)) << x;
+  }
+}
+
+TEST_F(PostprocessTest, MatchesReferenceForAllSmallInputs) {
+  // Every 16.16 value in [-8, 8)
+  std::vector<uint32_t> rx;
+  for (int32_t raw = -8 * FP_2_POW_QW; raw < 8 * FP_2_POW_QW; raw++) {
+    rx.push_back(uint32_t(raw));
+  }
+  expect_matches_reference(rx);
+}
+
+TEST_F(PostprocessTest, MatchesReferenceForRandomInputs) {
+  std::mt19937 rng(7);
+  std::vector<uint32_t> rx(100003); // odd length exercises the scalar tail
+  for (auto &v : rx) {
+    v = rng();
+  }
+  rx[0] = 0x80000000;
+  rx[1] = 0x7fffffff;
+  expect_matches_reference(rx);
+}
+
+TEST_F(PostprocessTest, MatchesReferenceForRenderedFrame) {
+  Scene scene(64, 16.0f / 9.0f, 1.0f);
+  int width = int(scene.image_width);
+  int height = int(scene.image_height);
+
+  std::vector<uint32_t> rx;
+  for (int h = 0; h < height; h++) {
+    for (int w = 0; w < width; w++) {
+      vec3 ray_direction = scene.pixel_center(w, h) - scene.camera_center;
+      rx.push_back(uint32_t(FLOAT_2_FIX(ray_direction[1])));
+    }
+  }
+  expect_matches_reference(rx);
+}
+
+} // namespace
@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "profile.hpp"
+
+namespace {
+
+// Advances by a fixed step on every read
+struct fake_clock {
+  uint64_t t = 0;
+  uint64_t step = 1;
+  uint64_t now() { return t += step; }
+  uint64_t frequency() const { return 1000; }
+};
+
+class ProfileTest : public testing::Test {};
+
+TEST_F(ProfileTest, BucketsAreContiguousAndBounded) {
+  EXPECT_EQ(latency_histogram::bucket(0), 0);
+  EXPECT_EQ(latency_histogram::bucket(31), 31);
+  EXPECT_EQ(latency_histogram::bucket(UINT64_MAX),
+            latency_histogram::BUCKETS - 1);
+  EXPECT_EQ(latency_histogram::bucket_upper(latency_histogram::BUCKETS - 1),
+            UINT64_MAX);
+
+  for (int b = 0; b + 1 < latency_histogram::BUCKETS; b++) {
+    uint64_t upper = latency_histogram::bucket_upper(b);
+    ASSERT_EQ(latency_histogram::bucket(upper), b);
+    ASSERT_EQ(latency_histogram::bucket(upper + 1), b + 1);
+  }
+
+  std::mt19937_64 rng(7);
+  for (int i = 0; i < 100000; i++) {
+    uint64_t v = rng() >> (rng() % 64);
+    uint64_t upper =
+        latency_histogram::bucket_upper(latency_histogram::bucket(v));
+    ASSERT_GE(upper, v);
+    ASSERT_LE(double(upper - v), double(v) / latency_histogram::SUB_BUCKETS);
+  }
+}
+
+TEST_F(ProfileTest, Statistics) {
+  latency_histogram h;
+  EXPECT_EQ(h.percentile(0.99), 0u);
+  EXPECT_EQ(h.min(), 0u);
+
+  // 1..1000: one outlier percent above 990
+  for (uint64_t v = 1000; v >= 1; v--) {
+    h.record(v);
+  }
+  EXPECT_EQ(h.count(), 1000u);
+  EXPECT_EQ(h.min(), 1u);
+  EXPECT_EQ(h.max(), 1000u);
+  EXPECT_DOUBLE_EQ(h.mean(), 500.5);
+  EXPECT_EQ(h.percentile(0.0), 1u);
+  EXPECT_EQ(h.percentile(1.0), 1000u);
+
+  uint64_t p99 = h.percentile(0.99);
+  EXPECT_GE(p99, 990u);
+  EXPECT_LE(p99, 990u + 990u / latency_histogram::SUB_BUCKETS);
+
+  h.reset();
+  h.record(12);
+  EXPECT_EQ(h.percentile(0.5), 12u);
+  EXPECT_EQ(h.percentile(0.99), 12u);
+}
+
+TEST_F(ProfileTest, ScopedTimerRecordsIntoStage) {
+  profiler<fake_clock> prof(fake_clock{0, 5});
+  for (int i = 0; i < 3; i++) {
+    auto t = prof.time(STAGE_SHADE);
+  }
+  {
+    auto outer = prof.time(STAGE_UPLOAD);
+    auto inner = prof.time(STAGE_ENCODE);
+  }
+
+  EXPECT_EQ(prof.stage(STAGE_SHADE).count(), 3u);
+  EXPECT_EQ(prof.stage(STAGE_SHADE).max(), 5u);
+  EXPECT_EQ(prof.stage(STAGE_ENCODE).max(), 5u);
+  // Destroyed after inner, which read the clock once
+  EXPECT_EQ(prof.stage(STAGE_UPLOAD).max(), 15u);
+  EXPECT_EQ(prof.stage(STAGE_OUTPUT).count(), 0u);
+}
+
+TEST_F(ProfileTest, ChronoClockIsMonotonic) {
+  profiler<chrono_clock> prof;
+  uint64_t a = prof.now();
+  uint64_t b = prof.now();
+  EXPECT_LE(a, b);
+  EXPECT_EQ(prof.frequency(), 1000000000u);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+TEST_F(ProfileTest, RdtscClockIsCalibrated) {
+  rdtsc_clock clock(1);
+  EXPECT_GT(clock.frequency(), 1000000u);
+  uint64_t a = clock.now();
+  uint64_t b = clock.now();
+  EXPECT_LE(a, b);
+}
+#endif
+
+TEST_F(ProfileTest, BinaryRoundTripInsideLog) {
+  profiler<fake_clock> prof;
+  for (uint64_t v = 1; v <= 100; v++) {
+    prof.record(STAGE_RENDER_RECEIVE, v * 10);
+    prof.record(STAGE_OUTPUT, 3);
+  }
+  std::vector<profile_record> records = prof.summary();
+
+  std::string log = "RTPF but not a profile\n";
+  std::vector<uint8_t> capture(log.begin(), log.end());
+  export_profile(prof.frequency(), records, capture);
+  EXPECT_EQ(capture.size(), log.size() + sizeof(frame_header) +
+                                sizeof(profile_header) +
+                                STAGE_COUNT * sizeof(profile_record));
+
+  size_t offset = 0;
+  uint64_t frequency = 0;
+  std::vector<profile_record> imported;
+  ASSERT_TRUE(import_profile(capture.data(), capture.size(), offset,
+                             frequency, imported));
+  EXPECT_EQ(frequency, 1000u);
+  ASSERT_EQ(imported.size(), size_t(STAGE_COUNT));
+  EXPECT_EQ(offset, capture.size());
+
+  const profile_record &r = imported[STAGE_RENDER_RECEIVE];
+  EXPECT_EQ(r.count, 100u);
+  EXPECT_EQ(r.min, 10u);
+  EXPECT_EQ(r.mean, 505u);
+  EXPECT_EQ(r.max, 1000u);
+  EXPECT_EQ(r.p99, records[STAGE_RENDER_RECEIVE].p99);
+  EXPECT_EQ(imported[STAGE_OUTPUT].p99, 3u);
+  EXPECT_EQ(imported[STAGE_SHADE].count, 0u);
+
+  EXPECT_FALSE(import_profile(capture.data(), capture.size(), offset,
+                              frequency, imported));
+}
+
+// A frame whose raster happens to hold a whole profile record is skipped
+TEST_F(ProfileTest, ProfileInsideFrameIsIgnored) {
+  profiler<fake_clock> prof;
+  prof.record(STAGE_SHADE, 2);
+  std::vector<uint8_t> inner;
+  export_profile(prof.frequency(), prof.summary(), inner);
+
+  frame f(int(inner.size()), 1);
+  std::copy(inner.begin(), inner.end(), f.rgb.begin());
+  std::vector<uint8_t> capture;
+  export_frame(f, FRAME_FORMAT_PPM, capture);
+
+  size_t offset = 0;
+  uint64_t frequency = 0;
+  std::vector<profile_record> imported;
+  EXPECT_FALSE(import_profile(capture.data(), capture.size(), offset,
+                              frequency, imported));
+  EXPECT_EQ(offset, capture.size());
+}
+
+TEST_F(ProfileTest, CsvInMicroseconds) {
+  profiler<fake_clock> prof;
+  prof.record(STAGE_SHADE, 2); // 2 ms at 1 kHz
+
+  char buf[1024] = {};
+  std::FILE *f = fmemopen(buf, sizeof(buf) - 1, "w");
+  ASSERT_NE(f, nullptr);
+  write_profile_csv(f, prof.frequency(), prof.summary());
+  std::fclose(f);
+
+  std::string csv(buf);
+  EXPECT_EQ(csv.rfind("stage,count,min_us,mean_us,p99_us,max_us\n", 0), 0u);
+  EXPECT_NE(csv.find("\nshade,1,2000.000,2000.000,2000.000,2000.000\n"),
+            std::string::npos);
+  EXPECT_NE(csv.find("\ncamera_serialise,0,"), std::string::npos);
+}
+
+} // namespace
@@ -0,0 +1,17 @@
+; Sky gradient of "Ray Tracing in One Weekend": blend white into light blue
+; with the height of the normalised ray direction.
+
+.const one 1.0 1.0 1.0
+.const half 0.5 0.5 0.5
+.const blue 0.5 0.7 1.0
+
+dot r2, r0, r0
+rsq r2, r2
+mul r2, r0, r2      ; unit direction
+splat r2, r2.y
+const r3, one
+add r2, r2, r3
+const r4, half
+mul r2, r2, r4      ; a = 0.5 * (y + 1)
+const r4, blue
+lerp r0, r3, r4, r2 ; (1 - a) * white + a * blue
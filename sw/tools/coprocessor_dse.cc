@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Design-space exploration of the coprocessor with coprocessor_model.
+//
+// Sweeps every combination of lanes, RGU depth, output FIFO depth and clock
+// for one resolution and DMA backpressure pattern, and prints one CSV row per
+// configuration. Configurations that no other configuration at the same
+// clock beats in both fps and register bits are marked as pareto. The
+// cheapest configuration that reaches the target frame rate is reported on
+// stderr.
+//
+// Usage: coprocessor_dse [--resolution 1920x1080] [--lanes 1,2,4,8]
+//                        [--depth 5,6,8] [--fifo 0,1,4,16]
+//                        [--clock 100,150,200,250] [--fps 60]
+//                        [--ready always|random:<p>|bursty:<on>:<off>]
+//                        [--sample-beats 65536]
+
+#include "coprocessor_model.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// https://stackoverflow.com/a/868894
+char *getCmdOption(char **begin, char **end, const std::string &option) {
+  char **itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end) {
+    return *itr;
+  }
+  return 0;
+}
+
+static std::vector<double> parse_list(const char *arg,
+                                      std::vector<double> fallback) {
+  if (!arg) {
+    return fallback;
+  }
+  std::vector<double> values;
+  std::stringstream ss(arg);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    values.push_back(std::atof(item.c_str()));
+  }
+  return values;
+}
+
+// m_axis_tready of the DMA, restarted for every configuration
+struct ready_pattern {
+  enum kind_t { ALWAYS, RANDOM, BURSTY } kind = ALWAYS;
+  double probability = 1.0;
+  uint64_t on = 1;
+  uint64_t off = 0;
+
+  bool parse(const std::string &s) {
+    if (s == "always") {
+      kind = ALWAYS;
+      return true;
+    }
+    if (s.rfind("random:", 0) == 0) {
+      kind = RANDOM;
+      probability = std::atof(s.c_str() + 7);
+      return probability > 0 && probability <= 1;
+    }
+    if (std::sscanf(s.c_str(), "bursty:%" SCNu64 ":%" SCNu64, &on, &off) ==
+        2) {
+      kind = BURSTY;
+      return on > 0;
+    }
+    return false;
+  }
+
+  frame_timing run(const coprocessor_model &model, uint32_t width,
+                   uint32_t height, uint64_t max_beats) const {
+    auto always = [] { return true; };
+    switch (kind) {
+    case RANDOM: {
+      std::mt19937 rng(1);
+      std::bernoulli_distribution p(probability);
+      auto ready = [&] { return p(rng); };
+      return model.run(width, height, always, ready, max_beats);
+    }
+    case BURSTY: {
+      uint64_t cycle = 0;
+      auto ready = [&] { return cycle++ % (on + off) < on; };
+      return model.run(width, height, always, ready, max_beats);
+    }
+    default:
+      return model.run(width, height, always, always, max_beats);
+    }
+  }
+};
+
+struct design_point {
+  coprocessor_config config;
+  frame_timing timing;
+  double fps;
+  bool pareto;
+};
+
+int main(int argc, char *argv[]) {
+  uint32_t width = 1920;
+  uint32_t height = 1080;
+  char *arg = getCmdOption(argv, argv + argc, "--resolution");
+  if (arg && (std::sscanf(arg, "%ux%u", &width, &height) != 2 || width == 0 ||
+              height == 0)) {
+    std::cerr << "Invalid resolution " << arg << std::endl;
+    return 1;
+  }
+
+  std::vector<double> lanes =
+      parse_list(getCmdOption(argv, argv + argc, "--lanes"), {1, 2, 4, 8});
+  std::vector<double> depths =
+      parse_list(getCmdOption(argv, argv + argc, "--depth"), {5, 6, 8});
+  std::vector<double> fifos =
+      parse_list(getCmdOption(argv, argv + argc, "--fifo"), {0, 1, 4, 16});
+  std::vector<double> clocks = parse_list(
+      getCmdOption(argv, argv + argc, "--clock"), {100, 150, 200, 250});
+
+  double target_fps = 60;
+  arg = getCmdOption(argv, argv + argc, "--fps");
+  if (arg) {
+    target_fps = std::atof(arg);
+  }
+
+  ready_pattern ready;
+  arg = getCmdOption(argv, argv + argc, "--ready");
+  if (arg && !ready.parse(arg)) {
+    std::cerr << "Invalid ready pattern " << arg << std::endl;
+    return 1;
+  }
+
+  uint64_t max_beats = 65536;
+  arg = getCmdOption(argv, argv + argc, "--sample-beats");
+  if (arg) {
+    max_beats = std::strtoull(arg, nullptr, 10);
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+
+  // The cycle count does not depend on the clock: simulate once per
+  // microarchitecture and scale
+  std::vector<design_point> points;
+  for (double l : lanes) {
+    for (double d : depths) {
+      for (double f : fifos) {
+        coprocessor_config config;
+        config.lanes = uint32_t(l);
+        config.depth = uint32_t(d);
+        config.fifo_depth = uint32_t(f);
+        if (config.lanes == 0 || config.depth == 0) {
+          continue;
+        }
+        frame_timing timing =
+            ready.run(coprocessor_model(config), width, height, max_beats);
+        if (timing.timed_out) {
+          std::cerr << "Frame did not complete with " << config.lanes
+                    << " lanes, depth " << config.depth << ", FIFO "
+                    << config.fifo_depth << std::endl;
+          return 1;
+        }
+
+        for (double c : clocks) {
+          config.clock_mhz = c;
+          points.push_back({config, timing, timing.fps(c), true});
+        }
+      }
+    }
+  }
+
+  for (design_point &p : points) {
+    uint64_t bits = p.config.register_bits();
+    for (const design_point &q : points) {
+      uint64_t q_bits = q.config.register_bits();
+      if (q.config.clock_mhz == p.config.clock_mhz && q.fps >= p.fps &&
+          q_bits <= bits && (q.fps > p.fps || q_bits < bits)) {
+        p.pareto = false;
+        break;
+      }
+    }
+  }
+
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+          .count();
+
+  std::printf("lanes,depth,fifo,clock_mhz,period_cycles,cycles_per_pixel,"
+              "stalls,fps,register_bits,pareto\n");
+  const design_point *best = nullptr;
+  for (const design_point &p : points) {
+    std::printf("%u,%u,%u,%.1f,%llu,%.4f,%llu,%.2f,%llu,%d\n", p.config.lanes,
+                p.config.depth, p.config.fifo_depth, p.config.clock_mhz,
+                (unsigned long long)p.timing.period(),
+                p.timing.cycles_per_pixel(),
+                (unsigned long long)p.timing.stalls, p.fps,
+                (unsigned long long)p.config.register_bits(), p.pareto ? 1 : 0);
+
+    if (p.fps >= target_fps &&
+        (!best ||
+         p.config.register_bits() < best->config.register_bits() ||
+         (p.config.register_bits() == best->config.register_bits() &&
+          p.config.clock_mhz < best->config.clock_mhz))) {
+      best = &p;
+    }
+  }
+
+  std::cerr << points.size() << " configurations of " << width << "x"
+            << height << " in " << seconds << " s" << std::endl;
+  if (!best) {
+    std::cerr << "No configuration reaches " << target_fps << " fps"
+              << std::endl;
+    return 1;
+  }
+  std::cerr << "Cheapest configuration for " << target_fps
+            << " fps: lanes=" << best->config.lanes
+            << " depth=" << best->config.depth
+            << " fifo=" << best->config.fifo_depth
+            << " clock=" << best->config.clock_mhz << " MHz (" << best->fps
+            << " fps)" << std::endl;
+  return 0;
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Extract the frames exported by the MPSoC application from a raw UART
+// capture and store them as binary PPM files. Log text records are printed
+// as they are, stage profiles as CSV.
+//
+// Usage: frame_decode <capture> [-o <prefix>]
+
+#include "frame_export.hpp"
+#include "profile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// https://stackoverflow.com/a/868894
+char *getCmdOption(char **begin, char **end, const std::string &option) {
+  char **itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end) {
+    return *itr;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <capture> [-o <prefix>]"
+              << std::endl;
+    return 1;
+  }
+
+  std::string prefix = "frame";
+  char *prefix_arg = getCmdOption(argv, argv + argc, "-o");
+  if (prefix_arg) {
+    prefix = prefix_arg;
+  }
+
+  std::ifstream in(argv[1], std::ios::binary);
+  if (!in) {
+    std::cerr << "Cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+  std::vector<uint8_t> capture((std::istreambuf_iterator<char>(in)),
+                               std::istreambuf_iterator<char>());
+
+  // Walk the records in order. Payloads are never searched, so a frame cannot
+  // contain a false profile or frame header.
+  size_t offset = 0;
+  int count = 0;
+  frame_header header;
+  size_t payload;
+  frame f;
+  while (import_record(capture.data(), capture.size(), offset, header, payload,
+                       f)) {
+    const uint8_t *data = capture.data() + payload;
+    if (header.format == FRAME_FORMAT_TEXT) {
+      std::cout.write(reinterpret_cast<const char *>(data),
+                      header.payload_length);
+      continue;
+    }
+
+    if (header.format == FRAME_FORMAT_PROFILE) {
+      uint64_t frequency;
+      std::vector<profile_record> records;
+      if (parse_profile(data, header.payload_length, frequency, records)) {
+        std::cout << "Profile at byte " << offset << ", " << frequency
+                  << " ticks/s:" << std::endl;
+        write_profile_csv(stdout, frequency, records);
+        std::fflush(stdout);
+      }
+      continue;
+    }
+
+    std::vector<uint8_t> ppm;
+    encode_ppm(f, ppm);
+
+    std::string name = prefix + "_" + std::to_string(count) + ".ppm";
+    std::ofstream out(name, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(ppm.data()), ppm.size());
+
+    std::cout << name << ": " << f.width << "x" << f.height
+              << ", frame ends at byte " << offset << std::endl;
+    count += 1;
+  }
+
+  if (count == 0) {
+    std::cerr << "No frames found" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Fixed-point precision explorer for the coprocessor datapath.
+//
+// Runs the ray generation of rt_rgu_5_stage bit-accurately at every IW.QW in
+// the given ranges, for every combination of resolution and focal length,
+// and prints the worst max and RMS error against float as CSV, together
+// with the DSP48E2 slices per RGU multiplier. The sweep samples every
+// stride-th pixel; the narrowest format within the pixel-error budget is
+// then checked on every pixel and printed as parameters.vh settings.
+// --update rewrites the FP_IW, FP_QW and FP_WL parameters of an existing
+// parameters.vh. --round selects the rounding of the camera registers and of
+// every resize (ROUND of sfp_resize) instead of truncation.
+//
+// Usage: precision_explore [--resolution 640x360,1920x1080,3840x2160]
+//                          [--focal 0.5,1,2,4] [--iw 4:20] [--qw 4:24]
+//                          [--budget <pixels>] [--stride 4]
+//                          [--round trunc|half-up|half-even]
+//                          [--update hw/rt/parameters.vh]
+
+#include "precision.hpp"
+#include "scene.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// DSP48E2 slices of the KV260 (XCK26)
+static const int KV260_DSP48E2 = 1248;
+
+// sfp_vec_mul_s x 2 in rt_rgu_5_stage: x and y times the three components
+// of the pixel deltas. The DSP counts below are for all six, i.e. a lane
+// that outputs the whole ray direction. They come from the tiling in
+// dsp48e2_per_multiplier() and have not been checked against a synthesis
+// run of that design.
+static const int RGU_MULTIPLIERS = 6;
+
+// rt_core currently only sends ray_direction[1], so synthesis removes the x
+// and z products. This is what the Vivado report in the README measures:
+// 2 x 4 = 8 DSP48E2 at 16.16 with full products.
+static const int RGU_LIVE_MULTIPLIERS = 2;
+
+// https://stackoverflow.com/a/868894
+char *getCmdOption(char **begin, char **end, const std::string &option) {
+  char **itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end) {
+    return *itr;
+  }
+  return 0;
+}
+
+static std::vector<std::string> split(const std::string &s, char sep) {
+  std::vector<std::string> items;
+  std::stringstream ss(s);
+  std::string item;
+  while (std::getline(ss, item, sep)) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+static bool parse_round(const std::string &s, sfp_round &round) {
+  if (s == "trunc") {
+    round = SFP_TRUNCATE;
+  } else if (s == "half-up") {
+    round = SFP_ROUND_HALF_UP;
+  } else if (s == "half-even") {
+    round = SFP_ROUND_HALF_EVEN;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool parse_range(const char *arg, int &lo, int &hi) {
+  return arg && std::sscanf(arg, "%d:%d", &lo, &hi) == 2 && lo >= 1 &&
+         lo <= hi;
+}
+
+struct scene_config {
+  int width;
+  int height;
+  float focal_length;
+};
+
+struct format_result {
+  sfp_format format;
+  double max = 0;
+  double rms = 0;
+  double pixels = 0;
+  bool passed = true;
+};
+
+static format_result evaluate(sfp_format f,
+                              const std::vector<scene_config> &scenes,
+                              int stride, double budget, sfp_round round) {
+  format_result r{f};
+  for (const scene_config &s : scenes) {
+    Scene scene(float(s.width), float(s.width) / float(s.height),
+                s.focal_length);
+    precision_error e = rgu_error(scene, f, stride, budget, round);
+    r.max = std::max(r.max, e.max);
+    r.rms = std::max(r.rms, e.rms);
+    r.pixels = std::max(r.pixels, e.pixels);
+    if (e.exceeded || e.pixels > budget) {
+      r.passed = false;
+      break;
+    }
+  }
+  return r;
+}
+
+static bool update_parameters(const std::string &path, sfp_format f) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::string text = ss.str();
+
+  const std::pair<const char *, int> params[] = {
+      {"FP_IW", f.iw}, {"FP_QW", f.qw}, {"FP_WL", f.wl()}};
+  for (const auto &[name, value] : params) {
+    std::regex re(std::string("parameter ") + name + " = [0-9]+;");
+    if (!std::regex_search(text, re)) {
+      return false;
+    }
+    text = std::regex_replace(text, re,
+                              std::string("parameter ") + name + " = " +
+                                  std::to_string(value) + ";");
+  }
+
+  std::ofstream out(path);
+  out << text;
+  return bool(out);
+}
+
+int main(int argc, char *argv[]) {
+  std::string resolutions = "640x360,1920x1080,3840x2160";
+  std::string focal_lengths = "0.5,1,2,4";
+  int iw_lo = 4, iw_hi = 20;
+  int qw_lo = 4, qw_hi = 24;
+  double budget = 0.25;
+  int stride = 4;
+  sfp_round round = SFP_TRUNCATE;
+
+  char *arg = getCmdOption(argv, argv + argc, "--resolution");
+  if (arg) {
+    resolutions = arg;
+  }
+  arg = getCmdOption(argv, argv + argc, "--focal");
+  if (arg) {
+    focal_lengths = arg;
+  }
+  arg = getCmdOption(argv, argv + argc, "--iw");
+  if (arg && !parse_range(arg, iw_lo, iw_hi)) {
+    std::cerr << "Invalid IW range " << arg << std::endl;
+    return 1;
+  }
+  arg = getCmdOption(argv, argv + argc, "--qw");
+  if (arg && !parse_range(arg, qw_lo, qw_hi)) {
+    std::cerr << "Invalid QW range " << arg << std::endl;
+    return 1;
+  }
+  arg = getCmdOption(argv, argv + argc, "--budget");
+  if (arg) {
+    budget = std::atof(arg);
+  }
+  arg = getCmdOption(argv, argv + argc, "--stride");
+  if (arg) {
+    stride = std::max(1, std::atoi(arg));
+  }
+  arg = getCmdOption(argv, argv + argc, "--round");
+  if (arg && !parse_round(arg, round)) {
+    std::cerr << "Invalid rounding mode " << arg << std::endl;
+    return 1;
+  }
+  if (iw_hi + qw_hi > 62) {
+    std::cerr << "Formats wider than 62 bits are not supported" << std::endl;
+    return 1;
+  }
+
+  std::vector<scene_config> scenes;
+  for (const std::string &r : split(resolutions, ',')) {
+    int w, h;
+    if (std::sscanf(r.c_str(), "%dx%d", &w, &h) != 2 || w < 1 || h < 1) {
+      std::cerr << "Invalid resolution " << r << std::endl;
+      return 1;
+    }
+    for (const std::string &f : split(focal_lengths, ',')) {
+      scenes.push_back({w, h, std::strtof(f.c_str(), nullptr)});
+    }
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+
+  std::printf("iw,qw,wl,max_error,rms_error,max_error_pixels,passed,"
+              "dsp_per_mul,rgu_lanes\n");
+  std::vector<format_result> candidates;
+  for (int iw = iw_lo; iw <= iw_hi; iw++) {
+    for (int qw = qw_lo; qw <= qw_hi; qw++) {
+      format_result r = evaluate({iw, qw}, scenes, stride, budget, round);
+      int dsp = rgu_uses_dsp({iw, qw})
+                    ? 1
+                    : dsp48e2_per_multiplier(iw + qw, iw + qw);
+      std::printf("%d,%d,%d,%.3g,%.3g,%.3g,%d,%d,%d\n", iw, qw, iw + qw,
+                  r.max, r.rms, r.pixels, r.passed ? 1 : 0, dsp,
+                  KV260_DSP48E2 / (RGU_MULTIPLIERS * dsp));
+      if (r.passed) {
+        candidates.push_back(r);
+      }
+    }
+  }
+
+  // Narrowest first, then the most accurate
+  std::sort(candidates.begin(), candidates.end(),
+            [](const format_result &a, const format_result &b) {
+              if (a.format.wl() != b.format.wl()) {
+                return a.format.wl() < b.format.wl();
+              }
+              return a.pixels < b.pixels;
+            });
+
+  // The sweep sampled the image, confirm on every pixel
+  const format_result *best = nullptr;
+  format_result confirmed;
+  for (const format_result &c : candidates) {
+    confirmed = evaluate(c.format, scenes, 1, budget, round);
+    if (confirmed.passed) {
+      best = &confirmed;
+      break;
+    }
+  }
+
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0)
+          .count();
+  std::cerr << scenes.size() << " scenes, "
+            << (iw_hi - iw_lo + 1) * (qw_hi - qw_lo + 1) << " formats in "
+            << seconds << " s" << std::endl;
+
+  if (!best) {
+    std::cerr << "No format meets the budget of " << budget << " pixels"
+              << std::endl;
+    return 1;
+  }
+
+  sfp_format f = best->format;
+  int dsp = rgu_uses_dsp(f) ? 1 : dsp48e2_per_multiplier(f.wl(), f.wl());
+  int dsp_full = dsp48e2_per_multiplier(32, 32);
+  std::cerr << "Narrowest format within " << budget << " pixels: " << f.iw
+            << "." << f.qw << " (max error " << best->max << ", "
+            << best->pixels << " pixels, rms " << best->rms << ")"
+            << std::endl;
+  std::cerr << "DSP48E2 per RGU lane: " << RGU_MULTIPLIERS * dsp
+            << " (16.16 with full products: " << RGU_MULTIPLIERS * dsp_full
+            << "), " << RGU_LIVE_MULTIPLIERS * dsp
+            << " with the y component only (16.16 with full products: "
+            << RGU_LIVE_MULTIPLIERS * dsp_full << ")" << std::endl;
+  std::cerr << std::endl << "// parameters.vh" << std::endl;
+  std::cerr << "parameter FP_IW = " << f.iw << ";" << std::endl;
+  std::cerr << "parameter FP_QW = " << f.qw << ";" << std::endl;
+  std::cerr << "parameter FP_WL = " << f.wl() << ";" << std::endl;
+  std::cerr << std::endl << "// scene.hpp, parameters.hpp" << std::endl;
+  std::cerr << "#define FP_IW " << f.iw << std::endl;
+  std::cerr << "#define FP_QW " << f.qw << std::endl;
+  std::cerr << "#define FP_2_POW_QW " << (1ll << f.qw) << std::endl;
+  std::cerr << "#define FP_WL " << f.wl() << std::endl;
+
+  arg = getCmdOption(argv, argv + argc, "--update");
+  if (arg) {
+    if (!update_parameters(arg, f)) {
+      std::cerr << "Cannot update " << arg << std::endl;
+      return 1;
+    }
+    std::cerr << "Updated " << arg << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2025 Hugo Melder
+
+// Assembler for rt_shader_core.
+//
+// Prints the configuration stream of the program (header, instructions,
+// constants) as one hex word per line, e.g. for $readmemh or to be sent over
+// s_cfg. With --eval the program is run on one fragment by the reference
+// interpreter instead and r0 is printed. --disassemble lists the
+// instructions as decoded from their encoding.
+//
+// Usage: shader_asm <program.s> [--eval <x,y,z>] [--origin <x,y,z>]
+//                   [--disassemble]
+
+#include "shader_interpreter.hpp"
+#include "shader_isa.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// https://stackoverflow.com/a/868894
+char *getCmdOption(char **begin, char **end, const std::string &option) {
+  char **itr = std::find(begin, end, option);
+  if (itr != end && ++itr != end) {
+    return *itr;
+  }
+  return 0;
+}
+
+static bool parse_vec(const char *arg, shader_vec &v, sfp_format f) {
+  double x, y, z;
+  if (!arg || std::sscanf(arg, "%lf,%lf,%lf", &x, &y, &z) != 3) {
+    return false;
+  }
+  v = {sfp_from_float(x, f), sfp_from_float(y, f), sfp_from_float(z, f)};
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " <program.s> [--eval <x,y,z>] [--origin <x,y,z>]"
+                 " [--disassemble]"
+              << std::endl;
+    return 1;
+  }
+
+  std::ifstream in(argv[1]);
+  if (!in) {
+    std::cerr << "Cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+  std::stringstream source;
+  source << in.rdbuf();
+
+  shader_program program;
+  std::string error;
+  if (!shader_assemble(source.str(), program, error)) {
+    std::cerr << argv[1] << ": " << error << std::endl;
+    return 1;
+  }
+
+  sfp_format f = {FP_IW, FP_QW};
+  char *eval = getCmdOption(argv, argv + argc, "--eval");
+  if (eval) {
+    shader_vec direction, origin = {};
+    char *origin_arg = getCmdOption(argv, argv + argc, "--origin");
+    if (!parse_vec(eval, direction, f) ||
+        (origin_arg && !parse_vec(origin_arg, origin, f))) {
+      std::cerr << "Expected a vector as <x,y,z>" << std::endl;
+      return 1;
+    }
+    shader_interpreter shader(program, f);
+    shader_vec r = shader.run(direction, origin);
+    std::printf("%g %g %g\n", sfp_to_double(r[0], f), sfp_to_double(r[1], f),
+                sfp_to_double(r[2], f));
+    return 0;
+  }
+
+  if (std::find(argv, argv + argc, std::string("--disassemble")) !=
+      argv + argc) {
+    for (size_t i = 0; i < program.code.size(); i++) {
+      std::printf("%3zu: %08x  %s\n", i, program.code[i],
+                  shader_disassemble(program.code[i]).c_str());
+    }
+    return 0;
+  }
+
+  for (uint32_t word : program.stream()) {
+    std::printf("%08x\n", word);
+  }
+  std::cerr << program.code.size() << " instructions, "
+            << program.constants.size() << " constants" << std::endl;
+  return 0;
+}